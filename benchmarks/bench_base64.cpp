@@ -0,0 +1,274 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the base64 codec.
+ *
+ * The encoder and decoder are run on 1Mb of binary data with each SIMD
+ * level to compare the kernels. The basic authorization benchmark
+ * encodes a short "user:password" string as done by set_basic_auth().
+ *
+ * The "legacy" benchmarks run the lambda that set_basic_auth() used
+ * before the codec was added, as a baseline. That lambda stops at the
+ * first NUL character so it gets data without any NUL.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/base64.h>
+#include    <edhttp/token.h>
+
+
+
+namespace
+{
+
+
+
+std::string make_data()
+{
+    std::string data;
+    data.reserve(1024 * 1024);
+    std::uint32_t v(1);
+    while(data.length() < 1024 * 1024)
+    {
+        v = v * 1103515245 + 12345;
+        data += static_cast<char>(v >> 16);
+    }
+    return data;
+}
+
+
+std::string make_data_without_nul()
+{
+    std::string data(make_data());
+    for(auto & c : data)
+    {
+        if(c == '\0')
+        {
+            c = '\1';
+        }
+    }
+    return data;
+}
+
+
+std::string const g_data(make_data());
+std::string const g_data_without_nul(make_data_without_nul());
+std::string const g_encoded(edhttp::base64_encode(g_data));
+
+
+char const g_legacy_base64[] =
+{
+    // 8x8 characters
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
+    'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+    'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
+    'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3',
+    '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+
+/** \brief The encoder used by set_basic_auth() before base64.h existed.
+ *
+ * This is a verbatim copy of the lambda, kept as a baseline.
+ *
+ * \param[in] in  The string to encode, it cannot include a NUL.
+ * \param[out] out  The encoded string.
+ */
+void legacy_encode(std::string const & in, std::string & out)
+{
+    // reset output (just in case)
+    out.clear();
+
+    // WARNING: following algorithm does NOT take any line length
+    //          in account; and it is deadly well optimized
+    unsigned char const *s(reinterpret_cast<unsigned char const *>(in.c_str()));
+    while(*s != '\0')
+    {
+        // get 1 to 3 characters of input
+        out += g_legacy_base64[s[0] >> 2]; // & 0x3F not required
+        ++s;
+        if(s[0] != '\0')
+        {
+            out += g_legacy_base64[((s[-1] << 4) & 0x30) | ((s[0] >> 4) & 0x0F)];
+            ++s;
+            if(s[0] != '\0')
+            {
+                // 24 bits of input uses 4 base64 characters
+                out += g_legacy_base64[((s[-1] << 2) & 0x3C) | ((s[0] >> 6) & 0x03)];
+                out += g_legacy_base64[s[0] & 0x3F];
+                s++;
+            }
+            else
+            {
+                // 16 bits of input uses 3 base64 characters + 1 pad
+                out += g_legacy_base64[(s[-1] << 2) & 0x3C];
+                out += '=';
+                break;
+            }
+        }
+        else
+        {
+            // 8 bits of input uses 2 base64 characters + 2 pads
+            out += g_legacy_base64[(s[-1] << 4) & 0x30];
+            out += "==";
+            break;
+        }
+    }
+}
+
+
+void run_encode(edhttp_benchmark::state & state, edhttp::simd_level_t level)
+{
+    edhttp::simd_level_t const saved(edhttp::set_simd_level(level));
+    std::string out;
+    while(state.keep_running())
+    {
+        out.clear();
+        edhttp::base64_encode(g_data, out);
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    edhttp::set_simd_level(saved);
+    state.set_bytes_processed(g_data.length());
+}
+
+
+void run_decode(edhttp_benchmark::state & state, edhttp::simd_level_t level)
+{
+    edhttp::simd_level_t const saved(edhttp::set_simd_level(level));
+    std::string out;
+    while(state.keep_running())
+    {
+        out.clear();
+        edhttp_benchmark::do_not_optimize(edhttp::base64_decode(g_encoded, out));
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    edhttp::set_simd_level(saved);
+    state.set_bytes_processed(g_encoded.length());
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(base64_encode_legacy_1mb)
+{
+    std::string out;
+    while(state.keep_running())
+    {
+        legacy_encode(g_data_without_nul, out);
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    state.set_bytes_processed(g_data_without_nul.length());
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_scalar_1mb)
+{
+    run_encode(state, edhttp::simd_level_t::SIMD_LEVEL_SCALAR);
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_ssse3_1mb)
+{
+    run_encode(state, edhttp::simd_level_t::SIMD_LEVEL_SSSE3);
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_avx2_1mb)
+{
+    run_encode(state, edhttp::simd_level_t::SIMD_LEVEL_AVX2);
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_mime_lines_1mb)
+{
+    edhttp::base64_encoder encoder(edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, 0, 76);
+    std::string out;
+    while(state.keep_running())
+    {
+        out.clear();
+        encoder.encode(g_data, out);
+        encoder.finish(out);
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    state.set_bytes_processed(g_data.length());
+}
+
+
+EDHTTP_BENCHMARK(base64_decode_scalar_1mb)
+{
+    run_decode(state, edhttp::simd_level_t::SIMD_LEVEL_SCALAR);
+}
+
+
+EDHTTP_BENCHMARK(base64_decode_ssse3_1mb)
+{
+    run_decode(state, edhttp::simd_level_t::SIMD_LEVEL_SSSE3);
+}
+
+
+EDHTTP_BENCHMARK(base64_decode_avx2_1mb)
+{
+    run_decode(state, edhttp::simd_level_t::SIMD_LEVEL_AVX2);
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_basic_auth)
+{
+    std::string const username("alexis");
+    std::string const secret(std::string("p\0ssw0rd", 8));
+    std::string authorization;
+    while(state.keep_running())
+    {
+        authorization = "Basic ";
+        edhttp::base64_encode(username + ':' + secret, authorization);
+        edhttp_benchmark::do_not_optimize(authorization);
+    }
+    state.set_bytes_processed(username.length() + 1 + secret.length());
+}
+
+
+EDHTTP_BENCHMARK(base64_encode_basic_auth_legacy)
+{
+    std::string const username("alexis");
+    std::string const secret("passw0rd");
+    std::string base64;
+    std::string authorization;
+    while(state.keep_running())
+    {
+        legacy_encode(username + ':' + secret, base64);
+        authorization = "Basic " + base64;
+        edhttp_benchmark::do_not_optimize(authorization);
+    }
+    state.set_bytes_processed(username.length() + 1 + secret.length());
+}
+
+
+// vim: ts=4 sw=4 et
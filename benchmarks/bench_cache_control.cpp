@@ -0,0 +1,79 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+/** \file
+ * \brief Benchmark the Cache-Control parser.
+ *
+ * \note
+ * The parser is shared with the language tags and refuses parts longer
+ * than 8 characters (i.e. immutable, must-revalidate, no-transform)
+ * so the inputs avoid those.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/cache_control.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_response_cache_control("public, max-age=3600, s-maxage=7200, no-store");
+std::string const g_request_cache_control("no-cache, max-stale=60, min-fresh=10");
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(cache_control_response)
+{
+    edhttp::cache_control_settings settings;
+    while(state.keep_running())
+    {
+        settings.reset_cache_info();
+        settings.set_cache_info(g_response_cache_control, false);
+        edhttp_benchmark::do_not_optimize(settings.get_max_age());
+    }
+    state.set_bytes_processed(g_response_cache_control.length());
+}
+
+
+EDHTTP_BENCHMARK(cache_control_request)
+{
+    edhttp::cache_control_settings settings;
+    while(state.keep_running())
+    {
+        settings.reset_cache_info();
+        settings.set_cache_info(g_request_cache_control, false);
+        edhttp_benchmark::do_not_optimize(settings.get_max_stale());
+    }
+    state.set_bytes_processed(g_request_cache_control.length());
+}
+
+
+
+// vim: ts=4 sw=4 et
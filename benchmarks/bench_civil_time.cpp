@@ -0,0 +1,131 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the civil time conversions.
+ *
+ * The C library timegm() and gmtime_r() functions are used as the
+ * reference points.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/civil_time.h>
+#include    <edhttp/mkgmtime.h>
+
+
+
+namespace
+{
+
+
+
+// one date every ~41 days from 1900 to 2100
+//
+time_t next_time(time_t t)
+{
+    t += 3'541'147;
+    if(t > 4'102'444'800)
+    {
+        t -= 6'311'433'600;
+    }
+    return t;
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(civil_time_timegm)
+{
+    time_t t(-2'208'988'800);
+    while(state.keep_running())
+    {
+        struct tm tim;
+        gmtime_r(&t, &tim);
+        edhttp_benchmark::do_not_optimize(timegm(&tim));
+        t = next_time(t);
+    }
+    state.set_label("gmtime_r() + timegm()");
+}
+
+
+EDHTTP_BENCHMARK(civil_time_mkgmtime)
+{
+    time_t t(-2'208'988'800);
+    while(state.keep_running())
+    {
+        struct tm tim;
+        gmtime_r(&t, &tim);
+        edhttp_benchmark::do_not_optimize(mkgmtime(&tim));
+        t = next_time(t);
+    }
+    state.set_label("gmtime_r() + mkgmtime()");
+}
+
+
+EDHTTP_BENCHMARK(civil_time_round_trip)
+{
+    time_t t(-2'208'988'800);
+    while(state.keep_running())
+    {
+        edhttp::civil_time_t const c(edhttp::civil_from_time(t));
+        edhttp_benchmark::do_not_optimize(edhttp::time_from_civil(
+                  c.f_year
+                , c.f_month
+                , c.f_day
+                , c.f_hour
+                , c.f_minute
+                , c.f_second));
+        t = next_time(t);
+    }
+    state.set_label("civil_from_time() + time_from_civil()");
+}
+
+
+EDHTTP_BENCHMARK(civil_time_gmtime_r)
+{
+    time_t t(-2'208'988'800);
+    while(state.keep_running())
+    {
+        struct tm tim;
+        edhttp_benchmark::do_not_optimize(gmtime_r(&t, &tim)->tm_mday);
+        t = next_time(t);
+    }
+}
+
+
+EDHTTP_BENCHMARK(civil_time_civil_from_time)
+{
+    time_t t(-2'208'988'800);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::civil_from_time(t).f_day);
+        t = next_time(t);
+    }
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,248 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+/** \file
+ * \brief Benchmark the compressors and the tar archiver.
+ *
+ * Each compressor is run at three levels on a small (4Kb, a typical
+ * HTML page) and a large (1Mb) buffer. The input is text generated
+ * with a fixed seed so the results can be compared between releases.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/compression/archiver.h>
+#include    <edhttp/compression/compressor.h>
+
+
+// C++
+//
+#include    <cstring>
+#include    <iterator>
+#include    <random>
+#include    <stdexcept>
+
+
+
+namespace
+{
+
+
+
+struct compressor_def_t
+{
+    char const *        f_name = nullptr;
+    bool                f_needs_size = false;   // raw deflate does not save the size
+};
+
+compressor_def_t const g_compressors[] =
+{
+    { "bz2", false },
+    { "deflate", true },
+    { "gzip", false },
+    { "xz", false },
+};
+
+edhttp::level_t const g_levels[] =
+{
+    10,
+    50,
+    90,
+};
+
+struct size_def_t
+{
+    char const *        f_name = nullptr;
+    std::size_t         f_size = 0;
+};
+
+size_def_t const g_sizes[] =
+{
+    { "4kb", 4 * 1024 },
+    { "1mb", 1024 * 1024 },
+};
+
+
+edhttp::buffer_t generate_text(std::size_t size)
+{
+    char const * const words[] =
+    {
+        "the", "event", "dispatcher", "sends", "an", "HTTP", "request",
+        "to", "server", "and", "reads", "response", "with", "headers",
+        "<div class=\"content\">", "</div>", "<p>", "</p>", "cache",
+        "cookie", "compression", "of", "a", "page", "is", "fast",
+    };
+
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<std::size_t> pick(0, std::size(words) - 1);
+    edhttp::buffer_t result;
+    result.reserve(size + 32);
+    while(result.size() < size)
+    {
+        char const * w(words[pick(generator)]);
+        result.insert(result.end(), w, w + strlen(w));
+        result.push_back(pick(generator) == 0 ? '\n' : ' ');
+    }
+    result.resize(size);
+    return result;
+}
+
+
+edhttp::compressor * compressor(char const * name)
+{
+    edhttp::compressor * c(edhttp::get_compressor(name));
+    if(c == nullptr)
+    {
+        throw std::logic_error(std::string("compressor \"") + name + "\" not found.");
+    }
+    return c;
+}
+
+
+bool register_compressors()
+{
+    for(auto const & def : g_compressors)
+    {
+        char const * name(def.f_name);
+        for(auto const & size : g_sizes)
+        {
+            for(auto const level : g_levels)
+            {
+                std::string const benchmark_name(
+                          std::string("compress_")
+                        + name
+                        + "_level"
+                        + std::to_string(static_cast<int>(level))
+                        + "_"
+                        + size.f_name);
+                edhttp_benchmark::registrar(
+                      benchmark_name.c_str()
+                    , [name, size, level](edhttp_benchmark::state & state)
+                      {
+                          edhttp::compressor * c(compressor(name));
+                          edhttp::buffer_t const input(generate_text(size.f_size));
+                          while(state.keep_running())
+                          {
+                              edhttp_benchmark::do_not_optimize(c->compress(input, level, true));
+                          }
+                          state.set_bytes_processed(input.size());
+                      });
+            }
+
+            std::string const benchmark_name(
+                      std::string("decompress_")
+                    + name
+                    + "_"
+                    + size.f_name);
+            edhttp_benchmark::registrar(
+                  benchmark_name.c_str()
+                , [def, size](edhttp_benchmark::state & state)
+                  {
+                      edhttp::compressor * c(compressor(def.f_name));
+                      edhttp::buffer_t const input(generate_text(size.f_size));
+                      edhttp::buffer_t const compressed(c->compress(input, 50, true));
+                      while(state.keep_running())
+                      {
+                          if(def.f_needs_size)
+                          {
+                              edhttp_benchmark::do_not_optimize(c->decompress(compressed, input.size()));
+                          }
+                          else
+                          {
+                              edhttp_benchmark::do_not_optimize(c->decompress(compressed));
+                          }
+                      }
+                      state.set_bytes_processed(input.size());
+                  });
+        }
+    }
+
+    return true;
+}
+
+
+bool const g_compressors_registered = register_compressors();
+
+
+edhttp::archiver_file make_file(std::size_t idx, edhttp::buffer_t const & data)
+{
+    edhttp::archiver_file file;
+    file.set_type(edhttp::file_type_t::FILE_TYPE_REGULAR);
+    file.set_data(data);
+    file.set_filename("static/assets/file-" + std::to_string(idx) + ".html");
+    file.set_user("www-data", 33);
+    file.set_group("www-data", 33);
+    file.set_mode(0644);
+    file.set_mtime(snapdev::timespec_ex(1700000000, 0));
+    return file;
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(tar_append_file)
+{
+    edhttp::archiver * tar(edhttp::get_archiver("tar"));
+    edhttp::archiver_file const file(make_file(1, generate_text(16 * 1024)));
+    while(state.keep_running())
+    {
+        edhttp::archiver_archive archive;
+        tar->append_file(archive, file);
+        edhttp_benchmark::do_not_optimize(archive.get().size());
+    }
+    state.set_bytes_processed(file.get_data().size());
+}
+
+
+EDHTTP_BENCHMARK(tar_next_file)
+{
+    constexpr std::size_t const FILE_COUNT = 64;
+
+    edhttp::archiver * tar(edhttp::get_archiver("tar"));
+    edhttp::archiver_archive archive;
+    edhttp::buffer_t const data(generate_text(16 * 1024));
+    for(std::size_t idx(0); idx < FILE_COUNT; ++idx)
+    {
+        tar->append_file(archive, make_file(idx, data));
+    }
+
+    edhttp::archiver_file file;
+    std::size_t count(0);
+    while(state.keep_running())
+    {
+        if(!tar->next_file(archive, file))
+        {
+            tar->rewind(archive);
+            tar->next_file(archive, file);
+        }
+        ++count;
+    }
+    edhttp_benchmark::do_not_optimize(count);
+    state.set_bytes_processed(data.size());
+}
+
+
+
+// vim: ts=4 sw=4 et
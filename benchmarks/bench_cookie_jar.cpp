@@ -0,0 +1,111 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the cookie jar.
+ *
+ * The jar is filled with 5,000 cookies spread over 1,000 sites, which
+ * is what a crawler ends up with, then we measure the time it takes to
+ * build the Cookie header of one request.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/cookie_jar.h>
+
+
+
+namespace
+{
+
+
+
+time_t const g_now = 1700000000;
+
+
+edhttp::cookie_jar & get_jar()
+{
+    static edhttp::cookie_jar jar(10000);
+    if(jar.size() == 0)
+    {
+        for(int i(0); i < 5000; ++i)
+        {
+            std::string const site("site" + std::to_string(i % 1000) + ".com");
+            std::string const domain(i % 2 == 0 ? "; Domain=" + site : std::string());
+            jar.set_cookie(
+                      "cookie_" + std::to_string(i) + "=" + std::to_string(i * 7919) + "; Max-Age=3600" + domain
+                    , "www." + site
+                    , i % 3 == 0 ? "/account/index.html" : "/"
+                    , false
+                    , g_now);
+        }
+    }
+    return jar;
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(cookie_jar_match)
+{
+    edhttp::cookie_jar const & jar(get_jar());
+    std::string cookies;
+    while(state.keep_running())
+    {
+        cookies.clear();
+        jar.append_cookies(cookies, "www.site7.com", "/account/settings", false, g_now);
+        edhttp_benchmark::do_not_optimize(cookies);
+    }
+    state.set_label("5,000 cookies, 1,000 sites");
+}
+
+
+EDHTTP_BENCHMARK(cookie_jar_no_match)
+{
+    edhttp::cookie_jar const & jar(get_jar());
+    std::string cookies;
+    while(state.keep_running())
+    {
+        cookies.clear();
+        jar.append_cookies(cookies, "www.unknown.org", "/", false, g_now);
+        edhttp_benchmark::do_not_optimize(cookies);
+    }
+    state.set_label("5,000 cookies, 1,000 sites");
+}
+
+
+EDHTTP_BENCHMARK(cookie_jar_set_cookie)
+{
+    edhttp::cookie_jar jar;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(jar.set_cookie("sid=31d4d96e407aad42; Path=/; Secure; HttpOnly; Max-Age=3600", "www.example.com", "/", true, g_now));
+    }
+    state.set_label("replace");
+}
+
+
+// vim: ts=4 sw=4 et
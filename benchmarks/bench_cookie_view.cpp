@@ -0,0 +1,122 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the Cookie header parser.
+ *
+ * The http_cookie_map benchmark splits the header in a map of strings,
+ * which is what an application does without cookie_view.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/cookie_view.h>
+
+
+// C++
+//
+#include    <map>
+
+
+
+namespace
+{
+
+
+
+std::string make_header(int count)
+{
+    std::string header;
+    for(int i(0); i < count; ++i)
+    {
+        if(i != 0)
+        {
+            header += "; ";
+        }
+        header += "cookie_" + std::to_string(i) + "=value%20" + std::to_string(i * 7919);
+    }
+    return header;
+}
+
+
+std::string const g_header(make_header(30));
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(http_cookie_map)
+{
+    while(state.keep_running())
+    {
+        std::map<std::string, std::string> cookies;
+        std::string::size_type pos(0);
+        while(pos < g_header.length())
+        {
+            std::string::size_type end(g_header.find(';', pos));
+            if(end == std::string::npos)
+            {
+                end = g_header.length();
+            }
+            std::string const pair(g_header.substr(pos, end - pos));
+            std::string::size_type const equal(pair.find('='));
+            std::string name(pair.substr(0, equal));
+            while(!name.empty() && name[0] == ' ')
+            {
+                name.erase(0, 1);
+            }
+            cookies[name] = pair.substr(equal + 1);
+            pos = end + 1;
+        }
+        edhttp_benchmark::do_not_optimize(cookies.find("cookie_29")->second);
+    }
+    state.set_bytes_processed(g_header.length());
+    state.set_label("30 cookies");
+}
+
+
+EDHTTP_BENCHMARK(cookie_view_parse)
+{
+    while(state.keep_running())
+    {
+        edhttp::cookie_view cookies(g_header);
+        edhttp_benchmark::do_not_optimize(cookies.get_value("cookie_29"));
+    }
+    state.set_bytes_processed(g_header.length());
+    state.set_label("30 cookies");
+}
+
+
+EDHTTP_BENCHMARK(cookie_view_decoded_value)
+{
+    edhttp::cookie_view const cookies(g_header);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(cookies.get_decoded_value("cookie_15"));
+    }
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,106 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the field name interning table.
+ *
+ * Compare the perfect hash lookup against lowercasing the name and
+ * comparing it against a list of strings.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/field_name.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <vector>
+
+
+
+namespace
+{
+
+
+
+std::vector<std::string> const g_names =
+{
+    "Accept",
+    "Content-Type",
+    "x-request-id",
+    "User-Agent",
+    "Cache-Control",
+    "Cookie",
+    "If-None-Match",
+    "Host",
+};
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(field_name_perfect_hash)
+{
+    while(state.keep_running())
+    {
+        for(auto const & n : g_names)
+        {
+            edhttp_benchmark::do_not_optimize(edhttp::get_field_name_id(n));
+        }
+    }
+    state.set_label("8 names per iteration");
+}
+
+
+EDHTTP_BENCHMARK(field_name_tolower_compare)
+{
+    std::vector<std::string> const known =
+    {
+        "accept",
+        "cache-control",
+        "connection",
+        "content-length",
+        "content-type",
+        "cookie",
+        "host",
+        "if-none-match",
+        "user-agent",
+    };
+    while(state.keep_running())
+    {
+        for(auto const & n : g_names)
+        {
+            std::string name(n);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            edhttp_benchmark::do_not_optimize(std::find(known.begin(), known.end(), name));
+        }
+    }
+    state.set_label("8 names per iteration");
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,218 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+/** \file
+ * \brief Benchmark the HTTP client request and response handling.
+ *
+ * The request benchmark only builds the HTTP request string. The
+ * response benchmark sends requests over a keep-alive loopback
+ * connection to a minimal server thread which answers each request
+ * with the same canned response, so the timing is dominated by
+ * read_response() and the system calls it makes.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/http_client_server.h>
+
+
+// C++
+//
+#include    <stdexcept>
+#include    <string>
+#include    <thread>
+
+
+// C
+//
+#include    <arpa/inet.h>
+#include    <netinet/in.h>
+#include    <sys/socket.h>
+#include    <unistd.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_response_body(
+      "{\"items\":[{\"id\":1,\"name\":\"apple\",\"price\":0.5}"
+      ",{\"id\":2,\"name\":\"banana\",\"price\":0.25}"
+      ",{\"id\":3,\"name\":\"cherry\",\"price\":3.75}]}");
+
+std::string const g_response(
+      "HTTP/1.1 200 OK\r\n"
+      "Date: Mon, 07 Oct 2024 12:00:00 GMT\r\n"
+      "Server: edhttp-benchmark\r\n"
+      "Content-Type: application/json; charset=utf-8\r\n"
+      "Cache-Control: private, max-age=60\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: " + std::to_string(g_response_body.length()) + "\r\n"
+      "\r\n"
+    + g_response_body);
+
+
+void set_request(edhttp::http_request & request, int port)
+{
+    request.set_host("127.0.0.1");
+    request.set_port(port);
+    request.set_method("GET");
+    request.set_path("/api/v2/items?sort=price&limit=50");
+    request.set_header("Accept", "application/json");
+    request.set_header("Accept-Encoding", "gzip, deflate");
+    request.set_header("Accept-Language", "en-US,en;q=0.9");
+}
+
+
+/** \brief A server answering each request with the same response.
+ *
+ * The server accepts a single connection and replies to each request
+ * it reads with g_response. It stops once the client closes the
+ * connection.
+ */
+class loopback_server
+{
+public:
+    loopback_server()
+    {
+        f_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(f_socket < 0)
+        {
+            throw std::runtime_error("could not create the loopback server socket.");
+        }
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length(sizeof(a));
+        if(bind(f_socket, reinterpret_cast<sockaddr *>(&a), sizeof(a)) != 0
+        || getsockname(f_socket, reinterpret_cast<sockaddr *>(&a), &length) != 0
+        || listen(f_socket, 1) != 0)
+        {
+            close(f_socket);
+            throw std::runtime_error("could not bind the loopback server socket.");
+        }
+        f_port = ntohs(a.sin_port);
+        f_thread = std::thread(&loopback_server::run, this);
+    }
+
+    loopback_server(loopback_server const &) = delete;
+    loopback_server & operator = (loopback_server const &) = delete;
+
+    ~loopback_server()
+    {
+        // the client must be gone by now so the thread returns; the
+        // shutdown() wakes up accept() in case the client never connected
+        //
+        shutdown(f_socket, SHUT_RDWR);
+        f_thread.join();
+        close(f_socket);
+    }
+
+    int get_port() const
+    {
+        return f_port;
+    }
+
+private:
+    void run()
+    {
+        int const s(accept(f_socket, nullptr, nullptr));
+        if(s < 0)
+        {
+            return;
+        }
+        std::string pending;
+        char buf[4096];
+        for(;;)
+        {
+            ssize_t const r(read(s, buf, sizeof(buf)));
+            if(r <= 0)
+            {
+                break;
+            }
+            pending.append(buf, r);
+            for(;;)
+            {
+                std::string::size_type const pos(pending.find("\r\n\r\n"));
+                if(pos == std::string::npos)
+                {
+                    break;
+                }
+                pending.erase(0, pos + 4);
+                if(write(s, g_response.c_str(), g_response.length()) != static_cast<ssize_t>(g_response.length()))
+                {
+                    close(s);
+                    return;
+                }
+            }
+        }
+        close(s);
+    }
+
+    int                 f_socket = -1;
+    int                 f_port = 0;
+    std::thread         f_thread = std::thread();
+};
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(http_request_get_request)
+{
+    edhttp::http_request request;
+    set_request(request, 8080);
+    std::size_t size(0);
+    while(state.keep_running())
+    {
+        std::string const r(request.get_request(true, "session=abc123; theme=dark"));
+        size = r.length();
+        edhttp_benchmark::do_not_optimize(r);
+    }
+    state.set_bytes_processed(size);
+}
+
+
+EDHTTP_BENCHMARK(http_client_read_response)
+{
+    loopback_server server;
+    {
+        edhttp::http_request request;
+        set_request(request, server.get_port());
+
+        edhttp::http_client client;
+        client.set_keep_alive(true);
+        while(state.keep_running())
+        {
+            edhttp_benchmark::do_not_optimize(client.send_request(request));
+        }
+    }
+    state.set_bytes_processed(g_response.length());
+}
+
+
+
+// vim: ts=4 sw=4 et
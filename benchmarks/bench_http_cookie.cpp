@@ -0,0 +1,105 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the Set-Cookie serialization.
+ *
+ * The http_cookie_to_http_header benchmark creates one string per
+ * cookie; the append_set_cookies benchmark writes all the cookies in
+ * one reused buffer.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/http_cookie.h>
+
+
+
+namespace
+{
+
+
+
+edhttp::http_cookie::vector_t make_cookies(int count)
+{
+    edhttp::http_cookie::vector_t cookies;
+    for(int i(0); i < count; ++i)
+    {
+        edhttp::http_cookie cookie("cookie_" + std::to_string(i), "value " + std::to_string(i * 7919));
+        cookie.set_domain("example.com");
+        cookie.set_secure();
+        cookie.set_http_only();
+        if(i % 4 != 0)
+        {
+            cookie.set_expire_in(86400 * 30);
+        }
+        cookies.push_back(cookie);
+    }
+    return cookies;
+}
+
+
+edhttp::http_cookie::vector_t const g_cookies(make_cookies(20));
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(http_cookie_to_http_header)
+{
+    std::size_t size(0);
+    while(state.keep_running())
+    {
+        std::string out;
+        for(auto const & c : g_cookies)
+        {
+            out += c.to_http_header();
+            out += "\r\n";
+        }
+        size = out.length();
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    state.set_bytes_processed(size);
+    state.set_label("20 cookies");
+}
+
+
+EDHTTP_BENCHMARK(append_set_cookies)
+{
+    std::size_t size(0);
+    std::string out;
+    while(state.keep_running())
+    {
+        out.clear();
+        edhttp::append_set_cookies(out, g_cookies);
+        size = out.length();
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    state.set_bytes_processed(size);
+    state.set_label("20 cookies");
+}
+
+
+// vim: ts=4 sw=4 et
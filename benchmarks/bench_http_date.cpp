@@ -0,0 +1,188 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the HTTP date functions.
+ *
+ * The http_date_format_stringstream benchmark reproduces the previous
+ * implementation of date_to_string() (gmtime_r() and a stringstream)
+ * as a reference point.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/http_date.h>
+
+
+// C++
+//
+#include    <iomanip>
+#include    <sstream>
+
+
+// C
+//
+#include    <time.h>
+
+
+
+namespace
+{
+
+
+
+char const * const g_week_day[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+char const * const g_month[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+
+std::string stringstream_http_date(time_t seconds)
+{
+    struct tm time_info;
+    gmtime_r(&seconds, &time_info);
+    std::stringstream ss;
+    ss << std::setfill('0')
+       << g_week_day[time_info.tm_wday]
+       << ", "
+       << std::setw(2) << time_info.tm_mday
+       << ' '
+       << g_month[time_info.tm_mon]
+       << ' '
+       << std::setw(4) << time_info.tm_year + 1900
+       << ' '
+       << std::setw(2) << time_info.tm_hour
+       << ':'
+       << std::setw(2) << time_info.tm_min
+       << ':'
+       << std::setw(2) << time_info.tm_sec
+       << " GMT";
+    return ss.str();
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(http_date_format_stringstream)
+{
+    time_t seconds(1700000000);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(stringstream_http_date(seconds));
+        ++seconds;
+    }
+}
+
+
+EDHTTP_BENCHMARK(http_date_format)
+{
+    char buf[edhttp::HTTP_DATE_LENGTH];
+    time_t seconds(1700000000);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::format_http_date(seconds, buf));
+        ++seconds;
+    }
+}
+
+
+EDHTTP_BENCHMARK(http_date_format_same_second)
+{
+    char buf[edhttp::HTTP_DATE_LENGTH];
+    time_t const seconds(1700000000);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::format_http_date(seconds, buf));
+    }
+}
+
+
+EDHTTP_BENCHMARK(http_date_to_string)
+{
+    time_t seconds(1700000000);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::date_to_string(seconds, edhttp::date_format_t::DATE_FORMAT_HTTP));
+        ++seconds;
+    }
+}
+
+
+EDHTTP_BENCHMARK(http_date_parse_imf_fixdate)
+{
+    std::string_view const date("Sun, 06 Nov 1994 08:49:37 GMT");
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::parse_http_date(date));
+    }
+    state.set_bytes_processed(date.length());
+}
+
+
+EDHTTP_BENCHMARK(http_date_parse_rfc850)
+{
+    std::string_view const date("Sunday, 06-Nov-94 08:49:37 GMT");
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::parse_http_date(date));
+    }
+    state.set_bytes_processed(date.length());
+}
+
+
+EDHTTP_BENCHMARK(http_date_parse_asctime)
+{
+    std::string_view const date("Sun Nov  6 08:49:37 1994");
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::parse_http_date(date));
+    }
+    state.set_bytes_processed(date.length());
+}
+
+
+EDHTTP_BENCHMARK(http_date_string_to_date)
+{
+    std::string const date("Sun, 06 Nov 1994 08:49:37 GMT");
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::string_to_date(date));
+    }
+    state.set_bytes_processed(date.length());
+}
+
+
+EDHTTP_BENCHMARK(http_date_string_to_date_lenient)
+{
+    std::string const date("Sun, 06 Nov 1994 03:49:37 EST");
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::string_to_date(date));
+    }
+    state.set_bytes_processed(date.length());
+    state.set_label("slow path");
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,162 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the metrics.
+ *
+ * The contended benchmarks run 3 more threads updating the same metric
+ * while the loop is timed. The single atomic benchmark shows the cost
+ * of the same updates without shards.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/metrics.h>
+
+
+// C++
+//
+#include    <thread>
+#include    <vector>
+
+
+
+namespace
+{
+
+
+
+template<typename F>
+void run_contended(edhttp_benchmark::state & state, F update)
+{
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for(int idx(0); idx < 3; ++idx)
+    {
+        threads.emplace_back([&done, &update]()
+            {
+                while(!done.load(std::memory_order_relaxed))
+                {
+                    update();
+                }
+            });
+    }
+    while(state.keep_running())
+    {
+        update();
+    }
+    done = true;
+    for(auto & t : threads)
+    {
+        t.join();
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(metrics_counter_increment)
+{
+    edhttp::metric_counter counter("bench_counter_total", "Benchmark.");
+    while(state.keep_running())
+    {
+        counter.increment();
+    }
+    edhttp_benchmark::do_not_optimize(counter.get_value());
+}
+
+
+EDHTTP_BENCHMARK(metrics_counter_increment_contended)
+{
+    edhttp::metric_counter counter("bench_counter_total", "Benchmark.");
+    run_contended(state, [&counter]() { counter.increment(); });
+    edhttp_benchmark::do_not_optimize(counter.get_value());
+}
+
+
+EDHTTP_BENCHMARK(metrics_single_atomic_contended)
+{
+    std::atomic<std::uint64_t> value(0);
+    run_contended(state, [&value]() { value.fetch_add(1, std::memory_order_relaxed); });
+    edhttp_benchmark::do_not_optimize(value.load());
+}
+
+
+EDHTTP_BENCHMARK(metrics_histogram_record)
+{
+    edhttp::metric_histogram histogram("bench_duration_seconds", "Benchmark.");
+    std::uint64_t value(1);
+    while(state.keep_running())
+    {
+        histogram.record(value);
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    edhttp_benchmark::do_not_optimize(histogram.get_sum());
+}
+
+
+EDHTTP_BENCHMARK(metrics_histogram_record_contended)
+{
+    edhttp::metric_histogram histogram("bench_duration_seconds", "Benchmark.");
+    run_contended(state, [&histogram]() { histogram.record(1'500'000); });
+    edhttp_benchmark::do_not_optimize(histogram.get_sum());
+}
+
+
+EDHTTP_BENCHMARK(metrics_histogram_timer)
+{
+    edhttp::metric_histogram histogram("bench_duration_seconds", "Benchmark.");
+    while(state.keep_running())
+    {
+        edhttp::metric_histogram::timer t(histogram);
+    }
+    edhttp_benchmark::do_not_optimize(histogram.get_sum());
+}
+
+
+EDHTTP_BENCHMARK(metrics_render_50)
+{
+    edhttp::metrics_registry registry;
+    for(int idx(0); idx < 40; ++idx)
+    {
+        registry.get_counter("bench_requests_total", "Requests.", edhttp::metric::label("id", std::to_string(idx))).increment(idx);
+    }
+    for(int idx(0); idx < 10; ++idx)
+    {
+        registry.get_histogram("bench_duration_seconds", "Durations.", edhttp::metric::label("id", std::to_string(idx))).record(1'000'000);
+    }
+
+    std::string out;
+    while(state.keep_running())
+    {
+        registry.render(out);
+        edhttp_benchmark::do_not_optimize(out);
+    }
+    state.set_bytes_processed(out.length());
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,138 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the MIME type detection.
+ *
+ * The large text benchmarks show the difference between inspecting a
+ * whole 1Mb upload and only its first 4Kb. Note that libmagic already
+ * limits many of its text tests so the default of 64Kb costs about the
+ * same as the whole buffer.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/mime_type.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_png("\x89PNG\r\n\x1a\n\0\0\0\rIHDR\0\0\0\x01\0\0\0\x01\x08\x02\0\0\0", 29);
+
+
+std::string make_text()
+{
+    std::string text;
+    while(text.length() < 1024 * 1024)
+    {
+        text += "The quick brown fox jumps over the lazy dog.\n";
+    }
+    return text;
+}
+
+
+std::string const g_text(make_text());
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(mime_type_png)
+{
+    edhttp::prewarm_mime_type();
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type(g_png));
+    }
+    state.set_bytes_processed(g_png.length());
+}
+
+
+EDHTTP_BENCHMARK(mime_type_sniff_png)
+{
+    std::span<char const> const data(g_png.data(), g_png.length());
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::sniff_mime_type(data));
+    }
+    state.set_bytes_processed(g_png.length());
+}
+
+
+EDHTTP_BENCHMARK(mime_type_sniff_unknown)
+{
+    // text goes through all the signatures before being rejected
+    //
+    std::span<char const> const data(g_text.data(), g_text.length());
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::sniff_mime_type(data));
+    }
+    state.set_bytes_processed(edhttp::MIME_TYPE_SNIFF_SIZE);
+}
+
+
+EDHTTP_BENCHMARK(mime_type_from_extension)
+{
+    edhttp_benchmark::do_not_optimize(edhttp::get_mime_type_from_extension("png"));
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type_from_extension("/images/logo.png"));
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type_from_extension("/index.HTML"));
+    }
+    state.set_label("2 lookups");
+}
+
+
+EDHTTP_BENCHMARK(mime_type_large_text_whole)
+{
+    edhttp::prewarm_mime_type();
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type(g_text));
+    }
+    state.set_bytes_processed(g_text.length());
+    state.set_label("1Mb");
+}
+
+
+EDHTTP_BENCHMARK(mime_type_large_text_prefix)
+{
+    edhttp::prewarm_mime_type();
+    std::span<char const> const data(g_text.data(), g_text.length());
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type(data, 4 * 1024));
+    }
+    state.set_bytes_processed(4 * 1024);
+    state.set_label("first 4Kb of 1Mb");
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,132 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the MIME type cache.
+ *
+ * The text buffer is not recognized by the sniffer so without the cache
+ * each call goes through libmagic.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/mime_type_cache.h>
+
+
+// C++
+//
+#include    <fstream>
+
+
+// C
+//
+#include    <unistd.h>
+
+
+
+namespace
+{
+
+
+
+std::string make_text()
+{
+    std::string text;
+    while(text.length() < 64 * 1024)
+    {
+        text += "The quick brown fox jumps over the lazy dog.\n";
+    }
+    return text;
+}
+
+
+std::string const g_text(make_text());
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(mime_type_cache_miss)
+{
+    std::span<char const> const data(g_text.data(), g_text.length());
+    edhttp::prewarm_mime_type();
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::get_mime_type(data));
+    }
+    state.set_bytes_processed(g_text.length());
+    state.set_label("no cache");
+}
+
+
+EDHTTP_BENCHMARK(mime_type_cache_buffer_hit)
+{
+    std::span<char const> const data(g_text.data(), g_text.length());
+    edhttp::mime_type_cache cache;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(cache.get_mime_type(data));
+    }
+    state.set_bytes_processed(g_text.length());
+    state.set_label("hit rate: " + std::to_string(cache.get_hit_rate()));
+}
+
+
+EDHTTP_BENCHMARK(mime_type_cache_file_hit)
+{
+    char filename[] = "/tmp/edhttp-bench-mime-XXXXXX";
+    int const fd(mkstemp(filename));
+    if(fd == -1)
+    {
+        return;
+    }
+    close(fd);
+    {
+        std::ofstream out(filename);
+        out << g_text;
+    }
+
+    edhttp::mime_type_cache cache;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(cache.get_file_mime_type(filename));
+    }
+    state.set_label("hit rate: " + std::to_string(cache.get_hit_rate()));
+    unlink(filename);
+}
+
+
+EDHTTP_BENCHMARK(mime_type_cache_hash_64kb)
+{
+    std::span<char const> const data(g_text.data(), g_text.length());
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::mime_type_cache::hash_prefix(data, 1));
+    }
+    state.set_bytes_processed(g_text.length());
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,189 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the multipart parser and builder.
+ *
+ * The upload is a 4Mb multipart/form-data body with one small text
+ * field and a large binary file. It is parsed in 64Kb buffers as it
+ * would be read from a socket.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/multipart.h>
+
+
+
+namespace
+{
+
+
+
+class counting_parser
+    : public edhttp::multipart_parser
+{
+public:
+    counting_parser(std::string_view boundary)
+        : multipart_parser(boundary)
+    {
+    }
+
+    std::size_t         f_bytes = 0;
+
+protected:
+    virtual void process_part_begin(edhttp::multipart_header_map_t const & headers) override
+    {
+        edhttp_benchmark::do_not_optimize(headers);
+    }
+
+    virtual void process_part_data(std::string_view data) override
+    {
+        f_bytes += data.length();
+    }
+
+    virtual void process_part_end() override
+    {
+    }
+};
+
+
+std::string make_file()
+{
+    std::string file;
+    file.reserve(4 * 1024 * 1024);
+    std::uint32_t seed(1);
+    while(file.length() < 4 * 1024 * 1024)
+    {
+        seed = seed * 1103515245 + 12345;
+        file += static_cast<char>(seed >> 16);
+    }
+    return file;
+}
+
+
+std::string const g_file(make_file());
+
+
+std::string make_upload(std::string const & boundary)
+{
+    edhttp::multipart_builder builder(boundary);
+    std::string upload;
+    builder.begin_part(
+              {{"Content-Disposition", "form-data; name=\"title\""}}
+            , edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE
+            , upload);
+    builder.write(std::string_view("My Holiday Pictures"), upload);
+    builder.begin_part(
+              {
+                  {"Content-Disposition", "form-data; name=\"file\"; filename=\"pictures.tar\""},
+                  {"Content-Type", "application/x-tar"},
+              }
+            , edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE
+            , upload);
+    builder.write(g_file, upload);
+    builder.finish(upload);
+    return upload;
+}
+
+
+std::string const g_boundary("----WebKitFormBoundary7MA4YWxkTrZu0gW");
+std::string const g_upload(make_upload(g_boundary));
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(multipart_parse_4mb)
+{
+    while(state.keep_running())
+    {
+        counting_parser parser(g_boundary);
+        for(std::size_t pos(0); pos < g_upload.length(); pos += 64 * 1024)
+        {
+            parser.feed(std::span<char const>(g_upload.data() + pos, std::min<std::size_t>(64 * 1024, g_upload.length() - pos)));
+        }
+        parser.finish();
+        edhttp_benchmark::do_not_optimize(parser.f_bytes);
+    }
+    state.set_bytes_processed(g_upload.length());
+}
+
+
+EDHTTP_BENCHMARK(multipart_build_base64_4mb)
+{
+    std::string out;
+    while(state.keep_running())
+    {
+        edhttp::multipart_builder builder(g_boundary);
+        out.clear();
+        builder.begin_part(
+                  {{"Content-Type", "application/octet-stream"}}
+                , edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_BASE64
+                , out);
+        for(std::size_t pos(0); pos < g_file.length(); pos += 64 * 1024)
+        {
+            builder.write(std::span<char const>(g_file.data() + pos, std::min<std::size_t>(64 * 1024, g_file.length() - pos)), out);
+
+            // simulate sending the data so memory use remains constant
+            //
+            edhttp_benchmark::do_not_optimize(out);
+            out.clear();
+        }
+        builder.finish(out);
+    }
+    state.set_bytes_processed(g_file.length());
+}
+
+
+EDHTTP_BENCHMARK(multipart_build_quoted_printable_4mb)
+{
+    std::string text;
+    while(text.length() < 4 * 1024 * 1024)
+    {
+        text += "The quick brown fox jumps over the lazy dog.\r\n";
+    }
+    std::string out;
+    while(state.keep_running())
+    {
+        edhttp::multipart_builder builder(g_boundary);
+        out.clear();
+        builder.begin_part(
+                  {{"Content-Type", "text/plain; charset=utf-8"}}
+                , edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE
+                , out);
+        for(std::size_t pos(0); pos < text.length(); pos += 64 * 1024)
+        {
+            builder.write(std::span<char const>(text.data() + pos, std::min<std::size_t>(64 * 1024, text.length() - pos)), out);
+            edhttp_benchmark::do_not_optimize(out);
+            out.clear();
+        }
+        builder.finish(out);
+    }
+    state.set_bytes_processed(text.length());
+}
+
+
+// vim: ts=4 sw=4 et
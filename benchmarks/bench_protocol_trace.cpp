@@ -0,0 +1,174 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the cost of the protocol traces.
+ *
+ * The benchmarks parse the same response as http_response does (status
+ * line, header fields and body) with the traces it emits. The
+ * snap_log benchmark uses SNAP_LOG_TRACE as the client used to, the
+ * disabled benchmark uses EDHTTP_TRACE() with the protocol traces
+ * turned off, and the none benchmark has no traces at all.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/protocol_trace.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <map>
+#include    <string>
+#include    <vector>
+
+
+
+namespace
+{
+
+
+
+enum class trace_t
+{
+    TRACE_NONE,
+    TRACE_SNAP_LOG,
+    TRACE_EDHTTP
+};
+
+
+#define BENCH_TRACE(message) \
+    if constexpr(T == trace_t::TRACE_SNAP_LOG) \
+    { \
+        SNAP_LOG_TRACE << message << SNAP_LOG_SEND; \
+    } \
+    else if constexpr(T == trace_t::TRACE_EDHTTP) \
+    { \
+        EDHTTP_TRACE(message); \
+    }
+
+
+std::vector<std::string> const g_response =
+{
+    "HTTP/1.1 200 OK",
+    "Date: Sun, 18 Oct 2026 12:49:49 GMT",
+    "Server: edhttp",
+    "Content-Type: text/html; charset=utf-8",
+    "Content-Length: 1024",
+    "Cache-Control: public, max-age=3600",
+    "ETag: \"5f3c-1a2b3c4d\"",
+    "Last-Modified: Sat, 17 Oct 2026 08:00:00 GMT",
+    "Vary: Accept-Encoding",
+    "Set-Cookie: session=abc123; Path=/; HttpOnly",
+    "Connection: keep-alive",
+};
+
+std::string const g_body(1024, 'x');
+
+
+template<trace_t T>
+std::size_t parse_response()
+{
+    BENCH_TRACE("*** read the protocol line");
+    std::string const & protocol(g_response[0]);
+    BENCH_TRACE("*** got protocol: " << protocol);
+    char const * p(protocol.c_str() + 9);
+    int response_code(0);
+    for(; *p >= '0' && *p <= '9'; ++p)
+    {
+        response_code = response_code * 10 + (*p - '0');
+    }
+    BENCH_TRACE("***   +---> code: " << response_code);
+    for(; *p == ' '; ++p);
+    BENCH_TRACE("***   +---> msg: " << p);
+
+    std::map<std::string, std::string> header;
+    for(std::size_t idx(1); idx < g_response.size(); ++idx)
+    {
+        std::string const & field(g_response[idx]);
+        BENCH_TRACE("got a header field: " << field);
+        std::string::size_type const colon(field.find(':'));
+        std::string name(field.substr(0, colon));
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        std::string::size_type const start(field.find_first_not_of(' ', colon + 1));
+        header[name] = field.substr(start);
+    }
+
+    BENCH_TRACE("reading " << g_body.length() << " bytes...");
+    std::string const body(g_body);
+    BENCH_TRACE("body [" << body << "]...");
+
+    return header.size() + body.length() + static_cast<std::size_t>(response_code);
+}
+
+
+std::size_t response_size()
+{
+    std::size_t size(g_body.length());
+    for(auto const & line : g_response)
+    {
+        size += line.length() + 2;
+    }
+    return size + 2;
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(protocol_trace_none)
+{
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(parse_response<trace_t::TRACE_NONE>());
+    }
+    state.set_bytes_processed(response_size());
+}
+
+
+EDHTTP_BENCHMARK(protocol_trace_snap_log)
+{
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(parse_response<trace_t::TRACE_SNAP_LOG>());
+    }
+    state.set_bytes_processed(response_size());
+}
+
+
+EDHTTP_BENCHMARK(protocol_trace_disabled)
+{
+    edhttp::set_protocol_trace(false);
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(parse_response<trace_t::TRACE_EDHTTP>());
+    }
+    state.set_bytes_processed(response_size());
+}
+
+
+
+// vim: ts=4 sw=4 et
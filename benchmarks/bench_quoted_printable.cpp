@@ -0,0 +1,116 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the quoted-printable codec.
+ *
+ * The text is mostly plain ASCII, as found in email bodies, with a few
+ * accented letters. The streaming benchmarks encode the same text in
+ * 4Kb chunks.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/quoted_printable.h>
+
+
+
+namespace
+{
+
+
+
+std::string make_text()
+{
+    std::string text;
+    while(text.length() < 1024 * 1024)
+    {
+        text += "The quick brown fox jumps over the lazy dog. Voil\xC3\xA0 un caf\xC3\xA9 =)\r\n";
+    }
+    return text;
+}
+
+
+std::string const g_text(make_text());
+std::string const g_encoded(edhttp::quoted_printable_encode(g_text));
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(quoted_printable_encode_1mb)
+{
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::quoted_printable_encode(g_text));
+    }
+    state.set_bytes_processed(g_text.length());
+}
+
+
+EDHTTP_BENCHMARK(quoted_printable_encode_streaming_1mb)
+{
+    edhttp::quoted_printable_encoder encoder;
+    std::string out;
+    while(state.keep_running())
+    {
+        for(std::size_t pos(0); pos < g_text.length(); pos += 4096)
+        {
+            out.clear();
+            encoder.encode(std::span<char const>(g_text.data() + pos, std::min<std::size_t>(4096, g_text.length() - pos)), out);
+            edhttp_benchmark::do_not_optimize(out);
+        }
+        encoder.finish(out);
+    }
+    state.set_bytes_processed(g_text.length());
+}
+
+
+EDHTTP_BENCHMARK(quoted_printable_encode_binary_64kb)
+{
+    std::string data;
+    for(std::size_t idx(0); idx < 64 * 1024; ++idx)
+    {
+        data += static_cast<char>(idx * 37);
+    }
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::quoted_printable_encode(data, edhttp::QUOTED_PRINTABLE_FLAG_BINARY));
+    }
+    state.set_bytes_processed(data.length());
+}
+
+
+EDHTTP_BENCHMARK(quoted_printable_decode_1mb)
+{
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(edhttp::quoted_printable_decode(g_encoded));
+    }
+    state.set_bytes_processed(g_encoded.length());
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,124 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the session cookie codec.
+ *
+ * The payload is a typical session: an identifier, a user and a few
+ * flags, about 64 bytes.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/session_cookie.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_secret("0123456789abcdef0123456789abcdef");
+std::string const g_payload("sid=3f9a1c2e7b4d8a6f0e1d2c3b4a596877;uid=1234567;roles=editor,author");
+
+
+edhttp::session_cookie & get_codec(edhttp::session_cookie::algorithm_t algorithm)
+{
+    static edhttp::session_cookie hmac(edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256);
+    static edhttp::session_cookie gcm(edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM);
+    edhttp::session_cookie & codec(algorithm == edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256 ? hmac : gcm);
+    if(!codec.has_key(1))
+    {
+        codec.add_key(1, g_secret);
+    }
+    return codec;
+}
+
+
+void decode(edhttp_benchmark::state & state, edhttp::session_cookie::algorithm_t algorithm)
+{
+    edhttp::session_cookie const & codec(get_codec(algorithm));
+    std::string const value(codec.encode(g_payload));
+    std::string payload;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(codec.decode(value, payload));
+    }
+    state.set_bytes_processed(value.length());
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(session_cookie_hmac_encode)
+{
+    edhttp::session_cookie const & codec(get_codec(edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256));
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(codec.encode(g_payload));
+    }
+    state.set_bytes_processed(g_payload.length());
+}
+
+
+EDHTTP_BENCHMARK(session_cookie_hmac_decode)
+{
+    decode(state, edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256);
+}
+
+
+EDHTTP_BENCHMARK(session_cookie_gcm_encode)
+{
+    edhttp::session_cookie const & codec(get_codec(edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM));
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(codec.encode(g_payload));
+    }
+    state.set_bytes_processed(g_payload.length());
+}
+
+
+EDHTTP_BENCHMARK(session_cookie_gcm_decode)
+{
+    decode(state, edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM);
+}
+
+
+EDHTTP_BENCHMARK(session_cookie_cache_hit)
+{
+    edhttp::session_cookie const & codec(get_codec(edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256));
+    std::string const value(codec.encode(g_payload));
+    edhttp::session_cookie_cache cache;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(cache.decode(codec, value));
+    }
+    state.set_label("hits: " + std::to_string(cache.get_hits()));
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Benchmark the token, field value, and path scanners.
+ *
+ * Each scanner is measured with the scalar kernel and with the best
+ * SIMD kernel available on this computer.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/token.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_header_name("Access-Control-Allow-Credentials");
+
+std::string const g_field_value(
+        "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36"
+        " (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36");
+
+std::string const g_path(
+        "/api/v2/projects/edhttp/files/edhttp%2Fhttp_client_server.cpp/raw;ref=main");
+
+
+template<typename F>
+void run_scan(edhttp_benchmark::state & state, std::string const & input, edhttp::simd_level_t level, F scan)
+{
+    edhttp::simd_level_t const saved(edhttp::set_simd_level(level));
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(scan(input));
+    }
+    edhttp::set_simd_level(saved);
+    state.set_bytes_processed(input.length());
+}
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(token_scan_scalar)
+{
+    run_scan(state, g_header_name, edhttp::simd_level_t::SIMD_LEVEL_SCALAR, edhttp::scan_token);
+}
+
+
+EDHTTP_BENCHMARK(token_scan_simd)
+{
+    run_scan(state, g_header_name, edhttp::simd_level_t::SIMD_LEVEL_AVX2, edhttp::scan_token);
+}
+
+
+EDHTTP_BENCHMARK(token_is_token)
+{
+    run_scan(state, g_header_name, edhttp::simd_level_t::SIMD_LEVEL_AVX2, edhttp::is_token);
+}
+
+
+EDHTTP_BENCHMARK(token_field_value_scalar)
+{
+    run_scan(state, g_field_value, edhttp::simd_level_t::SIMD_LEVEL_SCALAR, edhttp::scan_field_value);
+}
+
+
+EDHTTP_BENCHMARK(token_field_value_simd)
+{
+    run_scan(state, g_field_value, edhttp::simd_level_t::SIMD_LEVEL_AVX2, edhttp::scan_field_value);
+}
+
+
+EDHTTP_BENCHMARK(token_path_scalar)
+{
+    run_scan(state, g_path, edhttp::simd_level_t::SIMD_LEVEL_SCALAR, edhttp::scan_path);
+}
+
+
+EDHTTP_BENCHMARK(token_path_simd)
+{
+    run_scan(state, g_path, edhttp::simd_level_t::SIMD_LEVEL_AVX2, edhttp::scan_path);
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,85 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+/** \file
+ * \brief Benchmark the parsing of weighted HTTP strings.
+ *
+ * The inputs are typical Accept-Language and Accept-Encoding fields
+ * sent by browsers.
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/weighted_http_string.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_accept_language("fr-CA,fr;q=0.9,en-US;q=0.8,en;q=0.7,de;q=0.5");
+std::string const g_accept_language_long("en-US,en;q=0.95,fr-CA;q=0.9,fr;q=0.85,es-MX;q=0.8,es;q=0.75,de-DE;q=0.7,de;q=0.65,it;q=0.6,pt-BR;q=0.55,ja;q=0.5,zh-CN;q=0.45,*;q=0.1");
+std::string const g_accept_encoding("gzip, deflate, br, zstd");
+
+
+
+} // no name namespace
+
+
+
+EDHTTP_BENCHMARK(weighted_http_string_accept_language)
+{
+    edhttp::weighted_http_string w;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(w.parse(g_accept_language, true));
+    }
+    state.set_bytes_processed(g_accept_language.length());
+}
+
+
+EDHTTP_BENCHMARK(weighted_http_string_accept_language_long)
+{
+    edhttp::weighted_http_string w;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(w.parse(g_accept_language_long, true));
+    }
+    state.set_bytes_processed(g_accept_language_long.length());
+}
+
+
+EDHTTP_BENCHMARK(weighted_http_string_accept_encoding)
+{
+    edhttp::weighted_http_string w;
+    while(state.keep_running())
+    {
+        edhttp_benchmark::do_not_optimize(w.parse(g_accept_encoding, true));
+    }
+    state.set_bytes_processed(g_accept_encoding.length());
+}
+
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,101 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Minimal benchmark harness.
+ *
+ * Each benchmark is a function receiving a state object. The function
+ * runs its loop while state::keep_running() returns true. The harness
+ * calibrates the number of iterations so each benchmark runs for at
+ * least the minimum time and then reports the results in JSON.
+ *
+ * \code
+ *     EDHTTP_BENCHMARK(my_benchmark)
+ *     {
+ *         std::string const input("...");
+ *         while(state.keep_running())
+ *         {
+ *             edhttp_benchmark::do_not_optimize(function_to_measure(input));
+ *         }
+ *         state.set_bytes_processed(input.length());
+ *     }
+ * \endcode
+ */
+
+// C++
+//
+#include    <cstdint>
+#include    <functional>
+#include    <string>
+
+
+
+namespace edhttp_benchmark
+{
+
+
+
+class state
+{
+public:
+                        state(std::size_t iterations);
+
+    bool                keep_running();
+    std::size_t         get_iterations() const;
+
+    void                set_bytes_processed(std::size_t bytes_per_iteration);
+    std::size_t         get_bytes_processed() const;
+    void                set_label(std::string const & label);
+    std::string const & get_label() const;
+
+private:
+    std::size_t         f_iterations = 0;
+    std::size_t         f_remaining = 0;
+    std::size_t         f_bytes_processed = 0;
+    std::string         f_label = std::string();
+};
+
+
+typedef std::function<void(state &)>    benchmark_func_t;
+
+
+class registrar
+{
+public:
+                        registrar(char const * name, benchmark_func_t func);
+};
+
+
+template<typename T>
+inline void do_not_optimize(T const & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+
+} // namespace edhttp_benchmark
+
+
+#define EDHTTP_BENCHMARK(name) \
+    static void benchmark_##name(::edhttp_benchmark::state & state); \
+    static ::edhttp_benchmark::registrar const g_registrar_##name(#name, benchmark_##name); \
+    static void benchmark_##name(::edhttp_benchmark::state & state)
+
+// vim: ts=4 sw=4 et
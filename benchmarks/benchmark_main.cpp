@@ -0,0 +1,290 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Run the edhttp benchmarks and print the results in JSON.
+ *
+ * Usage:
+ *
+ * \code
+ *     edhttp-benchmarks [--filter <name>] [--min-time <seconds>] [--list]
+ * \endcode
+ *
+ * The --filter option only runs the benchmarks which name includes
+ * the specified string. The --min-time option defines the minimum
+ * amount of time each benchmark runs (0.25 seconds by default).
+ */
+
+// self
+//
+#include    "benchmark.h"
+
+
+// edhttp
+//
+#include    <edhttp/version.h>
+
+
+// C++
+//
+#include    <chrono>
+#include    <cstring>
+#include    <ctime>
+#include    <iomanip>
+#include    <iostream>
+#include    <sstream>
+#include    <vector>
+
+
+
+namespace edhttp_benchmark
+{
+
+
+namespace
+{
+
+
+
+struct benchmark_t
+{
+    std::string         f_name = std::string();
+    benchmark_func_t    f_func = benchmark_func_t();
+};
+
+
+std::vector<benchmark_t> & get_benchmarks()
+{
+    static std::vector<benchmark_t> g_benchmarks;
+    return g_benchmarks;
+}
+
+
+std::string json_string(std::string const & s)
+{
+    std::stringstream out;
+    out << '"';
+    for(auto const c : s)
+    {
+        switch(c)
+        {
+        case '"':
+            out << "\\\"";
+            break;
+
+        case '\\':
+            out << "\\\\";
+            break;
+
+        default:
+            if(static_cast<unsigned char>(c) < 0x20)
+            {
+                out << "\\u"
+                    << std::hex << std::setw(4) << std::setfill('0')
+                    << static_cast<int>(c)
+                    << std::dec;
+            }
+            else
+            {
+                out << c;
+            }
+            break;
+
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+
+
+} // no name namespace
+
+
+
+state::state(std::size_t iterations)
+    : f_iterations(iterations)
+    , f_remaining(iterations)
+{
+}
+
+
+bool state::keep_running()
+{
+    if(f_remaining == 0)
+    {
+        return false;
+    }
+    --f_remaining;
+    return true;
+}
+
+
+std::size_t state::get_iterations() const
+{
+    return f_iterations;
+}
+
+
+void state::set_bytes_processed(std::size_t bytes_per_iteration)
+{
+    f_bytes_processed = bytes_per_iteration;
+}
+
+
+std::size_t state::get_bytes_processed() const
+{
+    return f_bytes_processed;
+}
+
+
+void state::set_label(std::string const & label)
+{
+    f_label = label;
+}
+
+
+std::string const & state::get_label() const
+{
+    return f_label;
+}
+
+
+registrar::registrar(char const * name, benchmark_func_t func)
+{
+    get_benchmarks().push_back({ name, func });
+}
+
+
+
+} // namespace edhttp_benchmark
+
+
+
+int main(int argc, char * argv[])
+{
+    std::string filter;
+    double min_time(0.25);
+    bool list(false);
+    for(int i(1); i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            ++i;
+            filter = argv[i];
+        }
+        else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            ++i;
+            min_time = std::stod(argv[i]);
+        }
+        else if(strcmp(argv[i], "--list") == 0)
+        {
+            list = true;
+        }
+        else
+        {
+            std::cerr
+                << "Usage: "
+                << argv[0]
+                << " [--filter <name>] [--min-time <seconds>] [--list]\n";
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if(list)
+    {
+        for(auto const & b : edhttp_benchmark::get_benchmarks())
+        {
+            std::cout << b.f_name << '\n';
+        }
+        return 0;
+    }
+
+    std::cout
+        << "{\n"
+        << "  \"context\": {\n"
+        << "    \"library\": \"edhttp\",\n"
+        << "    \"version\": " << edhttp_benchmark::json_string(edhttp::get_version_string()) << ",\n"
+        << "    \"date\": " << time(nullptr) << ",\n"
+        << "    \"min_time\": " << min_time << "\n"
+        << "  },\n"
+        << "  \"benchmarks\": [";
+
+    char const * separator("\n");
+    for(auto const & b : edhttp_benchmark::get_benchmarks())
+    {
+        if(!filter.empty()
+        && b.f_name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        // double the number of iterations until the minimum time is reached
+        //
+        std::size_t iterations(1);
+        double seconds(0.0);
+        std::size_t bytes(0);
+        std::string label;
+        for(;;)
+        {
+            edhttp_benchmark::state s(iterations);
+            auto const start(std::chrono::steady_clock::now());
+            b.f_func(s);
+            auto const end(std::chrono::steady_clock::now());
+            seconds = std::chrono::duration<double>(end - start).count();
+            bytes = s.get_bytes_processed();
+            label = s.get_label();
+            if(seconds >= min_time
+            || iterations >= 1'000'000'000)
+            {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        double const ns_per_op(seconds * 1e9 / static_cast<double>(iterations));
+        std::cout
+            << separator
+            << "    {\n"
+            << "      \"name\": " << edhttp_benchmark::json_string(b.f_name) << ",\n"
+            << "      \"iterations\": " << iterations << ",\n"
+            << "      \"real_time\": " << seconds << ",\n"
+            << "      \"ns_per_op\": " << ns_per_op;
+        if(bytes != 0)
+        {
+            std::cout
+                << ",\n      \"bytes_per_second\": "
+                << static_cast<double>(bytes) * static_cast<double>(iterations) / seconds;
+        }
+        if(!label.empty())
+        {
+            std::cout
+                << ",\n      \"label\": " << edhttp_benchmark::json_string(label);
+        }
+        std::cout << "\n    }";
+        separator = ",\n";
+    }
+
+    std::cout << "\n  ]\n}\n";
+
+    return 0;
+}
+
+
+// vim: ts=4 sw=4 et
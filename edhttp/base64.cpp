@@ -0,0 +1,959 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Base64 encoder and decoder.
+ *
+ * This file implements the base64 encoding as defined in RFC 4648 with
+ * the standard and URL safe alphabets. The data can be encoded and
+ * decoded at once or in chunks with the base64_encoder and
+ * base64_decoder classes.
+ *
+ * When available, the bulk of the data is processed 12 or 24 input bytes
+ * at a time (encoding) and 16 or 32 characters at a time (decoding) with
+ * SSSE3 and AVX2 kernels (Muła & Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions"). The kernel in use follows the
+ * get_simd_level() setting.
+ */
+
+// self
+//
+#include    "edhttp/base64.h"
+
+#include    "edhttp/exception.h"
+#include    "edhttp/token.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cstring>
+
+
+// C
+//
+#if defined(__x86_64__) || defined(__i386__)
+#define EDHTTP_X86_SIMD
+#include    <immintrin.h>
+#endif
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+namespace
+{
+
+
+
+struct alphabet_tables_t
+{
+    char                f_characters[64] = {};
+    std::int8_t         f_values[256] = {};
+    char                f_char63 = '\0';
+
+    // SIMD lookup tables
+    //
+    std::int8_t         f_encode_shift[16] = {};
+    std::uint8_t        f_decode_lo[16] = {};
+    std::uint8_t        f_decode_hi[16] = {};
+    std::int8_t         f_decode_roll[16] = {};
+};
+
+
+/** \brief Compute the tables used to encode and decode one alphabet.
+ *
+ * The decoding validation works with two tables indexed by the low and
+ * high nibbles of each character: the high nibble gives a class bit and
+ * the low nibble table has that bit set when the character is not part
+ * of the alphabet. The roll table, indexed by the high nibble, gives the
+ * value to add to a character to get its 6 bit value. Character 63 may
+ * share its high nibble with letters so it uses entry `hi | 8` instead.
+ *
+ * Any inconsistency throws, which stops the compilation since the tables
+ * are constexpr.
+ *
+ * \param[in] characters  The 64 characters of the alphabet.
+ *
+ * \return The tables.
+ */
+constexpr alphabet_tables_t make_tables(char const * characters)
+{
+    alphabet_tables_t t;
+    for(auto & v : t.f_values)
+    {
+        v = -1;
+    }
+    for(int idx(0); idx < 64; ++idx)
+    {
+        t.f_characters[idx] = characters[idx];
+        t.f_values[static_cast<std::uint8_t>(characters[idx])] = static_cast<std::int8_t>(idx);
+    }
+    t.f_char63 = characters[63];
+
+    t.f_encode_shift[0] = static_cast<std::int8_t>('a' - 26);
+    for(int idx(1); idx <= 10; ++idx)
+    {
+        t.f_encode_shift[idx] = static_cast<std::int8_t>('0' - 52);
+    }
+    t.f_encode_shift[11] = static_cast<std::int8_t>(characters[62] - 62);
+    t.f_encode_shift[12] = static_cast<std::int8_t>(characters[63] - 63);
+    t.f_encode_shift[13] = static_cast<std::int8_t>('A');
+
+    std::uint16_t valid[16] = {};
+    for(int idx(0); idx < 64; ++idx)
+    {
+        std::uint8_t const c(static_cast<std::uint8_t>(characters[idx]));
+        valid[c >> 4] = static_cast<std::uint16_t>(valid[c >> 4] | (1 << (c & 15)));
+
+        int roll(c >> 4);
+        if(idx == 63)
+        {
+            roll |= 8;
+        }
+        std::int8_t const offset(static_cast<std::int8_t>(idx - c));
+        if(t.f_decode_roll[roll] != 0 && t.f_decode_roll[roll] != offset)
+        {
+            throw logic_error("base64 alphabet incompatible with the SIMD decoder.");
+        }
+        t.f_decode_roll[roll] = offset;
+    }
+
+    std::uint16_t classes[8] = {};
+    int class_count(0);
+    for(int hi(0); hi < 16; ++hi)
+    {
+        int found(0);
+        while(found < class_count && classes[found] != valid[hi])
+        {
+            ++found;
+        }
+        if(found == class_count)
+        {
+            if(class_count == 8)
+            {
+                throw logic_error("base64 alphabet incompatible with the SIMD decoder.");
+            }
+            classes[class_count] = valid[hi];
+            ++class_count;
+        }
+        t.f_decode_hi[hi] = static_cast<std::uint8_t>(1 << found);
+    }
+    for(int lo(0); lo < 16; ++lo)
+    {
+        for(int k(0); k < class_count; ++k)
+        {
+            if((classes[k] & (1 << lo)) == 0)
+            {
+                t.f_decode_lo[lo] = static_cast<std::uint8_t>(t.f_decode_lo[lo] | (1 << k));
+            }
+        }
+    }
+
+    return t;
+}
+
+
+constexpr alphabet_tables_t const g_standard_tables(make_tables(
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"));
+
+constexpr alphabet_tables_t const g_url_tables(make_tables(
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"));
+
+
+alphabet_tables_t const & get_tables(base64_alphabet_t alphabet)
+{
+    return alphabet == base64_alphabet_t::BASE64_ALPHABET_URL
+                ? g_url_tables
+                : g_standard_tables;
+}
+
+
+
+#ifdef EDHTTP_X86_SIMD
+__attribute__((target("ssse3")))
+inline __m128i encode_indices_ssse3(__m128i in)
+{
+    __m128i const t0(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)));
+    __m128i const t1(_mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040)));
+    __m128i const t2(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)));
+    __m128i const t3(_mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010)));
+    return _mm_or_si128(t1, t3);
+}
+
+
+__attribute__((target("ssse3")))
+inline __m128i encode_lookup_ssse3(__m128i indices, __m128i shift)
+{
+    __m128i reduced(_mm_subs_epu8(indices, _mm_set1_epi8(51)));
+    __m128i const less(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices));
+    reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shift, reduced), indices);
+}
+
+
+__attribute__((target("ssse3")))
+std::size_t encode_ssse3(
+      std::uint8_t const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables)
+{
+    __m128i const shift(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_encode_shift)));
+    __m128i const shuffle(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+    // the load reads 16 bytes and uses 12
+    //
+    std::size_t pos(0);
+    for(; pos + 16 <= size; pos += 12, d += 16)
+    {
+        __m128i const in(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)), shuffle));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d), encode_lookup_ssse3(encode_indices_ssse3(in), shift));
+    }
+    return pos;
+}
+
+
+__attribute__((target("avx2")))
+std::size_t encode_avx2(
+      std::uint8_t const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables)
+{
+    __m256i const shift(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_encode_shift))));
+    __m256i const shuffle(_mm256_setr_epi8(
+              1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+            , 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+    // each lane loads 16 bytes and uses 12
+    //
+    std::size_t pos(0);
+    for(; pos + 28 <= size; pos += 24, d += 32)
+    {
+        __m256i in(_mm256_inserti128_si256(
+                  _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)))
+                , _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos + 12))
+                , 1));
+        in = _mm256_shuffle_epi8(in, shuffle);
+
+        __m256i const t0(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)));
+        __m256i const t1(_mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040)));
+        __m256i const t2(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)));
+        __m256i const t3(_mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010)));
+        __m256i const indices(_mm256_or_si256(t1, t3));
+
+        __m256i reduced(_mm256_subs_epu8(indices, _mm256_set1_epi8(51)));
+        __m256i const less(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices));
+        reduced = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        _mm256_storeu_si256(
+                  reinterpret_cast<__m256i *>(d)
+                , _mm256_add_epi8(_mm256_shuffle_epi8(shift, reduced), indices));
+    }
+    return pos;
+}
+
+
+/** \brief Decode blocks of 16 characters.
+ *
+ * The function stops at the first block which includes a character
+ * outside of the alphabet (including padding) and lets the scalar code
+ * handle it.
+ *
+ * Each block writes 16 bytes of which 12 are valid so the output buffer
+ * must have 4 extra bytes.
+ *
+ * \return The number of characters decoded, a multiple of 16.
+ */
+__attribute__((target("ssse3")))
+std::size_t decode_ssse3(
+      char const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables)
+{
+    __m128i const lut_lo(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_lo)));
+    __m128i const lut_hi(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_hi)));
+    __m128i const lut_roll(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_roll)));
+    __m128i const nibble(_mm_set1_epi8(0x0F));
+    __m128i const char63(_mm_set1_epi8(tables.f_char63));
+    __m128i const eight(_mm_set1_epi8(8));
+    __m128i const zero(_mm_setzero_si128());
+    __m128i const pack(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    std::size_t pos(0);
+    for(; pos + 16 <= size; pos += 16, d += 12)
+    {
+        __m128i const in(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)));
+        __m128i const hi(_mm_and_si128(_mm_srli_epi32(in, 4), nibble));
+        __m128i const lo(_mm_and_si128(in, nibble));
+        __m128i const invalid(_mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, zero)) != 0xFFFF)
+        {
+            break;
+        }
+        __m128i const roll(_mm_shuffle_epi8(
+                  lut_roll
+                , _mm_or_si128(hi, _mm_and_si128(_mm_cmpeq_epi8(in, char63), eight))));
+        __m128i const values(_mm_add_epi8(in, roll));
+        __m128i const merged(_mm_madd_epi16(
+                  _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140))
+                , _mm_set1_epi32(0x00011000)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_shuffle_epi8(merged, pack));
+    }
+    return pos;
+}
+
+
+/** \brief Decode blocks of 32 characters.
+ *
+ * Each block writes 32 bytes of which 24 are valid so the output buffer
+ * must have 8 extra bytes.
+ *
+ * \return The number of characters decoded, a multiple of 32.
+ */
+__attribute__((target("avx2")))
+std::size_t decode_avx2(
+      char const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables)
+{
+    __m256i const lut_lo(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_lo))));
+    __m256i const lut_hi(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_hi))));
+    __m256i const lut_roll(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(tables.f_decode_roll))));
+    __m256i const nibble(_mm256_set1_epi8(0x0F));
+    __m256i const char63(_mm256_set1_epi8(tables.f_char63));
+    __m256i const eight(_mm256_set1_epi8(8));
+    __m256i const zero(_mm256_setzero_si256());
+    __m256i const pack(_mm256_setr_epi8(
+              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+            , 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    __m256i const lanes(_mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+    std::size_t pos(0);
+    for(; pos + 32 <= size; pos += 32, d += 24)
+    {
+        __m256i const in(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + pos)));
+        __m256i const hi(_mm256_and_si256(_mm256_srli_epi32(in, 4), nibble));
+        __m256i const lo(_mm256_and_si256(in, nibble));
+        __m256i const invalid(_mm256_and_si256(_mm256_shuffle_epi8(lut_lo, lo), _mm256_shuffle_epi8(lut_hi, hi)));
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(invalid, zero)) != -1)
+        {
+            break;
+        }
+        __m256i const roll(_mm256_shuffle_epi8(
+                  lut_roll
+                , _mm256_or_si256(hi, _mm256_and_si256(_mm256_cmpeq_epi8(in, char63), eight))));
+        __m256i const values(_mm256_add_epi8(in, roll));
+        __m256i const merged(_mm256_madd_epi16(
+                  _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140))
+                , _mm256_set1_epi32(0x00011000)));
+        _mm256_storeu_si256(
+                  reinterpret_cast<__m256i *>(d)
+                , _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack), lanes));
+    }
+    return pos;
+}
+#endif
+
+
+/** \brief Encode complete groups of 3 bytes.
+ *
+ * \param[in] s  The bytes to encode.
+ * \param[in] size  The number of bytes, a multiple of 3.
+ * \param[out] d  The output buffer, which receives size / 3 * 4
+ * characters.
+ * \param[in] tables  The alphabet tables.
+ */
+void encode_groups(
+      std::uint8_t const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables)
+{
+    std::size_t pos(0);
+#ifdef EDHTTP_X86_SIMD
+    switch(get_simd_level())
+    {
+    case simd_level_t::SIMD_LEVEL_AVX2:
+        pos = encode_avx2(s, size, d, tables);
+        [[fallthrough]];
+    case simd_level_t::SIMD_LEVEL_SSSE3:
+        pos += encode_ssse3(s + pos, size - pos, d + pos / 3 * 4, tables);
+        d += pos / 3 * 4;
+        break;
+
+    case simd_level_t::SIMD_LEVEL_SCALAR:
+        break;
+
+    }
+#endif
+    for(; pos < size; pos += 3, d += 4)
+    {
+        std::uint32_t const v((s[pos] << 16) | (s[pos + 1] << 8) | s[pos + 2]);
+        d[0] = tables.f_characters[(v >> 18) & 0x3F];
+        d[1] = tables.f_characters[(v >> 12) & 0x3F];
+        d[2] = tables.f_characters[(v >>  6) & 0x3F];
+        d[3] = tables.f_characters[(v >>  0) & 0x3F];
+    }
+}
+
+
+/** \brief Encode the last 1 or 2 bytes.
+ *
+ * \return The number of characters written to \p d.
+ */
+std::size_t encode_tail(
+      std::uint8_t const * s
+    , std::size_t size
+    , char * d
+    , alphabet_tables_t const & tables
+    , int flags)
+{
+    std::uint32_t const v((s[0] << 16) | (size == 2 ? s[1] << 8 : 0));
+    d[0] = tables.f_characters[(v >> 18) & 0x3F];
+    d[1] = tables.f_characters[(v >> 12) & 0x3F];
+    std::size_t length(2);
+    if(size == 2)
+    {
+        d[2] = tables.f_characters[(v >> 6) & 0x3F];
+        length = 3;
+    }
+    if((flags & BASE64_FLAG_NO_PADDING) == 0)
+    {
+        for(; length < 4; ++length)
+        {
+            d[length] = '=';
+        }
+    }
+    return length;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Compute the size of the encoded data.
+ *
+ * \param[in] size  The number of bytes to encode.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING flag changes the result.
+ *
+ * \return The number of characters base64_encode() generates for
+ * \p size bytes (without line breaks).
+ */
+std::size_t base64_encoded_size(std::size_t size, int flags)
+{
+    if((flags & BASE64_FLAG_NO_PADDING) != 0)
+    {
+        return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+    }
+    return (size + 2) / 3 * 4;
+}
+
+
+/** \brief Encode data in base64.
+ *
+ * This function encodes \p data and appends the result to \p out.
+ * The output is not broken in lines; use the base64_encoder for that.
+ *
+ * \param[in] data  The bytes to encode; it may include NUL characters.
+ * \param[in,out] out  The string where the encoded data gets appended.
+ * \param[in] alphabet  The alphabet to use.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING flag or 0.
+ */
+void base64_encode(
+      std::string_view data
+    , std::string & out
+    , base64_alphabet_t alphabet
+    , int flags)
+{
+    alphabet_tables_t const & tables(get_tables(alphabet));
+    std::uint8_t const * s(reinterpret_cast<std::uint8_t const *>(data.data()));
+    std::size_t const groups(data.length() / 3 * 3);
+
+    std::size_t const start(out.length());
+    out.resize(start + base64_encoded_size(data.length(), 0));
+    char * d(out.data() + start);
+    encode_groups(s, groups, d, tables);
+    d += groups / 3 * 4;
+    if(groups < data.length())
+    {
+        d += encode_tail(s + groups, data.length() - groups, d, tables, flags);
+    }
+    out.resize(static_cast<std::size_t>(d - out.data()));
+}
+
+
+/** \brief Encode data in base64.
+ *
+ * \param[in] data  The bytes to encode; it may include NUL characters.
+ * \param[in] alphabet  The alphabet to use.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING flag or 0.
+ *
+ * \return The encoded data.
+ */
+std::string base64_encode(
+      std::string_view data
+    , base64_alphabet_t alphabet
+    , int flags)
+{
+    std::string result;
+    base64_encode(data, result, alphabet, flags);
+    return result;
+}
+
+
+/** \brief Decode base64 data.
+ *
+ * This function decodes \p data and appends the result to \p out.
+ *
+ * By default, the function fails on characters which are not part of
+ * the alphabet. The padding is optional, but if present it must be
+ * complete and nothing can follow it. With the BASE64_FLAG_NO_PADDING
+ * flag, the padding is refused. With the BASE64_FLAG_IGNORE_INVALID
+ * flag, all the characters outside of the alphabet, including the '='
+ * and line breaks, are ignored.
+ *
+ * \param[in] data  The data to decode.
+ * \param[in,out] out  The string where the decoded bytes get appended.
+ * \param[in] alphabet  The alphabet to use.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING and
+ * BASE64_FLAG_IGNORE_INVALID flags or 0.
+ *
+ * \return true if \p data was valid; on false the content of \p out is
+ * undefined.
+ */
+bool base64_decode(
+      std::string_view data
+    , std::string & out
+    , base64_alphabet_t alphabet
+    , int flags)
+{
+    base64_decoder decoder(alphabet, flags);
+    return decoder.decode(data, out)
+        && decoder.finish(out);
+}
+
+
+/** \brief Get the value of one base64 character.
+ *
+ * \param[in] c  The character to convert.
+ * \param[in] alphabet  The alphabet to use.
+ *
+ * \return The value of \p c (0 to 63) or -1 if \p c is not part of
+ * the alphabet.
+ */
+int base64_value(char c, base64_alphabet_t alphabet)
+{
+    return get_tables(alphabet).f_values[static_cast<std::uint8_t>(c)];
+}
+
+
+
+/** \class base64_encoder
+ * \brief Streaming base64 encoder.
+ *
+ * The encoder accepts its input in chunks of any size. Up to 2 bytes
+ * are kept between calls so the output does not depend on the chunk
+ * boundaries. Call finish() to write those last bytes and the padding.
+ *
+ * When \p line_length is not zero, a CRLF is inserted every
+ * \p line_length characters, as required by MIME (76 characters).
+ */
+
+
+/** \brief Initialize the encoder.
+ *
+ * \exception invalid_parameter
+ * The line length must be a multiple of 4.
+ *
+ * \param[in] alphabet  The alphabet to use.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING flag or 0.
+ * \param[in] line_length  The maximum length of a line or 0.
+ */
+base64_encoder::base64_encoder(
+          base64_alphabet_t alphabet
+        , int flags
+        , std::size_t line_length)
+    : f_alphabet(alphabet)
+    , f_flags(flags)
+    , f_line_length(line_length)
+{
+    if(f_line_length % 4 != 0)
+    {
+        throw invalid_parameter(
+                  "the base64 line length ("
+                + std::to_string(line_length)
+                + ") must be a multiple of 4.");
+    }
+}
+
+
+/** \brief Encode one chunk of data.
+ *
+ * \param[in] data  The bytes to encode.
+ * \param[in,out] out  The string where the encoded data gets appended.
+ */
+void base64_encoder::encode(std::span<char const> data, std::string & out)
+{
+    std::uint8_t const * s(reinterpret_cast<std::uint8_t const *>(data.data()));
+    std::size_t size(data.size());
+
+    std::uint8_t group[3];
+    std::size_t group_size(0);
+    if(f_carry_size > 0)
+    {
+        if(f_carry_size + size < 3)
+        {
+            for(; size > 0; ++s, --size, ++f_carry_size)
+            {
+                f_carry[f_carry_size] = *s;
+            }
+            return;
+        }
+        std::memcpy(group, f_carry, f_carry_size);
+        std::memcpy(group + f_carry_size, s, 3 - f_carry_size);
+        s += 3 - f_carry_size;
+        size -= 3 - f_carry_size;
+        f_carry_size = 0;
+        group_size = 3;
+    }
+
+    std::size_t const groups(size / 3 * 3);
+    std::size_t const chars((group_size + groups) / 3 * 4);
+    std::size_t const max_breaks(f_line_length == 0 ? 0 : chars / f_line_length + 1);
+    std::size_t const start(out.length());
+    out.resize(start + chars + max_breaks * 2);
+    char * d(out.data() + start);
+
+    alphabet_tables_t const & tables(get_tables(f_alphabet));
+    if(f_line_length == 0)
+    {
+        if(group_size != 0)
+        {
+            encode_groups(group, 3, d, tables);
+            d += 4;
+        }
+        encode_groups(s, groups, d, tables);
+        d += groups / 3 * 4;
+    }
+    else
+    {
+        auto line_break = [&]()
+        {
+            if(f_line >= f_line_length)
+            {
+                d[0] = '\r';
+                d[1] = '\n';
+                d += 2;
+                f_line = 0;
+            }
+        };
+        if(group_size != 0)
+        {
+            line_break();
+            encode_groups(group, 3, d, tables);
+            d += 4;
+            f_line += 4;
+        }
+        std::size_t pos(0);
+        while(pos < groups)
+        {
+            line_break();
+            std::size_t const count(std::min((f_line_length - f_line) / 4 * 3, groups - pos));
+            encode_groups(s + pos, count, d, tables);
+            d += count / 3 * 4;
+            f_line += count / 3 * 4;
+            pos += count;
+        }
+    }
+    out.resize(static_cast<std::size_t>(d - out.data()));
+
+    for(std::size_t idx(groups); idx < size; ++idx, ++f_carry_size)
+    {
+        f_carry[f_carry_size] = s[idx];
+    }
+}
+
+
+/** \brief Terminate the encoding.
+ *
+ * This function writes the last 1 or 2 bytes, if any, and the padding.
+ * The encoder is then reset so it can be reused.
+ *
+ * \param[in,out] out  The string where the encoded data gets appended.
+ */
+void base64_encoder::finish(std::string & out)
+{
+    if(f_carry_size > 0)
+    {
+        if(f_line_length != 0 && f_line >= f_line_length)
+        {
+            out += "\r\n";
+        }
+        char tail[4];
+        std::size_t const length(encode_tail(f_carry, f_carry_size, tail, get_tables(f_alphabet), f_flags));
+        out.append(tail, length);
+    }
+    reset();
+}
+
+
+/** \brief Reset the encoder.
+ *
+ * Any pending bytes are dropped.
+ */
+void base64_encoder::reset()
+{
+    f_line = 0;
+    f_carry_size = 0;
+}
+
+
+
+/** \class base64_decoder
+ * \brief Streaming base64 decoder.
+ *
+ * The decoder accepts its input in chunks of any size. An incomplete
+ * group of 4 characters is kept between calls. See base64_decode()
+ * for the rules applied to invalid characters and padding.
+ *
+ * Once an error was found, the decoder keeps returning false until
+ * reset.
+ */
+
+
+/** \brief Initialize the decoder.
+ *
+ * \param[in] alphabet  The alphabet to use.
+ * \param[in] flags  The BASE64_FLAG_NO_PADDING and
+ * BASE64_FLAG_IGNORE_INVALID flags or 0.
+ */
+base64_decoder::base64_decoder(base64_alphabet_t alphabet, int flags)
+    : f_alphabet(alphabet)
+    , f_flags(flags)
+{
+}
+
+
+/** \brief Decode one chunk of data.
+ *
+ * \param[in] data  The characters to decode.
+ * \param[in,out] out  The string where the decoded bytes get appended.
+ *
+ * \return false if an invalid character or invalid padding was found.
+ */
+bool base64_decoder::decode(std::span<char const> data, std::string & out)
+{
+    if(f_error)
+    {
+        return false;
+    }
+
+    alphabet_tables_t const & tables(get_tables(f_alphabet));
+    bool const ignore_invalid((f_flags & BASE64_FLAG_IGNORE_INVALID) != 0);
+    char const * s(data.data());
+    std::size_t const size(data.size());
+
+    // the SIMD kernels write up to 8 bytes past the decoded data
+    //
+    std::size_t const start(out.length());
+    out.resize(start + size / 4 * 3 + 3 + 8);
+    char * const begin(out.data() + start);
+    char * d(begin);
+
+    std::size_t pos(0);
+    while(pos < size)
+    {
+        if(f_count == 0 && !f_padded)
+        {
+#ifdef EDHTTP_X86_SIMD
+            std::size_t count(0);
+            switch(get_simd_level())
+            {
+            case simd_level_t::SIMD_LEVEL_AVX2:
+                count = decode_avx2(s + pos, size - pos, d, tables);
+                [[fallthrough]];
+            case simd_level_t::SIMD_LEVEL_SSSE3:
+                count += decode_ssse3(s + pos + count, size - pos - count, d + count / 4 * 3, tables);
+                break;
+
+            case simd_level_t::SIMD_LEVEL_SCALAR:
+                break;
+
+            }
+            pos += count;
+            d += count / 4 * 3;
+#endif
+
+            // scalar version of the same, 4 characters at a time
+            //
+            std::uint8_t const * u(reinterpret_cast<std::uint8_t const *>(s));
+            for(; pos + 4 <= size; pos += 4, d += 3)
+            {
+                int const a(tables.f_values[u[pos + 0]]);
+                int const b(tables.f_values[u[pos + 1]]);
+                int const c(tables.f_values[u[pos + 2]]);
+                int const e(tables.f_values[u[pos + 3]]);
+                if((a | b | c | e) < 0)
+                {
+                    break;
+                }
+                std::uint32_t const v((a << 18) | (b << 12) | (c << 6) | e);
+                d[0] = static_cast<char>(v >> 16);
+                d[1] = static_cast<char>(v >> 8);
+                d[2] = static_cast<char>(v);
+            }
+            if(pos >= size)
+            {
+                break;
+            }
+        }
+
+        char const c(s[pos]);
+        ++pos;
+        int const v(tables.f_values[static_cast<std::uint8_t>(c)]);
+        if(v < 0)
+        {
+            if(ignore_invalid)
+            {
+                continue;
+            }
+            if(c != '='
+            || (f_flags & BASE64_FLAG_NO_PADDING) != 0)
+            {
+                f_error = true;
+                break;
+            }
+            if(!f_padded)
+            {
+                // "xx==" or "xxx="
+                //
+                if(f_count < 2)
+                {
+                    f_error = true;
+                    break;
+                }
+                f_padded = true;
+                f_padding = 4 - f_count;
+                d[0] = static_cast<char>(f_bits >> (f_count == 2 ? 4 : 10));
+                if(f_count == 3)
+                {
+                    d[1] = static_cast<char>(f_bits >> 2);
+                }
+                d += f_count - 1;
+                f_count = 0;
+                f_bits = 0;
+            }
+            if(f_padding == 0)
+            {
+                f_error = true;
+                break;
+            }
+            --f_padding;
+            continue;
+        }
+        if(f_padded)
+        {
+            // nothing can follow the padding
+            //
+            f_error = true;
+            break;
+        }
+        f_bits = (f_bits << 6) | static_cast<std::uint32_t>(v);
+        ++f_count;
+        if(f_count == 4)
+        {
+            d[0] = static_cast<char>(f_bits >> 16);
+            d[1] = static_cast<char>(f_bits >> 8);
+            d[2] = static_cast<char>(f_bits);
+            d += 3;
+            f_count = 0;
+            f_bits = 0;
+        }
+    }
+
+    out.resize(start + static_cast<std::size_t>(d - begin));
+    return !f_error;
+}
+
+
+/** \brief Terminate the decoding.
+ *
+ * When the input was not padded, the last 2 or 3 characters get decoded
+ * here. The decoder is then reset so it can be reused.
+ *
+ * \param[in,out] out  The string where the decoded bytes get appended.
+ *
+ * \return false if the data was invalid: an error was found earlier,
+ * the padding is incomplete, or a single character is left (unless
+ * invalid characters are ignored).
+ */
+bool base64_decoder::finish(std::string & out)
+{
+    bool result(!f_error && f_padding == 0);
+    switch(f_count)
+    {
+    case 1:
+        if((f_flags & BASE64_FLAG_IGNORE_INVALID) == 0)
+        {
+            result = false;
+        }
+        break;
+
+    case 2:
+        out += static_cast<char>(f_bits >> 4);
+        break;
+
+    case 3:
+        out += static_cast<char>(f_bits >> 10);
+        out += static_cast<char>(f_bits >> 2);
+        break;
+
+    }
+    reset();
+    return result;
+}
+
+
+/** \brief Reset the decoder.
+ *
+ * Any pending characters and errors are cleared.
+ */
+void base64_decoder::reset()
+{
+    f_bits = 0;
+    f_count = 0;
+    f_padding = 0;
+    f_padded = false;
+    f_error = false;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,110 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <span>
+#include    <string>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+enum class base64_alphabet_t
+{
+    BASE64_ALPHABET_STANDARD,       // RFC 4648 section 4 ("+/")
+    BASE64_ALPHABET_URL             // RFC 4648 section 5 ("-_")
+};
+
+
+int const BASE64_FLAG_NO_PADDING      = 0x0001;   // no '=' characters are added or accepted
+int const BASE64_FLAG_IGNORE_INVALID  = 0x0002;   // decoder skips characters outside the alphabet
+
+std::size_t         base64_encoded_size(std::size_t size, int flags = 0);
+void                base64_encode(
+                          std::string_view data
+                        , std::string & out
+                        , base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                        , int flags = 0);
+std::string         base64_encode(
+                          std::string_view data
+                        , base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                        , int flags = 0);
+bool                base64_decode(
+                          std::string_view data
+                        , std::string & out
+                        , base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                        , int flags = 0);
+int                 base64_value(
+                          char c
+                        , base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD);
+
+
+class base64_encoder
+{
+public:
+                        base64_encoder(
+                              base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                            , int flags = 0
+                            , std::size_t line_length = 0);
+
+    void                encode(std::span<char const> data, std::string & out);
+    void                finish(std::string & out);
+    void                reset();
+
+private:
+    base64_alphabet_t   f_alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD;
+    int                 f_flags = 0;
+    std::size_t         f_line_length = 0;
+    std::size_t         f_line = 0;
+    std::uint8_t        f_carry[2] = {};
+    std::size_t         f_carry_size = 0;
+};
+
+
+class base64_decoder
+{
+public:
+                        base64_decoder(
+                              base64_alphabet_t alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                            , int flags = 0);
+
+    bool                decode(std::span<char const> data, std::string & out);
+    bool                finish(std::string & out);
+    void                reset();
+
+private:
+    base64_alphabet_t   f_alphabet = base64_alphabet_t::BASE64_ALPHABET_STANDARD;
+    int                 f_flags = 0;
+    std::uint32_t       f_bits = 0;
+    std::size_t         f_count = 0;            // characters in the current quantum
+    std::size_t         f_padding = 0;          // '=' still expected
+    bool                f_padded = false;       // padding started
+    bool                f_error = false;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
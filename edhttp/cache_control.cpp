@@ -93,6 +93,7 @@ void cache_control_settings::reset_cache_info()
     f_private = false;
     f_public = false;
     f_s_maxage = IGNORE_VALUE;
+    f_stale_while_revalidate = IGNORE_VALUE;
 }
 
 
@@ -286,6 +287,10 @@ void cache_control_settings::set_cache_info(std::string const & info, bool const
             {
                 set_s_maxage(c.get_value());
             }
+            else if(name == "stale-while-revalidate")
+            {
+                set_stale_while_revalidate(c.get_value());
+            }
             break;
 
         }
@@ -1073,6 +1078,79 @@ int64_t cache_control_settings::get_s_maxage() const
 }
 
 
+/** \brief Set the number of seconds a stale response can still be served.
+ *
+ * This function defines the 'stale-while-revalidate' value as defined
+ * in RFC 5861. Once the data becomes stale, a cache is allowed to
+ * continue to serve it for that many seconds while it revalidates the
+ * data with the origin server in the background.
+ *
+ * To use the maximum, call this function with AGE_MAXIMUM.
+ *
+ * To ignore this value, call this function with IGNORE_VALUE. This is
+ * the default value for this field.
+ *
+ * \note
+ * This field may appear in the server response.
+ *
+ * \param[in] stale_while_revalidate  The number of seconds the stale
+ *                                    data can still be returned.
+ *
+ * \sa get_stale_while_revalidate()
+ */
+void cache_control_settings::set_stale_while_revalidate(int64_t const stale_while_revalidate)
+{
+    if(stale_while_revalidate >= AGE_MAXIMUM)
+    {
+        f_stale_while_revalidate = AGE_MAXIMUM;
+    }
+    else if(stale_while_revalidate < 0)
+    {
+        f_stale_while_revalidate = IGNORE_VALUE;
+    }
+    else
+    {
+        f_stale_while_revalidate = stale_while_revalidate;
+    }
+}
+
+
+/** \brief Set the 'stale-while-revalidate' field value from a string.
+ *
+ * This function accepts a string as input to setup the
+ * 'stale-while-revalidate' field.
+ *
+ * The value may be set to -1 if the string does not represent a valid
+ * decimal number (no signs allowed.) It will be clamped to a maximum
+ * of AGE_MAXIMUM.
+ *
+ * \param[in] stale_while_revalidate  The new number of seconds defined
+ *                                    as a string.
+ *
+ * \sa get_stale_while_revalidate()
+ */
+void cache_control_settings::set_stale_while_revalidate(std::string const & stale_while_revalidate)
+{
+    f_stale_while_revalidate = string_to_seconds(stale_while_revalidate);
+}
+
+
+/** \brief Retrieve the current 'stale-while-revalidate' field.
+ *
+ * This function returns the number of seconds a cache is allowed to
+ * serve the data after it became stale, as long as it revalidates it
+ * in the background.
+ *
+ * \return The number of seconds or IGNORE_VALUE.
+ *
+ * \sa set_stale_while_revalidate()
+ */
+int64_t cache_control_settings::get_stale_while_revalidate() const
+{
+    return f_stale_while_revalidate;
+}
+
+
 /** \brief How long of a 'stale' is accepted by the client.
  *
  * The client may asks for data that is stale. Assuming that
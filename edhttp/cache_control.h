@@ -93,6 +93,10 @@ public:
     void                            update_s_maxage(int64_t s_maxage);
     int64_t                         get_s_maxage() const;
 
+    void                            set_stale_while_revalidate(int64_t const stale_while_revalidate);
+    void                            set_stale_while_revalidate(std::string const & stale_while_revalidate);
+    int64_t                         get_stale_while_revalidate() const;
+
     // request only (client)
     void                            set_max_stale(int64_t const max_stale);
     void                            set_max_stale(std::string const & max_stale);
@@ -126,6 +130,7 @@ private:
     bool                            f_public = false;
     fields_t                        f_revalidate_field_names = fields_t();
     int64_t                         f_s_maxage = IGNORE_VALUE;
+    int64_t                         f_stale_while_revalidate = IGNORE_VALUE;
     tags_t                          f_tags = tags_t();
 };
 
@@ -0,0 +1,263 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Conversions between Unix time and the civil calendar.
+ *
+ * These functions convert a number of days or seconds since the Unix
+ * epoch to a year, month and day and back. They use the algorithms
+ * described by Howard Hinnant
+ * (http://howardhinnant.github.io/date_algorithms.html) which run in
+ * constant time, work with negative times (before 1970) and support
+ * 64 bit years in the proleptic Gregorian calendar.
+ *
+ * All the functions are constexpr and do not depend on the timezone
+ * or the locale. They are used by mkgmtime(), the HTTP date functions
+ * and the cookies.
+ */
+
+// C++
+//
+#include    <cstdint>
+
+
+
+namespace edhttp
+{
+
+
+
+struct civil_date_t
+{
+    std::int64_t    f_year = 1970;
+    int             f_month = 1;        // 1 to 12
+    int             f_day = 1;          // 1 to 31
+};
+
+
+struct civil_time_t
+{
+    std::int64_t    f_year = 1970;
+    int             f_month = 1;        // 1 to 12
+    int             f_day = 1;          // 1 to 31
+    int             f_hour = 0;
+    int             f_minute = 0;
+    int             f_second = 0;
+    int             f_week_day = 4;     // 0 is Sunday
+    int             f_year_day = 0;     // 0 is January 1st
+};
+
+
+// helpers used by the inline functions below, not part of the API
+//
+namespace detail
+{
+
+
+
+constexpr std::int64_t const    SECONDS_PER_DAY = 86400;
+
+
+/** \brief Divide and round toward negative infinity.
+ *
+ * \param[in] value  The value to divide.
+ * \param[in] divisor  A positive divisor.
+ *
+ * \return The floor of value / divisor.
+ */
+constexpr std::int64_t floor_div(std::int64_t value, std::int64_t divisor)
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+
+
+/** \brief Modulo with a result always between 0 and divisor - 1.
+ *
+ * \param[in] value  The value to divide.
+ * \param[in] divisor  A positive divisor.
+ *
+ * \return The remainder of the floor division.
+ */
+constexpr std::int64_t floor_mod(std::int64_t value, std::int64_t divisor)
+{
+    std::int64_t const r(value % divisor);
+    return r < 0 ? r + divisor : r;
+}
+
+
+constexpr bool is_leap_year(std::int64_t year)
+{
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+
+
+} // namespace detail
+
+
+/** \brief Get the number of days in a month.
+ *
+ * \param[in] year  The year, used to know whether February has 29 days.
+ * \param[in] month  The month, from 1 to 12.
+ *
+ * \return 28 to 31.
+ */
+constexpr int days_in_month(std::int64_t year, int month)
+{
+    if(month == 2)
+    {
+        return detail::is_leap_year(year) ? 29 : 28;
+    }
+    return month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31;
+}
+
+
+/** \brief Compute the number of days since the Unix epoch.
+ *
+ * This is the days_from_civil() algorithm. The day may be out of range
+ * (i.e. 0 or 32) in which case the result is simply offset by that many
+ * days.
+ *
+ * \param[in] year  The year.
+ * \param[in] month  The month (1 to 12).
+ * \param[in] day  The day of the month (1 to 31).
+ *
+ * \return The number of days since 1970-01-01, negative for dates before.
+ */
+constexpr std::int64_t days_from_civil(std::int64_t year, int month, int day)
+{
+    year -= month <= 2 ? 1 : 0;
+    std::int64_t const era(detail::floor_div(year, 400));
+    std::uint32_t const year_of_era(static_cast<std::uint32_t>(year - era * 400));
+    std::uint32_t const day_of_year((153 * static_cast<std::uint32_t>(month > 2 ? month - 3 : month + 9) + 2) / 5);
+    std::uint32_t const day_of_era(year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year);
+    return era * 146097 + static_cast<std::int64_t>(day_of_era) + day - 1 - 719468;
+}
+
+
+/** \brief Compute the date from a number of days since the Unix epoch.
+ *
+ * This is the civil_from_days() algorithm, the inverse of
+ * days_from_civil().
+ *
+ * \param[in] days  The number of days since 1970-01-01.
+ *
+ * \return The corresponding year, month and day.
+ */
+constexpr civil_date_t civil_from_days(std::int64_t days)
+{
+    days += 719468;     // shift the epoch to 0000-03-01
+    std::int64_t const era(detail::floor_div(days, 146097));
+    std::uint32_t const day_of_era(static_cast<std::uint32_t>(days - era * 146097));
+    std::uint32_t const year_of_era((day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365);
+    std::uint32_t const day_of_year(day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100));
+    std::uint32_t const mp((5 * day_of_year + 2) / 153);
+
+    civil_date_t result;
+    result.f_day = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+    result.f_month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    result.f_year = static_cast<std::int64_t>(year_of_era) + era * 400 + (result.f_month <= 2 ? 1 : 0);
+    return result;
+}
+
+
+/** \brief Compute the day of the week.
+ *
+ * \param[in] days  The number of days since 1970-01-01.
+ *
+ * \return 0 for Sunday to 6 for Saturday.
+ */
+constexpr int week_day_from_days(std::int64_t days)
+{
+    // 1970-01-01 was a Thursday
+    //
+    return static_cast<int>(detail::floor_mod(days + 4, 7));
+}
+
+
+/** \brief Convert a date and time to a Unix time.
+ *
+ * The month is normalized first (i.e. month 13 is January of the next
+ * year and month 0 is December of the previous year). The day, hour,
+ * minute and second are linear and can be out of range or negative.
+ * This is what makes it possible to apply a timezone by adjusting the
+ * hour and minute.
+ *
+ * \param[in] year  The year.
+ * \param[in] month  The month (1 to 12).
+ * \param[in] day  The day of the month (1 to 31).
+ * \param[in] hour  The hour (0 to 23).
+ * \param[in] minute  The minute (0 to 59).
+ * \param[in] second  The second (0 to 59).
+ *
+ * \return The number of seconds since the Unix epoch.
+ */
+constexpr std::int64_t time_from_civil(
+      std::int64_t year
+    , std::int64_t month
+    , std::int64_t day
+    , std::int64_t hour = 0
+    , std::int64_t minute = 0
+    , std::int64_t second = 0)
+{
+    year += detail::floor_div(month - 1, 12);
+    month = detail::floor_mod(month - 1, 12) + 1;
+    return (days_from_civil(year, static_cast<int>(month), 1) + day - 1) * detail::SECONDS_PER_DAY
+         + hour * 3600
+         + minute * 60
+         + second;
+}
+
+
+/** \brief Break down a Unix time in its date and time parts.
+ *
+ * \param[in] seconds  The number of seconds since the Unix epoch.
+ *
+ * \return The date and time parts.
+ */
+constexpr civil_time_t civil_from_time(std::int64_t seconds)
+{
+    std::int64_t const days(detail::floor_div(seconds, detail::SECONDS_PER_DAY));
+    int const time_of_day(static_cast<int>(seconds - days * detail::SECONDS_PER_DAY));
+    civil_date_t const date(civil_from_days(days));
+
+    civil_time_t result;
+    result.f_year = date.f_year;
+    result.f_month = date.f_month;
+    result.f_day = date.f_day;
+    result.f_hour = time_of_day / 3600;
+    result.f_minute = time_of_day / 60 % 60;
+    result.f_second = time_of_day % 60;
+    result.f_week_day = week_day_from_days(days);
+    result.f_year_day = static_cast<int>(days - days_from_civil(date.f_year, 1, 1));
+    return result;
+}
+
+
+static_assert(days_from_civil(1970, 1, 1) == 0);
+static_assert(days_from_civil(2000, 3, 1) == 11017);
+static_assert(days_from_civil(1969, 12, 31) == -1);
+static_assert(civil_from_days(-719468).f_year == 0);
+static_assert(time_from_civil(1994, 11, 6, 8, 49, 37) == 784111777);
+static_assert(time_from_civil(1995, -1, 6, 8, 49, 37) == 784111777);
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -17,6 +17,7 @@
 //
 #include    "edhttp/compression/archiver.h"
 
+#include    "edhttp/metrics.h"
 
 
 // C++
@@ -49,6 +50,48 @@ typedef std::map<std::string, archiver *>     archiver_map_t;
 archiver_map_t * g_archivers;
 
 
+struct archiver_metrics_t
+{
+    metric_counter *    f_appended_files = nullptr;
+    metric_counter *    f_appended_bytes = nullptr;
+    metric_counter *    f_extracted_files = nullptr;
+    metric_counter *    f_extracted_bytes = nullptr;
+};
+
+typedef std::map<archiver const *, archiver_metrics_t>  archiver_metrics_map_t;
+
+// the metrics of each archiver, it gets updated along g_archivers
+//
+archiver_metrics_map_t * g_archiver_metrics;
+
+
+archiver_metrics_t create_metrics(std::string const & name)
+{
+    metrics_registry & registry(metrics_registry::instance());
+    std::string const labels(metric::label("archiver", name));
+    std::string const append(labels + ',' + metric::label("operation", "append"));
+    std::string const extract(labels + ',' + metric::label("operation", "extract"));
+
+    char const * files_help("Number of files added to or read from archives.");
+    char const * bytes_help("Number of bytes of file data added to or read from archives.");
+
+    archiver_metrics_t result;
+    result.f_appended_files = &registry.get_counter("edhttp_archiver_files_total", files_help, append);
+    result.f_appended_bytes = &registry.get_counter("edhttp_archiver_bytes_total", bytes_help, append);
+    result.f_extracted_files = &registry.get_counter("edhttp_archiver_files_total", files_help, extract);
+    result.f_extracted_bytes = &registry.get_counter("edhttp_archiver_bytes_total", bytes_help, extract);
+    return result;
+}
+
+
+std::size_t data_size(archiver_file const & file)
+{
+    return file.get_type() == file_type_t::FILE_TYPE_REGULAR
+                ? file.get_data().size()
+                : 0;
+}
+
+
 
 } // no name namespace
 
@@ -59,8 +102,10 @@ archiver::archiver(char const * name)
     if(g_archivers == nullptr)
     {
         g_archivers = new archiver_map_t;
+        g_archiver_metrics = new archiver_metrics_map_t;
     }
     (*g_archivers)[name] = this;
+    (*g_archiver_metrics)[this] = create_metrics(name);
 }
 
 
@@ -74,11 +119,14 @@ archiver::~archiver()
             break;
         }
     }
+    g_archiver_metrics->erase(this);
 
     if(g_archivers->empty())
     {
         delete g_archivers;
         g_archivers = nullptr;
+        delete g_archiver_metrics;
+        g_archiver_metrics = nullptr;
     }
 }
 
@@ -110,6 +158,35 @@ archiver * get_archiver(std::string const & archiver_name)
 }
 
 
+/** \brief Count a file added to an archive.
+ *
+ * Archivers call this function once the \p file was appended so the
+ * number of files and bytes archived get exported as metrics.
+ *
+ * \param[in] file  The file which was appended.
+ */
+void archiver::file_appended(archiver_file const & file) const
+{
+    archiver_metrics_t const & m(g_archiver_metrics->at(this));
+    m.f_appended_files->increment();
+    m.f_appended_bytes->increment(data_size(file));
+}
+
+
+/** \brief Count a file read from an archive.
+ *
+ * Archivers call this function each time next_file() returns a file.
+ *
+ * \param[in] file  The file which was read.
+ */
+void archiver::file_extracted(archiver_file const & file) const
+{
+    archiver_metrics_t const & m(g_archiver_metrics->at(this));
+    m.f_extracted_files->increment();
+    m.f_extracted_bytes->increment(data_size(file));
+}
+
+
 
 } // namespace edhttp
 // vim: ts=4 sw=4 et
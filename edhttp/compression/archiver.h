@@ -37,6 +37,10 @@ public:
     virtual void            append_file(archiver_archive & archive, archiver_file const & file) = 0;
     virtual bool            next_file(archiver_archive & archive, archiver_file & file) const = 0;
     virtual void            rewind(archiver_archive & archive) = 0;
+
+protected:
+    void                    file_appended(archiver_file const & file) const;
+    void                    file_extracted(archiver_file const & file) const;
 };
 
 
@@ -18,6 +18,7 @@
 #include    "edhttp/compression/compressor.h"
 
 #include    "edhttp/exception.h"
+#include    "edhttp/metrics.h"
 #include    "edhttp/token.h"
 
 
@@ -69,6 +70,74 @@ typedef std::map<std::string, compressor *>   compressor_map_t;
 compressor_map_t * g_compressors;
 
 
+struct compressor_metrics_t
+{
+    metric_histogram *  f_compress_duration = nullptr;
+    metric_counter *    f_compress_input = nullptr;
+    metric_counter *    f_compress_output = nullptr;
+    metric_histogram *  f_compression_ratio = nullptr;
+    metric_histogram *  f_decompress_duration = nullptr;
+    metric_counter *    f_decompress_input = nullptr;
+    metric_counter *    f_decompress_output = nullptr;
+};
+
+typedef std::map<compressor const *, compressor_metrics_t>  compressor_metrics_map_t;
+
+// the metrics of each compressor, it gets updated along g_compressors
+//
+compressor_metrics_map_t * g_compressor_metrics;
+
+
+compressor_metrics_t create_metrics(std::string const & name)
+{
+    metrics_registry & registry(metrics_registry::instance());
+    std::string const labels(metric::label("compressor", name));
+
+    // the ratio is saved in percent and rendered as a fraction
+    //
+    metric_histogram::bounds_t const ratio_bounds{ 10, 20, 30, 40, 50, 60, 70, 80, 90, 100 };
+
+    compressor_metrics_t result;
+    result.f_compress_duration = &registry.get_histogram(
+              "edhttp_compress_duration_seconds"
+            , "Time spent compressing buffers."
+            , labels);
+    result.f_compress_input = &registry.get_counter(
+              "edhttp_compress_input_bytes_total"
+            , "Number of bytes given to the compressor."
+            , labels);
+    result.f_compress_output = &registry.get_counter(
+              "edhttp_compress_output_bytes_total"
+            , "Number of bytes output by the compressor."
+            , labels);
+    result.f_compression_ratio = &registry.get_histogram(
+              "edhttp_compression_ratio"
+            , "Size of the compressed buffer selected by compress() over the size of the input."
+            , labels
+            , ratio_bounds
+            , 100.0);
+    result.f_decompress_duration = &registry.get_histogram(
+              "edhttp_decompress_duration_seconds"
+            , "Time spent decompressing buffers."
+            , labels);
+    result.f_decompress_input = &registry.get_counter(
+              "edhttp_decompress_input_bytes_total"
+            , "Number of bytes given to the decompressor."
+            , labels);
+    result.f_decompress_output = &registry.get_counter(
+              "edhttp_decompress_output_bytes_total"
+            , "Number of bytes output by the decompressor."
+            , labels);
+    return result;
+}
+
+
+compressor_metrics_t const & get_metrics(compressor const * c)
+{
+    return g_compressor_metrics->at(c);
+}
+
+
 
 } // no name namespace
 
@@ -124,8 +193,10 @@ compressor::compressor(char const * name)
     if(g_compressors == nullptr)
     {
         g_compressors = new compressor_map_t;
+        g_compressor_metrics = new compressor_metrics_map_t;
     }
     (*g_compressors)[name] = this;
+    (*g_compressor_metrics)[this] = create_metrics(n);
 }
 
 
@@ -148,11 +219,14 @@ compressor::~compressor()
             break;
         }
     }
+    g_compressor_metrics->erase(this);
 
     if(g_compressors->empty())
     {
         delete g_compressors;
         g_compressors = nullptr;
+        delete g_compressor_metrics;
+        g_compressor_metrics = nullptr;
     }
 }
 
@@ -256,24 +330,32 @@ result_t compress(advgetopt::string_list_t const & compressor_names, buffer_t co
 
         // create a lambda of common code
         //
-        auto select_best = [&result_buffer, &result_name, &input, level, text](compressor * c)
+        compressor const * result_compressor(nullptr);
+        auto select_best = [&result_buffer, &result_name, &result_compressor, &input, level, text](compressor * c)
         {
+            compressor_metrics_t const & m(get_metrics(c));
+            buffer_t test_buffer;
+            {
+                metric_histogram::timer t(*m.f_compress_duration);
+                test_buffer = c->compress(input, level, text);
+            }
+            m.f_compress_input->increment(input.size());
+            m.f_compress_output->increment(test_buffer.size());
+
             if(result_name.empty())
             {
-                result_buffer = c->compress(input, level, text);
+                result_buffer.swap(test_buffer);
                 if(result_buffer.size() < input.size())
                 {
                     result_name = c->get_name();
+                    result_compressor = c;
                 }
             }
-            else
+            else if(test_buffer.size() < result_buffer.size())
             {
-                buffer_t test_buffer(c->compress(input, level, text));
-                if(test_buffer.size() < result_buffer.size())
-                {
-                    result_buffer.swap(test_buffer);
-                    result_name = c->get_name();
-                }
+                result_buffer.swap(test_buffer);
+                result_name = c->get_name();
+                result_compressor = c;
             }
         };
 
@@ -302,6 +384,7 @@ result_t compress(advgetopt::string_list_t const & compressor_names, buffer_t co
         //
         if(!result_name.empty())
         {
+            get_metrics(result_compressor).f_compression_ratio->record(result_buffer.size() * 100 / input.size());
             return result_t(result_buffer, result_name);
         }
     }
@@ -335,7 +418,15 @@ result_t decompress(buffer_t const & input)
         {
             if(c.second->compatible(input))
             {
-                return result_t(c.second->decompress(input), c.second->get_name());
+                compressor_metrics_t const & m(get_metrics(c.second));
+                buffer_t output;
+                {
+                    metric_histogram::timer t(*m.f_decompress_duration);
+                    output = c.second->decompress(input);
+                }
+                m.f_decompress_input->increment(input.size());
+                m.f_decompress_output->increment(output.size());
+                return result_t(output, c.second->get_name());
             }
         }
     }
@@ -248,6 +248,8 @@ void tar::append_file(archiver_archive & archive, archiver_file const & file)
         break;
 
     }
+
+    file_appended(file);
 }
 
 
@@ -398,6 +400,8 @@ bool tar::next_file(archiver_archive & archive, archiver_file & file) const
         archive.advance_pos(total_size);
     }
 
+    file_extracted(file);
+
     return true;
 }
 
@@ -0,0 +1,997 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Client side storage of the cookies sent by servers.
+ *
+ * The cookie_jar class implements the storage model of RFC 6265
+ * section 5.3. The http_client saves the cookies found in the
+ * Set-Cookie headers of each response in its jar and sends them back
+ * in the Cookie header of the following requests.
+ *
+ * The cookies are saved in a trie of domain labels read from right to
+ * left (i.e. "com" -> "example" -> "www"). Looking for the cookies of a
+ * host means walking down a few nodes; each node holds lists of cookies
+ * per path. A min-heap of the expiration dates is used to purge expired
+ * cookies and to make room when the jar is full.
+ */
+
+// self
+//
+#include    "edhttp/cookie_jar.h"
+
+#include    "edhttp/exception.h"
+#include    "edhttp/http_date.h"
+
+
+// libtld
+//
+#include    <libtld/tld.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <utility>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+bool is_wsp(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+
+std::string_view trim(std::string_view s)
+{
+    while(!s.empty() && is_wsp(s.front()))
+    {
+        s.remove_prefix(1);
+    }
+    while(!s.empty() && is_wsp(s.back()))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+
+char to_lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+}
+
+
+bool equal_ignore_case(std::string_view a, char const * b)
+{
+    std::size_t idx(0);
+    for(; idx < a.length() && b[idx] != '\0'; ++idx)
+    {
+        if(to_lower(a[idx]) != b[idx])
+        {
+            return false;
+        }
+    }
+    return idx == a.length() && b[idx] == '\0';
+}
+
+
+std::string lowercase(std::string_view s)
+{
+    std::string result(s);
+    for(auto & c : result)
+    {
+        c = to_lower(c);
+    }
+    return result;
+}
+
+
+/** \brief Get the next label of a domain name, from the right.
+ *
+ * \param[in,out] domain  The domain, the label gets removed.
+ * \param[out] label  The last label of \p domain.
+ *
+ * \return false once the domain is empty.
+ */
+bool next_label(std::string_view & domain, std::string_view & label)
+{
+    if(domain.empty())
+    {
+        return false;
+    }
+    std::string_view::size_type const pos(domain.rfind('.'));
+    if(pos == std::string_view::npos)
+    {
+        label = domain;
+        domain = std::string_view();
+    }
+    else
+    {
+        label = domain.substr(pos + 1);
+        domain = domain.substr(0, pos);
+    }
+    return true;
+}
+
+
+bool valid_domain(std::string_view domain)
+{
+    return !domain.empty()
+        && domain.front() != '.'
+        && domain.back() != '.'
+        && domain.find("..") == std::string_view::npos;
+}
+
+
+bool is_ip_address(std::string_view host)
+{
+    if(host.find(':') != std::string_view::npos)
+    {
+        return true;
+    }
+    return host.find_first_not_of("0123456789.") == std::string_view::npos;
+}
+
+
+/** \brief Check whether a host matches a cookie domain.
+ *
+ * This is the domain-match of RFC 6265 section 5.1.3.
+ *
+ * \param[in] host  The lowercase host name.
+ * \param[in] domain  The lowercase cookie domain.
+ *
+ * \return true if host is domain or one of its sub-domains.
+ */
+bool domain_match(std::string_view host, std::string_view domain)
+{
+    if(host == domain)
+    {
+        return true;
+    }
+    return host.length() > domain.length()
+        && host[host.length() - domain.length() - 1] == '.'
+        && host.substr(host.length() - domain.length()) == domain
+        && !is_ip_address(host);
+}
+
+
+std::string_view strip_query(std::string_view path)
+{
+    return path.substr(0, path.find_first_of("?#"));
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a cookie jar.
+ *
+ * RFC 6265 asks user agents to support at least 3,000 cookies in total,
+ * which is the default limit.
+ *
+ * \exception invalid_parameter
+ * The \p max_cookies parameter must be at least 1.
+ *
+ * \param[in] max_cookies  The maximum number of cookies kept in the jar.
+ */
+cookie_jar::cookie_jar(std::size_t max_cookies)
+    : f_max_cookies(max_cookies)
+{
+    if(max_cookies == 0)
+    {
+        throw invalid_parameter("the maximum number of cookies in a cookie_jar must be at least 1.");
+    }
+}
+
+
+/** \brief Save the cookie of a Set-Cookie header.
+ *
+ * This function parses the \p set_cookie header value as defined in
+ * RFC 6265 section 5.2 and saves the resulting cookie in the jar
+ * following the storage model of section 5.3:
+ *
+ * \li the Max-Age attribute has priority over Expires;
+ * \li a cookie without a Domain attribute is only returned to \p host;
+ * \li a Domain attribute has to domain-match \p host and cannot be a
+ * public suffix (i.e. "com" or "co.uk"), unless it is \p host itself;
+ * \li a cookie without a valid Path attribute gets the default path
+ * computed from the request \p path;
+ * \li a Secure cookie must be received over a secure connection;
+ * \li a cookie with the same name, domain and path replaces the
+ * existing one; if already expired, it deletes it.
+ *
+ * \param[in] set_cookie  The value of one Set-Cookie header.
+ * \param[in] host  The host of the request which received that header.
+ * \param[in] path  The path of that request.
+ * \param[in] secure  Whether the request was sent over TLS.
+ * \param[in] now  The current time.
+ *
+ * \return true if the cookie was accepted (saved or used to delete an
+ * existing cookie), false if it is invalid or the jar is full of session
+ * cookies.
+ */
+bool cookie_jar::set_cookie(
+      std::string_view set_cookie
+    , std::string_view host
+    , std::string_view path
+    , bool secure
+    , time_t now)
+{
+    std::string_view::size_type pos(set_cookie.find(';'));
+    std::string_view const name_value(set_cookie.substr(0, pos));
+    std::string_view::size_type const equal(name_value.find('='));
+    if(equal == std::string_view::npos)
+    {
+        return false;
+    }
+    std::string_view const name(trim(name_value.substr(0, equal)));
+    if(name.empty())
+    {
+        return false;
+    }
+
+    cookie_t cookie;
+    cookie.f_name = name;
+    cookie.f_value = trim(name_value.substr(equal + 1));
+
+    bool has_max_age(false);
+    time_t expires(-1);
+    std::string domain;
+    std::string_view cookie_path;
+    while(pos != std::string_view::npos)
+    {
+        set_cookie.remove_prefix(pos + 1);
+        pos = set_cookie.find(';');
+        std::string_view const attribute(set_cookie.substr(0, pos));
+        std::string_view::size_type const attr_equal(attribute.find('='));
+        std::string_view const attr_name(trim(attribute.substr(0, attr_equal)));
+        std::string_view const attr_value(attr_equal == std::string_view::npos
+                            ? std::string_view()
+                            : trim(attribute.substr(attr_equal + 1)));
+
+        if(equal_ignore_case(attr_name, "expires"))
+        {
+            time_t const t(string_to_date(std::string(attr_value)));
+            if(t != -1 && !has_max_age)
+            {
+                expires = t;
+            }
+        }
+        else if(equal_ignore_case(attr_name, "max-age"))
+        {
+            std::string_view digits(attr_value);
+            bool const negative(!digits.empty() && digits.front() == '-');
+            if(negative)
+            {
+                digits.remove_prefix(1);
+            }
+            if(!digits.empty()
+            && digits.find_first_not_of("0123456789") == std::string_view::npos)
+            {
+                // avoid overflows, anything over a few years is "forever"
+                //
+                std::int64_t delta(0);
+                for(char const c : digits)
+                {
+                    delta = std::min<std::int64_t>(delta * 10 + (c - '0'), 0x7FFFFFFFLL);
+                }
+                has_max_age = true;
+                expires = negative || delta == 0 ? 0 : now + delta;
+            }
+        }
+        else if(equal_ignore_case(attr_name, "domain"))
+        {
+            std::string_view d(attr_value);
+            if(!d.empty() && d.front() == '.')
+            {
+                d.remove_prefix(1);
+            }
+            if(!d.empty())
+            {
+                domain = lowercase(d);
+            }
+        }
+        else if(equal_ignore_case(attr_name, "path"))
+        {
+            cookie_path = attr_value;
+        }
+        else if(equal_ignore_case(attr_name, "secure"))
+        {
+            cookie.f_secure = true;
+        }
+        else if(equal_ignore_case(attr_name, "httponly"))
+        {
+            cookie.f_http_only = true;
+        }
+        else if(equal_ignore_case(attr_name, "samesite"))
+        {
+            if(equal_ignore_case(attr_value, "strict"))
+            {
+                cookie.f_same_site = same_site_t::SAME_SITE_STRICT;
+            }
+            else if(equal_ignore_case(attr_value, "lax"))
+            {
+                cookie.f_same_site = same_site_t::SAME_SITE_LAX;
+            }
+            else if(equal_ignore_case(attr_value, "none"))
+            {
+                cookie.f_same_site = same_site_t::SAME_SITE_NONE;
+            }
+        }
+    }
+    cookie.f_expire = expires;
+
+    std::string const request_host(lowercase(host));
+    if(!valid_domain(request_host))
+    {
+        return false;
+    }
+    if(!domain.empty()
+    && is_public_suffix(domain))
+    {
+        if(domain != request_host)
+        {
+            return false;
+        }
+        domain.clear();
+    }
+    if(domain.empty())
+    {
+        cookie.f_host_only = true;
+        cookie.f_domain = request_host;
+    }
+    else
+    {
+        if(!valid_domain(domain)
+        || !domain_match(request_host, domain))
+        {
+            return false;
+        }
+        cookie.f_host_only = false;
+        cookie.f_domain = domain;
+    }
+
+    if(cookie_path.empty()
+    || cookie_path.front() != '/')
+    {
+        cookie.f_path = default_path(path);
+    }
+    else
+    {
+        cookie.f_path = cookie_path;
+    }
+
+    if(cookie.f_secure && !secure)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return store(std::move(cookie), now);
+}
+
+
+/** \brief Append the cookies to send with a request.
+ *
+ * This function appends the name=value pairs of all the cookies that
+ * match \p host and \p path to \p out, as expected in a Cookie header
+ * (RFC 6265 section 5.4). The cookies with longer paths are listed
+ * first and cookies with the same path length are listed in creation
+ * order.
+ *
+ * Session cookies are always included. Expired cookies are not, they
+ * get removed by purge_expired() or when the jar is full.
+ *
+ * \param[in,out] out  The string where the cookies get appended.
+ * \param[in] host  The host the request is sent to.
+ * \param[in] path  The path of the request (a query string is ignored).
+ * \param[in] secure  Whether the request is sent over TLS.
+ * \param[in] now  The current time.
+ */
+void cookie_jar::append_cookies(
+      std::string & out
+    , std::string_view host
+    , std::string_view path
+    , bool secure
+    , time_t now) const
+{
+    // DNS names are limited to 253 characters, lowercase on the stack
+    //
+    char buf[256];
+    if(host.length() >= sizeof(buf))
+    {
+        return;
+    }
+    for(std::size_t idx(0); idx < host.length(); ++idx)
+    {
+        buf[idx] = to_lower(host[idx]);
+    }
+    std::string_view remaining(buf, host.length());
+    path = strip_query(path);
+    if(path.empty())
+    {
+        path = "/";
+    }
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    f_matches.clear();
+    domain_node_t const * node(&f_root);
+    std::string_view label;
+    while(next_label(remaining, label))
+    {
+        auto const it(node->f_children.find(label));
+        if(it == node->f_children.end())
+        {
+            break;
+        }
+        node = it->second.get();
+        bool const full_match(remaining.empty());
+        for(auto const & list : node->f_paths)
+        {
+            if(!path_match(path, list.f_path))
+            {
+                continue;
+            }
+            for(auto const & c : list.f_cookies)
+            {
+                if((c.f_host_only && !full_match)
+                || (c.f_secure && !secure)
+                || (c.f_expire != -1 && c.f_expire <= now))
+                {
+                    continue;
+                }
+                f_matches.push_back(&c);
+            }
+        }
+    }
+
+    if(f_matches.size() > 1)
+    {
+        std::sort(
+              f_matches.begin()
+            , f_matches.end()
+            , [](cookie_t const * a, cookie_t const * b)
+            {
+                if(a->f_path.length() != b->f_path.length())
+                {
+                    return a->f_path.length() > b->f_path.length();
+                }
+                return a->f_creation < b->f_creation;
+            });
+    }
+
+    for(auto const * c : f_matches)
+    {
+        if(!out.empty())
+        {
+            out += "; ";
+        }
+        out += c->f_name;
+        out += '=';
+        out += c->f_value;
+    }
+}
+
+
+/** \brief Get the value of the Cookie header for a request.
+ *
+ * \param[in] host  The host the request is sent to.
+ * \param[in] path  The path of the request.
+ * \param[in] secure  Whether the request is sent over TLS.
+ * \param[in] now  The current time.
+ *
+ * \return The cookies or an empty string if none match.
+ *
+ * \sa append_cookies()
+ */
+std::string cookie_jar::get_cookies(
+      std::string_view host
+    , std::string_view path
+    , bool secure
+    , time_t now) const
+{
+    std::string result;
+    append_cookies(result, host, path, secure, now);
+    return result;
+}
+
+
+/** \brief Search a specific cookie.
+ *
+ * \warning
+ * The returned pointer is only valid until the jar gets modified.
+ *
+ * \param[in] domain  The domain of the cookie (lowercase).
+ * \param[in] path  The path of the cookie.
+ * \param[in] name  The name of the cookie.
+ *
+ * \return A pointer to the cookie or nullptr.
+ */
+cookie_jar::cookie_t const * cookie_jar::find_cookie(
+      std::string_view domain
+    , std::string_view path
+    , std::string_view name) const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    domain_node_t const * node(find_node(domain));
+    if(node == nullptr)
+    {
+        return nullptr;
+    }
+    for(auto const & list : node->f_paths)
+    {
+        if(list.f_path == path)
+        {
+            for(auto const & c : list.f_cookies)
+            {
+                if(c.f_name == name)
+                {
+                    return &c;
+                }
+            }
+            break;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Get the number of cookies in the jar.
+ *
+ * \return The number of cookies, including expired cookies not yet
+ * purged.
+ */
+std::size_t cookie_jar::size() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_size;
+}
+
+
+std::size_t cookie_jar::get_max_cookies() const
+{
+    return f_max_cookies;
+}
+
+
+/** \brief Remove the expired cookies.
+ *
+ * The expiration dates are kept in a min-heap so this function only
+ * looks at the cookies which did expire.
+ *
+ * \param[in] now  The current time.
+ *
+ * \return The number of cookies removed.
+ */
+std::size_t cookie_jar::purge_expired(time_t now)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    std::size_t count(0);
+    while(!f_expiry.empty()
+       && f_expiry.top().f_expire <= now)
+    {
+        expiry_t const e(f_expiry.top());
+        f_expiry.pop();
+        if(remove_cookie(e.f_domain, e.f_path, e.f_name, e.f_creation, e.f_expire))
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+
+/** \brief Remove all the cookies.
+ */
+void cookie_jar::clear()
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    f_root = domain_node_t();
+    f_expiry = expiry_heap_t();
+    f_size = 0;
+}
+
+
+/** \brief Check whether a domain is a public suffix.
+ *
+ * Cookies cannot be set on a public suffix such as "com" or "co.uk"
+ * since they would be sent to all the websites under that suffix.
+ * The check uses the same libtld database as the uri class.
+ *
+ * \param[in] domain  The domain to check, without a leading period.
+ *
+ * \return true if \p domain is a known public suffix.
+ */
+bool cookie_jar::is_public_suffix(std::string_view domain)
+{
+    // tld() expects a domain name in front of the TLD
+    //
+    std::string name("x.");
+    name += domain;
+    struct tld_info info;
+    tld_result const r(::tld(name.c_str(), &info));
+    return r == TLD_RESULT_SUCCESS
+        && info.f_tld == name.c_str() + 1;
+}
+
+
+/** \brief Check whether a request path matches a cookie path.
+ *
+ * This is the path-match of RFC 6265 section 5.1.4.
+ *
+ * \param[in] request_path  The path of the request.
+ * \param[in] cookie_path  The path of the cookie.
+ *
+ * \return true if the cookie applies to the request path.
+ */
+bool cookie_jar::path_match(std::string_view request_path, std::string_view cookie_path)
+{
+    if(request_path.length() < cookie_path.length()
+    || request_path.compare(0, cookie_path.length(), cookie_path) != 0)
+    {
+        return false;
+    }
+    return request_path.length() == cookie_path.length()
+        || cookie_path.back() == '/'
+        || request_path[cookie_path.length()] == '/';
+}
+
+
+/** \brief Compute the default path of a cookie.
+ *
+ * This is the default-path of RFC 6265 section 5.1.4: the directory
+ * of the request path.
+ *
+ * \param[in] request_path  The path of the request.
+ *
+ * \return The default path.
+ */
+std::string cookie_jar::default_path(std::string_view request_path)
+{
+    request_path = strip_query(request_path);
+    if(request_path.empty()
+    || request_path.front() != '/')
+    {
+        return "/";
+    }
+    std::string_view::size_type const pos(request_path.rfind('/'));
+    if(pos == 0)
+    {
+        return "/";
+    }
+    return std::string(request_path.substr(0, pos));
+}
+
+
+cookie_jar::domain_node_t * cookie_jar::find_node(std::string_view domain) const
+{
+    domain_node_t const * node(&f_root);
+    std::string_view label;
+    while(next_label(domain, label))
+    {
+        auto const it(node->f_children.find(label));
+        if(it == node->f_children.end())
+        {
+            return nullptr;
+        }
+        node = it->second.get();
+    }
+    return const_cast<domain_node_t *>(node);
+}
+
+
+cookie_jar::domain_node_t & cookie_jar::create_node(std::string_view domain)
+{
+    domain_node_t * node(&f_root);
+    std::string_view label;
+    while(next_label(domain, label))
+    {
+        auto it(node->f_children.find(label));
+        if(it == node->f_children.end())
+        {
+            it = node->f_children.emplace(std::string(label), std::make_unique<domain_node_t>()).first;
+        }
+        node = it->second.get();
+    }
+    return *node;
+}
+
+
+bool cookie_jar::remove_cookie(
+      std::string_view domain
+    , std::string_view path
+    , std::string_view name
+    , std::uint64_t creation
+    , time_t expire)
+{
+    domain_node_t * node(find_node(domain));
+    if(node == nullptr)
+    {
+        return false;
+    }
+    for(auto list(node->f_paths.begin()); list != node->f_paths.end(); ++list)
+    {
+        if(list->f_path != path)
+        {
+            continue;
+        }
+        for(auto c(list->f_cookies.begin()); c != list->f_cookies.end(); ++c)
+        {
+            // the heap entry is stale if the cookie was replaced since
+            //
+            if(c->f_name == name
+            && c->f_creation == creation
+            && c->f_expire == expire)
+            {
+                list->f_cookies.erase(c);
+                if(list->f_cookies.empty())
+                {
+                    node->f_paths.erase(list);
+                    prune_nodes(domain);
+                }
+                --f_size;
+                return true;
+            }
+        }
+        break;
+    }
+    return false;
+}
+
+
+/** \brief Remove the empty nodes on the way to \p domain.
+ *
+ * Once the last cookie of a domain is removed, its node and the parent
+ * nodes which have neither cookies nor children get removed so the trie
+ * does not keep growing with the domains seen over time.
+ *
+ * \param[in] domain  The domain which lost its last path list.
+ */
+void cookie_jar::prune_nodes(std::string_view domain)
+{
+    std::vector<std::pair<domain_node_t *, std::string_view>> parents;
+    domain_node_t * node(&f_root);
+    std::string_view label;
+    while(next_label(domain, label))
+    {
+        auto const it(node->f_children.find(label));
+        if(it == node->f_children.end())
+        {
+            return;
+        }
+        parents.emplace_back(node, label);
+        node = it->second.get();
+    }
+
+    while(!parents.empty())
+    {
+        domain_node_t * parent(parents.back().first);
+        auto const it(parent->f_children.find(parents.back().second));
+        if(!it->second->f_paths.empty()
+        || !it->second->f_children.empty())
+        {
+            break;
+        }
+        parent->f_children.erase(it);
+        parents.pop_back();
+    }
+}
+
+
+/** \brief Remove one cookie to make room for a new one.
+ *
+ * The cookie which expires first is removed. Session cookies are never
+ * evicted.
+ *
+ * \return false if no persistent cookie could be removed.
+ */
+bool cookie_jar::evict_one()
+{
+    while(!f_expiry.empty())
+    {
+        expiry_t const e(f_expiry.top());
+        f_expiry.pop();
+        if(remove_cookie(e.f_domain, e.f_path, e.f_name, e.f_creation, e.f_expire))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** \brief Rebuild the expiry heap once it has too many stale entries.
+ *
+ * When a cookie gets replaced with a new expiration date, the old heap
+ * entry remains until it reaches the top. A server refreshing a
+ * Max-Age cookie on each response would make the heap grow forever
+ * so once it is more than twice as large as necessary, it gets rebuilt
+ * from the cookies in the jar.
+ */
+void cookie_jar::compact_expiry()
+{
+    if(f_expiry.size() <= f_size * 2 + 64)
+    {
+        return;
+    }
+
+    std::vector<expiry_t> entries;
+    entries.reserve(f_size);
+    std::vector<domain_node_t const *> nodes{&f_root};
+    while(!nodes.empty())
+    {
+        domain_node_t const * node(nodes.back());
+        nodes.pop_back();
+        for(auto const & child : node->f_children)
+        {
+            nodes.push_back(child.second.get());
+        }
+        for(auto const & list : node->f_paths)
+        {
+            for(auto const & c : list.f_cookies)
+            {
+                if(c.f_expire != -1)
+                {
+                    entries.push_back(expiry_t{c.f_expire, c.f_creation, c.f_domain, c.f_path, c.f_name});
+                }
+            }
+        }
+    }
+    f_expiry = expiry_heap_t(std::greater<expiry_t>(), std::move(entries));
+}
+
+
+/** \brief Save a cookie in the jar.
+ *
+ * \param[in] cookie  The cookie to save, replace, or delete.
+ * \param[in] now  The current time.
+ *
+ * \return false if the cookie could not be saved because the jar is full
+ * of session cookies.
+ */
+bool cookie_jar::store(cookie_t && cookie, time_t now)
+{
+    bool const expired(cookie.f_expire != -1 && cookie.f_expire <= now);
+
+    domain_node_t * node(find_node(cookie.f_domain));
+    if(node != nullptr)
+    {
+        for(auto list(node->f_paths.begin()); list != node->f_paths.end(); ++list)
+        {
+            if(list->f_path != cookie.f_path)
+            {
+                continue;
+            }
+            for(auto c(list->f_cookies.begin()); c != list->f_cookies.end(); ++c)
+            {
+                if(c->f_name != cookie.f_name)
+                {
+                    continue;
+                }
+                if(expired)
+                {
+                    list->f_cookies.erase(c);
+                    if(list->f_cookies.empty())
+                    {
+                        node->f_paths.erase(list);
+                        prune_nodes(cookie.f_domain);
+                    }
+                    --f_size;
+                    return true;
+                }
+
+                // replace, keeping the original creation order
+                //
+                cookie.f_creation = c->f_creation;
+                bool const same_expire(c->f_expire == cookie.f_expire);
+                *c = std::move(cookie);
+                if(c->f_expire != -1
+                && !same_expire)
+                {
+                    f_expiry.push(expiry_t{c->f_expire, c->f_creation, c->f_domain, c->f_path, c->f_name});
+                    compact_expiry();
+                }
+                return true;
+            }
+            break;
+        }
+    }
+
+    if(expired)
+    {
+        return true;
+    }
+
+    if(f_size >= f_max_cookies)
+    {
+        // first get rid of the cookies that already expired, then of
+        // the cookies expiring soonest
+        //
+        while(!f_expiry.empty()
+           && f_expiry.top().f_expire <= now)
+        {
+            expiry_t const e(f_expiry.top());
+            f_expiry.pop();
+            remove_cookie(e.f_domain, e.f_path, e.f_name, e.f_creation, e.f_expire);
+        }
+        while(f_size >= f_max_cookies)
+        {
+            if(!evict_one())
+            {
+                // the jar is full of session cookies
+                //
+                return false;
+            }
+        }
+    }
+
+    cookie.f_creation = f_next_creation++;
+    if(cookie.f_expire != -1)
+    {
+        f_expiry.push(expiry_t{cookie.f_expire, cookie.f_creation, cookie.f_domain, cookie.f_path, cookie.f_name});
+    }
+
+    domain_node_t & n(create_node(cookie.f_domain));
+    auto list(n.f_paths.begin());
+    for(; list != n.f_paths.end(); ++list)
+    {
+        if(list->f_path == cookie.f_path)
+        {
+            break;
+        }
+        if(list->f_path.length() < cookie.f_path.length())
+        {
+            list = n.f_paths.insert(list, path_list_t{cookie.f_path, {}});
+            break;
+        }
+    }
+    if(list == n.f_paths.end())
+    {
+        list = n.f_paths.insert(list, path_list_t{cookie.f_path, {}});
+    }
+    list->f_cookies.push_back(std::move(cookie));
+    ++f_size;
+    return true;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,160 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <cstdint>
+#include    <functional>
+#include    <map>
+#include    <memory>
+#include    <mutex>
+#include    <queue>
+#include    <string>
+#include    <string_view>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+class cookie_jar
+{
+public:
+    typedef std::shared_ptr<cookie_jar>     pointer_t;
+
+    static constexpr std::size_t    DEFAULT_MAX_COOKIES = 3000;
+
+    enum class same_site_t
+    {
+        SAME_SITE_DEFAULT,
+        SAME_SITE_NONE,
+        SAME_SITE_LAX,
+        SAME_SITE_STRICT
+    };
+
+    struct cookie_t
+    {
+        std::string         f_name = std::string();
+        std::string         f_value = std::string();
+        std::string         f_domain = std::string();   // lowercase, no leading period
+        std::string         f_path = std::string();
+        time_t              f_expire = -1;              // -1 for a session cookie
+        std::uint64_t       f_creation = 0;             // creation order, kept when replaced
+        same_site_t         f_same_site = same_site_t::SAME_SITE_DEFAULT;
+        bool                f_host_only = true;
+        bool                f_secure = false;
+        bool                f_http_only = false;
+    };
+
+                        cookie_jar(std::size_t max_cookies = DEFAULT_MAX_COOKIES);
+
+                        cookie_jar(cookie_jar const &) = delete;
+    cookie_jar &        operator = (cookie_jar const &) = delete;
+
+    bool                set_cookie(
+                              std::string_view set_cookie
+                            , std::string_view host
+                            , std::string_view path
+                            , bool secure
+                            , time_t now);
+    void                append_cookies(
+                              std::string & out
+                            , std::string_view host
+                            , std::string_view path
+                            , bool secure
+                            , time_t now) const;
+    std::string         get_cookies(
+                              std::string_view host
+                            , std::string_view path
+                            , bool secure
+                            , time_t now) const;
+    cookie_t const *    find_cookie(
+                              std::string_view domain
+                            , std::string_view path
+                            , std::string_view name) const;
+
+    std::size_t         size() const;
+    std::size_t         get_max_cookies() const;
+    std::size_t         purge_expired(time_t now);
+    void                clear();
+
+    static bool         is_public_suffix(std::string_view domain);
+    static bool         path_match(std::string_view request_path, std::string_view cookie_path);
+    static std::string  default_path(std::string_view request_path);
+
+private:
+    struct path_list_t
+    {
+        std::string         f_path = std::string();
+        std::vector<cookie_t>
+                            f_cookies = std::vector<cookie_t>();
+    };
+
+    struct domain_node_t
+    {
+        std::map<std::string, std::unique_ptr<domain_node_t>, std::less<>>
+                            f_children = std::map<std::string, std::unique_ptr<domain_node_t>, std::less<>>();
+        std::vector<path_list_t>
+                            f_paths = std::vector<path_list_t>();  // longest path first
+    };
+
+    struct expiry_t
+    {
+        bool                operator > (expiry_t const & rhs) const { return f_expire > rhs.f_expire; }
+
+        time_t              f_expire = 0;
+        std::uint64_t       f_creation = 0;
+        std::string         f_domain = std::string();
+        std::string         f_path = std::string();
+        std::string         f_name = std::string();
+    };
+
+    typedef std::priority_queue<expiry_t, std::vector<expiry_t>, std::greater<expiry_t>>
+                                            expiry_heap_t;
+
+    domain_node_t *     find_node(std::string_view domain) const;
+    domain_node_t &     create_node(std::string_view domain);
+    bool                remove_cookie(
+                              std::string_view domain
+                            , std::string_view path
+                            , std::string_view name
+                            , std::uint64_t creation
+                            , time_t expire);
+    void                prune_nodes(std::string_view domain);
+    bool                evict_one();
+    void                compact_expiry();
+    bool                store(cookie_t && cookie, time_t now);
+
+    mutable std::mutex  f_mutex = std::mutex();
+    domain_node_t       f_root = domain_node_t();
+    expiry_heap_t       f_expiry = expiry_heap_t();
+    std::size_t         f_size = 0;
+    std::size_t         f_max_cookies = DEFAULT_MAX_COOKIES;
+    std::uint64_t       f_next_creation = 0;
+    mutable std::vector<cookie_t const *>
+                        f_matches = std::vector<cookie_t const *>();
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
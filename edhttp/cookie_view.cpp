@@ -0,0 +1,356 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Parse the Cookie header sent by clients.
+ *
+ * The http_cookie class describes the cookies a server sends with a
+ * Set-Cookie header. The cookie_view class is the other side: it
+ * parses the Cookie header received with each request and gives
+ * access to the name/value pairs without copying them.
+ */
+
+// self
+//
+#include    "edhttp/cookie_view.h"
+
+#include    "edhttp/exception.h"
+
+
+// C
+//
+#include    <string.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+bool is_ows(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+
+int hex_digit(char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a Cookie header parser.
+ *
+ * This function initializes the parser and parses the \p header if
+ * not empty.
+ *
+ * \warning
+ * The object keeps views to the input string. You must make sure that
+ * the string remains valid for as long as you access the cookies.
+ *
+ * \param[in] header  The value of a Cookie header.
+ *
+ * \sa parse()
+ */
+cookie_view::cookie_view(std::string_view header)
+{
+    if(!header.empty())
+    {
+        parse(header);
+    }
+}
+
+
+/** \brief Parse the value of a Cookie header.
+ *
+ * This function parses the value of a Cookie header as defined in
+ * RFC 6265 section 4.2.1:
+ *
+ * \code
+ *     cookie-header = "Cookie:" OWS cookie-string OWS
+ *     cookie-string = cookie-pair *( ";" SP cookie-pair )
+ *     cookie-pair   = cookie-name "=" cookie-value
+ *     cookie-value  = *cookie-octet / ( DQUOTE *cookie-octet DQUOTE )
+ * \endcode
+ *
+ * The parser runs over the header once and does not copy anything.
+ * The names and values are views in \p header and the first
+ * INLINE_SIZE cookies are saved inside the object so a request with
+ * many cookies does not allocate. Quoted values are returned without
+ * their quotes and no percent decoding is applied; call
+ * get_decoded_value() when a cookie is expected to be encoded.
+ *
+ * Browsers do not always follow the specification, so the parser
+ * accepts any amount of spaces and tabs around the separators. A pair
+ * without a name or without an equal sign is skipped and the function
+ * returns false once done.
+ *
+ * The cookies are appended to the existing list. Call clear() first
+ * to reuse the object.
+ *
+ * \param[in] header  The Cookie header value to parse.
+ *
+ * \return true if all the pairs were valid.
+ */
+bool cookie_view::parse(std::string_view header)
+{
+    bool valid(true);
+    char const * s(header.data());
+    char const * const end(s + header.length());
+    while(s < end)
+    {
+        while(s < end && (is_ows(*s) || *s == ';'))
+        {
+            ++s;
+        }
+        if(s >= end)
+        {
+            break;
+        }
+
+        // memchr() is much faster than a byte by byte loop on long headers
+        //
+        char const * pair_end(static_cast<char const *>(memchr(s, ';', end - s)));
+        if(pair_end == nullptr)
+        {
+            pair_end = end;
+        }
+        char const * const name_start(s);
+        char const * const equal(static_cast<char const *>(memchr(s, '=', pair_end - s)));
+        s = pair_end;
+
+        char const * name_end(equal == nullptr ? name_start : equal);
+        while(name_end > name_start && is_ows(name_end[-1]))
+        {
+            --name_end;
+        }
+        if(name_end == name_start)
+        {
+            valid = false;
+            continue;
+        }
+
+        char const * value_start(equal + 1);
+        while(value_start < pair_end && is_ows(*value_start))
+        {
+            ++value_start;
+        }
+        char const * value_end(pair_end);
+        while(value_end > value_start && is_ows(value_end[-1]))
+        {
+            --value_end;
+        }
+        if(value_end - value_start >= 2
+        && *value_start == '"'
+        && value_end[-1] == '"')
+        {
+            ++value_start;
+            --value_end;
+        }
+
+        cookie_t cookie;
+        cookie.f_name = std::string_view(name_start, name_end - name_start);
+        cookie.f_value = std::string_view(value_start, value_end - value_start);
+        f_cookies.push_back(cookie);
+    }
+
+    return valid;
+}
+
+
+/** \brief Forget about the cookies parsed so far.
+ *
+ * This function clears the list of cookies so the object can be
+ * reused to parse another header.
+ */
+void cookie_view::clear()
+{
+    f_cookies.clear();
+}
+
+
+/** \brief Get the number of cookies.
+ *
+ * \return The number of cookies parsed so far, including duplicates.
+ */
+std::size_t cookie_view::size() const
+{
+    return f_cookies.size();
+}
+
+
+/** \brief Check whether any cookie was found.
+ *
+ * \return true if no cookies were parsed.
+ */
+bool cookie_view::empty() const
+{
+    return f_cookies.empty();
+}
+
+
+/** \brief Get a cookie by index.
+ *
+ * The cookies are kept in the order they appear in the header.
+ *
+ * \exception out_of_range
+ * The \p idx parameter must be smaller than size().
+ *
+ * \param[in] idx  The index of the cookie.
+ *
+ * \return A reference to the cookie name and value.
+ */
+cookie_view::cookie_t const & cookie_view::get_cookie(std::size_t idx) const
+{
+    if(idx >= f_cookies.size())
+    {
+        throw out_of_range("cookie index out of range.");
+    }
+    return f_cookies[idx];
+}
+
+
+/** \brief Check whether a cookie is defined.
+ *
+ * Cookie names are case sensitive.
+ *
+ * \param[in] name  The name of the cookie.
+ *
+ * \return true if a cookie with that name was found.
+ */
+bool cookie_view::has_cookie(std::string_view name) const
+{
+    return find_cookie(name) != nullptr;
+}
+
+
+/** \brief Get the raw value of a cookie.
+ *
+ * When the same name appears more than once, the first one wins. This
+ * is the one with the longest path, since RFC 6265 asks user agents
+ * to sort the cookies that way.
+ *
+ * \param[in] name  The name of the cookie.
+ *
+ * \return The value as found in the header or an empty view.
+ */
+std::string_view cookie_view::get_value(std::string_view name) const
+{
+    cookie_t const * cookie(find_cookie(name));
+    if(cookie == nullptr)
+    {
+        return std::string_view();
+    }
+    return cookie->f_value;
+}
+
+
+/** \brief Get the percent decoded value of a cookie.
+ *
+ * \param[in] name  The name of the cookie.
+ *
+ * \return The decoded value or an empty string.
+ *
+ * \sa percent_decode()
+ */
+std::string cookie_view::get_decoded_value(std::string_view name) const
+{
+    return percent_decode(get_value(name));
+}
+
+
+/** \brief Decode the %XX sequences of a cookie value.
+ *
+ * Cookie values cannot include spaces, commas, semicolons, etc. so
+ * servers often percent encode them. This function reverses that
+ * encoding. Contrary to a query string, a '+' is kept as is. A '%'
+ * which is not followed by two hexadecimal digits is also kept as is.
+ *
+ * \param[in] value  The value to decode.
+ *
+ * \return The decoded value.
+ */
+std::string cookie_view::percent_decode(std::string_view value)
+{
+    std::string result;
+    result.reserve(value.length());
+    std::size_t const max(value.length());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(value[idx] == '%' && idx + 2 < max)
+        {
+            int const hi(hex_digit(value[idx + 1]));
+            int const lo(hex_digit(value[idx + 2]));
+            if(hi >= 0 && lo >= 0)
+            {
+                result += static_cast<char>(hi * 16 + lo);
+                idx += 2;
+                continue;
+            }
+        }
+        result += value[idx];
+    }
+    return result;
+}
+
+
+cookie_view::cookie_t const * cookie_view::find_cookie(std::string_view name) const
+{
+    std::size_t const max(f_cookies.size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(f_cookies[idx].f_name == name)
+        {
+            return &f_cookies[idx];
+        }
+    }
+    return nullptr;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
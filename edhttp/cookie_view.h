@@ -0,0 +1,72 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/inline_vector.h>
+
+
+// C++
+//
+#include    <string>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+class cookie_view
+{
+public:
+    static std::size_t const    INLINE_SIZE = 32;
+
+    struct cookie_t
+    {
+        std::string_view    f_name = std::string_view();
+        std::string_view    f_value = std::string_view();   // without the quotes, not decoded
+    };
+
+                        cookie_view(std::string_view header = std::string_view());
+
+    bool                parse(std::string_view header);
+    void                clear();
+
+    std::size_t         size() const;
+    bool                empty() const;
+    cookie_t const &    get_cookie(std::size_t idx) const;
+    bool                has_cookie(std::string_view name) const;
+    std::string_view    get_value(std::string_view name) const;
+    std::string         get_decoded_value(std::string_view name) const;
+
+    static std::string  percent_decode(std::string_view value);
+
+private:
+    cookie_t const *    find_cookie(std::string_view name) const;
+
+    inline_vector<cookie_t, INLINE_SIZE>
+                        f_cookies = inline_vector<cookie_t, INLINE_SIZE>();
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
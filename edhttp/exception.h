@@ -49,6 +49,7 @@ DECLARE_EXCEPTION(edhttp_exception, too_many_names);
 DECLARE_EXCEPTION(edhttp_exception, unquotable_string);
 
 DECLARE_EXCEPTION(edhttp_exception, cookie_parse_exception);
+DECLARE_EXCEPTION(edhttp_exception, session_cookie_error);
 
 DECLARE_EXCEPTION(edhttp_exception, link_parse_exception);
 DECLARE_EXCEPTION(edhttp_exception, link_parameter_exception);
@@ -59,6 +60,9 @@ DECLARE_EXCEPTION(edhttp_exception, client_no_addresses);
 DECLARE_EXCEPTION(edhttp_exception, client_io_error);
 
 DECLARE_EXCEPTION(edhttp_exception, mime_type_no_magic);
+DECLARE_EXCEPTION(edhttp_exception, mime_type_io_error);
+
+DECLARE_EXCEPTION(edhttp_exception, multipart_error);
 
 
 
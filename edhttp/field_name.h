@@ -0,0 +1,212 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief Interned HTTP field names.
+ *
+ * The well known field names defined in names.an (the `field_...`
+ * entries) are given a small integer identifier. The
+ * get_field_name_id() function converts a field name to its identifier
+ * using a perfect hash table computed at compile time. The comparison
+ * is case insensitive and does not allocate, so code dispatching on
+ * field names can use a switch() instead of lowercasing the name and
+ * comparing it against many strings.
+ *
+ * The list of names is generated from names.an by field_names.cmake.
+ */
+
+// C++
+//
+#include    <cstdint>
+#include    <iterator>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+enum class field_name_t : std::uint8_t
+{
+#define EDHTTP_FIELD_NAME(id, name) id,
+#include    <edhttp/field_names.h>
+#undef EDHTTP_FIELD_NAME
+
+    FIELD_NAME_UNKNOWN
+};
+
+
+
+namespace detail
+{
+
+
+
+constexpr std::string_view const g_field_names[] =
+{
+#define EDHTTP_FIELD_NAME(id, name) name,
+#include    <edhttp/field_names.h>
+#undef EDHTTP_FIELD_NAME
+};
+
+
+constexpr std::size_t const FIELD_NAME_COUNT = std::size(g_field_names);
+
+static_assert(FIELD_NAME_COUNT < 255, "field_name_t uses 8 bits and the table uses 0 as \"empty\".");
+
+
+// with 8 slots per name, a collision free seed is found in a few tries
+//
+constexpr std::size_t field_name_table_size()
+{
+    std::size_t size(1);
+    while(size < FIELD_NAME_COUNT * 8)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+
+constexpr std::size_t const FIELD_NAME_TABLE_SIZE = field_name_table_size();
+
+
+// FNV-1a on the name with bit 5 forced so the hash is case insensitive
+// (other characters may collide; the final comparison is exact)
+//
+constexpr std::uint32_t field_name_hash(std::string_view name, std::uint32_t seed)
+{
+    std::uint32_t h(2166136261U ^ seed);
+    for(auto const c : name)
+    {
+        h ^= static_cast<std::uint8_t>(c) | 0x20;
+        h *= 16777619U;
+    }
+    return h ^ (h >> 16);
+}
+
+
+constexpr char field_name_lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+}
+
+
+constexpr bool field_name_equal(std::string_view lhs, std::string_view rhs)
+{
+    if(lhs.length() != rhs.length())
+    {
+        return false;
+    }
+    for(std::size_t idx(0); idx < lhs.length(); ++idx)
+    {
+        if(field_name_lower(lhs[idx]) != field_name_lower(rhs[idx]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+struct field_name_table_t
+{
+    std::uint32_t       f_seed = 0;
+    std::uint8_t        f_slots[FIELD_NAME_TABLE_SIZE] = {};     // index + 1, 0 means empty
+};
+
+
+constexpr field_name_table_t generate_field_name_table()
+{
+    for(std::uint32_t seed(0);; ++seed)
+    {
+        field_name_table_t table;
+        table.f_seed = seed;
+        bool collision(false);
+        for(std::size_t idx(0); idx < FIELD_NAME_COUNT; ++idx)
+        {
+            std::size_t const slot(field_name_hash(g_field_names[idx], seed) & (FIELD_NAME_TABLE_SIZE - 1));
+            if(table.f_slots[slot] != 0)
+            {
+                collision = true;
+                break;
+            }
+            table.f_slots[slot] = static_cast<std::uint8_t>(idx + 1);
+        }
+        if(!collision)
+        {
+            return table;
+        }
+    }
+}
+
+
+constexpr field_name_table_t const g_field_name_table = generate_field_name_table();
+
+
+
+} // namespace detail
+
+
+
+/** \brief Convert a field name to its identifier.
+ *
+ * The comparison is case insensitive.
+ *
+ * \param[in] name  The name of a field such as "Content-Length".
+ *
+ * \return The identifier of the field or field_name_t::FIELD_NAME_UNKNOWN.
+ */
+constexpr field_name_t get_field_name_id(std::string_view name)
+{
+    std::uint8_t const slot(detail::g_field_name_table.f_slots[
+                detail::field_name_hash(name, detail::g_field_name_table.f_seed)
+                    & (detail::FIELD_NAME_TABLE_SIZE - 1)]);
+    if(slot != 0
+    && detail::field_name_equal(detail::g_field_names[slot - 1], name))
+    {
+        return static_cast<field_name_t>(slot - 1);
+    }
+    return field_name_t::FIELD_NAME_UNKNOWN;
+}
+
+
+/** \brief Get the canonical name of a field.
+ *
+ * \param[in] id  The identifier of the field.
+ *
+ * \return The name as defined in names.an or an empty view for
+ * field_name_t::FIELD_NAME_UNKNOWN.
+ */
+constexpr std::string_view get_field_name(field_name_t id)
+{
+    std::size_t const idx(static_cast<std::size_t>(id));
+    if(idx >= detail::FIELD_NAME_COUNT)
+    {
+        return std::string_view();
+    }
+    return detail::g_field_names[idx];
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,57 @@
+# Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+#
+# https://snapwebsites.org/project/edhttp
+# contact@m2osw.com
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+##
+## Generate the list of HTTP field names from names.an
+##
+## Usage:
+##     cmake -D INPUT=names.an -D OUTPUT=field_names.h -P field_names.cmake
+##
+## Each "field_<name>=<Field-Name>" entry generates one line:
+##     EDHTTP_FIELD_NAME(FIELD_NAME_<NAME>, "<Field-Name>")
+##
+## The "field_<name>_lowercase" entries are aliases and are skipped.
+##
+
+if(NOT INPUT OR NOT OUTPUT)
+    message(FATAL_ERROR "field_names.cmake requires the INPUT and OUTPUT variables.")
+endif()
+
+file(STRINGS ${INPUT} lines REGEX "^field_[a-z0-9_]+=")
+
+set(content "// DO NOT EDIT -- this file is generated from names.an by field_names.cmake\n")
+foreach(line ${lines})
+    string(REGEX REPLACE "^field_([a-z0-9_]+)=(.*)$" "\\1" key "${line}")
+    string(REGEX REPLACE "^field_([a-z0-9_]+)=(.*)$" "\\2" value "${line}")
+    if(NOT key MATCHES "_lowercase$")
+        string(TOUPPER "${key}" id)
+        string(REGEX REPLACE "^\"(.*)\"$" "\\1" value "${value}")
+        string(APPEND content "EDHTTP_FIELD_NAME(FIELD_NAME_${id}, \"${value}\")\n")
+    endif()
+endforeach()
+
+# avoid touching the file when nothing changed so we do not recompile
+#
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} existing)
+endif()
+if(NOT "${existing}" STREQUAL "${content}")
+    file(WRITE ${OUTPUT} "${content}")
+endif()
+
+# vim: ts=4 sw=4 et nocindent
@@ -21,19 +21,23 @@
 //
 #include    "edhttp/health.h"
 
-#include    "edhttp/http_client_server.h"
+#include    "edhttp/exception.h"
+#include    "edhttp/metrics.h"
+#include    "edhttp/names.h"
 
 
 // eventdispatcher
 //
 #include    <eventdispatcher/communicator.h>
 #include    <eventdispatcher/tcp_server_connection.h>
-#include    <eventdispatcher/tcp_server_client_message_connection.h>
+#include    <eventdispatcher/tcp_server_client_buffer_connection.h>
+#include    <eventdispatcher/timer.h>
 
 
 // snaplogger
 //
 #include    <snaplogger/map_diagnostic.h>
+#include    <snaplogger/message.h>
 
 
 // libaddr
@@ -41,6 +45,20 @@
 #include    <libaddr/addr_parser.h>
 
 
+// C++
+//
+#include    <algorithm>
+#include    <array>
+#include    <atomic>
+#include    <deque>
+#include    <mutex>
+
+
+// C
+//
+#include    <string.h>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -67,10 +85,12 @@ namespace
  * * `--health-certificate` -- the certificate (optional)
  * * `--health-listen` -- the IP address to listen
  * * `--health-private-key` -- the private key (optional)
+ * * `--health-watchdog-interval` -- how often the workers get checked
  *
  * Note that the `--health-listen` option is also optional. If not specified,
  * then no health server is created and other processes will not have access
- * to the health of the service.
+ * to the health and metrics of the service. The workers are not checked
+ * either since the watchdog is only created along the health server.
  */
 advgetopt::option const g_options[] =
 {
@@ -81,7 +101,7 @@ advgetopt::option const g_options[] =
         , advgetopt::Flags(advgetopt::all_flags<
                       advgetopt::GETOPT_FLAG_GROUP_OPTIONS
                     , advgetopt::GETOPT_FLAG_REQUIRED>())
-        , advgetopt::Help("the IP and port to listen on for health messages.")
+        , advgetopt::Help("the IP and port to listen on for health and metrics requests.")
     ),
     advgetopt::define_option(
           advgetopt::Name("health-certificate")
@@ -97,6 +117,14 @@ advgetopt::option const g_options[] =
                     , advgetopt::GETOPT_FLAG_REQUIRED>())
         , advgetopt::Help("private key for --health-listen connection.")
     ),
+    advgetopt::define_option(
+          advgetopt::Name("health-watchdog-interval")
+        , advgetopt::Flags(advgetopt::all_flags<
+                      advgetopt::GETOPT_FLAG_GROUP_OPTIONS
+                    , advgetopt::GETOPT_FLAG_REQUIRED>())
+        , advgetopt::DefaultValue("1000")
+        , advgetopt::Help("number of milliseconds between checks of the health workers, 0 to not check them.")
+    ),
 
     // END
     //
@@ -105,7 +133,331 @@ advgetopt::option const g_options[] =
 
 
 
-// TODO: this needs to be a the HTTP server (which we do not quite have yet)
+// the number of lines accepted in a request, including the request line
+//
+constexpr std::size_t const     MAX_REQUEST_LINES = 100;
+
+// the number of microseconds a probe has to send its request
+//
+constexpr std::int64_t const    PROBE_TIMEOUT = 5'000'000;
+
+constexpr char const            g_health_path[] = "/health";
+constexpr char const            g_metrics_path[] = "/metrics";
+constexpr char const            g_text_plain[] = "text/plain; charset=utf-8";
+constexpr char const            g_metrics_text_plain[] = "text/plain; version=0.0.4; charset=utf-8";
+
+
+/** \brief A pre-rendered health response.
+ *
+ * The response includes the header and the body. The HEAD response is
+ * the same buffer limited to the header.
+ */
+struct health_response_t
+{
+    std::string         f_status = std::string();
+    std::string         f_response = std::string();
+    std::size_t         f_header_size = 0;
+};
+
+
+void append_header(
+      std::string & out
+    , std::string_view code
+    , std::string_view content_type
+    , std::size_t content_length
+    , std::string_view extra_fields = std::string_view())
+{
+    out += "HTTP/1.1 ";
+    out += code;
+    out += "\r\n";
+    out += g_name_edhttp_field_content_type;
+    out += ": ";
+    out += content_type;
+    out += "\r\n";
+    out += g_name_edhttp_field_content_length;
+    out += ": ";
+    out += std::to_string(content_length);
+    out += "\r\n";
+    out += g_name_edhttp_field_cache_control;
+    out += ": ";
+    out += g_name_edhttp_param_no_store;
+    out += "\r\n";
+    out += g_name_edhttp_field_connection;
+    out += ": ";
+    out += g_name_edhttp_param_close;
+    out += "\r\n";
+    out += extra_fields;
+    out += "\r\n";
+}
+
+
+health_response_t render_status(std::string const & status)
+{
+    // only "OK" is a success, the other statuses mean that the service
+    // cannot be used (yet)
+    //
+    std::string const body(status + '\n');
+
+    health_response_t result;
+    result.f_status = status;
+    append_header(
+              result.f_response
+            , status == HEALTH_OK
+                    ? "200 OK"
+                    : "503 Service Unavailable"
+            , g_text_plain
+            , body.length());
+    result.f_header_size = result.f_response.length();
+    result.f_response += body;
+    return result;
+}
+
+
+std::string render_error(
+      std::string_view code
+    , std::string_view extra_fields = std::string_view())
+{
+    std::string const body(std::string(code) + '\n');
+    std::string result;
+    append_header(result, code, g_text_plain, body.length(), extra_fields);
+    return result + body;
+}
+
+
+/** \brief The health state shared by all the threads.
+ *
+ * The responses of the known statuses are rendered once. The current
+ * status is a pointer to one of those responses so changing the status
+ * is a simple atomic exchange and a health probe does not need to
+ * generate anything.
+ *
+ * Other statuses get rendered the first time they are used and are
+ * kept until the process exits since a reader may still be sending
+ * that buffer. To bound that memory, at most HEALTH_MAX_CUSTOM_STATUSES
+ * are rendered; the statuses used after that get the HEALTH_ERROR
+ * response.
+ *
+ * The published status is the worst of the status set by the service
+ * and the status derived from its workers by the watchdog.
+ */
+struct health_state_t
+{
+                        health_state_t();
+
+    health_response_t const *
+                        find(std::string const & status);
+    void                publish();
+
+    std::array<health_response_t, 4>
+                        f_known = std::array<health_response_t, 4>();
+    std::mutex          f_mutex = std::mutex();
+    std::deque<health_response_t>
+                        f_custom = std::deque<health_response_t>();
+    bool                f_custom_overflow = false;
+    std::atomic<health_response_t const *>
+                        f_service = nullptr;
+    std::atomic<health_response_t const *>
+                        f_workers = nullptr;
+    std::atomic<health_response_t const *>
+                        f_current = nullptr;
+    std::string const   f_bad_request = render_error("400 Bad Request");
+    std::string const   f_not_found = render_error("404 Not Found");
+    std::string const   f_method_not_allowed = render_error(
+                              "405 Method Not Allowed"
+                            , std::string(g_name_edhttp_field_allow)
+                                + ": "
+                                + g_name_edhttp_method_get
+                                + ", "
+                                + g_name_edhttp_method_head
+                                + "\r\n");
+};
+
+
+health_state_t::health_state_t()
+{
+    f_known[0] = render_status(HEALTH_STARTING);
+    f_known[1] = render_status(HEALTH_OK);
+    f_known[2] = render_status(HEALTH_ERROR);
+    f_known[3] = render_status(HEALTH_FAILED);
+    f_service.store(&f_known[0], std::memory_order_release);
+    f_workers.store(&f_known[1], std::memory_order_release);
+    f_current.store(&f_known[0], std::memory_order_release);
+}
+
+
+health_response_t const * health_state_t::find(std::string const & status)
+{
+    for(auto const & r : f_known)
+    {
+        if(r.f_status == status)
+        {
+            return &r;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+    for(auto const & r : f_custom)
+    {
+        if(r.f_status == status)
+        {
+            return &r;
+        }
+    }
+    if(f_custom.size() >= HEALTH_MAX_CUSTOM_STATUSES)
+    {
+        if(!f_custom_overflow)
+        {
+            f_custom_overflow = true;
+            SNAP_LOG_WARNING
+                << "too many distinct health statuses, publishing \""
+                << status
+                << "\" and further new statuses as \""
+                << HEALTH_ERROR
+                << "\"."
+                << SNAP_LOG_SEND;
+        }
+        return &f_known[2];
+    }
+    f_custom.push_back(render_status(status));
+    return &f_custom.back();
+}
+
+
+int severity(health_response_t const * response)
+{
+    if(response->f_status == HEALTH_OK)
+    {
+        return 0;
+    }
+    if(response->f_status == HEALTH_STARTING)
+    {
+        return 1;
+    }
+    if(response->f_status == HEALTH_FAILED)
+    {
+        return 3;
+    }
+    return 2;
+}
+
+
+/** \brief Publish the worst of the service and workers statuses.
+ *
+ * If the service and the watchdog publish at the same time, the result
+ * may be based on a status which just changed. The watchdog publishes
+ * again on its next tick so this does not last.
+ */
+void health_state_t::publish()
+{
+    health_response_t const * service(f_service.load(std::memory_order_acquire));
+    health_response_t const * workers(f_workers.load(std::memory_order_acquire));
+    health_response_t const * response(severity(workers) > severity(service) ? workers : service);
+    if(f_current.exchange(response, std::memory_order_acq_rel) != response)
+    {
+        snaplogger::set_diagnostic(DIAG_KEY_HEALTH, response->f_status);
+    }
+}
+
+
+health_state_t & get_state()
+{
+    static health_state_t state;
+    return state;
+}
+
+
+
+/** \brief One heartbeat slot per worker.
+ *
+ * The slots are aligned on a cache line so workers do not slow each
+ * other down. A worker only writes to its own slot and the watchdog
+ * only reads the slots.
+ */
+struct alignas(64) worker_slot_t
+{
+    std::atomic<std::uint64_t>  f_heartbeat = 0;
+    std::atomic<worker_state_t> f_state = worker_state_t::WORKER_STATE_IDLE;
+};
+
+
+/** \brief What the watchdog knows about each worker.
+ *
+ * This information is protected by the workers mutex. It is only
+ * accessed when registering workers and when checking them.
+ */
+struct worker_info_t
+{
+    bool                f_used = false;
+    bool                f_stalled = false;
+    std::string         f_name = std::string();
+    std::chrono::steady_clock::duration
+                        f_max_stall = std::chrono::steady_clock::duration();
+    std::uint64_t       f_last_heartbeat = 0;
+    std::chrono::steady_clock::time_point
+                        f_last_change = std::chrono::steady_clock::time_point();
+};
+
+
+struct workers_t
+{
+    std::array<worker_slot_t, HEALTH_MAX_WORKERS>
+                        f_slots = std::array<worker_slot_t, HEALTH_MAX_WORKERS>();
+    std::mutex          f_mutex = std::mutex();
+    std::array<worker_info_t, HEALTH_MAX_WORKERS>
+                        f_info = std::array<worker_info_t, HEALTH_MAX_WORKERS>();
+    metric_gauge &      f_stalled_workers = metrics_registry::instance().get_gauge(
+                              "edhttp_health_stalled_workers"
+                            , "Number of busy workers which did not send a heartbeat in time.");
+};
+
+
+workers_t & get_workers()
+{
+    static workers_t workers;
+    return workers;
+}
+
+
+worker_slot_t & get_slot(int worker)
+{
+    if(static_cast<unsigned int>(worker) >= HEALTH_MAX_WORKERS)
+    {
+        throw out_of_range(
+                  "health worker identifier "
+                + std::to_string(worker)
+                + " is out of range.");
+    }
+    return get_workers().f_slots[worker];
+}
+
+
+/** \brief Render the response to a metrics scrape.
+ *
+ * The buffers are kept between calls so a scrape does not allocate
+ * memory once the buffers are large enough.
+ *
+ * \param[in] head  Whether the body is to be omitted.
+ *
+ * \return The response, valid until the next call in the same thread.
+ */
+std::string_view render_metrics(bool head)
+{
+    thread_local std::string body;
+    thread_local std::string response;
+
+    metrics_registry::instance().render(body);
+
+    response.clear();
+    append_header(response, "200 OK", g_metrics_text_plain, body.length());
+    if(!head)
+    {
+        response += body;
+    }
+    return response;
+}
+
+
+
 class health_server_connection
     : public ed::tcp_server_connection
 {
@@ -120,30 +472,38 @@ public:
                                     , int max_connections = -1
                                     , bool reuse_addr = false);
 
-    void                set_status(std::string const & status);
-    std::string         get_status() const;
-
     // tcp_server_connection implementation
     virtual void        process_accept();
-
-private:
-    std::string         f_status = std::string();
 };
 
 
+/** \brief Answer one health probe.
+ *
+ * The connection reads the request line and the header fields. Once
+ * the empty line is received, it writes the pre-rendered response
+ * selected by the request line and closes the connection.
+ *
+ * A client which does not send its request within PROBE_TIMEOUT gets
+ * disconnected so it does not hold one of the few connection slots.
+ */
 class health_client_connection
-    : public ed::tcp_server_client_message_connection
+    : public ed::tcp_server_client_buffer_connection
 {
 public:
-                                health_client_connection(
-                                      health_server_connection * server
-                                    , ed::tcp_bio_client::pointer_t client);
+                                health_client_connection(ed::tcp_bio_client::pointer_t client);
 
                                 health_client_connection(health_client_connection const &) = delete;
     health_client_connection &  operator = (health_client_connection const &) = delete;
 
+    // tcp_server_client_buffer_connection implementation
+    virtual void                process_line(std::string const & line) override;
+
+    // connection implementation
+    virtual void                process_timeout() override;
+
 private:
-    health_server_connection *  f_server = nullptr;
+    std::string                 f_request_line = std::string();
+    std::size_t                 f_lines = 0;
 };
 
 
@@ -162,23 +522,7 @@ health_server_connection::health_server_connection(
         , max_connections
         , reuse_addr)
 {
-    // do a set_status() so that way we get the set_diagnostic() for "free"
-    //
-    set_status(HEALTH_STARTING);
-}
-
-
-void health_server_connection::set_status(std::string const & status)
-{
-    f_status = status;
-
-    snaplogger::set_diagnostic(DIAG_KEY_HEALTH, status);
-}
-
-
-std::string health_server_connection::get_status() const
-{
-    return f_status;
+    snaplogger::set_diagnostic(DIAG_KEY_HEALTH, get_status());
 }
 
 
@@ -198,7 +542,7 @@ void health_server_connection::process_accept()
         return;
     }
 
-    health_client_connection::pointer_t client(std::make_shared<health_client_connection>(this, new_client));
+    ed::connection::pointer_t client(std::make_shared<health_client_connection>(new_client));
     if(!ed::communicator::instance()->add_connection(client))
     {
         SNAP_LOG_ERROR
@@ -212,17 +556,94 @@ void health_server_connection::process_accept()
 
 
 
-health_client_connection::health_client_connection(
-          health_server_connection * server
-        , ed::tcp_bio_client::pointer_t client)
-    : tcp_server_client_message_connection(client)
-    , f_server(server)
+health_client_connection::health_client_connection(ed::tcp_bio_client::pointer_t client)
+    : tcp_server_client_buffer_connection(client)
+{
+    set_timeout_delay(PROBE_TIMEOUT);
+}
+
+
+void health_client_connection::process_line(std::string const & line)
+{
+    if(is_done())
+    {
+        return;
+    }
+
+    std::string_view l(line);
+    if(!l.empty() && l.back() == '\r')
+    {
+        l.remove_suffix(1);
+    }
+
+    ++f_lines;
+    if(f_lines == 1)
+    {
+        f_request_line = l;
+        return;
+    }
+    std::string_view response;
+    if(l.empty())
+    {
+        // render only now: the metrics response lives in a buffer
+        // shared with the other probes of this thread
+        //
+        response = get_health_response(f_request_line);
+    }
+    else
+    {
+        if(f_lines < MAX_REQUEST_LINES)
+        {
+            // we do not need any of the header fields
+            //
+            return;
+        }
+        response = get_state().f_bad_request;
+    }
+
+    write(response.data(), response.length());
+    mark_done();
+}
+
+
+void health_client_connection::process_timeout()
+{
+    // the client is idle or does not read our response
+    //
+    remove_from_communicator();
+}
+
+
+
+class health_watchdog
+    : public ed::timer
+{
+public:
+    typedef std::shared_ptr<health_watchdog>    pointer_t;
+
+                        health_watchdog(std::int64_t interval_us);
+
+    // timer implementation
+    virtual void        process_timeout() override;
+};
+
+
+health_watchdog::health_watchdog(std::int64_t interval_us)
+    : timer(interval_us)
+{
+    set_name("health_watchdog");
+}
+
+
+void health_watchdog::process_timeout()
 {
+    check_health_workers();
 }
 
 
 
 health_server_connection::pointer_t            g_health_connection;
+health_watchdog::pointer_t                     g_health_watchdog;
 
 
 
@@ -237,6 +658,16 @@ void add_health_options(advgetopt::getopt & opts)
 
 bool process_health_options(advgetopt::getopt & opts)
 {
+    std::int64_t const interval(opts.get_long("health-watchdog-interval"));
+    if(interval < 0 || interval > 3'600'000)
+    {
+        SNAP_LOG_ERROR
+            << "--health-watchdog-interval must be between 0 and 3600000 milliseconds ("
+            << interval
+            << " is not valid)."
+            << SNAP_LOG_SEND;
+        return false;
+    }
     if(!opts.is_defined("health-listen"))
     {
         return true;
@@ -309,27 +740,319 @@ bool process_health_options(advgetopt::getopt & opts)
         return false;
     }
 
+    // the watchdog only updates the status sent to the probes so it is
+    // not useful without the listener
+    //
+    if(interval > 0
+    && g_health_watchdog == nullptr)
+    {
+        g_health_watchdog = std::make_shared<health_watchdog>(interval * 1'000);
+        if(!ed::communicator::instance()->add_connection(g_health_watchdog))
+        {
+            SNAP_LOG_ERROR
+                << "adding the health watchdog to the list of connections failed."
+                << SNAP_LOG_SEND;
+            return false;
+        }
+    }
+
     return true;
 }
 
 
+/** \brief Change the health status of this service.
+ *
+ * The function can be called from any thread. The known statuses
+ * (HEALTH_STARTING, HEALTH_OK, HEALTH_ERROR, HEALTH_FAILED) are
+ * saved without locking anything. The health diagnostic of the logger
+ * is updated only when the published status changes.
+ *
+ * The response sent to health probes is rendered once per status and
+ * swapped atomically, so a probe costs one write of a cached buffer.
+ *
+ * \param[in] status  The new status.
+ */
 void set_status(std::string const & status)
 {
-    if(g_health_connection != nullptr)
+    health_state_t & state(get_state());
+    health_response_t const * response(state.find(status));
+    if(state.f_service.exchange(response, std::memory_order_acq_rel) != response)
     {
-        g_health_connection->set_status(status);
+        state.publish();
     }
 }
 
 
+/** \brief Get the current health status.
+ *
+ * The status is the last status passed to set_status() unless the
+ * watchdog found a worker in a worse state, in which case it is
+ * HEALTH_ERROR or HEALTH_FAILED.
+ *
+ * \return The current status, HEALTH_STARTING by default.
+ */
 std::string get_status()
 {
-    if(g_health_connection != nullptr)
+    return get_state().f_current.load(std::memory_order_acquire)->f_status;
+}
+
+
+/** \brief Get the response to a health probe.
+ *
+ * This function parses \p request_line and returns the pre-rendered
+ * response to send back:
+ *
+ * * `GET /health` -- the current status, with a 200 code when the
+ *   status is HEALTH_OK and a 503 code otherwise;
+ * * `HEAD /health` -- the same without the body;
+ * * `GET /metrics` -- the metrics of the metrics_registry in the
+ *   Prometheus text exposition format;
+ * * any other method -- 405;
+ * * any other path -- 404;
+ * * an invalid request line -- 400.
+ *
+ * The health responses remain valid until the process exits. The
+ * metrics response remains valid until the next call to this function
+ * in the same thread.
+ *
+ * \param[in] request_line  The first line of the HTTP request, without
+ * the line terminator.
+ *
+ * \return The complete HTTP response.
+ */
+std::string_view get_health_response(std::string_view request_line)
+{
+    health_state_t & state(get_state());
+
+    std::string_view::size_type const method_end(request_line.find(' '));
+    if(method_end == std::string_view::npos)
+    {
+        return state.f_bad_request;
+    }
+    std::string_view const method(request_line.substr(0, method_end));
+    std::string_view const rest(request_line.substr(method_end + 1));
+    std::string_view::size_type const target_end(rest.find(' '));
+    if(target_end == std::string_view::npos
+    || !rest.substr(target_end + 1).starts_with("HTTP/1."))
+    {
+        return state.f_bad_request;
+    }
+    std::string_view const target(rest.substr(0, target_end));
+    std::string_view const path(target.substr(0, target.find('?')));
+    if(path == g_metrics_path)
+    {
+        if(method == g_name_edhttp_method_get
+        || method == g_name_edhttp_method_head)
+        {
+            return render_metrics(method == g_name_edhttp_method_head);
+        }
+        return state.f_method_not_allowed;
+    }
+    if(path != g_health_path)
+    {
+        return state.f_not_found;
+    }
+
+    health_response_t const * response(state.f_current.load(std::memory_order_acquire));
+    if(method == g_name_edhttp_method_get)
     {
-        return g_health_connection->get_status();
+        return response->f_response;
     }
+    if(method == g_name_edhttp_method_head)
+    {
+        return std::string_view(response->f_response).substr(0, response->f_header_size);
+    }
+    return state.f_method_not_allowed;
+}
+
+
+/** \brief Register a worker thread.
+ *
+ * A service with long running worker threads registers each worker so
+ * the watchdog can detect workers which are stuck. While busy, a worker
+ * is expected to call health_heartbeat() at least once every
+ * \p max_stall. Otherwise the watchdog reports it and the published
+ * status becomes HEALTH_ERROR until the worker sends a new heartbeat.
+ *
+ * New workers start in the WORKER_STATE_IDLE state.
+ *
+ * \exception out_of_range
+ * All the HEALTH_MAX_WORKERS slots are already in use.
+ *
+ * \param[in] name  The name of the worker, used in the logs.
+ * \param[in] max_stall  The longest time a busy worker can go without
+ * sending a heartbeat.
+ *
+ * \return The identifier of the worker.
+ */
+int register_health_worker(std::string const & name, std::chrono::milliseconds max_stall)
+{
+    workers_t & workers(get_workers());
+    std::lock_guard<std::mutex> lock(workers.f_mutex);
+    for(std::size_t idx(0); idx < HEALTH_MAX_WORKERS; ++idx)
+    {
+        worker_info_t & info(workers.f_info[idx]);
+        if(!info.f_used)
+        {
+            worker_slot_t & slot(workers.f_slots[idx]);
+            slot.f_state.store(worker_state_t::WORKER_STATE_IDLE, std::memory_order_relaxed);
+
+            info.f_used = true;
+            info.f_stalled = false;
+            info.f_name = name;
+            info.f_max_stall = max_stall;
+            info.f_last_heartbeat = slot.f_heartbeat.load(std::memory_order_relaxed);
+            info.f_last_change = std::chrono::steady_clock::now();
+            return static_cast<int>(idx);
+        }
+    }
+
+    throw out_of_range(
+              "too many health workers, cannot register \""
+            + name
+            + "\".");
+}
+
+
+/** \brief Unregister a worker thread.
+ *
+ * Call this function when a worker exits. Its slot can then be reused.
+ *
+ * \param[in] worker  The identifier returned by register_health_worker().
+ */
+void unregister_health_worker(int worker)
+{
+    worker_slot_t & slot(get_slot(worker));
+    workers_t & workers(get_workers());
+    std::lock_guard<std::mutex> lock(workers.f_mutex);
+    workers.f_info[worker].f_used = false;
+    slot.f_state.store(worker_state_t::WORKER_STATE_IDLE, std::memory_order_relaxed);
+}
+
+
+/** \brief Tell the watchdog that a worker is making progress.
+ *
+ * This function is expected to be called from the worker's loop. It
+ * only increments the heartbeat counter of the worker's slot: no lock,
+ * no clock and no shared cache line. It must only be called by the
+ * worker itself.
+ *
+ * \param[in] worker  The identifier returned by register_health_worker().
+ */
+void health_heartbeat(int worker)
+{
+    std::atomic<std::uint64_t> & heartbeat(get_slot(worker).f_heartbeat);
+    heartbeat.store(heartbeat.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+/** \brief Change the state of a worker.
+ *
+ * Idle workers are not checked for stalls. A worker goes busy when it
+ * starts a task and idle when it waits for the next one. The error and
+ * failed states are reflected in the published status.
+ *
+ * Changing the state also counts as a heartbeat.
+ *
+ * \param[in] worker  The identifier returned by register_health_worker().
+ * \param[in] state  The new state of the worker.
+ */
+void set_health_worker_state(int worker, worker_state_t state)
+{
+    worker_slot_t & slot(get_slot(worker));
+    slot.f_state.store(state, std::memory_order_relaxed);
+    slot.f_heartbeat.fetch_add(1, std::memory_order_release);
+}
+
+
+/** \brief Check the workers and update the published status.
+ *
+ * The watchdog timer calls this function on each tick. A busy worker
+ * which did not send a heartbeat for more than its maximum stall time
+ * gets reported once in the logs and turns the status to HEALTH_ERROR.
+ * A worker in the failed state turns the status to HEALTH_FAILED.
+ *
+ * \param[in] now  The current time.
+ *
+ * \return The number of stalled workers.
+ */
+std::size_t check_health_workers(std::chrono::steady_clock::time_point now)
+{
+    workers_t & workers(get_workers());
+    health_state_t & state(get_state());
+
+    int worst(1);   // index of HEALTH_OK in f_known
+    std::size_t stalled(0);
+    {
+        std::lock_guard<std::mutex> lock(workers.f_mutex);
+        for(std::size_t idx(0); idx < HEALTH_MAX_WORKERS; ++idx)
+        {
+            worker_info_t & info(workers.f_info[idx]);
+            if(!info.f_used)
+            {
+                continue;
+            }
+            worker_slot_t const & slot(workers.f_slots[idx]);
+
+            std::uint64_t const heartbeat(slot.f_heartbeat.load(std::memory_order_acquire));
+            worker_state_t const worker_state(slot.f_state.load(std::memory_order_relaxed));
+            if(heartbeat != info.f_last_heartbeat
+            || worker_state == worker_state_t::WORKER_STATE_IDLE)
+            {
+                info.f_last_heartbeat = heartbeat;
+                info.f_last_change = now;
+                if(info.f_stalled)
+                {
+                    info.f_stalled = false;
+                    SNAP_LOG_INFO
+                        << "health worker \""
+                        << info.f_name
+                        << "\" is making progress again."
+                        << SNAP_LOG_SEND;
+                }
+            }
+
+            switch(worker_state)
+            {
+            case worker_state_t::WORKER_STATE_IDLE:
+                break;
+
+            case worker_state_t::WORKER_STATE_BUSY:
+                if(now - info.f_last_change > info.f_max_stall)
+                {
+                    if(!info.f_stalled)
+                    {
+                        info.f_stalled = true;
+                        SNAP_LOG_ERROR
+                            << "health worker \""
+                            << info.f_name
+                            << "\" did not send a heartbeat in "
+                            << std::chrono::duration_cast<std::chrono::milliseconds>(now - info.f_last_change).count()
+                            << "ms."
+                            << SNAP_LOG_SEND;
+                    }
+                    ++stalled;
+                    worst = std::max(worst, 2);
+                }
+                break;
+
+            case worker_state_t::WORKER_STATE_ERROR:
+                worst = std::max(worst, 2);
+                break;
+
+            case worker_state_t::WORKER_STATE_FAILED:
+                worst = 3;
+                break;
+
+            }
+        }
+    }
+
+    workers.f_stalled_workers.set(static_cast<std::int64_t>(stalled));
+    state.f_workers.store(&state.f_known[worst], std::memory_order_release);
+    state.publish();
 
-    return std::string();
+    return stalled;
 }
 
 
@@ -22,6 +22,14 @@
 #include    <advgetopt/advgetopt.h>
 
 
+// C++
+//
+#include    <chrono>
+#include    <cstdint>
+#include    <string>
+#include    <string_view>
+
+
 
 namespace edhttp
 {
@@ -41,10 +49,38 @@ constexpr char const        HEALTH_ERROR[]    = "ERROR";
 constexpr char const        HEALTH_FAILED[]   = "FAILED";
 
 
+// the maximum number of other statuses rendered by set_status(), further
+// statuses are published as HEALTH_ERROR
+//
+constexpr std::size_t       HEALTH_MAX_CUSTOM_STATUSES = 16;
+
+
+// the maximum number of workers that can register with the watchdog
+//
+constexpr std::size_t       HEALTH_MAX_WORKERS = 64;
+
+
+enum class worker_state_t : std::uint8_t
+{
+    WORKER_STATE_IDLE,          // waiting for work, not checked for stalls
+    WORKER_STATE_BUSY,          // must send heartbeats
+    WORKER_STATE_ERROR,
+    WORKER_STATE_FAILED
+};
+
+
 void            add_health_options(advgetopt::getopt & opts);
 bool            process_health_options(advgetopt::getopt & opts);
 void            set_status(std::string const & status);
 std::string     get_status();
+std::string_view
+                get_health_response(std::string_view request_line);
+
+int             register_health_worker(std::string const & name, std::chrono::milliseconds max_stall);
+void            unregister_health_worker(int worker);
+void            health_heartbeat(int worker);
+void            set_health_worker_state(int worker, worker_state_t state);
+std::size_t     check_health_workers(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
 
 
 
@@ -0,0 +1,554 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/** \file
+ * \brief Probe the health of many services at once.
+ *
+ * The health_checker sends a GET to the health endpoint (see health.h)
+ * of each of its targets and parses the status found in the body of
+ * the response.
+ *
+ * The targets are probed by a set of threads, each using blocking
+ * http_client objects. Each target has its own client which is kept
+ * between calls to check() so the keep-alive connection gets reused
+ * on the following rounds. The threads are also kept between rounds;
+ * they get created by the first check() and wait for the next round
+ * until the health_checker is destroyed.
+ */
+
+// self
+//
+#include    "edhttp/health_checker.h"
+
+#include    "edhttp/exception.h"
+#include    "edhttp/health.h"
+#include    "edhttp/names.h"
+#include    "edhttp/uri.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <atomic>
+#include    <condition_variable>
+#include    <mutex>
+#include    <system_error>
+#include    <thread>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+struct health_checker::target_t
+{
+    std::string                     f_uri = std::string();
+    http_request                    f_request = http_request();
+    std::unique_ptr<http_client>    f_client = std::unique_ptr<http_client>();
+};
+
+
+/** \brief The threads probing the targets along with check().
+ *
+ * Each call to check() starts a new round by incrementing f_round.
+ * The workers wake up, probe targets until f_next goes past the last
+ * one, then decrement f_busy. check() returns once f_busy is zero.
+ */
+struct health_checker::pool_t
+{
+    std::mutex                      f_mutex = std::mutex();
+    std::condition_variable         f_start = std::condition_variable();
+    std::condition_variable         f_done = std::condition_variable();
+    std::vector<std::thread>        f_threads = std::vector<std::thread>();
+    std::uint64_t                   f_round = 0;
+    std::size_t                     f_busy = 0;
+    bool                            f_stop = false;
+    std::atomic<std::size_t>        f_next = 0;
+};
+
+
+
+/** \brief Initialize a health checker.
+ *
+ * \param[in] concurrency  The maximum number of probes running in
+ * parallel.
+ * \param[in] timeout  The maximum amount of time a probe waits on
+ * a server.
+ */
+health_checker::health_checker(
+          std::size_t concurrency
+        , std::chrono::milliseconds timeout)
+    : f_pool(std::make_shared<pool_t>())
+{
+    set_concurrency(concurrency);
+    set_timeout(timeout);
+}
+
+
+health_checker::~health_checker()
+{
+    stop_workers();
+}
+
+
+/** \brief Add a health endpoint to probe.
+ *
+ * The \p uri is the full URI of the endpoint, for example
+ * "http://10.0.0.5:8080/health". The "https" targets are probed over
+ * TLS, whatever their port.
+ *
+ * \exception invalid_parameter
+ * The URI does not resolve to any address or its scheme is not "http"
+ * or "https".
+ *
+ * \param[in] uri  The URI of the health endpoint.
+ */
+void health_checker::add_target(std::string const & uri)
+{
+    std::shared_ptr<target_t> target(std::make_shared<target_t>());
+    target->f_uri = uri;
+
+    // http_request::set_uri() refuses IP addresses which are the most
+    // common form of health target, so parse the URI here instead
+    //
+    edhttp::uri u;
+    if(!u.set_uri(uri, false, true))
+    {
+        throw invalid_parameter(
+                  "health target \""
+                + uri
+                + "\" is not a valid URI: "
+                + u.get_last_error_message());
+    }
+    std::string const & scheme(u.scheme());
+    if(scheme != g_name_edhttp_scheme_http
+    && scheme != g_name_edhttp_scheme_https)
+    {
+        throw invalid_parameter(
+                  "health target \""
+                + uri
+                + "\" must use the http or https scheme.");
+    }
+    target->f_request.set_scheme(scheme);
+    target->f_request.set_address_ranges(u.address_ranges());
+    std::string path(u.path());
+    std::string const query_string(u.query_string());
+    if(!query_string.empty())
+    {
+        path += '?';
+        path += query_string;
+    }
+    target->f_request.set_path(path);
+    if(target->f_request.get_address_ranges().empty())
+    {
+        throw invalid_parameter("health target \"" + uri + "\" has no address.");
+    }
+    target->f_request.set_agent_name("edhttp-health-checker");
+    f_targets.push_back(std::move(target));
+}
+
+
+/** \brief Get the number of targets.
+ *
+ * \return The number of targets added with add_target().
+ */
+std::size_t health_checker::size() const
+{
+    return f_targets.size();
+}
+
+
+/** \brief Remove all the targets.
+ *
+ * This also closes all the connections and clears the last results.
+ */
+void health_checker::clear()
+{
+    f_targets.clear();
+    f_probes.clear();
+}
+
+
+std::size_t health_checker::get_concurrency() const
+{
+    return f_concurrency;
+}
+
+
+/** \brief Change the number of threads used to probe the targets.
+ *
+ * If the pool has more threads than the new concurrency allows, they
+ * all get stopped and the next check() starts the threads it needs.
+ *
+ * \exception invalid_parameter
+ * The concurrency must be at least 1.
+ *
+ * \param[in] concurrency  The maximum number of probes running in
+ * parallel.
+ */
+void health_checker::set_concurrency(std::size_t concurrency)
+{
+    if(concurrency == 0)
+    {
+        throw invalid_parameter("the health checker concurrency must be at least 1.");
+    }
+
+    f_concurrency = concurrency;
+    if(f_pool->f_threads.size() >= f_concurrency)
+    {
+        stop_workers();
+    }
+}
+
+
+std::chrono::milliseconds health_checker::get_timeout() const
+{
+    return f_timeout;
+}
+
+
+/** \brief Change the per probe timeout.
+ *
+ * The timeout limits the whole probe: connecting, sending the request,
+ * and reading the response (see http_client::set_timeout()). The
+ * existing connections are closed so the next check() uses the new
+ * timeout.
+ *
+ * \exception invalid_parameter
+ * The timeout must be positive.
+ *
+ * \param[in] timeout  The new timeout.
+ */
+void health_checker::set_timeout(std::chrono::milliseconds timeout)
+{
+    if(timeout.count() <= 0)
+    {
+        throw invalid_parameter("the health checker timeout must be positive.");
+    }
+
+    f_timeout = timeout;
+    for(auto & t : f_targets)
+    {
+        t->f_client.reset();
+    }
+}
+
+
+/** \brief Probe all the targets.
+ *
+ * This function blocks until all the targets answered, failed, or
+ * timed out. The calling thread probes targets along with up to
+ * concurrency - 1 worker threads. The threads pick the next target
+ * from a shared index so a slow target does not hold the others back.
+ *
+ * The worker threads are created the first time they are needed and
+ * then reused by the following calls.
+ *
+ * \return The results, in the same order as the targets.
+ */
+health_checker::probe_vector_t const & health_checker::check()
+{
+    f_probes.resize(f_targets.size());
+
+    std::size_t const count(std::min(f_concurrency, f_targets.size()));
+    if(count > 1)
+    {
+        start_workers(count - 1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(f_pool->f_mutex);
+        f_pool->f_next.store(0, std::memory_order_relaxed);
+        f_pool->f_busy = f_pool->f_threads.size();
+        ++f_pool->f_round;
+    }
+    f_pool->f_start.notify_all();
+
+    run_round();
+
+    std::unique_lock<std::mutex> lock(f_pool->f_mutex);
+    f_pool->f_done.wait(lock, [this]() { return f_pool->f_busy == 0; });
+
+    return f_probes;
+}
+
+
+/** \brief Get the results of the last call to check().
+ *
+ * \return The results, in the same order as the targets.
+ */
+health_checker::probe_vector_t const & health_checker::get_probes() const
+{
+    return f_probes;
+}
+
+
+/** \brief Count the probes with the specified result.
+ *
+ * \param[in] result  The result to count.
+ *
+ * \return The number of probes of the last check() with that result.
+ */
+std::size_t health_checker::count(result_t result) const
+{
+    return std::count_if(
+              f_probes.begin()
+            , f_probes.end()
+            , [result](probe_t const & p)
+              {
+                  return p.f_result == result;
+              });
+}
+
+
+/** \brief Get the worst result of the last check().
+ *
+ * \return The worst result or RESULT_OK if there were no probes.
+ */
+health_checker::result_t health_checker::get_overall() const
+{
+    result_t overall(result_t::RESULT_OK);
+    for(auto const & p : f_probes)
+    {
+        overall = std::max(overall, p.f_result);
+    }
+    return overall;
+}
+
+
+/** \brief Convert the body of a health response to a result.
+ *
+ * The body is one of the HEALTH_... statuses followed by a newline.
+ * Any other status is viewed as RESULT_UNKNOWN.
+ *
+ * \param[in] body  The body of the response.
+ *
+ * \return The corresponding result.
+ */
+health_checker::result_t health_checker::parse_status(std::string_view body)
+{
+    while(!body.empty()
+       && (body.back() == '\n' || body.back() == '\r' || body.back() == ' '))
+    {
+        body.remove_suffix(1);
+    }
+
+    if(body == HEALTH_OK)
+    {
+        return result_t::RESULT_OK;
+    }
+    if(body == HEALTH_STARTING)
+    {
+        return result_t::RESULT_STARTING;
+    }
+    if(body == HEALTH_ERROR)
+    {
+        return result_t::RESULT_ERROR;
+    }
+    if(body == HEALTH_FAILED)
+    {
+        return result_t::RESULT_FAILED;
+    }
+    return result_t::RESULT_UNKNOWN;
+}
+
+
+char const * health_checker::result_to_string(result_t result)
+{
+    switch(result)
+    {
+    case result_t::RESULT_OK:
+        return "OK";
+
+    case result_t::RESULT_STARTING:
+        return "STARTING";
+
+    case result_t::RESULT_UNKNOWN:
+        return "UNKNOWN";
+
+    case result_t::RESULT_ERROR:
+        return "ERROR";
+
+    case result_t::RESULT_FAILED:
+        return "FAILED";
+
+    case result_t::RESULT_UNREACHABLE:
+        return "UNREACHABLE";
+
+    }
+
+    return "INVALID";
+}
+
+
+/** \brief Make sure the pool has at least \p count threads.
+ *
+ * \param[in] count  The number of threads needed.
+ */
+void health_checker::start_workers(std::size_t count)
+{
+    std::lock_guard<std::mutex> lock(f_pool->f_mutex);
+    while(f_pool->f_threads.size() < count)
+    {
+        try
+        {
+            f_pool->f_threads.emplace_back(&health_checker::worker, this, f_pool->f_round);
+        }
+        catch(std::system_error const &)
+        {
+            // out of threads, work with what we have
+            //
+            break;
+        }
+    }
+}
+
+
+/** \brief Stop and join all the threads of the pool.
+ */
+void health_checker::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(f_pool->f_mutex);
+        f_pool->f_stop = true;
+    }
+    f_pool->f_start.notify_all();
+
+    for(auto & t : f_pool->f_threads)
+    {
+        t.join();
+    }
+    f_pool->f_threads.clear();
+    f_pool->f_stop = false;
+}
+
+
+/** \brief The loop of a worker thread.
+ *
+ * \param[in] round  The last round started before this thread.
+ */
+void health_checker::worker(std::uint64_t round)
+{
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(f_pool->f_mutex);
+            f_pool->f_start.wait(lock, [this, round]()
+                {
+                    return f_pool->f_stop || f_pool->f_round != round;
+                });
+            if(f_pool->f_stop)
+            {
+                return;
+            }
+            round = f_pool->f_round;
+        }
+
+        run_round();
+
+        std::lock_guard<std::mutex> lock(f_pool->f_mutex);
+        --f_pool->f_busy;
+        if(f_pool->f_busy == 0)
+        {
+            f_pool->f_done.notify_one();
+        }
+    }
+}
+
+
+/** \brief Probe targets until none are left in this round.
+ */
+void health_checker::run_round()
+{
+    for(;;)
+    {
+        std::size_t const idx(f_pool->f_next.fetch_add(1, std::memory_order_relaxed));
+        if(idx >= f_targets.size())
+        {
+            break;
+        }
+        probe(*f_targets[idx], f_probes[idx]);
+    }
+}
+
+
+/** \brief Probe one target.
+ *
+ * On any error the client of the target is dropped so the next round
+ * starts with a new connection.
+ *
+ * \param[in,out] target  The target to probe.
+ * \param[out] result  Where the result gets saved.
+ */
+void health_checker::probe(target_t & target, probe_t & result)
+{
+    result = probe_t();
+    result.f_uri = target.f_uri;
+
+    std::chrono::steady_clock::time_point const start(std::chrono::steady_clock::now());
+    try
+    {
+        if(target.f_client == nullptr)
+        {
+            target.f_client = std::make_unique<http_client>();
+            target.f_client->set_cookie_jar(cookie_jar::pointer_t());
+            target.f_client->set_timeout(f_timeout);
+        }
+
+        http_response::pointer_t response(target.f_client->send_request(target.f_request));
+        result.f_response_code = response->get_response_code();
+        result.f_status = response->get_response();
+        while(!result.f_status.empty()
+           && (result.f_status.back() == '\n' || result.f_status.back() == '\r'))
+        {
+            result.f_status.pop_back();
+        }
+        if(result.f_response_code == 200
+        || result.f_response_code == 503)
+        {
+            result.f_result = parse_status(result.f_status);
+        }
+        else
+        {
+            result.f_result = result_t::RESULT_UNKNOWN;
+            result.f_error = "unexpected response code "
+                           + std::to_string(result.f_response_code)
+                           + ".";
+        }
+    }
+    catch(std::exception const & e)
+    {
+        target.f_client.reset();
+        result.f_result = result_t::RESULT_UNREACHABLE;
+        result.f_error = e.what();
+    }
+    result.f_duration = std::chrono::steady_clock::now() - start;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,124 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/http_client_server.h>
+
+
+// C++
+//
+#include    <chrono>
+#include    <cstdint>
+#include    <memory>
+#include    <string>
+#include    <string_view>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+class health_checker
+{
+public:
+    typedef std::shared_ptr<health_checker>     pointer_t;
+
+    static constexpr std::size_t    DEFAULT_CONCURRENCY = 64;
+    static constexpr std::chrono::milliseconds
+                                    DEFAULT_TIMEOUT = std::chrono::milliseconds(2'000);
+
+    // sorted from best to worst
+    //
+    enum class result_t
+    {
+        RESULT_OK,
+        RESULT_STARTING,
+        RESULT_UNKNOWN,         // unexpected status or response code
+        RESULT_ERROR,
+        RESULT_FAILED,
+        RESULT_UNREACHABLE      // connection, timeout, or protocol error
+    };
+
+    struct probe_t
+    {
+        std::string         f_uri = std::string();
+        result_t            f_result = result_t::RESULT_UNREACHABLE;
+        int                 f_response_code = 0;
+        std::string         f_status = std::string();
+        std::string         f_error = std::string();
+        std::chrono::steady_clock::duration
+                            f_duration = std::chrono::steady_clock::duration();
+    };
+    typedef std::vector<probe_t>                probe_vector_t;
+
+                        health_checker(
+                              std::size_t concurrency = DEFAULT_CONCURRENCY
+                            , std::chrono::milliseconds timeout = DEFAULT_TIMEOUT);
+                        health_checker(health_checker const &) = delete;
+                        ~health_checker();
+    health_checker &    operator = (health_checker const &) = delete;
+
+    void                add_target(std::string const & uri);
+    std::size_t         size() const;
+    void                clear();
+
+    std::size_t         get_concurrency() const;
+    void                set_concurrency(std::size_t concurrency);
+    std::chrono::milliseconds
+                        get_timeout() const;
+    void                set_timeout(std::chrono::milliseconds timeout);
+
+    probe_vector_t const &
+                        check();
+    probe_vector_t const &
+                        get_probes() const;
+    std::size_t         count(result_t result) const;
+    result_t            get_overall() const;
+
+    static result_t     parse_status(std::string_view body);
+    static char const * result_to_string(result_t result);
+
+private:
+    struct target_t;
+    struct pool_t;
+
+    void                start_workers(std::size_t count);
+    void                stop_workers();
+    void                worker(std::uint64_t round);
+    void                run_round();
+    void                probe(target_t & target, probe_t & result);
+
+    std::vector<std::shared_ptr<target_t>>
+                        f_targets = std::vector<std::shared_ptr<target_t>>();
+    std::shared_ptr<pool_t>
+                        f_pool = std::shared_ptr<pool_t>();
+    probe_vector_t      f_probes = probe_vector_t();
+    std::size_t         f_concurrency = DEFAULT_CONCURRENCY;
+    std::chrono::milliseconds
+                        f_timeout = DEFAULT_TIMEOUT;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
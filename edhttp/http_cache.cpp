@@ -0,0 +1,647 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/** \file
+ * \brief Shared in-memory HTTP object cache.
+ *
+ * This file implements a cache one can use to keep HTTP responses in
+ * memory. The cache is sharded so multiple threads can access it with
+ * limited contention. Each shard is managed as a segmented LRU (a
+ * probation segment and a protected segment) so a scan of many one time
+ * requests does not flush the objects that are accessed repeatedly.
+ *
+ * Entries get tagged with the tags found in the cache_control_settings
+ * (see cache_control_settings::add_tag()) which allows for surrogate-key
+ * style purges without scanning the entire cache.
+ */
+
+// self
+//
+#include    "edhttp/http_cache.h"
+
+#include    "edhttp/exception.h"
+
+
+// C++
+//
+#include    <functional>
+
+
+// C
+//
+#include    <time.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Percent of a shard budget reserved to the protected segment.
+ *
+ * The segmented LRU keeps objects that were hit at least twice in the
+ * protected segment. This segment can grow up to this percent of the
+ * shard budget. The rest is used by the probation segment.
+ */
+constexpr std::size_t const     g_protected_percent = 80;
+
+
+/** \brief Approximate overhead of one cache entry.
+ *
+ * The byte budget has to account for more than just the response.
+ * This value represents the list node, the index entry, etc.
+ */
+constexpr std::size_t const     g_entry_overhead = 128;
+
+
+
+} // no name namespace
+
+
+
+/** \brief Compute the number of bytes this entry uses.
+ *
+ * This function computes the number of bytes counted against the
+ * cache byte budget for this entry.
+ *
+ * \return The approximate size of this entry in bytes.
+ */
+std::size_t http_cache::entry_t::size() const
+{
+    std::size_t result(g_entry_overhead + f_key.length() + f_response.length());
+    for(auto const & t : f_tags)
+    {
+        result += t.length();
+    }
+    return result;
+}
+
+
+/** \brief Remove an entry from this shard.
+ *
+ * This function removes the specified entry from its segment, the index,
+ * and the tag index.
+ *
+ * \warning
+ * The shard mutex must be locked by the caller.
+ *
+ * \param[in] it  The iterator of the entry to remove.
+ */
+void http_cache::shard_t::remove(lru_t::iterator it)
+{
+    for(auto const & t : it->f_tags)
+    {
+        auto tag(f_tags.find(t));
+        if(tag != f_tags.end())
+        {
+            tag->second.erase(&*it);
+            if(tag->second.empty())
+            {
+                f_tags.erase(tag);
+            }
+        }
+    }
+
+    f_index.erase(it->f_key);
+
+    std::size_t const size(it->size());
+    if(it->f_protected)
+    {
+        f_protected_bytes -= size;
+        f_protected.erase(it);
+    }
+    else
+    {
+        f_probation_bytes -= size;
+        f_probation.erase(it);
+    }
+}
+
+
+/** \brief Move an entry to the head of the protected segment.
+ *
+ * An entry found in the probation segment gets promoted to the protected
+ * segment. An entry already in the protected segment is moved to its head.
+ *
+ * When the protected segment grows over its budget, the least recently
+ * used protected entries get demoted back to the head of the probation
+ * segment, giving them one more chance.
+ *
+ * \warning
+ * The shard mutex must be locked by the caller.
+ *
+ * \param[in] it  The entry to promote.
+ * \param[in] protected_budget  The maximum number of bytes in the
+ * protected segment.
+ */
+void http_cache::shard_t::promote(lru_t::iterator it, std::size_t protected_budget)
+{
+    if(it->f_protected)
+    {
+        f_protected.splice(f_protected.begin(), f_protected, it);
+        return;
+    }
+
+    std::size_t const size(it->size());
+    f_probation_bytes -= size;
+    f_protected_bytes += size;
+    it->f_protected = true;
+    f_protected.splice(f_protected.begin(), f_probation, it);
+
+    while(f_protected_bytes > protected_budget
+       && f_protected.size() > 1)
+    {
+        auto last(std::prev(f_protected.end()));
+        std::size_t const last_size(last->size());
+        f_protected_bytes -= last_size;
+        f_probation_bytes += last_size;
+        last->f_protected = false;
+        f_probation.splice(f_probation.begin(), f_protected, last);
+    }
+}
+
+
+/** \brief Evict entries until the shard fits its budget.
+ *
+ * This function removes the least recently used entries of the probation
+ * segment first. Only if the probation segment is empty does it remove
+ * entries from the protected segment.
+ *
+ * \warning
+ * The shard mutex must be locked by the caller.
+ *
+ * \param[in] byte_budget  The maximum number of bytes in this shard.
+ *
+ * \return The number of entries that were evicted.
+ */
+std::size_t http_cache::shard_t::evict_bytes(std::size_t byte_budget)
+{
+    std::size_t count(0);
+    while(f_probation_bytes + f_protected_bytes > byte_budget)
+    {
+        if(!f_probation.empty())
+        {
+            remove(std::prev(f_probation.end()));
+        }
+        else if(!f_protected.empty())
+        {
+            remove(std::prev(f_protected.end()));
+        }
+        else
+        {
+            break; // LCOV_EXCL_LINE
+        }
+        ++count;
+    }
+
+    return count;
+}
+
+
+/** \brief Initialize an HTTP cache.
+ *
+ * This function creates an HTTP cache which can hold up to \p byte_budget
+ * bytes. The budget is evenly split between \p shard_count shards. Each
+ * shard is protected by its own mutex so threads accessing different
+ * keys rarely block each other.
+ *
+ * \exception invalid_parameter
+ * The \p shard_count parameter must be at least 1 and the \p byte_budget
+ * must be large enough for each shard to be given at least one entry
+ * worth of memory.
+ *
+ * \param[in] byte_budget  The maximum number of bytes to keep in memory.
+ * \param[in] shard_count  The number of shards to use.
+ */
+http_cache::http_cache(std::size_t byte_budget, std::size_t shard_count)
+    : f_byte_budget(byte_budget)
+{
+    if(shard_count == 0)
+    {
+        throw invalid_parameter("the number of shards of an http_cache must be at least 1.");
+    }
+    f_shard_budget = byte_budget / shard_count;
+    if(f_shard_budget < g_entry_overhead)
+    {
+        throw invalid_parameter("the byte budget of an http_cache is too small for the number of shards.");
+    }
+
+    f_shards.reserve(shard_count);
+    for(std::size_t idx(0); idx < shard_count; ++idx)
+    {
+        f_shards.push_back(std::make_unique<shard_t>());
+    }
+}
+
+
+/** \brief Save a response in the cache.
+ *
+ * This function saves the \p response in the cache under \p key.
+ *
+ * The \p settings define whether the response can be cached at all
+ * and for how long:
+ *
+ * \li 'no-store' and 'private' responses are never saved since this
+ *     is a shared cache;
+ * \li 's-maxage', if defined, has priority over 'max-age';
+ * \li 'no-cache' responses are saved but viewed as stale immediately;
+ * \li 'stale-while-revalidate' defines how long after the response
+ *     became stale it can still be returned.
+ *
+ * The tags defined in the \p settings are attached to the entry so
+ * purge_tag() can later remove it.
+ *
+ * If an entry with the same key already exists, it gets replaced.
+ *
+ * \param[in] key  The key used to save this response, in most cases the URI.
+ * \param[in] response  The response to save.
+ * \param[in] settings  The cache control settings of that response.
+ * \param[in] now  The current time or -1 to use time(nullptr).
+ *
+ * \return true if the response was saved in the cache.
+ */
+bool http_cache::store(
+      std::string const & key
+    , std::string const & response
+    , cache_control_settings const & settings
+    , time_t now)
+{
+    if(settings.get_no_store()
+    || settings.get_private())
+    {
+        return false;
+    }
+
+    int64_t ttl(settings.get_s_maxage());
+    if(ttl == cache_control_settings::IGNORE_VALUE)
+    {
+        ttl = settings.get_max_age();
+    }
+    if(settings.get_no_cache()
+    || ttl < 0)
+    {
+        ttl = 0;
+    }
+    int64_t stale(settings.get_stale_while_revalidate());
+    if(stale < 0)
+    {
+        stale = 0;
+    }
+    if(ttl + stale == 0)
+    {
+        return false;
+    }
+
+    if(now < 0)
+    {
+        now = time(nullptr);
+    }
+
+    entry_t e;
+    e.f_key = key;
+    e.f_response = response;
+    e.f_tags = settings.get_tags();
+    e.f_fresh_until = now + ttl;
+    e.f_stale_until = e.f_fresh_until + stale;
+    std::size_t const size(e.size());
+    if(size > f_shard_budget)
+    {
+        return false;
+    }
+
+    shard_t & s(get_shard(key));
+    std::lock_guard<std::mutex> lock(s.f_mutex);
+
+    auto const existing(s.f_index.find(key));
+    if(existing != s.f_index.end())
+    {
+        s.remove(existing->second);
+    }
+
+    s.f_probation.push_front(std::move(e));
+    auto it(s.f_probation.begin());
+    s.f_probation_bytes += size;
+    s.f_index[key] = it;
+    for(auto const & t : it->f_tags)
+    {
+        s.f_tags[t].insert(&*it);
+    }
+
+    s.evict_bytes(f_shard_budget);
+
+    return true;
+}
+
+
+/** \brief Search the cache for a response.
+ *
+ * This function searches the cache for the response saved under \p key.
+ *
+ * If the response is still fresh, it is copied in \p response and the
+ * function returns LOOKUP_FRESH.
+ *
+ * If the response is stale but still within its 'stale-while-revalidate'
+ * window, it is copied in \p response and the function returns
+ * LOOKUP_REVALIDATE to the first caller and LOOKUP_STALE to the following
+ * callers. The caller receiving LOOKUP_REVALIDATE is expected to fetch
+ * a new copy and call store() with it. That way only one request goes
+ * back to the origin server.
+ *
+ * The revalidation is a lease: if store() does not get called within
+ * get_revalidation_lease() seconds, the next lookup returns
+ * LOOKUP_REVALIDATE again. A caller which fails to fetch a new copy
+ * can call cancel_revalidation() to hand the revalidation to the next
+ * caller immediately.
+ *
+ * Otherwise the entry is removed and the function returns LOOKUP_MISS.
+ *
+ * \param[in] key  The key of the response to search.
+ * \param[out] response  The response if found.
+ * \param[in] now  The current time or -1 to use time(nullptr).
+ *
+ * \return One of the LOOKUP_... values.
+ */
+http_cache::lookup_t http_cache::lookup(
+      std::string const & key
+    , std::string & response
+    , time_t now)
+{
+    if(now < 0)
+    {
+        now = time(nullptr);
+    }
+
+    shard_t & s(get_shard(key));
+    std::lock_guard<std::mutex> lock(s.f_mutex);
+
+    auto const existing(s.f_index.find(key));
+    if(existing == s.f_index.end())
+    {
+        return lookup_t::LOOKUP_MISS;
+    }
+
+    lru_t::iterator it(existing->second);
+    if(now >= it->f_stale_until)
+    {
+        s.remove(it);
+        return lookup_t::LOOKUP_MISS;
+    }
+
+    s.promote(it, f_shard_budget * g_protected_percent / 100);
+    response = it->f_response;
+
+    if(now < it->f_fresh_until)
+    {
+        return lookup_t::LOOKUP_FRESH;
+    }
+
+    if(now < it->f_revalidate_until)
+    {
+        return lookup_t::LOOKUP_STALE;
+    }
+    it->f_revalidate_until = now + f_revalidation_lease.load(std::memory_order_relaxed);
+    return lookup_t::LOOKUP_REVALIDATE;
+}
+
+
+/** \brief Give up on a revalidation.
+ *
+ * A caller who received LOOKUP_REVALIDATE from lookup() and could not
+ * get a new copy of the response (i.e. the origin server is down or
+ * the request was abandoned) calls this function so the next lookup()
+ * returns LOOKUP_REVALIDATE instead of waiting for the lease to expire.
+ *
+ * \param[in] key  The key of the entry being revalidated.
+ *
+ * \return true if the entry exists and was being revalidated.
+ */
+bool http_cache::cancel_revalidation(std::string const & key)
+{
+    shard_t & s(get_shard(key));
+    std::lock_guard<std::mutex> lock(s.f_mutex);
+
+    auto const existing(s.f_index.find(key));
+    if(existing == s.f_index.end()
+    || existing->second->f_revalidate_until == 0)
+    {
+        return false;
+    }
+    existing->second->f_revalidate_until = 0;
+
+    return true;
+}
+
+
+/** \brief Remove one entry from the cache.
+ *
+ * This function removes the entry saved under \p key.
+ *
+ * \param[in] key  The key of the entry to remove.
+ *
+ * \return true if the entry existed.
+ */
+bool http_cache::erase(std::string const & key)
+{
+    shard_t & s(get_shard(key));
+    std::lock_guard<std::mutex> lock(s.f_mutex);
+
+    auto const existing(s.f_index.find(key));
+    if(existing == s.f_index.end())
+    {
+        return false;
+    }
+    s.remove(existing->second);
+
+    return true;
+}
+
+
+/** \brief Remove all the entries marked with the specified tag.
+ *
+ * This function removes all the entries that were saved with the
+ * specified \p tag. The tags are indexed so this function only visits
+ * the entries that include that tag (along with one index lookup per
+ * shard).
+ *
+ * \param[in] tag  The tag of the entries to remove.
+ *
+ * \return The number of entries removed.
+ */
+std::size_t http_cache::purge_tag(std::string const & tag)
+{
+    std::size_t count(0);
+    for(auto & s : f_shards)
+    {
+        std::lock_guard<std::mutex> lock(s->f_mutex);
+
+        auto const tagged(s->f_tags.find(tag));
+        if(tagged == s->f_tags.end())
+        {
+            continue;
+        }
+
+        // remove() modifies the tag index so we need a copy of the keys
+        //
+        std::vector<std::string> keys;
+        keys.reserve(tagged->second.size());
+        for(auto const & e : tagged->second)
+        {
+            keys.push_back(e->f_key);
+        }
+        for(auto const & k : keys)
+        {
+            auto const existing(s->f_index.find(k));
+            if(existing != s->f_index.end())
+            {
+                s->remove(existing->second);
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+/** \brief Remove all the entries from the cache.
+ *
+ * This function empties the cache.
+ */
+void http_cache::clear()
+{
+    for(auto & s : f_shards)
+    {
+        std::lock_guard<std::mutex> lock(s->f_mutex);
+
+        s->f_index.clear();
+        s->f_tags.clear();
+        s->f_probation.clear();
+        s->f_protected.clear();
+        s->f_probation_bytes = 0;
+        s->f_protected_bytes = 0;
+    }
+}
+
+
+/** \brief Retrieve the byte budget.
+ *
+ * This function returns the byte budget as passed to the constructor.
+ *
+ * \return The maximum number of bytes this cache uses.
+ */
+std::size_t http_cache::get_byte_budget() const
+{
+    return f_byte_budget;
+}
+
+
+/** \brief Retrieve the number of bytes currently used by the cache.
+ *
+ * This function sums the number of bytes used by each shard.
+ *
+ * \return The number of bytes used by the cache.
+ */
+std::size_t http_cache::get_byte_size() const
+{
+    std::size_t result(0);
+    for(auto const & s : f_shards)
+    {
+        std::lock_guard<std::mutex> lock(s->f_mutex);
+        result += s->f_probation_bytes + s->f_protected_bytes;
+    }
+    return result;
+}
+
+
+/** \brief Retrieve the number of entries in the cache.
+ *
+ * This function sums the number of entries found in each shard.
+ *
+ * \return The number of entries in the cache.
+ */
+std::size_t http_cache::get_entry_count() const
+{
+    std::size_t result(0);
+    for(auto const & s : f_shards)
+    {
+        std::lock_guard<std::mutex> lock(s->f_mutex);
+        result += s->f_index.size();
+    }
+    return result;
+}
+
+
+/** \brief Get the revalidation lease.
+ *
+ * \return The number of seconds a caller has to revalidate an entry.
+ */
+time_t http_cache::get_revalidation_lease() const
+{
+    return f_revalidation_lease.load(std::memory_order_relaxed);
+}
+
+
+/** \brief Change the revalidation lease.
+ *
+ * When lookup() returns LOOKUP_REVALIDATE, the caller has \p lease
+ * seconds to save a new copy with store(). Past that delay, the
+ * revalidation is viewed as failed and another caller gets
+ * LOOKUP_REVALIDATE.
+ *
+ * \exception invalid_parameter
+ * The lease must be at least 1 second.
+ *
+ * \param[in] lease  The number of seconds allowed for a revalidation.
+ */
+void http_cache::set_revalidation_lease(time_t lease)
+{
+    if(lease < 1)
+    {
+        throw invalid_parameter("the revalidation lease of an http_cache must be at least 1 second.");
+    }
+    f_revalidation_lease.store(lease, std::memory_order_relaxed);
+}
+
+
+/** \brief Retrieve the shard used to save \p key.
+ *
+ * \param[in] key  The key to be hashed.
+ *
+ * \return A reference to the corresponding shard.
+ */
+http_cache::shard_t & http_cache::get_shard(std::string const & key)
+{
+    return *f_shards[std::hash<std::string>()(key) % f_shards.size()];
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,131 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/cache_control.h>
+
+
+// C++
+//
+#include    <atomic>
+#include    <list>
+#include    <memory>
+#include    <mutex>
+#include    <unordered_map>
+#include    <unordered_set>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+class http_cache
+{
+public:
+    typedef std::shared_ptr<http_cache>     pointer_t;
+
+    static std::size_t const    DEFAULT_SHARD_COUNT = 16;
+    static constexpr time_t     DEFAULT_REVALIDATION_LEASE = 10;
+
+    enum class lookup_t
+    {
+        LOOKUP_MISS,            // not in cache (or expired)
+        LOOKUP_FRESH,           // fresh data returned
+        LOOKUP_STALE,           // stale data returned, revalidation in progress
+        LOOKUP_REVALIDATE       // stale data returned, caller must revalidate
+    };
+
+                                http_cache(
+                                      std::size_t byte_budget
+                                    , std::size_t shard_count = DEFAULT_SHARD_COUNT);
+
+                                http_cache(http_cache const &) = delete;
+    http_cache &                operator = (http_cache const &) = delete;
+
+    bool                        store(
+                                      std::string const & key
+                                    , std::string const & response
+                                    , cache_control_settings const & settings
+                                    , time_t now = -1);
+    lookup_t                    lookup(
+                                      std::string const & key
+                                    , std::string & response
+                                    , time_t now = -1);
+    bool                        cancel_revalidation(std::string const & key);
+    bool                        erase(std::string const & key);
+    std::size_t                 purge_tag(std::string const & tag);
+    void                        clear();
+
+    std::size_t                 get_byte_budget() const;
+    std::size_t                 get_byte_size() const;
+    std::size_t                 get_entry_count() const;
+    time_t                      get_revalidation_lease() const;
+    void                        set_revalidation_lease(time_t lease);
+
+private:
+    struct entry_t
+    {
+        std::string                 f_key = std::string();
+        std::string                 f_response = std::string();
+        cache_control_settings::tags_t
+                                    f_tags = cache_control_settings::tags_t();
+        time_t                      f_fresh_until = 0;
+        time_t                      f_stale_until = 0;
+        bool                        f_protected = false;
+        time_t                      f_revalidate_until = 0;
+
+        std::size_t                 size() const;
+    };
+
+    typedef std::list<entry_t>      lru_t;
+
+    struct shard_t
+    {
+        std::size_t                 evict_bytes(std::size_t byte_budget);
+        void                        remove(lru_t::iterator it);
+        void                        promote(lru_t::iterator it, std::size_t protected_budget);
+
+        mutable std::mutex          f_mutex = std::mutex();
+        lru_t                       f_probation = lru_t();
+        lru_t                       f_protected = lru_t();
+        std::unordered_map<std::string, lru_t::iterator>
+                                    f_index = std::unordered_map<std::string, lru_t::iterator>();
+        std::unordered_map<std::string, std::unordered_set<entry_t *>>
+                                    f_tags = std::unordered_map<std::string, std::unordered_set<entry_t *>>();
+        std::size_t                 f_probation_bytes = 0;
+        std::size_t                 f_protected_bytes = 0;
+    };
+
+    shard_t &                   get_shard(std::string const & key);
+
+    std::size_t                 f_byte_budget = 0;
+    std::size_t                 f_shard_budget = 0;
+    std::atomic<time_t>         f_revalidation_lease = DEFAULT_REVALIDATION_LEASE;
+    std::vector<std::unique_ptr<shard_t>>
+                                f_shards = std::vector<std::unique_ptr<shard_t>>();
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -21,8 +21,12 @@
 //
 #include    "edhttp/http_client_server.h"
 
+#include    "edhttp/base64.h"
 #include    "edhttp/exception.h"
+#include    "edhttp/field_name.h"
+#include    "edhttp/metrics.h"
 #include    "edhttp/names.h"
+#include    "edhttp/protocol_trace.h"
 #include    "edhttp/token.h"
 #include    "edhttp/uri.h"
 #include    "edhttp/version.h"
@@ -51,38 +55,729 @@
 // C++
 //
 #include    <algorithm>
+#include    <climits>
 #include    <iostream>
 #include    <sstream>
 
 
+// OpenSSL
+//
+#include    <openssl/err.h>
+#include    <openssl/ssl.h>
+#include    <openssl/x509.h>
+
+
+// C
+//
+#include    <arpa/inet.h>
+#include    <fcntl.h>
+#include    <poll.h>
+#include    <string.h>
+#include    <sys/socket.h>
+#include    <sys/time.h>
+#include    <time.h>
+#include    <unistd.h>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
 
 
 
-namespace edhttp
-{
+namespace edhttp
+{
+
+
+namespace
+{
+
+
+
+struct client_metrics_t
+{
+                        client_metrics_t();
+
+    metric_counter &    f_requests;
+    metric_counter &    f_connections;
+    metric_counter &    f_sent_bytes;
+    metric_counter &    f_received_bytes;
+    metric_histogram &  f_duration;
+    metric_counter *    f_responses[5] = {};
+};
+
+
+client_metrics_t::client_metrics_t()
+    : f_requests(metrics_registry::instance().get_counter(
+              "edhttp_http_client_requests_total"
+            , "Number of requests sent by the HTTP client."))
+    , f_connections(metrics_registry::instance().get_counter(
+              "edhttp_http_client_connections_total"
+            , "Number of connections opened by the HTTP client."))
+    , f_sent_bytes(metrics_registry::instance().get_counter(
+              "edhttp_http_client_sent_bytes_total"
+            , "Number of bytes sent by the HTTP client, headers included."))
+    , f_received_bytes(metrics_registry::instance().get_counter(
+              "edhttp_http_client_received_bytes_total"
+            , "Number of bytes of response bodies received by the HTTP client."))
+    , f_duration(metrics_registry::instance().get_histogram(
+              "edhttp_http_client_request_duration_seconds"
+            , "Time from sending a request to having read its response."))
+{
+    // requests which do not get a response show up as the difference
+    // between the number of requests and the number of responses
+    //
+    for(int idx(0); idx < 5; ++idx)
+    {
+        f_responses[idx] = &metrics_registry::instance().get_counter(
+                  "edhttp_http_client_responses_total"
+                , "Number of responses received by the HTTP client per class of status code."
+                , metric::label("code", std::to_string(idx + 1) + "xx"));
+    }
+}
+
+
+client_metrics_t & get_client_metrics()
+{
+    static client_metrics_t metrics;
+    return metrics;
+}
+
+
+/** \brief Record the trace of one request.
+ *
+ * The trace is only started when a sink is attached. The destructor
+ * sends the trace to the sink whether the request succeeded or not.
+ */
+class trace_scope
+{
+public:
+    trace_scope(trace_sink * sink)
+        : f_sink(sink)
+    {
+        if(f_sink != nullptr)
+        {
+            f_trace.start();
+        }
+    }
+
+    trace_scope(trace_scope const &) = delete;
+    trace_scope & operator = (trace_scope const &) = delete;
+
+    ~trace_scope()
+    {
+        if(f_sink != nullptr)
+        {
+            f_trace.finish();
+            try
+            {
+                f_sink->record(f_trace);
+            }
+            catch(std::exception const & e)
+            {
+                SNAP_LOG_WARNING
+                    << "trace sink failed recording a trace: "
+                    << e.what()
+                    << SNAP_LOG_SEND;
+            }
+        }
+    }
+
+    http_trace * get()
+    {
+        return f_sink == nullptr ? nullptr : &f_trace;
+    }
+
+    void set_error(std::string const & error)
+    {
+        if(f_sink != nullptr)
+        {
+            f_trace.f_error = error;
+        }
+    }
+
+private:
+    trace_sink *        f_sink = nullptr;
+    http_trace          f_trace = http_trace();
+};
+
+
+/** \brief Close a file descriptor on exit.
+ */
+class fd_guard
+{
+public:
+    fd_guard(int fd)
+        : f_fd(fd)
+    {
+    }
+
+    fd_guard(fd_guard const &) = delete;
+
+    ~fd_guard()
+    {
+        if(f_fd != -1)
+        {
+            close(f_fd);
+        }
+    }
+
+    fd_guard & operator = (fd_guard const &) = delete;
+
+    int get() const
+    {
+        return f_fd;
+    }
+
+    int release()
+    {
+        int const fd(f_fd);
+        f_fd = -1;
+        return fd;
+    }
+
+private:
+    int         f_fd = -1;
+};
+
+
+struct ssl_ctx_deleter
+{
+    void operator () (SSL_CTX * ctx) const
+    {
+        SSL_CTX_free(ctx);
+    }
+};
+
+
+struct ssl_deleter
+{
+    void operator () (SSL * ssl) const
+    {
+        SSL_free(ssl);
+    }
+};
+
+
+typedef std::unique_ptr<SSL_CTX, ssl_ctx_deleter>   ssl_ctx_ptr_t;
+typedef std::unique_ptr<SSL, ssl_deleter>           ssl_ptr_t;
+
+
+/** \brief Get the TLS context shared by the timed connections.
+ *
+ * The peer certificate must be signed by one of the certificate
+ * authorities installed on the system.
+ *
+ * \return The TLS context or nullptr if it could not be created.
+ */
+SSL_CTX * get_ssl_context()
+{
+    static ssl_ctx_ptr_t const ctx([]()
+        {
+            ssl_ctx_ptr_t c(SSL_CTX_new(TLS_client_method()));
+            if(c != nullptr)
+            {
+                SSL_CTX_set_min_proto_version(c.get(), TLS1_2_VERSION);
+                SSL_CTX_set_options(c.get(), SSL_OP_NO_COMPRESSION);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+                // many servers close the connection without a close_notify
+                //
+                SSL_CTX_set_options(c.get(), SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+                SSL_CTX_set_verify(c.get(), SSL_VERIFY_PEER, nullptr);
+                SSL_CTX_set_verify_depth(c.get(), 4);
+                if(SSL_CTX_set_default_verify_paths(c.get()) != 1)
+                {
+                    c.reset();
+                }
+            }
+            return c;
+        }());
+    return ctx.get();
+}
+
+
+/** \brief Get the time left before \p deadline.
+ *
+ * \exception client_io_error
+ * The deadline is already reached.
+ *
+ * \param[in] deadline  The time when the request times out.
+ *
+ * \return The number of microseconds left, at least 1.
+ */
+std::chrono::microseconds time_left(std::chrono::steady_clock::time_point deadline)
+{
+    std::chrono::microseconds const left(std::chrono::duration_cast<std::chrono::microseconds>(
+                deadline - std::chrono::steady_clock::now()));
+    if(left.count() <= 0)
+    {
+        throw client_io_error("timed out waiting on the server.");
+    }
+    return left;
+}
+
+
+/** \brief Wait until \p socket is ready for \p events.
+ *
+ * \param[in] socket  The socket to wait on.
+ * \param[in] events  The poll() events to wait for (POLLIN or POLLOUT).
+ * \param[in] deadline  The time when the request times out.
+ *
+ * \return An empty string if the socket is ready, an error message
+ * otherwise.
+ */
+std::string wait_for(int socket, short events, std::chrono::steady_clock::time_point deadline)
+{
+    for(;;)
+    {
+        std::chrono::milliseconds const left(std::chrono::ceil<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()));
+        if(left.count() <= 0)
+        {
+            return "timed out connecting.";
+        }
+
+        pollfd fd = {};
+        fd.fd = socket;
+        fd.events = events;
+        int const r(poll(&fd, 1, static_cast<int>(std::min<std::chrono::milliseconds::rep>(left.count(), INT_MAX))));
+        if(r > 0)
+        {
+            return std::string();
+        }
+        if(r < 0
+        && errno != EINTR)
+        {
+            int const e(errno);
+            return std::string("poll() failed: ") + strerror(e);
+        }
+    }
+}
+
+
+/** \brief Check whether \p host is an IP address.
+ *
+ * The SNI extension only accepts domain names.
+ *
+ * \param[in] host  The host to check.
+ *
+ * \return true if \p host is an IPv4 or IPv6 address.
+ */
+bool is_ip_address(std::string const & host)
+{
+    in6_addr a;
+    return inet_pton(AF_INET, host.c_str(), &a) == 1
+        || inet_pton(AF_INET6, host.c_str(), &a) == 1;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief A connection of the http_client.
+ *
+ * Without a timeout, the client uses an ed::tcp_bio_client. With a
+ * timeout, it opens its own socket so the connection and the TLS
+ * handshake are bounded too (see open_connection()). Once connected,
+ * both kinds of connections are used with blocking I/O limited by
+ * arm_deadline().
+ */
+class client_connection
+{
+public:
+    typedef std::shared_ptr<client_connection>  pointer_t;
+
+                                client_connection() {}
+                                client_connection(client_connection const &) = delete;
+    virtual                     ~client_connection() {}
+    client_connection &         operator = (client_connection const &) = delete;
+
+    virtual int                 get_socket() const = 0;
+    virtual int                 read(char * buf, std::size_t size) = 0;
+    virtual int                 read_line(std::string & line) = 0;
+    virtual int                 write(char const * buf, std::size_t size) = 0;
+
+    void                        arm_deadline(std::chrono::steady_clock::time_point deadline);
+
+private:
+    // a new socket has no timeouts
+    std::chrono::milliseconds   f_armed = std::chrono::milliseconds();
+};
+
+
+/** \brief Limit the next I/O on this connection to the time left.
+ *
+ * The SO_RCVTIMEO and SO_SNDTIMEO options limit each system call
+ * separately. Setting them to what is left of the deadline before
+ * each write and read turns them into one limit for the whole request.
+ * Without a deadline, the options are reset to zero (no limit) so a
+ * kept alive connection does not keep the limit of a previous request.
+ *
+ * The time left is rounded up to the millisecond and the options are
+ * only changed when that value changes, so reading many lines in a row
+ * does not cost two system calls per line.
+ *
+ * \exception client_io_error
+ * The deadline is reached or the options cannot be changed.
+ *
+ * \param[in] deadline  The time when the request times out, or
+ * time_point::max() for no limit.
+ */
+void client_connection::arm_deadline(std::chrono::steady_clock::time_point deadline)
+{
+    std::chrono::milliseconds left(0);
+    if(deadline != std::chrono::steady_clock::time_point::max())
+    {
+        left = std::chrono::ceil<std::chrono::milliseconds>(time_left(deadline));
+    }
+    if(left == f_armed)
+    {
+        return;
+    }
+
+    // the options are unknown until both calls succeed
+    //
+    f_armed = std::chrono::milliseconds(-1);
+
+    timeval tv = {};
+    tv.tv_sec = static_cast<time_t>(left.count() / 1'000);
+    tv.tv_usec = static_cast<suseconds_t>(left.count() % 1'000 * 1'000);
+    if(setsockopt(get_socket(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0
+    || setsockopt(get_socket(), SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0)
+    {
+        int const e(errno);
+        throw client_io_error(std::string("could not set the socket timeouts: ") + strerror(e));
+    }
+    f_armed = left;
+}
+
+
+
+namespace
+{
+
+
+
+/** \brief A connection through an ed::tcp_bio_client.
+ */
+class bio_connection
+    : public client_connection
+{
+public:
+    bio_connection(ed::tcp_bio_client::pointer_t client)
+        : f_client(client)
+    {
+    }
+
+    virtual int get_socket() const override
+    {
+        return f_client->get_socket();
+    }
+
+    virtual int read(char * buf, std::size_t size) override
+    {
+        return f_client->read(buf, size);
+    }
+
+    virtual int read_line(std::string & line) override
+    {
+        return f_client->read_line(line);
+    }
+
+    virtual int write(char const * buf, std::size_t size) override
+    {
+        return f_client->write(buf, size);
+    }
+
+private:
+    ed::tcp_bio_client::pointer_t   f_client = ed::tcp_bio_client::pointer_t();
+};
+
+
+/** \brief A connection through a socket connected by open_connection().
+ *
+ * The data is read in blocks and buffered so read_line() does not need
+ * one system call per character.
+ */
+class socket_connection
+    : public client_connection
+{
+public:
+    socket_connection(int socket, ssl_ptr_t ssl)
+        : f_socket(socket)
+        , f_ssl(std::move(ssl))
+    {
+    }
+
+    virtual int get_socket() const override
+    {
+        return f_socket.get();
+    }
+
+    virtual int read(char * buf, std::size_t size) override
+    {
+        std::size_t done(std::min(size, f_buffer.length() - f_pos));
+        memcpy(buf, f_buffer.data() + f_pos, done);
+        f_pos += done;
+        while(done < size)
+        {
+            int const r(raw_read(buf + done, size - done));
+            if(r < 0)
+            {
+                return -1;
+            }
+            if(r == 0)
+            {
+                break;
+            }
+            done += r;
+        }
+        return static_cast<int>(done);
+    }
+
+    virtual int read_line(std::string & line) override
+    {
+        line.clear();
+        for(;;)
+        {
+            std::string::size_type const eol(f_buffer.find('\n', f_pos));
+            if(eol != std::string::npos)
+            {
+                line.append(f_buffer, f_pos, eol - f_pos);
+                f_pos = eol + 1;
+                return static_cast<int>(line.length());
+            }
+            line.append(f_buffer, f_pos);
+            f_buffer.clear();
+            f_pos = 0;
+
+            char buf[BUFSIZ];
+            int const r(raw_read(buf, sizeof(buf)));
+            if(r < 0
+            || (r == 0 && line.empty()))
+            {
+                return -1;
+            }
+            if(r == 0)
+            {
+                return static_cast<int>(line.length());
+            }
+            f_buffer.assign(buf, r);
+        }
+    }
+
+    virtual int write(char const * buf, std::size_t size) override
+    {
+        std::size_t done(0);
+        while(done < size)
+        {
+            std::size_t const chunk(std::min<std::size_t>(size - done, INT_MAX));
+            ssize_t r(-1);
+            if(f_ssl != nullptr)
+            {
+                r = SSL_write(f_ssl.get(), buf + done, static_cast<int>(chunk));
+            }
+            else
+            {
+                r = send(f_socket.get(), buf + done, chunk, MSG_NOSIGNAL);
+                if(r < 0
+                && errno == EINTR)
+                {
+                    continue;
+                }
+            }
+            if(r <= 0)
+            {
+                return -1;
+            }
+            done += r;
+        }
+        return static_cast<int>(done);
+    }
+
+private:
+    int raw_read(char * buf, std::size_t size)
+    {
+        std::size_t const chunk(std::min<std::size_t>(size, INT_MAX));
+        if(f_ssl != nullptr)
+        {
+            int const r(SSL_read(f_ssl.get(), buf, static_cast<int>(chunk)));
+            if(r > 0)
+            {
+                return r;
+            }
+            return SSL_get_error(f_ssl.get(), r) == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+        }
+        for(;;)
+        {
+            ssize_t const r(::read(f_socket.get(), buf, chunk));
+            if(r >= 0)
+            {
+                return static_cast<int>(r);
+            }
+            if(errno != EINTR)
+            {
+                return -1;
+            }
+        }
+    }
+
+    fd_guard                    f_socket;
+    ssl_ptr_t                   f_ssl = ssl_ptr_t();
+    std::string                 f_buffer = std::string();
+    std::string::size_type      f_pos = 0;
+};
+
+
+/** \brief Connect to \p address before \p deadline.
+ *
+ * The ed::tcp_bio_client connects and runs the TLS handshake in its
+ * constructor with blocking calls which, against a blackholed address,
+ * only fail once the kernel gives up on the SYN retries (minutes). This
+ * function connects a non-blocking socket and runs the TLS handshake
+ * with poll() so an unreachable or silent server costs at most the time
+ * left. The socket is then made blocking and handed to the connection.
+ *
+ * With TLS, the certificate of the server must be valid and, unless
+ * \p host is empty, match \p host.
+ *
+ * \param[in] address  The address to connect to.
+ * \param[in] host  The name of the server.
+ * \param[in] secure  Whether to use TLS.
+ * \param[in] deadline  The time when the request times out.
+ * \param[out] error  The error message on failure.
+ *
+ * \return The connection or nullptr on failure.
+ */
+client_connection::pointer_t open_connection(
+      addr::addr const & address
+    , std::string const & host
+    , bool secure
+    , std::chrono::steady_clock::time_point deadline
+    , std::string & error)
+{
+    fd_guard s(address.create_socket(
+                  addr::addr::SOCKET_FLAG_CLOEXEC
+                | addr::addr::SOCKET_FLAG_NONBLOCK));
+    if(s.get() == -1)
+    {
+        int const e(errno);
+        error = std::string("could not create a socket: ") + strerror(e);
+        return client_connection::pointer_t();
+    }
+
+    if(address.connect(s.get()) != 0)
+    {
+        int const e(errno);
+        if(e != EINPROGRESS)
+        {
+            error = std::string("connect() failed: ") + strerror(e);
+            return client_connection::pointer_t();
+        }
+
+        error = wait_for(s.get(), POLLOUT, deadline);
+        if(!error.empty())
+        {
+            return client_connection::pointer_t();
+        }
+
+        int connect_error(0);
+        socklen_t length(sizeof(connect_error));
+        if(getsockopt(s.get(), SOL_SOCKET, SO_ERROR, &connect_error, &length) != 0)
+        {
+            connect_error = errno;
+        }
+        if(connect_error != 0)
+        {
+            error = std::string("connect() failed: ") + strerror(connect_error);
+            return client_connection::pointer_t();
+        }
+    }
+
+    ssl_ptr_t ssl;
+    if(secure)
+    {
+        SSL_CTX * ctx(get_ssl_context());
+        if(ctx != nullptr)
+        {
+            ssl.reset(SSL_new(ctx));
+        }
+        if(ssl == nullptr
+        || SSL_set_fd(ssl.get(), s.get()) != 1)
+        {
+            error = "could not initialize TLS.";
+            return client_connection::pointer_t();
+        }
+        if(!host.empty())
+        {
+            if(!is_ip_address(host))
+            {
+                SSL_set_tlsext_host_name(ssl.get(), host.c_str());
+            }
+            SSL_set1_host(ssl.get(), host.c_str());
+        }
+
+        for(;;)
+        {
+            ERR_clear_error();
+            int const r(SSL_connect(ssl.get()));
+            if(r == 1)
+            {
+                break;
+            }
+            short events(0);
+            switch(SSL_get_error(ssl.get(), r))
+            {
+            case SSL_ERROR_WANT_READ:
+                events = POLLIN;
+                break;
+
+            case SSL_ERROR_WANT_WRITE:
+                events = POLLOUT;
+                break;
+
+            default:
+                {
+                    long const verify(SSL_get_verify_result(ssl.get()));
+                    if(verify != X509_V_OK)
+                    {
+                        error = std::string("TLS handshake failed: ") + X509_verify_cert_error_string(verify);
+                    }
+                    else
+                    {
+                        char const * reason(ERR_reason_error_string(ERR_peek_error()));
+                        error = std::string("TLS handshake failed: ") + (reason == nullptr ? "connection closed" : reason);
+                    }
+                }
+                return client_connection::pointer_t();
+
+            }
+            error = wait_for(s.get(), events, deadline);
+            if(!error.empty())
+            {
+                return client_connection::pointer_t();
+            }
+        }
+    }
+
+    int const flags(fcntl(s.get(), F_GETFL));
+    if(flags == -1
+    || fcntl(s.get(), F_SETFL, flags & ~O_NONBLOCK) != 0)
+    {
+        int const e(errno);
+        error = std::string("could not make the socket blocking: ") + strerror(e);
+        return client_connection::pointer_t();
+    }
 
+    return std::make_shared<socket_connection>(s.release(), std::move(ssl));
+}
 
-namespace
-{
 
-char const g_base64[] =
-{
-    // 8x8 characters
-    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
-    'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-    'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
-    'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-    'w', 'x', 'y', 'z', '0', '1', '2', '3',
-    '4', '5', '6', '7', '8', '9', '+', '/'
-};
 
-}
-// no name namespace
+} // no name namespace
 
 
 
@@ -232,7 +927,89 @@ std::string http_request::get_body() const
 }
 
 
+/** \brief Retrieve the scheme of the request.
+ *
+ * \return "http", "https", or an empty string if not specified.
+ */
+std::string http_request::get_scheme() const
+{
+    return f_scheme;
+}
+
+
+/** \brief Check whether the request is to be sent over TLS.
+ *
+ * When the scheme was defined (see set_uri() and set_scheme()), the
+ * request is secure if the scheme is "https". Otherwise the request
+ * is viewed as secure when sent to port 443.
+ *
+ * \return true if the request uses TLS.
+ */
+bool http_request::is_secure() const
+{
+    if(f_scheme.empty())
+    {
+        return get_port() == 443;
+    }
+    return f_scheme == g_name_edhttp_scheme_https;
+}
+
+
+/** \brief Generate the HTTP request.
+ *
+ * This function generates the request line, the header and the body
+ * to send to the server.
+ *
+ * \param[in] keep_alive  Whether to ask the server to keep the
+ * connection alive.
+ *
+ * \return The request ready to be sent to the server.
+ */
 std::string http_request::get_request(bool keep_alive) const
+{
+    return get_request(keep_alive, std::string());
+}
+
+
+/** \brief Generate the HTTP request with cookies.
+ *
+ * This function generates the request line, the header and the body
+ * to send to the server.
+ *
+ * The \p cookies parameter is used by the http_client to add the cookies
+ * found in its cookie jar. If the request already has a Cookie field,
+ * the \p cookies parameter is ignored.
+ *
+ * \param[in] keep_alive  Whether to ask the server to keep the
+ * connection alive.
+ * \param[in] cookies  The value of the Cookie field or an empty string.
+ *
+ * \return The request ready to be sent to the server.
+ */
+std::string http_request::get_request(bool keep_alive, std::string const & cookies) const
+{
+    return get_request(keep_alive, cookies, std::string());
+}
+
+
+/** \brief Generate the HTTP request with cookies and a traceparent.
+ *
+ * The http_client uses this function to send its traceparent without
+ * having to copy the request. When \p traceparent is not empty, it
+ * replaces the traceparent field of the request, if any.
+ *
+ * \param[in] keep_alive  Whether to ask the server to keep the
+ * connection alive.
+ * \param[in] cookies  The value of the Cookie field or an empty string.
+ * \param[in] traceparent  The value of the traceparent field or an
+ * empty string.
+ *
+ * \return The request ready to be sent to the server.
+ */
+std::string http_request::get_request(
+      bool keep_alive
+    , std::string const & cookies
+    , std::string const & traceparent) const
 {
     std::stringstream request;
 
@@ -297,6 +1074,7 @@ std::string http_request::get_request(bool keep_alive) const
     request << g_name_edhttp_field_host << ": " << get_host() << "\r\n";
 
     bool found_user_agent(false);
+    bool found_cookie(false);
     for(auto it(f_headers.begin()); it != f_headers.end(); ++it)
     {
         // make sure we do not output the following fields which are
@@ -304,22 +1082,41 @@ std::string http_request::get_request(bool keep_alive) const
         //
         //      Content-Length
         //
-        std::string name(it->first);
-        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-        if((content_type.empty() || name != g_name_edhttp_field_content_type_lowercase)
-        && name != g_name_edhttp_field_content_length_lowercase
-        && name != g_name_edhttp_field_host_lowercase
-        && name != g_name_edhttp_field_connection_lowercase)
+        switch(get_field_name_id(it->first))
         {
-            if(name == g_name_edhttp_field_user_agent_lowercase)
+        case field_name_t::FIELD_NAME_CONTENT_TYPE:
+            if(!content_type.empty())
+            {
+                continue;
+            }
+            break;
+
+        case field_name_t::FIELD_NAME_CONTENT_LENGTH:
+        case field_name_t::FIELD_NAME_HOST:
+        case field_name_t::FIELD_NAME_CONNECTION:
+            continue;
+
+        case field_name_t::FIELD_NAME_USER_AGENT:
+            found_user_agent = true;
+            break;
+
+        case field_name_t::FIELD_NAME_COOKIE:
+            found_cookie = true;
+            break;
+
+        default:
+            if(!traceparent.empty()
+            && it->first == g_name_edhttp_field_traceparent)
             {
-                found_user_agent = true;
+                continue;
             }
-            request << it->first
-                    << ": "
-                    << it->second
-                    << "\r\n";
+            break;
+
         }
+        request << it->first
+                << ": "
+                << it->second
+                << "\r\n";
     }
 
     // forcing the type? (generally doing so with POSTs)
@@ -332,6 +1129,23 @@ std::string http_request::get_request(bool keep_alive) const
             << content_type
             << "\r\n";
     }
+    if(!found_cookie
+    && !cookies.empty())
+    {
+        request
+            << g_name_edhttp_field_cookie
+            << ": "
+            << cookies
+            << "\r\n";
+    }
+    if(!traceparent.empty())
+    {
+        request
+            << g_name_edhttp_field_traceparent
+            << ": "
+            << traceparent
+            << "\r\n";
+    }
     if(!found_user_agent)
     {
         request
@@ -406,6 +1220,19 @@ void http_request::set_uri(std::string const & request_uri)
 
     f_address_ranges = u.address_ranges();
 
+    // other schemes are left unspecified (the port decides)
+    //
+    std::string const & scheme(u.scheme());
+    if(scheme == g_name_edhttp_scheme_http
+    || scheme == g_name_edhttp_scheme_https)
+    {
+        f_scheme = scheme;
+    }
+    else
+    {
+        f_scheme.clear();
+    }
+
     // use set_path() to make sure we get an absolute path
     // (which is not the case by default)
     set_path(u.path());
@@ -420,6 +1247,33 @@ void http_request::set_uri(std::string const & request_uri)
 }
 
 
+/** \brief Define the scheme of the request.
+ *
+ * The scheme determines whether the request is sent over TLS and
+ * whether the cookies marked Secure get sent. An empty string means
+ * that the port decides: only port 443 is secure.
+ *
+ * \exception invalid_parameter
+ * The scheme must be "http", "https" or an empty string.
+ *
+ * \param[in] scheme  The new scheme.
+ */
+void http_request::set_scheme(std::string const & scheme)
+{
+    if(!scheme.empty()
+    && scheme != g_name_edhttp_scheme_http
+    && scheme != g_name_edhttp_scheme_https)
+    {
+        throw invalid_parameter(
+                  "unsupported scheme \""
+                + scheme
+                + "\" for an HTTP request.");
+    }
+
+    f_scheme = scheme;
+}
+
+
 void http_request::set_host(std::string const & host)
 {
     int port(get_port());
@@ -544,55 +1398,11 @@ void http_request::set_post(std::string const & name, std::string const & value)
 
 void http_request::set_basic_auth(std::string const & username, std::string const & secret)
 {
-    auto encode = [](std::string const & in, std::string & out)
-    {
-        // reset output (just in case)
-        out.clear();
-
-        // WARNING: following algorithm does NOT take any line length
-        //          in account; and it is deadly well optimized
-        unsigned char const *s(reinterpret_cast<unsigned char const *>(in.c_str()));
-        while(*s != '\0')
-        {
-            // get 1 to 3 characters of input
-            out += g_base64[s[0] >> 2]; // & 0x3F not required
-            ++s;
-            if(s[0] != '\0')
-            {
-                out += g_base64[((s[-1] << 4) & 0x30) | ((s[0] >> 4) & 0x0F)];
-                ++s;
-                if(s[0] != '\0')
-                {
-                    // 24 bits of input uses 4 base64 characters
-                    out += g_base64[((s[-1] << 2) & 0x3C) | ((s[0] >> 6) & 0x03)];
-                    out += g_base64[s[0] & 0x3F];
-                    s++;
-                }
-                else
-                {
-                    // 16 bits of input uses 3 base64 characters + 1 pad
-                    out += g_base64[(s[-1] << 2) & 0x3C];
-                    out += '=';
-                    break;
-                }
-            }
-            else
-            {
-                // 8 bits of input uses 2 base64 characters + 2 pads
-                out += g_base64[(s[-1] << 4) & 0x30];
-                out += "==";
-                break;
-            }
-        }
-    };
+    std::string authorization(g_name_edhttp_param_basic_authorization);
+    authorization += ' ';
+    base64_encode(username + ':' + secret, authorization);
 
-    std::string const authorization_token(username + ":" + secret);
-    std::string base64;
-    encode(authorization_token, base64);
-
-    set_header(
-          g_name_edhttp_field_authorization
-        , g_name_edhttp_param_basic_authorization + (' ' + base64));
+    set_header(g_name_edhttp_field_authorization, authorization);
 }
 
 
@@ -664,6 +1474,37 @@ std::string http_response::get_response() const
 }
 
 
+/** \brief Retrieve the links received in 103 Early Hints responses.
+ *
+ * When the server sends one or more "103 Early Hints" interim responses
+ * before the final response, the values of their Link fields are saved
+ * here, separated by commas. You can parse the result with the
+ * http_link_header class.
+ *
+ * \return The early hints links or an empty string.
+ */
+std::string http_response::get_early_hints() const
+{
+    return f_early_hints;
+}
+
+
+/** \brief Retrieve the Set-Cookie fields of the response.
+ *
+ * A response can include any number of Set-Cookie fields and, contrary
+ * to the other fields, they cannot be concatenated with commas (the
+ * Expires attribute includes a comma). They are therefore saved in a
+ * separate list, in the order received. The get_header() function
+ * returns the last one.
+ *
+ * \return The values of the Set-Cookie fields.
+ */
+std::vector<std::string> const & http_response::get_set_cookies() const
+{
+    return f_set_cookies;
+}
+
+
 void http_response::append_original_header(std::string const & header)
 {
     f_original_header += header;
@@ -701,13 +1542,22 @@ void http_response::set_response(std::string const & response)
 }
 
 
-void http_response::read_response(ed::tcp_bio_client::pointer_t connection)
+void http_response::read_response(
+      client_connection & connection
+    , http_trace * trace
+    , std::chrono::steady_clock::time_point deadline)
 {
     struct reader
     {
-        reader(http_response * response, ed::tcp_bio_client::pointer_t connection)
+        reader(
+                  http_response * response
+                , client_connection & connection
+                , http_trace * trace
+                , std::chrono::steady_clock::time_point deadline)
             : f_response(response)
             , f_connection(connection)
+            , f_trace(trace)
+            , f_deadline(deadline)
         {
         }
 
@@ -716,14 +1566,53 @@ void http_response::read_response(ed::tcp_bio_client::pointer_t connection)
 
         void process()
         {
-            read_protocol();
-            read_header();
+            for(;;)
+            {
+                read_protocol();
+                if(f_trace != nullptr)
+                {
+                    f_trace->mark(trace_phase_t::TRACE_PHASE_FIRST_BYTE);
+                }
+                read_header();
+                if(f_trace != nullptr)
+                {
+                    f_trace->mark(trace_phase_t::TRACE_PHASE_HEADER);
+                }
+
+                // skip interim responses (i.e. 103 Early Hints), the
+                // final response follows; 101 is final (protocol switch)
+                //
+                int const code(f_response->get_response_code());
+                if(code < 100
+                || code >= 200
+                || code == 101)
+                {
+                    break;
+                }
+                auto const link(f_response->f_header.find(g_name_edhttp_field_link_lowercase));
+                if(code == 103
+                && link != f_response->f_header.end())
+                {
+                    if(!f_response->f_early_hints.empty())
+                    {
+                        f_response->f_early_hints += ", ";
+                    }
+                    f_response->f_early_hints += link->second;
+                }
+                f_response->f_header.clear();
+                f_response->f_set_cookies.clear();
+            }
             read_body();
+            if(f_trace != nullptr)
+            {
+                f_trace->mark(trace_phase_t::TRACE_PHASE_BODY);
+            }
         }
 
         int read_line(std::string& line)
         {
-            int r(f_connection->read_line(line));
+            f_connection.arm_deadline(f_deadline);
+            int r(f_connection.read_line(line));
             if(r >= 1)
             {
                 if(*line.rbegin() == '\r')
@@ -739,9 +1628,7 @@ void http_response::read_response(ed::tcp_bio_client::pointer_t connection)
         void read_protocol()
         {
             // first check that the protocol is HTTP and get the answer code
-SNAP_LOG_TRACE
-<< "*** read the protocol line"
-<< SNAP_LOG_SEND;
+            EDHTTP_TRACE("*** read the protocol line");
             std::string protocol;
             int const r(read_line(protocol));
             if(r < 0)
@@ -753,10 +1640,7 @@ SNAP_LOG_TRACE
             }
             f_response->append_original_header(protocol);
 
-SNAP_LOG_TRACE
-<< "*** got protocol: "
-<< protocol
-<< SNAP_LOG_SEND;
+            EDHTTP_TRACE("*** got protocol: " << protocol);
             char const *p(protocol.c_str());
             if(strncmp(p, "HTTP/1.0 ", 9) == 0)
             {
@@ -798,17 +1682,11 @@ SNAP_LOG_TRACE
                 throw client_io_error("unknown response code, expected exactly three digits");
             }
             f_response->set_response_code(response_code);
-SNAP_LOG_TRACE
-<< "***   +---> code: "
-<< response_code
-<< SNAP_LOG_SEND;
+            EDHTTP_TRACE("***   +---> code: " << response_code);
             // skip any spaces after the code
             for(; isspace(*p); ++p);
             f_response->set_http_message(p);
-SNAP_LOG_TRACE
-<< "***   +---> msg: "
-<< p
-<< SNAP_LOG_SEND;
+            EDHTTP_TRACE("***   +---> msg: " << p);
         }
 
         void read_header()
@@ -832,10 +1710,7 @@ SNAP_LOG_TRACE
                 }
                 f_response->append_original_header(field);
 
-SNAP_LOG_TRACE
-<< "got a header field: "
-<< field
-<< SNAP_LOG_SEND;
+                EDHTTP_TRACE("got a header field: " << field);
                 char const * f(field.c_str());
                 char const * e(f);
                 for(; *e != ':' && *e != '\0'; ++e);
@@ -859,6 +1734,10 @@ SNAP_LOG_TRACE
                 for(; end > e && isspace(end[-1]); --end);
                 std::string const value(e, end - e);
 
+                if(name == g_name_edhttp_field_set_cookie_lowercase)
+                {
+                    f_response->f_set_cookies.push_back(value);
+                }
                 f_response->set_header(name, value);
             }
         }
@@ -898,12 +1777,9 @@ SNAP_LOG_TRACE
                 {
                     std::vector<char> buffer;
                     buffer.resize(content_length);
-SNAP_LOG_TRACE
-<< "reading "
-<< content_length
-<< " bytes..."
-<< SNAP_LOG_SEND;
-                    int const r(f_connection->read(&buffer[0], content_length));
+                    EDHTTP_TRACE("reading " << content_length << " bytes...");
+                    f_connection.arm_deadline(f_deadline);
+                    int const r(f_connection.read(&buffer[0], content_length));
                     if(r < 0)
                     {
                         SNAP_LOG_ERROR
@@ -919,11 +1795,7 @@ SNAP_LOG_TRACE
                         throw client_io_error("read returned before the entire content buffer was read");
                     }
                     f_response->set_response(std::string(&buffer[0], content_length));
-SNAP_LOG_TRACE
-<< "body ["
-<< f_response->get_response()
-<< "]..."
-<< SNAP_LOG_SEND;
+                    EDHTTP_TRACE("body [" << f_response->get_response() << "]...");
                 }
             }
             else
@@ -934,7 +1806,8 @@ SNAP_LOG_TRACE
                 std::string response;
                 for(;;)
                 {
-                    int const r(f_connection->read(buffer, BUFSIZ));
+                    f_connection.arm_deadline(f_deadline);
+                    int const r(f_connection.read(buffer, BUFSIZ));
                     if(r < 0)
                     {
                         SNAP_LOG_ERROR
@@ -949,8 +1822,11 @@ SNAP_LOG_TRACE
         }
 
         http_response *                  f_response = nullptr;
-        ed::tcp_bio_client::pointer_t    f_connection = ed::tcp_bio_client::pointer_t();
-    } r(this, connection);
+        client_connection &              f_connection;
+        http_trace *                     f_trace = nullptr;
+        std::chrono::steady_clock::time_point
+                                         f_deadline = std::chrono::steady_clock::time_point::max();
+    } r(this, connection, trace, deadline);
 
     r.process();
 }
@@ -968,8 +1844,136 @@ void http_client::set_keep_alive(bool keep_alive)
 }
 
 
+/** \brief Retrieve the cookie jar of this client.
+ *
+ * \return The cookie jar or nullptr if cookies are turned off.
+ */
+cookie_jar::pointer_t http_client::get_cookie_jar() const
+{
+    return f_cookie_jar;
+}
+
+
+/** \brief Change the cookie jar of this client.
+ *
+ * By default a client has no cookie jar and ignores cookies. Once a
+ * jar is attached, the cookies found in the responses get saved in that
+ * jar and the matching cookies are attached to the following requests.
+ * The Secure cookies are only sent when the request is secure (see
+ * http_request::is_secure()).
+ *
+ * Several clients can share the same jar (i.e. a crawler with one
+ * client per host). Setting the jar to nullptr turns off the cookie
+ * support.
+ *
+ * \param[in] jar  The new cookie jar or nullptr.
+ */
+void http_client::set_cookie_jar(cookie_jar::pointer_t jar)
+{
+    f_cookie_jar = jar;
+}
+
+
+/** \brief Retrieve the I/O timeout of this client.
+ *
+ * \return The timeout, zero when the client waits forever.
+ */
+std::chrono::milliseconds http_client::get_timeout() const
+{
+    return f_timeout;
+}
+
+
+/** \brief Limit the time spent waiting on the server.
+ *
+ * By default the client blocks until the server answers. With a timeout,
+ * each call to send_request() gets a deadline covering the connection,
+ * sending the request, and reading the whole response. Once reached,
+ * send_request() throws a client_io_error. The connection is then
+ * closed since the rest of the response could still arrive.
+ *
+ * With a timeout, the client connects a non-blocking socket and runs
+ * the TLS handshake with poll() so an unreachable or silent server does
+ * not block the client for minutes. Without a timeout, the connection
+ * is an ed::tcp_bio_client.
+ *
+ * The new timeout applies to the next call to send_request().
+ *
+ * \param[in] timeout  The timeout, zero to wait forever.
+ */
+void http_client::set_timeout(std::chrono::milliseconds timeout)
+{
+    if(timeout.count() < 0)
+    {
+        throw invalid_parameter("the client timeout cannot be negative.");
+    }
+
+    f_timeout = timeout;
+}
+
+
+/** \brief Retrieve the trace sink of this client.
+ *
+ * \return The trace sink or nullptr if tracing is turned off.
+ */
+trace_sink::pointer_t http_client::get_trace_sink() const
+{
+    return f_trace_sink;
+}
+
+
+/** \brief Trace the requests sent by this client.
+ *
+ * When a sink is attached, each call to send_request() records the
+ * time spent in each phase of the request (see trace_phase_t) and sends
+ * the resulting http_trace to the sink once the request is done,
+ * whether it succeeded or failed.
+ *
+ * Without a sink, tracing costs one test per phase.
+ *
+ * \param[in] sink  The sink receiving the traces or nullptr.
+ */
+void http_client::set_trace_sink(trace_sink::pointer_t sink)
+{
+    f_trace_sink = sink;
+}
+
+
+bool http_client::get_send_traceparent() const
+{
+    return f_send_traceparent;
+}
+
+
+/** \brief Send a W3C traceparent header along the traced requests.
+ *
+ * If the request already has a valid traceparent header, the client
+ * continues that trace with a new span. Otherwise it starts a new
+ * trace. The identifiers are saved in the http_trace.
+ *
+ * This only applies when a trace sink is attached.
+ *
+ * \param[in] send_traceparent  Whether to send the header.
+ */
+void http_client::set_send_traceparent(bool send_traceparent)
+{
+    f_send_traceparent = send_traceparent;
+}
+
+
 http_response::pointer_t http_client::send_request(http_request const & request)
 {
+    client_metrics_t & metrics(get_client_metrics());
+    metrics.f_requests.increment();
+
+    trace_scope scope(f_trace_sink.get());
+    http_trace * trace(scope.get());
+
+    std::chrono::steady_clock::time_point const deadline(
+              f_timeout.count() > 0
+                    ? std::chrono::steady_clock::now() + f_timeout
+                    : std::chrono::steady_clock::time_point::max());
+
     // we can keep a connection alive, but the host and port cannot
     // change between calls... if you need to make such changes, you
     // may want to consider using another http_client object, otherwise
@@ -984,57 +1988,168 @@ http_response::pointer_t http_client::send_request(http_request const & request)
     {
         f_connection.reset();
     }
+    if(trace != nullptr)
+    {
+        trace->f_method = request.get_method();
+        trace->f_host = host;
+        trace->f_port = port;
+        trace->f_path = request.get_path();
+        trace->f_reused_connection = f_connection != nullptr;
+    }
 
     // if we have no connection, create a new one
+    bool const secure(request.is_secure());
     if(f_connection == nullptr)
     {
-        // TODO: allow user to specify the security instead of using the port
         addr::addr_range::vector_t address_ranges(request.get_address_ranges());
         if(address_ranges.empty())
         {
             SNAP_LOG_ERROR
                 << "no addresses available for client to connect."
                 << SNAP_LOG_SEND;
+            scope.set_error("no addresses available for client to connect.");
             throw client_no_addresses("no addresses available for client to connect.");
         }
+        if(trace != nullptr)
+        {
+            trace->mark(trace_phase_t::TRACE_PHASE_RESOLVE);
+        }
 
         // TODO: attempt connecting to any of the offered addresses
         //
+        std::string connect_error;
         for(auto & r : address_ranges)
         {
-            try
+            if(deadline != std::chrono::steady_clock::time_point::max())
+            {
+                // the ed::tcp_bio_client connect() and TLS handshake
+                // cannot be interrupted
+                //
+                f_connection = open_connection(r.get_from(), host, secure, deadline, connect_error);
+            }
+            else
+            {
+                try
+                {
+                    f_connection = std::make_shared<bio_connection>(std::make_shared<ed::tcp_bio_client>(
+                            r.get_from(),
+                            secure
+                                ? ed::mode_t::MODE_ALWAYS_SECURE
+                                : ed::mode_t::MODE_PLAIN));
+                }
+                catch(ed::failed_connecting const & e)
+                {
+                    // try again on a connection error
+                    //
+                    connect_error = e.what();
+                }
+            }
+            if(f_connection != nullptr)
             {
-                f_connection = std::make_shared<ed::tcp_bio_client>(
-                        r.get_from(),
-                        r.get_from().get_port() == 443
-                            ? ed::mode_t::MODE_ALWAYS_SECURE
-                            : ed::mode_t::MODE_PLAIN);
+                metrics.f_connections.increment();
 
                 // we successfully connected, so exit the loop
                 break;
             }
-            catch(ed::failed_connecting const & e)
+        }
+        if(f_connection == nullptr)
+        {
+            std::string msg("could not connect to any of the addresses of \"" + host + "\"");
+            if(!connect_error.empty())
             {
-                // try again on a connection error
+                msg += " (" + connect_error + ")";
             }
+            msg += '.';
+            scope.set_error(msg);
+            throw client_io_error(msg);
+        }
+        if(trace != nullptr)
+        {
+            trace->mark(trace_phase_t::TRACE_PHASE_CONNECT);
         }
 
         f_host = host;
         f_port = port;
     }
 
+    // add the cookies from our jar
+    //
+    std::string const path(request.get_path());
+    std::string cookies;
+    if(f_cookie_jar != nullptr)
+    {
+        f_cookie_jar->append_cookies(cookies, host, path, secure, time(nullptr));
+    }
+
     // build and send the request to the server
-    std::string const data(request.get_request(f_keep_alive));
+    std::string data;
+    if(trace != nullptr
+    && f_send_traceparent)
+    {
+        if(!trace->set_traceparent(request.get_header(g_name_edhttp_field_traceparent)))
+        {
+            trace->new_trace();
+        }
+        data = request.get_request(f_keep_alive, cookies, trace->get_traceparent());
+    }
+    else
+    {
+        data = request.get_request(f_keep_alive, cookies);
+    }
 //std::cerr << "***\n*** request = [" << data << "]\n***\n";
-    f_connection->write(data.c_str(), data.length());
-
-    // create a response and read the server's answer in that object
     http_response::pointer_t p(new http_response);
-    p->read_response(f_connection);
+    {
+        metric_histogram::timer t(metrics.f_duration);
+        try
+        {
+            f_connection->arm_deadline(deadline);
+            if(f_connection->write(data.c_str(), data.length()) != static_cast<int>(data.length()))
+            {
+                throw client_io_error("write I/O error while sending HTTP request");
+            }
+            metrics.f_sent_bytes.increment(data.length());
+            if(trace != nullptr)
+            {
+                trace->mark(trace_phase_t::TRACE_PHASE_WRITE);
+            }
+
+            // create a response and read the server's answer in that object
+            p->read_response(*f_connection, trace, deadline);
+        }
+        catch(std::exception const & e)
+        {
+            // whatever is left of the response would be read as the
+            // answer to the next request
+            //
+            f_connection.reset();
+            scope.set_error(e.what());
+            throw;
+        }
+    }
+    metrics.f_received_bytes.increment(p->f_response.length());
+    if(trace != nullptr)
+    {
+        trace->f_response_code = p->get_response_code();
+    }
+    int const code_class(p->get_response_code() / 100);
+    if(code_class >= 1 && code_class <= 5)
+    {
+        metrics.f_responses[code_class - 1]->increment();
+    }
+
+    if(f_cookie_jar != nullptr)
+    {
+        time_t const now(time(nullptr));
+        for(auto const & set_cookie : p->get_set_cookies())
+        {
+            f_cookie_jar->set_cookie(set_cookie, host, path, secure, now);
+        }
+    }
 
     // keep connection for further calls?
     if(!f_keep_alive
-    || p->get_header("connection") == "close")
+    || (p->has_header(g_name_edhttp_field_connection_lowercase)
+        && p->get_header(g_name_edhttp_field_connection_lowercase) == g_name_edhttp_param_close))
     {
         f_connection.reset();
     }
@@ -1043,6 +2158,42 @@ http_response::pointer_t http_client::send_request(http_request const & request)
 }
 
 
+/** \brief Send a 103 Early Hints interim response.
+ *
+ * A server calls this function as soon as it knows which resources
+ * the final page requires (i.e. CSS, JavaScript, fonts) and before it
+ * computes the final response. All the \p links are written in one
+ * buffer and sent with a single write().
+ *
+ * \note
+ * Only send early hints to HTTP/1.1 clients. HTTP/1.0 clients do not
+ * expect interim responses.
+ *
+ * \param[in] connection  The connection to the client.
+ * \param[in] links  The links to send, in general "rel=preload" links.
+ *
+ * \return true if the response was sent.
+ */
+bool send_early_hints(
+      ed::tcp_bio_client::pointer_t connection
+    , http_link::vector_t const & links)
+{
+    if(connection == nullptr
+    || links.empty())
+    {
+        return false;
+    }
+
+    std::string buffer;
+    buffer.reserve(64 + links.size() * 96);
+    append_early_hints(buffer, links);
+
+    auto const r(connection->write(buffer.data(), buffer.length()));
+    return r >= 0
+        && static_cast<std::size_t>(r) == buffer.length();
+}
+
+
 
 } // namespace edhttp
 // vim: ts=4 sw=4 et
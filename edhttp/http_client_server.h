@@ -17,6 +17,13 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
+// self
+//
+#include    <edhttp/cookie_jar.h>
+#include    <edhttp/http_link.h>
+#include    <edhttp/http_trace.h>
+
+
 // eventdispatcher
 //
 #include    <eventdispatcher/tcp_bio_client.h>
@@ -29,6 +36,7 @@
 
 // C++
 //
+#include    <chrono>
 #include    <map>
 #include    <vector>
 
@@ -49,6 +57,9 @@ typedef std::map<std::string, std::string>  header_t;
 typedef std::vector<char>                   attachment_t;
 
 
+class client_connection;
+
+
 class http_request
 {
 public:
@@ -67,8 +78,12 @@ public:
     std::string     get_post(std::string const & name) const;
     std::string     get_body() const; // also returns data
     std::string     get_request(bool keep_alive) const;
+    std::string     get_request(bool keep_alive, std::string const & cookies) const;
+    std::string     get_scheme() const;
+    bool            is_secure() const;
 
     void            set_uri(std::string const & uri);
+    void            set_scheme(std::string const & scheme);
     void            set_address_ranges(addr::addr_range::vector_t const & address_ranges);
     void            set_host(std::string const & host);
     void            set_port(int port);
@@ -82,9 +97,17 @@ public:
     void            set_body(std::string const & body);
 
 private:
+    friend class http_client;
+
+    std::string     get_request(
+                          bool keep_alive
+                        , std::string const & cookies
+                        , std::string const & traceparent) const;
+
     //std::string                 f_host = std::string();
     //int32_t                     f_port = -1;
     addr::addr_range::vector_t  f_address_ranges = addr::addr_range::vector_t();
+    std::string                 f_scheme = std::string();
     std::string                 f_agent_name = std::string("edhttp");
     std::string                 f_method = std::string();
     std::string                 f_path = std::string();
@@ -121,6 +144,9 @@ public:
     bool            has_header(std::string const & name) const;
     std::string     get_header(std::string const & name) const;
     std::string     get_response() const;
+    std::string     get_early_hints() const;
+    std::vector<std::string> const &
+                    get_set_cookies() const;
 
     void            append_original_header(std::string const & header);
     void            set_protocol(protocol_t protocol);
@@ -132,7 +158,10 @@ public:
 private:
     friend http_client;
 
-    void            read_response(ed::tcp_bio_client::pointer_t connection);
+    void            read_response(
+                          client_connection & connection
+                        , http_trace * trace
+                        , std::chrono::steady_clock::time_point deadline);
 
     std::string                 f_original_header = std::string();
     protocol_t                  f_protocol = protocol_t::UNKNOWN;
@@ -140,6 +169,8 @@ private:
     std::string                 f_http_message = std::string();
     header_t                    f_header = header_t();
     std::string                 f_response = std::string();
+    std::string                 f_early_hints = std::string();
+    std::vector<std::string>    f_set_cookies = std::vector<std::string>();
 };
 
 
@@ -152,18 +183,36 @@ public:
     http_client &               operator = (http_client const &) = delete;
 
     bool                        get_keep_alive() const;
+    cookie_jar::pointer_t       get_cookie_jar() const;
+    std::chrono::milliseconds   get_timeout() const;
+    trace_sink::pointer_t       get_trace_sink() const;
+    bool                        get_send_traceparent() const;
 
     void                        set_keep_alive(bool keep_alive);
+    void                        set_cookie_jar(cookie_jar::pointer_t jar);
+    void                        set_timeout(std::chrono::milliseconds timeout);
+    void                        set_trace_sink(trace_sink::pointer_t sink);
+    void                        set_send_traceparent(bool send_traceparent);
 
     http_response::pointer_t    send_request(http_request const & request);
 
 private:
     bool                            f_keep_alive = true;
-    ed::tcp_bio_client::pointer_t   f_connection = ed::tcp_bio_client::pointer_t();
+    std::shared_ptr<client_connection>
+                                    f_connection = std::shared_ptr<client_connection>();
     std::string                     f_host = std::string();
     int32_t                         f_port = -1;
+    cookie_jar::pointer_t           f_cookie_jar = cookie_jar::pointer_t();
+    std::chrono::milliseconds       f_timeout = std::chrono::milliseconds();
+    trace_sink::pointer_t           f_trace_sink = trace_sink::pointer_t();
+    bool                            f_send_traceparent = false;
 };
 
 
+bool                            send_early_hints(
+                                      ed::tcp_bio_client::pointer_t connection
+                                    , http_link::vector_t const & links);
+
+
 } // namespace edhttp
 // vim: ts=4 sw=4 et
@@ -21,21 +21,23 @@
 //
 #include    "edhttp/http_cookie.h"
 
+#include    "edhttp/civil_time.h"
 #include    "edhttp/exception.h"
 #include    "edhttp/http_date.h"
-#include    "edhttp/mkgmtime.h"
 #include    "edhttp/names.h"
 #include    "edhttp/token.h"
 
 
-// snapdev
+// C++
 //
-#include    <snapdev/hexadecimal_string.h>
+#include    <array>
+#include    <charconv>
 
 
 // C
 //
 #include    <sys/time.h>
+#include    <time.h>
 
 
 // last include
@@ -53,6 +55,63 @@ namespace
 
 
 
+/** \brief Table of the cookie-octet characters.
+ *
+ * RFC 6265 section 4.1.1 defines the characters allowed in a cookie
+ * value as:
+ *
+ * \code
+ *     cookie-octet = %x21 / %x23-2B / %x2D-3A / %x3C-5B / %x5D-7E
+ * \endcode
+ *
+ * Any other byte gets percent encoded.
+ */
+constexpr std::array<bool, 256> g_cookie_octet = []()
+{
+    std::array<bool, 256> table{};
+    for(int c(0x21); c <= 0x7E; ++c)
+    {
+        table[c] = c != '"' && c != ',' && c != ';' && c != '\\';
+    }
+    return table;
+}();
+
+
+char const g_hex_digits[] = "0123456789ABCDEF";
+
+
+/** \brief Append a value, percent encoding what is not a cookie-octet.
+ *
+ * The runs of valid characters are appended at once, which in most
+ * cases means the whole value is appended with one call.
+ *
+ * \param[in,out] out  The buffer receiving the value.
+ * \param[in] value  The value to append.
+ */
+void append_cookie_value(std::string & out, std::string const & value)
+{
+    char const * s(value.data());
+    char const * const end(s + value.length());
+    while(s < end)
+    {
+        char const * run(s);
+        while(run < end && g_cookie_octet[static_cast<unsigned char>(*run)])
+        {
+            ++run;
+        }
+        out.append(s, run - s);
+        if(run >= end)
+        {
+            break;
+        }
+        unsigned char const c(static_cast<unsigned char>(*run));
+        char const encoded[3] = { '%', g_hex_digits[c >> 4], g_hex_digits[c & 15] };
+        out.append(encoded, 3);
+        s = run + 1;
+    }
+}
+
+
 void safe_comment(std::string & result, std::string const & comment)
 {
     for(auto const c : comment)
@@ -65,6 +124,230 @@ void safe_comment(std::string & result, std::string const & comment)
 }
 
 
+/** \brief Cache of the formatted Expires dates.
+ *
+ * When serializing many cookies, most share the same expiration date.
+ * This cache keeps the last few dates so each one is formatted once.
+ */
+class date_cache
+{
+public:
+    std::string_view get(time_t date)
+    {
+        for(std::size_t idx(0); idx < f_count; ++idx)
+        {
+            if(f_entries[idx].f_date == date)
+            {
+                return std::string_view(f_entries[idx].f_buffer, HTTP_DATE_LENGTH);
+            }
+        }
+
+        // format first, the date may be out of range in which case the
+        // cache must remain unchanged
+        //
+        entry_t & e(f_entries[f_next]);
+        std::string_view const result(format_http_date(date, e.f_buffer));
+        e.f_date = date;
+        f_next = (f_next + 1) % CACHE_SIZE;
+        if(f_count < CACHE_SIZE)
+        {
+            ++f_count;
+        }
+        return result;
+    }
+
+private:
+    static constexpr std::size_t    CACHE_SIZE = 4;
+
+    struct entry_t
+    {
+        time_t          f_date = -1;
+        char            f_buffer[HTTP_DATE_LENGTH] = {};
+    };
+
+    entry_t             f_entries[CACHE_SIZE] = {};
+    std::size_t         f_count = 0;
+    std::size_t         f_next = 0;
+};
+
+
+/** \brief Compute the maximum size of a cookie header.
+ *
+ * The size assumes that the whole value gets percent encoded so the
+ * buffer never needs to be enlarged while appending the cookie.
+ *
+ * \param[in] cookie  The cookie to measure.
+ *
+ * \return The maximum number of bytes of the Set-Cookie header and its
+ * "\r\n".
+ */
+std::size_t estimated_size(http_cookie const & cookie)
+{
+    // "Set-Cookie: " + "; Expires=" + date + "; Max-Age=" + number
+    // + "; Secure; HttpOnly" + "\r\n" and the other attribute names
+    //
+    return 160
+         + cookie.get_name().length()
+         + cookie.get_value().length() * 3
+         + cookie.get_domain().length()
+         + cookie.get_path().length()
+         + cookie.get_comment().length()
+         + cookie.get_comment_uri().length();
+}
+
+
+void append_cookie(std::string & out, http_cookie const & cookie, time_t now, date_cache & dates)
+{
+    // Note: the name was already checked for invalid characters
+    //
+    out += cookie.get_name();
+    out += '=';
+    append_cookie_value(out, cookie.get_value());
+
+    switch(cookie.get_type())
+    {
+    case http_cookie::http_cookie_type_t::HTTP_COOKIE_TYPE_PERMANENT:
+        // HTTP format generates: Sun, 06 Nov 1994 08:49:37 GMT
+        // (see http://tools.ietf.org/html/rfc2616#section-3.3.1)
+        //
+        out += "; ";
+        out += g_name_edhttp_param_expires;
+        out += '=';
+        out += dates.get(cookie.get_expire());
+
+        // Modern browsers are expected to use the Max-Age=... field
+        // instead of the Expires to avoid potential date synchronization
+        // problems between our server and the client
+        // (see http://tools.ietf.org/html/rfc6265#section-4.1.2.2)
+        //
+        // TBD: although this works, we may want to know the exact
+        //      intend of the person setting the expiration time and
+        //      maybe use that amount (or even change our current
+        //      expire to a max-age and calculate the date in Expires=...
+        //      and not the one in Max-Age.)
+        {
+            time_t const max_age(cookie.get_expire() - now);
+            if(max_age > 0)
+            {
+                out += "; ";
+                out += g_name_edhttp_param_max_age;
+                out += '=';
+
+                char digits[24];
+                std::to_chars_result const r(std::to_chars(digits, digits + sizeof(digits), max_age));
+                out.append(digits, r.ptr - digits);
+            }
+        }
+        break;
+
+    case http_cookie::http_cookie_type_t::HTTP_COOKIE_TYPE_SESSION:
+        // no Expires
+        break;
+
+    case http_cookie::http_cookie_type_t::HTTP_COOKIE_TYPE_DELETE:
+        // no need to waste time computing that date
+        out += "; ";
+        out += g_name_edhttp_param_expires;
+        out += '=';
+        out += g_name_edhttp_jan1_1970;
+        break;
+
+    }
+
+    if(!cookie.get_domain().empty())
+    {
+        // the domain sanity was already checked so we can save it as it here
+        out += "; ";
+        out += g_name_edhttp_param_domain;
+        out += '=';
+        out += cookie.get_domain();
+    }
+
+    if(!cookie.get_path().empty())
+    {
+        // the path sanity was already checked so we can save it as it here
+        out += "; ";
+        out += g_name_edhttp_param_path;
+        out += '=';
+        out += cookie.get_path();
+    }
+
+    if(cookie.get_secure())
+    {
+        out += "; ";
+        out += g_name_edhttp_param_secure;
+    }
+
+    if(cookie.get_http_only())
+    {
+        out += "; ";
+        out += g_name_edhttp_param_http_only;
+    }
+
+    if(!cookie.get_comment().empty())
+    {
+        // we need to escape all "bad" characters, not just quotes
+        out += "; ";
+        out += g_name_edhttp_param_comment;
+        out += "=\"";
+        safe_comment(out, cookie.get_comment());
+        out += '"';
+    }
+
+    if(!cookie.get_comment_uri().empty())
+    {
+        // we need to escape all "bad" characters, not just quotes
+        out += "; ";
+        out += g_name_edhttp_param_comment_url;
+        out += "=\"";
+        safe_comment(out, cookie.get_comment_uri());
+        out += '"';
+    }
+}
+
+
+http_cookie const & get_cookie(http_cookie const & cookie)
+{
+    return cookie;
+}
+
+
+http_cookie const & get_cookie(std::pair<std::string const, http_cookie> const & p)
+{
+    return p.second;
+}
+
+
+template<typename T>
+void append_cookie_list(std::string & out, T const & cookies, time_t now)
+{
+    if(cookies.empty())
+    {
+        return;
+    }
+    if(now == -1)
+    {
+        now = time(nullptr);
+    }
+
+    std::size_t size(out.length());
+    for(auto const & c : cookies)
+    {
+        size += estimated_size(get_cookie(c));
+    }
+    out.reserve(size);
+
+    date_cache dates;
+    for(auto const & c : cookies)
+    {
+        out += g_name_edhttp_field_set_cookie;
+        out += ": ";
+        append_cookie(out, get_cookie(c), now, dates);
+        out += "\r\n";
+    }
+}
+
+
 
 } // no name namespace
 
@@ -344,12 +627,12 @@ void http_cookie::set_expire(std::string const & date_time)
 {
     time_t const now(time(nullptr));
     time_t const seconds(string_to_date(date_time));
-    if(seconds - now > 86400LL * 365LL)
+    if(seconds - now > detail::SECONDS_PER_DAY * 365)
     {
         // save 'now + 1 year' instead of date_time which is further in
         // the future and thus not HTTP 1.1 compatible
         //
-        f_expire = now + 86400LL * 365LL;
+        f_expire = now + detail::SECONDS_PER_DAY * 365;
     }
     else if(seconds < 0)
     {
@@ -390,9 +673,9 @@ void http_cookie::set_expire(std::string const & date_time)
 void http_cookie::set_expire_in(int64_t seconds)
 {
     // clamp to 1 year (max. allowed by HTTP 1.1)
-    if(seconds > 86400LL * 365LL)
+    if(seconds > detail::SECONDS_PER_DAY * 365)
     {
-        seconds = 86400LL * 365LL;
+        seconds = detail::SECONDS_PER_DAY * 365;
     }
 
     time_t const now(time(nullptr));
@@ -663,136 +946,89 @@ std::string const & http_cookie::get_comment_uri() const
 /** \brief Transform the cookie for the HTTP header.
  *
  * This function transforms the cookie so it works as an HTTP header.
- * It follows the HTTP 1.1 specifications, although it never makes
- * use of the Max-Age field.
+ * The result includes the "Set-Cookie: " field name but no "\r\n".
+ *
+ * To send many cookies, use append_set_cookies() which writes all
+ * of them in one buffer.
  *
  * \return A valid HTTP cookie header.
+ *
+ * \sa append_http_header()
  */
 std::string http_cookie::to_http_header() const
 {
-    // Note: the name was already checked for invalid characters
-    std::string result(g_name_edhttp_field_set_cookie);
+    std::string result;
+    result.reserve(estimated_size(*this));
+    result += g_name_edhttp_field_set_cookie;
     result += ": ";
-    result += f_name;
-    result += '=';
-
-    for(auto const c : f_value)
-    {
-        if(c == 0x21
-        || (c >= 0x23 && c <= 0x2B)
-        || (c >= 0x2D && c <= 0x3A)
-        || (c >= 0x3C && c <= 0x5B)
-        || (c >= 0x5D && c <= 0x7E))
-        {
-            result += c;
-        }
-        else
-        {
-            // add the byte as %XX
-            result += '%';
-            result += snapdev::int_to_hex(c, true, 2);
-        }
-    }
-
-    switch(get_type())
-    {
-    case http_cookie_type_t::HTTP_COOKIE_TYPE_PERMANENT:
-        // compute date/time
-        // HTTP format generates: Sun, 06 Nov 1994 08:49:37 GMT
-        // (see http://tools.ietf.org/html/rfc2616#section-3.3.1)
-        //
-        result += "; ";
-        result += g_name_edhttp_param_expires;
-        result += '=';
-        result += date_to_string(f_expire, date_format_t::DATE_FORMAT_HTTP);
-
-        // Modern browsers are expected to use the Max-Age=... field
-        // instead of the Expires to avoid potential date synchronization
-        // problems between our server and the client
-        // (see http://tools.ietf.org/html/rfc6265#section-4.1.2.2)
-        //
-        // TBD: although this works, we may want to know the exact
-        //      intend of the person setting the expiration time and
-        //      maybe use that amount (or even change our current
-        //      expire to a max-age and calculate the date in Expires=...
-        //      and not the one in Max-Age.)
-        {
-            time_t const max_age(f_expire - time(nullptr));
-            if(max_age > 0)
-            {
-                result += "; ";
-                result += g_name_edhttp_param_max_age;
-                result += '=';
-                result += std::to_string(max_age);
-            }
-        }
-        break;
-
-    case http_cookie_type_t::HTTP_COOKIE_TYPE_SESSION:
-        // no Expires
-        break;
-
-    case http_cookie_type_t::HTTP_COOKIE_TYPE_DELETE:
-        // no need to waste time computing that date
-        result += "; ";
-        result += g_name_edhttp_param_expires;
-        result += '=';
-        result += g_name_edhttp_jan1_1970;
-        break;
-
-    }
-
-    if(!f_domain.empty())
-    {
-        // the domain sanity was already checked so we can save it as it here
-        result += "; ";
-        result += g_name_edhttp_param_domain;
-        result += '=';
-        result += f_domain;
-    }
+    append_http_header(result);
+    return result;
+}
 
-    if(!f_path.empty())
-    {
-        // the path sanity was already checked so we can save it as it here
-        result += "; ";
-        result += g_name_edhttp_param_path;
-        result += '=';
-        result += f_path;
-    }
 
-    if(f_secure)
+/** \brief Append the value of the Set-Cookie header to a buffer.
+ *
+ * This function appends the cookie to \p out as expected in the value
+ * of a Set-Cookie header (i.e. the field name is not added). It follows
+ * the RFC 6265 specifications. The value is percent encoded if it
+ * includes characters other than cookie-octets.
+ *
+ * Permanent cookies get an Expires and a Max-Age attribute. The Max-Age
+ * is computed from \p now. If \p now is -1, the function uses the
+ * current time.
+ *
+ * \param[in,out] out  The buffer where the cookie gets appended.
+ * \param[in] now  The time used to compute the Max-Age attribute.
+ *
+ * \sa to_http_header()
+ * \sa append_set_cookies()
+ */
+void http_cookie::append_http_header(std::string & out, time_t now) const
+{
+    if(now == -1)
     {
-        result += "; ";
-        result += g_name_edhttp_param_secure;
+        now = time(nullptr);
     }
+    date_cache dates;
+    append_cookie(out, *this, now, dates);
+}
 
-    if(f_http_only)
-    {
-        result += "; ";
-        result += g_name_edhttp_param_http_only;
-    }
 
-    if(!f_comment.empty())
-    {
-        // we need to escape all "bad" characters, not just quotes
-        result += "; ";
-        result += g_name_edhttp_param_comment;
-        result += "=\"";
-        safe_comment(result, f_comment);
-        result += '"';
-    }
+/** \brief Append a list of Set-Cookie headers to a buffer.
+ *
+ * Contrary to most fields, Set-Cookie headers cannot be merged in one
+ * comma separated field (RFC 6265 section 3). This function appends
+ * one complete "Set-Cookie: ...\r\n" line per cookie to \p out.
+ *
+ * The buffer is enlarged once with the size of all the cookies and all
+ * the cookies share the same \p now so the time is retrieved once. The
+ * Expires dates are formatted once per distinct expiration date (in
+ * general, all the permanent cookies of a response have the same).
+ *
+ * \param[in,out] out  The buffer where the headers are appended.
+ * \param[in] cookies  The cookies to append.
+ * \param[in] now  The time used to compute the Max-Age attributes. If -1,
+ * use the current time.
+ */
+void append_set_cookies(std::string & out, http_cookie::vector_t const & cookies, time_t now)
+{
+    append_cookie_list(out, cookies, now);
+}
 
-    if(!f_comment_uri.empty())
-    {
-        // we need to escape all "bad" characters, not just quotes
-        result += "; ";
-        result += g_name_edhttp_param_comment_url;
-        result += "=\"";
-        safe_comment(result, f_comment_uri);
-        result += '"';
-    }
 
-    return result;
+/** \brief Append a map of Set-Cookie headers to a buffer.
+ *
+ * This function is the same as the other append_set_cookies() function,
+ * only it works with a map of cookies.
+ *
+ * \param[in,out] out  The buffer where the headers are appended.
+ * \param[in] cookies  The cookies to append.
+ * \param[in] now  The time used to compute the Max-Age attributes. If -1,
+ * use the current time.
+ */
+void append_set_cookies(std::string & out, http_cookie::map_t const & cookies, time_t now)
+{
+    append_cookie_list(out, cookies, now);
 }
 
 
@@ -19,7 +19,10 @@
 
 // C++
 //
+#include    <ctime>
+#include    <map>
 #include    <string>
+#include    <vector>
 
 
 
@@ -31,6 +34,9 @@ namespace edhttp
 class http_cookie
 {
 public:
+    typedef std::vector<http_cookie>            vector_t;
+    typedef std::map<std::string, http_cookie>  map_t;
+
     enum class http_cookie_type_t
     {
         HTTP_COOKIE_TYPE_PERMANENT,
@@ -65,6 +71,7 @@ public:
     std::string const & get_comment_uri() const;
 
     std::string         to_http_header() const;
+    void                append_http_header(std::string & out, time_t now = -1) const;
 
 private:
     std::string         f_name = std::string();         // name of the cookie
@@ -79,6 +86,10 @@ private:
 };
 
 
+void                    append_set_cookies(std::string & out, http_cookie::vector_t const & cookies, time_t now = -1);
+void                    append_set_cookies(std::string & out, http_cookie::map_t const & cookies, time_t now = -1);
+
+
 
 } // namespace edhttp
 // vim: ts=4 sw=4 et
@@ -21,8 +21,8 @@
 //
 #include    "edhttp/http_date.h"
 
+#include    "edhttp/civil_time.h"
 #include    "edhttp/exception.h"
-#include    "edhttp/mkgmtime.h"
 
 
 // snapdev
@@ -33,13 +33,13 @@
 
 // C++
 //
-#include    <iomanip>
-#include    <sstream>
+#include    <cstdint>
 
 
 // C
 //
 #include    <string.h>
+#include    <time.h>
 
 
 // last include
@@ -58,21 +58,19 @@ namespace
 
 char const * g_week_day_name[] =
 {
-    "Sunday", "Monday", "Tuesday", "Wedneday", "Thursday", "Friday", "Saturday"
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
 };
 
-int const g_week_day_length[] = { 6, 6, 7, 8, 8, 6, 8 }; // strlen() of g_week_day_name's
+int const g_week_day_length[] = { 6, 6, 7, 9, 8, 6, 8 }; // strlen() of g_week_day_name's
 
 char const * g_month_name[] =
 {
-    "January", "February", "Marsh", "April", "May", "June",
+    "January", "February", "March", "April", "May", "June",
     "July", "August", "September", "October", "November", "December"
 };
 
 int const g_month_length[] = { 7, 8, 5, 5, 3, 4, 4, 6, 9, 7, 8, 8 }; // strlen() of g_month_name
 
-int const g_month_days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
 signed char const g_timezone_adjust[26] =
 {
     /* A */ -1,
@@ -104,9 +102,224 @@ signed char const g_timezone_adjust[26] =
 };
 
 
+void write_2digits(char * s, int value)
+{
+    s[0] = static_cast<char>(value / 10 + '0');
+    s[1] = static_cast<char>(value % 10 + '0');
+}
+
+
+constexpr std::uint32_t pack4(char a, char b, char c, char d)
+{
+    return static_cast<std::uint32_t>(static_cast<std::uint8_t>(a))
+         | static_cast<std::uint32_t>(static_cast<std::uint8_t>(b)) <<  8
+         | static_cast<std::uint32_t>(static_cast<std::uint8_t>(c)) << 16
+         | static_cast<std::uint32_t>(static_cast<std::uint8_t>(d)) << 24;
+}
+
+
+std::uint32_t load4(char const * s)
+{
+    return pack4(s[0], s[1], s[2], s[3]);
+}
+
+
+// "Mon," ... "Sun," in the IMF-fixdate
+//
+constexpr std::uint32_t const g_packed_week_day[7] =
+{
+    pack4('S', 'u', 'n', ','),
+    pack4('M', 'o', 'n', ','),
+    pack4('T', 'u', 'e', ','),
+    pack4('W', 'e', 'd', ','),
+    pack4('T', 'h', 'u', ','),
+    pack4('F', 'r', 'i', ','),
+    pack4('S', 'a', 't', ','),
+};
+
+
+// " Jan" ... " Dec" in the IMF-fixdate and asctime formats
+//
+constexpr std::uint32_t const g_packed_month[12] =
+{
+    pack4(' ', 'J', 'a', 'n'),
+    pack4(' ', 'F', 'e', 'b'),
+    pack4(' ', 'M', 'a', 'r'),
+    pack4(' ', 'A', 'p', 'r'),
+    pack4(' ', 'M', 'a', 'y'),
+    pack4(' ', 'J', 'u', 'n'),
+    pack4(' ', 'J', 'u', 'l'),
+    pack4(' ', 'A', 'u', 'g'),
+    pack4(' ', 'S', 'e', 'p'),
+    pack4(' ', 'O', 'c', 't'),
+    pack4(' ', 'N', 'o', 'v'),
+    pack4(' ', 'D', 'e', 'c'),
+};
+
+
+int find_month(std::uint32_t packed)
+{
+    for(int month(0); month < 12; ++month)
+    {
+        if(g_packed_month[month] == packed)
+        {
+            return month + 1;
+        }
+    }
+    return 0;
+}
+
+
+bool is_week_day(std::uint32_t packed)
+{
+    for(auto const w : g_packed_week_day)
+    {
+        if(w == packed)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** \brief Read a number with exactly \p count digits.
+ *
+ * \param[in] s  The string with the digits.
+ * \param[in] count  The number of digits to read.
+ * \param[out] value  The resulting value.
+ *
+ * \return true if all the characters were digits.
+ */
+bool read_digits(char const * s, int count, int & value)
+{
+    value = 0;
+    for(int idx(0); idx < count; ++idx)
+    {
+        unsigned int const d(static_cast<unsigned char>(s[idx]) - '0');
+        if(d > 9)
+        {
+            return false;
+        }
+        value = value * 10 + static_cast<int>(d);
+    }
+    return true;
+}
+
+
+// "HH:MM:SS" (the seconds may be 60 for a leap second)
+//
+bool read_time(char const * s, int & seconds)
+{
+    int hour(0);
+    int minute(0);
+    int second(0);
+    if(!read_digits(s, 2, hour)
+    || s[2] != ':'
+    || !read_digits(s + 3, 2, minute)
+    || s[5] != ':'
+    || !read_digits(s + 6, 2, second)
+    || hour > 23
+    || minute > 59
+    || second > 60)
+    {
+        return false;
+    }
+    seconds = hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+
+time_t make_time(std::int64_t year, int month, int day, int seconds)
+{
+    if(day < 1
+    || day > days_in_month(year, month))
+    {
+        return -1;
+    }
+    return static_cast<time_t>(days_from_civil(year, month, day) * detail::SECONDS_PER_DAY + seconds);
+}
+
+
+struct http_date_cache_t
+{
+    time_t          f_seconds = 0;
+    bool            f_valid = false;
+    char            f_date[HTTP_DATE_LENGTH] = {};
+};
+
+
+thread_local http_date_cache_t g_http_date_cache = http_date_cache_t();
+
+
 }
 // noname namespace
 
+/** \brief Format a date as an HTTP IMF-fixdate.
+ *
+ * This function writes \p seconds in \p buf using the HTTP date format
+ * (RFC 9110 section 5.6.7):
+ *
+ * \code
+ *     Sun, 06 Nov 1994 08:49:37 GMT
+ * \endcode
+ *
+ * The date is computed with integer arithmetic (no gmtime_r() and no
+ * locale) and the result is not null terminated; it always uses exactly
+ * HTTP_DATE_LENGTH characters.
+ *
+ * Most of the dates we format are the current time (i.e. the Date
+ * header) so the last date formatted by each thread is kept in a
+ * cache. When called again within the same second, the function
+ * only copies the cached string.
+ *
+ * \exception out_of_range
+ * The year must be between 0 and 9999 to fit the format.
+ *
+ * \param[in] seconds  The time to format in seconds since the Unix epoch.
+ * \param[out] buf  The buffer where the date gets written.
+ *
+ * \return A view of \p buf.
+ */
+std::string_view format_http_date(time_t seconds, char (&buf)[HTTP_DATE_LENGTH])
+{
+    http_date_cache_t & cache(g_http_date_cache);
+    if(!cache.f_valid
+    || cache.f_seconds != seconds)
+    {
+        civil_time_t const t(civil_from_time(seconds));
+        if(t.f_year < 0 || t.f_year > 9999)
+        {
+            throw out_of_range("year out of range for an HTTP date.");
+        }
+
+        char * s(cache.f_date);
+        memcpy(s, g_week_day_name[t.f_week_day], 3);
+        s[3] = ',';
+        s[4] = ' ';
+        write_2digits(s + 5, t.f_day);
+        s[7] = ' ';
+        memcpy(s + 8, g_month_name[t.f_month - 1], 3);
+        s[11] = ' ';
+        write_2digits(s + 12, static_cast<int>(t.f_year / 100));
+        write_2digits(s + 14, static_cast<int>(t.f_year % 100));
+        s[16] = ' ';
+        write_2digits(s + 17, t.f_hour);
+        s[19] = ':';
+        write_2digits(s + 20, t.f_minute);
+        s[22] = ':';
+        write_2digits(s + 23, t.f_second);
+        memcpy(s + 25, " GMT", 4);
+
+        cache.f_seconds = seconds;
+        cache.f_valid = true;
+    }
+
+    memcpy(buf, cache.f_date, HTTP_DATE_LENGTH);
+    return std::string_view(buf, HTTP_DATE_LENGTH);
+}
+
+
 /** \brief Convert a time/date value to a string.
  *
  * This function transform a date such as the content::modified field
@@ -117,7 +330,7 @@ signed char const g_timezone_adjust[26] =
  * \li DATE_FORMAT_LONG  -- YYYY-MM-DDTHH:MM:SSZ
  * \li DATE_FORMAT_TIME  -- HH:MM:SS
  * \li DATE_FORMAT_EMAIL -- dd MMM yyyy hh:mm:ss +0000
- * \li DATE_FORMAT_HTTP  -- ddd, dd MMM yyyy hh:mm:ss +0000
+ * \li DATE_FORMAT_HTTP  -- ddd, dd MMM yyyy hh:mm:ss GMT
  *
  * The long format includes the time.
  *
@@ -145,102 +358,216 @@ signed char const g_timezone_adjust[26] =
  */
 std::string date_to_string(time_t seconds, date_format_t date_format)
 {
-    struct tm time_info;
-    gmtime_r(&seconds, &time_info);
+    switch(date_format)
+    {
+    case date_format_t::DATE_FORMAT_EMAIL:
+        { // dd MMM yyyy hh:mm:ss +0000
+            // do it manually so the date is ALWAYS in English
+            civil_time_t const t(civil_from_time(seconds));
+            char buf[6];
+            std::string result;
+            result.reserve(26);
+            write_2digits(buf, t.f_day);
+            buf[2] = ' ';
+            memcpy(buf + 3, g_month_name[t.f_month - 1], 3);
+            result.append(buf, 6);
+            result += ' ';
+            result += std::to_string(t.f_year);
+            write_2digits(buf, t.f_hour);
+            buf[2] = ':';
+            write_2digits(buf + 3, t.f_minute);
+            buf[5] = ':';
+            result += ' ';
+            result.append(buf, 6);
+            write_2digits(buf, t.f_second);
+            result.append(buf, 2);
+            result += " +0000";
+            return result;
+        }
+
+    case date_format_t::DATE_FORMAT_HTTP:
+        { // ddd, dd MMM yyyy hh:mm:ss GMT
+            char buf[HTTP_DATE_LENGTH];
+            return std::string(format_http_date(seconds, buf));
+        }
 
-    char buf[256];
-    buf[0] = '\0';
+    default:
+        break;
+
+    }
+
+    // like strftime()'s %Y, the year is not padded
+    //
+    civil_time_t const t(civil_from_time(seconds));
+    char buf[8];
+    std::string result;
+    result.reserve(20);
 
     switch(date_format)
     {
     case date_format_t::DATE_FORMAT_SHORT:
-        strftime(buf, sizeof(buf), "%Y-%m-%d", &time_info);
+    case date_format_t::DATE_FORMAT_LONG:
+        // YYYY-MM-DD
+        result += std::to_string(t.f_year);
+        buf[0] = '-';
+        write_2digits(buf + 1, t.f_month);
+        buf[3] = '-';
+        write_2digits(buf + 4, t.f_day);
+        result.append(buf, 6);
+        if(date_format == date_format_t::DATE_FORMAT_LONG)
+        {
+            // TBD do we want the Z when generating time for HTML headers?
+            // (it is useful for the sitemap.xml at this point)
+            //
+            // THH:MM:SSZ
+            buf[0] = 'T';
+            write_2digits(buf + 1, t.f_hour);
+            buf[3] = ':';
+            write_2digits(buf + 4, t.f_minute);
+            buf[6] = ':';
+            result.append(buf, 7);
+            write_2digits(buf, t.f_second);
+            buf[2] = 'Z';
+            result.append(buf, 3);
+        }
         break;
 
     case date_format_t::DATE_FORMAT_SHORT_US:
-        strftime(buf, sizeof(buf), "%m-%d-%Y", &time_info);
-        break;
-
-    case date_format_t::DATE_FORMAT_LONG:
-        // TBD do we want the Z when generating time for HTML headers?
-        // (it is useful for the sitemap.xml at this point)
-        strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &time_info);
+        // MM-DD-YYYY
+        write_2digits(buf, t.f_month);
+        buf[2] = '-';
+        write_2digits(buf + 3, t.f_day);
+        buf[5] = '-';
+        result.append(buf, 6);
+        result += std::to_string(t.f_year);
         break;
 
     case date_format_t::DATE_FORMAT_TIME:
-        strftime(buf, sizeof(buf), "%H:%M:%S", &time_info);
+        // HH:MM:SS
+        write_2digits(buf, t.f_hour);
+        buf[2] = ':';
+        write_2digits(buf + 3, t.f_minute);
+        buf[5] = ':';
+        write_2digits(buf + 6, t.f_second);
+        result.append(buf, 8);
         break;
 
     case date_format_t::DATE_FORMAT_EMAIL:
-        { // dd MMM yyyy hh:mm:ss +0000
-            // do it manually so the date is ALWAYS in English
-            std::stringstream ss;
-            ss << std::setfill('0')
-               << std::setw(2) << time_info.tm_mday
-               << ' '
-               << g_month_name[time_info.tm_mon][0]
-               << g_month_name[time_info.tm_mon][1]
-               << g_month_name[time_info.tm_mon][2]
-               << ' '
-               << std::setw(2) << time_info.tm_year
-               << ' '
-               << std::setw(2) << time_info.tm_hour
-               << ':'
-               << std::setw(2) << time_info.tm_min
-               << ':'
-               << std::setw(2) << time_info.tm_sec
-               << " +0000";
-            return ss.str();
-
-            //return QString("%1 %2 %3 %4:%5:%6 +0000")
-            //    .arg(time_info.tm_mday, 2, 10, QChar('0'))
-            //    .arg(QString::fromLatin1(g_month_name[time_info.tm_mon], 3))
-            //    .arg(time_info.tm_year + 1900, 4, 10, QChar('0'))
-            //    .arg(time_info.tm_hour, 2, 10, QChar('0'))
-            //    .arg(time_info.tm_min, 2, 10, QChar('0'))
-            //    .arg(time_info.tm_sec, 2, 10, QChar('0'));
-        }
+    case date_format_t::DATE_FORMAT_HTTP:
+        // handled above
         break;
 
-    case date_format_t::DATE_FORMAT_HTTP:
-        { // ddd, dd MMM yyyy hh:mm:ss GMT
-            // do it manually so the date is ALWAYS in English
-            std::stringstream ss;
-            ss << std::setfill('0')
-               << g_week_day_name[time_info.tm_wday][0]
-               << g_week_day_name[time_info.tm_wday][1]
-               << g_week_day_name[time_info.tm_wday][2]
-               << ", "
-               << std::setw(2) << time_info.tm_mday
-               << ' '
-               << g_month_name[time_info.tm_mon][0]
-               << g_month_name[time_info.tm_mon][1]
-               << g_month_name[time_info.tm_mon][2]
-               << ' '
-               << std::setw(4) << time_info.tm_year + 1900
-               << ' '
-               << std::setw(2) << time_info.tm_hour
-               << ':'
-               << std::setw(2) << time_info.tm_min
-               << ':'
-               << std::setw(2) << time_info.tm_sec
-               << " +0000";
-            return ss.str();
-
-            //return QString("%1, %2 %3 %4 %5:%6:%7 +0000")
-            //    .arg(QString::fromLatin1(g_week_day_name[time_info.tm_wday], 3))
-            //    .arg(time_info.tm_mday, 2, 10, QChar('0'))
-            //    .arg(QString::fromLatin1(g_month_name[time_info.tm_mon], 3))
-            //    .arg(time_info.tm_year + 1900, 4, 10, QChar('0'))
-            //    .arg(time_info.tm_hour, 2, 10, QChar('0'))
-            //    .arg(time_info.tm_min, 2, 10, QChar('0'))
-            //    .arg(time_info.tm_sec, 2, 10, QChar('0'));
+    }
+
+    return result;
+}
+
+
+/** \brief Parse an HTTP date.
+ *
+ * This function parses the three date formats that HTTP recipients
+ * have to accept (RFC 9110 section 5.6.7):
+ *
+ * \code
+ *     Sun, 06 Nov 1994 08:49:37 GMT    ; IMF-fixdate
+ *     Sunday, 06-Nov-94 08:49:37 GMT   ; obsolete RFC 850 format
+ *     Sun Nov  6 08:49:37 1994         ; ANSI C's asctime() format
+ * \endcode
+ *
+ * The IMF-fixdate, which is what all modern implementations send, is
+ * checked first with fixed offsets and 32-bit compares of the week day
+ * and month names. The epoch is then computed arithmetically.
+ *
+ * Contrary to string_to_date(), this function is strict: the names are
+ * case sensitive and no other format is accepted.
+ *
+ * In the RFC 850 format, a two digit year from 70 to 99 is viewed as
+ * 1970 to 1999 and a year from 00 to 69 as 2000 to 2069.
+ *
+ * \param[in] date  The date to parse.
+ *
+ * \return The date and time as a Unix time_t number or -1 on errors.
+ */
+time_t parse_http_date(std::string_view date)
+{
+    char const * s(date.data());
+    int seconds(0);
+    int day(0);
+    int year(0);
+    int month(0);
+
+    if(date.length() == HTTP_DATE_LENGTH)
+    {
+        // Sun, 06 Nov 1994 08:49:37 GMT
+        // 0123456789012345678901234567 8
+        //
+        if(!is_week_day(load4(s))
+        || s[4] != ' '
+        || !read_digits(s + 5, 2, day)
+        || (month = find_month(load4(s + 7))) == 0
+        || s[11] != ' '
+        || !read_digits(s + 12, 4, year)
+        || s[16] != ' '
+        || !read_time(s + 17, seconds)
+        || load4(s + 25) != pack4(' ', 'G', 'M', 'T'))
+        {
+            return -1;
         }
-        break;
+        return make_time(year, month, day, seconds);
+    }
 
+    if(date.length() == 24)
+    {
+        // Sun Nov  6 08:49:37 1994
+        // 012345678901234567890123
+        //
+        if(!is_week_day(pack4(s[0], s[1], s[2], ','))
+        || (month = find_month(load4(s + 3))) == 0
+        || s[7] != ' '
+        || (s[8] == ' ' ? !read_digits(s + 9, 1, day) : !read_digits(s + 8, 2, day))
+        || s[10] != ' '
+        || !read_time(s + 11, seconds)
+        || s[19] != ' '
+        || !read_digits(s + 20, 4, year))
+        {
+            return -1;
+        }
+        return make_time(year, month, day, seconds);
     }
 
-    return buf;
+    // Sunday, 06-Nov-94 08:49:37 GMT
+    //
+    std::string_view::size_type const comma(date.find(','));
+    if(comma == std::string_view::npos
+    || date.length() != comma + 24)
+    {
+        return -1;
+    }
+    int week_day(0);
+    for(; week_day < 7; ++week_day)
+    {
+        if(static_cast<std::size_t>(g_week_day_length[week_day]) == comma
+        && date.compare(0, comma, g_week_day_name[week_day]) == 0)
+        {
+            break;
+        }
+    }
+    s += comma + 1;
+    if(week_day >= 7
+    || !read_digits(s + 1, 2, day)
+    || s[3] != '-'
+    || (month = find_month(pack4(' ', s[4], s[5], s[6]))) == 0
+    || s[7] != '-'
+    || !read_digits(s + 8, 2, year)
+    || s[10] != ' '
+    || !read_time(s + 11, seconds)
+    || load4(s + 19) != pack4(' ', 'G', 'M', 'T')
+    || s[0] != ' ')
+    {
+        return -1;
+    }
+    year += year < 70 ? 2000 : 1900;
+    return make_time(year, month, day, seconds);
 }
 
 
@@ -289,6 +616,14 @@ std::string date_to_string(time_t seconds, date_format_t date_format)
  */
 time_t string_to_date(std::string const & date)
 {
+    // most dates we receive are in the IMF-fixdate format
+    //
+    time_t const fast(parse_http_date(date));
+    if(fast != -1)
+    {
+        return fast;
+    }
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Weffc++"
     struct parser_t
@@ -493,8 +828,8 @@ time_t string_to_date(std::string const & date)
                 return true;
             }
 
-            // XXX not too sure that the zone is properly handled at this point
-            // (i.e. should I do += or -=, it may be wrong in many places...)
+            // the zone is the offset of the local time from UTC so we
+            // have to subtract it (i.e. 03:00 EST is 08:00 UTC)
             //
             // The newest HTTP format is to only support "+/-####"
             //
@@ -513,35 +848,35 @@ time_t string_to_date(std::string const & date)
             }
             else if(f_s[0] == 'e' && f_s[1] == 's' && f_s[2] == 't' && f_s[3] == '\0') // EST
             {
-                f_time_info.tm_hour -= 5;
+                f_time_info.tm_hour += 5;
             }
             else if(f_s[0] == 'e' && f_s[1] == 'd' && f_s[2] == 't' && f_s[3] == '\0') // EDT
             {
-                f_time_info.tm_hour -= 4;
+                f_time_info.tm_hour += 4;
             }
             else if(f_s[0] == 'c' && f_s[1] == 's' && f_s[2] == 't' && f_s[3] == '\0') // CST
             {
-                f_time_info.tm_hour -= 6;
+                f_time_info.tm_hour += 6;
             }
             else if(f_s[0] == 'c' && f_s[1] == 'd' && f_s[2] == 't' && f_s[3] == '\0') // CDT
             {
-                f_time_info.tm_hour -= 5;
+                f_time_info.tm_hour += 5;
             }
             else if(f_s[0] == 'm' && f_s[1] == 's' && f_s[2] == 't' && f_s[3] == '\0') // MST
             {
-                f_time_info.tm_hour -= 7;
+                f_time_info.tm_hour += 7;
             }
             else if(f_s[0] == 'm' && f_s[1] == 'd' && f_s[2] == 't' && f_s[3] == '\0') // MDT
             {
-                f_time_info.tm_hour -= 6;
+                f_time_info.tm_hour += 6;
             }
             else if(f_s[0] == 'p' && f_s[1] == 's' && f_s[2] == 't' && f_s[3] == '\0') // PST
             {
-                f_time_info.tm_hour -= 8;
+                f_time_info.tm_hour += 8;
             }
             else if(f_s[0] == 'p' && f_s[1] == 'd' && f_s[2] == 't' && f_s[3] == '\0') // PDT
             {
-                f_time_info.tm_hour -= 7;
+                f_time_info.tm_hour += 7;
             }
             else if(f_s[0] >= 'a' && f_s[0] <= 'z' && f_s[0] != 'j' && f_s[1] == '\0')
             {
@@ -554,8 +889,8 @@ time_t string_to_date(std::string const & date)
                   && f_s[4] >= '0' && f_s[4] <= '9'
                   && f_s[5] == '\0')
             {
-                f_time_info.tm_hour += ((f_s[1] - '0') * 10 + f_s[2] - '0') * (f_s[0] == '+' ? 1 : -1);
-                f_time_info.tm_min  += ((f_s[3] - '0') * 10 + f_s[4] - '0') * (f_s[0] == '+' ? 1 : -1);
+                f_time_info.tm_hour += ((f_s[1] - '0') * 10 + f_s[2] - '0') * (f_s[0] == '+' ? -1 : 1);
+                f_time_info.tm_min  += ((f_s[3] - '0') * 10 + f_s[4] - '0') * (f_s[0] == '+' ? -1 : 1);
             }
             else
             {
@@ -741,15 +1076,29 @@ time_t string_to_date(std::string const & date)
     }
 
     // make sure the day is valid for that month/year
-    if(parser.f_time_info.tm_mday > last_day_of_month(parser.f_time_info.tm_mon + 1, parser.f_time_info.tm_year))
+    //
+    // this uses the proleptic Gregorian calendar like parse_http_date()
+    // and time_from_civil(); last_day_of_month() would accept dates such
+    // as 29 Feb 1700 which do not exist in that calendar
+    //
+    if(parser.f_time_info.tm_mon < 0
+    || parser.f_time_info.tm_mon > 11
+    || parser.f_time_info.tm_mday > days_in_month(parser.f_time_info.tm_year, parser.f_time_info.tm_mon + 1))
     {
         return -1;
     }
 
     // now we have a time_info which is fully adjusted except for DST...
-    // let's make time
-    parser.f_time_info.tm_year -= 1900;
-    return mkgmtime(&parser.f_time_info);
+    // the timezone may have moved the hour and minute out of range
+    // which the linear computation handles as expected
+    //
+    return static_cast<time_t>(time_from_civil(
+              parser.f_time_info.tm_year
+            , parser.f_time_info.tm_mon + 1
+            , parser.f_time_info.tm_mday
+            , parser.f_time_info.tm_hour
+            , parser.f_time_info.tm_min
+            , parser.f_time_info.tm_sec));
 }
 
 
@@ -772,6 +1121,11 @@ time_t string_to_date(std::string const & date)
  * This function throws if called with September 1752 because the
  * month has missing days within the month (days 3 to 13).
  *
+ * \note
+ * Up to 1752 February follows the Julian rule. The date parsing and
+ * formatting functions use the proleptic Gregorian calendar instead
+ * (see civil_time.h) so this function is not used to validate dates.
+ *
  * \exception logic_error
  * This exception is raised if the month is not between 1 and 12 inclusive
  * or if the month/year is September 1752 (because that month never existed).
@@ -808,10 +1162,8 @@ int last_day_of_month(int month, int year)
         {
             return year % 4 == 0 ? 29 : 28;
         }
-        return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0) ? 29 : 28;
     }
-
-    if(month == 9 && year == 1752)
+    else if(month == 9 && year == 1752)
     {
         // we cannot handle this nice one here, days 3 to 13 are missing on
         // this month... (to adjust the calendar all at once!)
@@ -821,7 +1173,7 @@ int last_day_of_month(int month, int year)
             + " as the year number");
     }
 
-    return g_month_days[month - 1];
+    return days_in_month(year, month);
 }
 
 
@@ -20,6 +20,7 @@
 // C++
 //
 #include    <string>
+#include    <string_view>
 
 
 
@@ -39,7 +40,12 @@ enum class date_format_t
 };
 
 
+constexpr std::size_t const    HTTP_DATE_LENGTH = 29;      // "Sun, 06 Nov 1994 08:49:37 GMT"
+
+
+std::string_view format_http_date(time_t seconds, char (&buf)[HTTP_DATE_LENGTH]);
 std::string     date_to_string(time_t v, date_format_t date_format);
+time_t          parse_http_date(std::string_view date);
 time_t          string_to_date(std::string const & date);
 int             last_day_of_month(int month, int year);
 
@@ -22,6 +22,8 @@
 #include    "edhttp/http_link.h"
 
 #include    "edhttp/exception.h"
+#include    "edhttp/names.h"
+#include    "edhttp/token.h"
 #include    "edhttp/uri.h"
 
 
@@ -41,6 +43,114 @@ namespace edhttp
 
 
 
+namespace
+{
+
+
+
+bool is_ows(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+
+bool equal_ignore_case(std::string_view a, std::string_view b)
+{
+    if(a.length() != b.length())
+    {
+        return false;
+    }
+    for(std::size_t idx(0); idx < a.length(); ++idx)
+    {
+        char ca(a[idx]);
+        char cb(b[idx]);
+        if(ca >= 'A' && ca <= 'Z')
+        {
+            ca |= 0x20;
+        }
+        if(cb >= 'A' && cb <= 'Z')
+        {
+            cb |= 0x20;
+        }
+        if(ca != cb)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template<typename T>
+http_link const & get_link(T const & l);
+
+template<>
+http_link const & get_link<http_link>(http_link const & l)
+{
+    return l;
+}
+
+template<>
+http_link const & get_link<http_link::map_t::value_type>(http_link::map_t::value_type const & l)
+{
+    return l.second;
+}
+
+
+template<typename C>
+void append_link_list(std::string & out, C const & links, bool redirect)
+{
+    bool first(true);
+    for(auto const & l : links)
+    {
+        http_link const & link(get_link(l));
+        if(redirect && !link.get_redirect())
+        {
+            continue;
+        }
+        if(first)
+        {
+            first = false;
+        }
+        else
+        {
+            out += ", ";
+        }
+        link.append_http_header(out);
+    }
+}
+
+
+template<typename C>
+void append_early_hints_response(std::string & out, C const & links)
+{
+    out += g_name_edhttp_http_1_1;
+    out += " 103 Early Hints\r\n";
+
+    std::size_t const start(out.length());
+    out += g_name_edhttp_field_link;
+    out += ": ";
+    std::size_t const value(out.length());
+    append_link_list(out, links, false);
+    if(out.length() == value)
+    {
+        // no links, do not send an empty field
+        //
+        out.resize(start);
+    }
+    else
+    {
+        out += "\r\n";
+    }
+    out += "\r\n";
+}
+
+
+
+} // no name namespace
+
+
+
 /** \brief Initializes the link.
  *
  * This function initializes the link.
@@ -228,38 +338,492 @@ http_link::param_t const & http_link::get_params() const
  * \warning
  * This generates that one link string. Not the actual header. The
  * header requires all the links to be added in one "Link: ..." entry.
+ * To generate the header with all the links at once, use
+ * links_to_http_header() or append_links() instead.
  *
  * See https://tools.ietf.org/html/rfc5988
  *
  * \return A valid HTTP link header.
+ *
+ * \sa append_http_header()
  */
 std::string http_link::to_http_header() const
 {
-    // Note: the name was already checked for invalid characters
     std::string result;
+    append_http_header(result);
+    return result;
+}
 
-    result += "<";
-    result += f_link;
-    result += ">; rel=";
-    result += f_rel;
 
-    for(auto p : f_params)
+/** \brief Append the link to an existing buffer.
+ *
+ * This function appends this link to \p out. It is the same as
+ * to_http_header() except that it does not allocate a new string for
+ * the result.
+ *
+ * \param[in,out] out  The buffer where the link gets appended.
+ *
+ * \sa to_http_header()
+ */
+void http_link::append_http_header(std::string & out) const
+{
+    // Note: the name was already checked for invalid characters
+    //
+    out += '<';
+    out += f_link;
+    out += ">; rel=";
+    out += f_rel;
+
+    for(auto const & p : f_params)
     {
         // Note: if we test the value of each parameter, then we could
         //       already know whether it needs quoting or not when we
         //       reach here
         //
-        result += "; ";
-        result += p.first;
-        result += "=\"";
-        result += p.second;
-        result += "\"";
+        out += "; ";
+        out += p.first;
+        out += "=\"";
+        out += p.second;
+        out += '"';
+    }
+}
+
+
+/** \brief Initialize a Link header parser.
+ *
+ * This function initializes the parser and parses the \p header if
+ * not empty.
+ *
+ * \warning
+ * The object keeps views to the input string. You must make sure that
+ * the string remains valid for as long as you access the parsed links.
+ *
+ * \param[in] header  The value of a Link header.
+ *
+ * \sa parse()
+ */
+http_link_header::http_link_header(std::string_view header)
+{
+    if(!header.empty())
+    {
+        parse(header);
+    }
+}
+
+
+/** \brief Parse the value of a Link header.
+ *
+ * This function parses the value of a Link header as defined in
+ * RFC 8288:
+ *
+ * \code
+ *     Link       = #link-value
+ *     link-value = "<" URI-Reference ">" *( OWS ";" OWS link-param )
+ *     link-param = token BWS [ "=" BWS ( token / quoted-string ) ]
+ * \endcode
+ *
+ * The parser does not copy any of the data. The URIs, parameter names,
+ * and parameter values are all views in the \p header string. Quoted
+ * values are returned without their quotes. If such a value includes
+ * a backslash, it is kept as is.
+ *
+ * The parsed links are appended to the existing list. Call clear() first
+ * to reuse the object (the buffers are kept so reusing the object does
+ * not allocate memory once large enough).
+ *
+ * \param[in] header  The Link header value to parse.
+ *
+ * \return true if the entire header was valid. On errors, the links
+ * parsed so far are kept.
+ */
+bool http_link_header::parse(std::string_view header)
+{
+    char const * s(header.data());
+    char const * const end(s + header.length());
+    for(;;)
+    {
+        while(s < end && (is_ows(*s) || *s == ','))
+        {
+            ++s;
+        }
+        if(s >= end)
+        {
+            return true;
+        }
+
+        if(*s != '<')
+        {
+            return false;
+        }
+        ++s;
+        char const * const uri_start(s);
+        while(s < end && *s != '>')
+        {
+            ++s;
+        }
+        if(s >= end)
+        {
+            return false;
+        }
+
+        link_t link;
+        link.f_uri = std::string_view(uri_start, s - uri_start);
+        link.f_param_start = static_cast<std::uint32_t>(f_params.size());
+        ++s;
+
+        for(;;)
+        {
+            while(s < end && is_ows(*s))
+            {
+                ++s;
+            }
+            if(s >= end || *s == ',')
+            {
+                break;
+            }
+            if(*s != ';')
+            {
+                return false;
+            }
+            ++s;
+            while(s < end && is_ows(*s))
+            {
+                ++s;
+            }
+
+            param_t param;
+            char const * const name_start(s);
+            s += scan_token(std::string_view(s, end - s));
+            if(s == name_start)
+            {
+                return false;
+            }
+            param.f_name = std::string_view(name_start, s - name_start);
+            while(s < end && is_ows(*s))
+            {
+                ++s;
+            }
+            if(s < end && *s == '=')
+            {
+                ++s;
+                while(s < end && is_ows(*s))
+                {
+                    ++s;
+                }
+                if(s < end && *s == '"')
+                {
+                    ++s;
+                    char const * const value_start(s);
+                    while(s < end && *s != '"')
+                    {
+                        if(*s == '\\')
+                        {
+                            ++s;
+                            if(s >= end)
+                            {
+                                return false;
+                            }
+                        }
+                        ++s;
+                    }
+                    if(s >= end)
+                    {
+                        return false;
+                    }
+                    param.f_value = std::string_view(value_start, s - value_start);
+                    param.f_quoted = true;
+                    ++s;
+                }
+                else
+                {
+                    char const * const value_start(s);
+                    s += scan_token(std::string_view(s, end - s));
+                    param.f_value = std::string_view(value_start, s - value_start);
+                }
+            }
+            f_params.push_back(param);
+            ++link.f_param_count;
+        }
+
+        f_links.push_back(link);
+    }
+}
+
+
+/** \brief Clear the list of links.
+ *
+ * This function clears the list of links. The buffers are not released
+ * so the next parse() can reuse them.
+ */
+void http_link_header::clear()
+{
+    f_links.clear();
+    f_params.clear();
+}
+
+
+/** \brief Get the number of links found in the header.
+ *
+ * \return The number of links parsed so far.
+ */
+std::size_t http_link_header::size() const
+{
+    return f_links.size();
+}
+
+
+/** \brief Check whether the header had any links.
+ *
+ * \return true if no links were parsed.
+ */
+bool http_link_header::empty() const
+{
+    return f_links.empty();
+}
+
+
+/** \brief Get the URI of the specified link.
+ *
+ * \exception out_of_range
+ * The \p idx parameter must be smaller than size().
+ *
+ * \param[in] idx  The index of the link.
+ *
+ * \return The URI of the link, without the angle brackets.
+ */
+std::string_view http_link_header::get_uri(std::size_t idx) const
+{
+    if(idx >= f_links.size())
+    {
+        throw out_of_range("link index out of range.");
     }
+    return f_links[idx].f_uri;
+}
+
+
+/** \brief Get the relation of the specified link.
+ *
+ * This function is a shortcut which returns the value of the "rel"
+ * parameter.
+ *
+ * \param[in] idx  The index of the link.
+ *
+ * \return The "rel" parameter or an empty view.
+ */
+std::string_view http_link_header::get_rel(std::size_t idx) const
+{
+    return get_param(idx, "rel");
+}
+
+
+/** \brief Check whether the specified link has the named parameter.
+ *
+ * The parameter names are case insensitive.
+ *
+ * \param[in] idx  The index of the link.
+ * \param[in] name  The name of the parameter.
+ *
+ * \return true if the parameter is defined.
+ */
+bool http_link_header::has_param(std::size_t idx, std::string_view name) const
+{
+    return find_param(idx, name) != nullptr;
+}
+
+
+/** \brief Get the value of a parameter of the specified link.
+ *
+ * The parameter names are case insensitive. If the parameter appears
+ * more than once, the first one is returned, as required by RFC 8288.
+ *
+ * \param[in] idx  The index of the link.
+ * \param[in] name  The name of the parameter.
+ *
+ * \return The value of the parameter or an empty view.
+ */
+std::string_view http_link_header::get_param(std::size_t idx, std::string_view name) const
+{
+    param_t const * p(find_param(idx, name));
+    if(p == nullptr)
+    {
+        return std::string_view();
+    }
+    return p->f_value;
+}
+
+
+/** \brief Get the number of parameters of the specified link.
+ *
+ * \param[in] idx  The index of the link.
+ *
+ * \return The number of parameters of that link.
+ */
+std::size_t http_link_header::get_param_count(std::size_t idx) const
+{
+    if(idx >= f_links.size())
+    {
+        throw out_of_range("link index out of range.");
+    }
+    return f_links[idx].f_param_count;
+}
+
+
+/** \brief Get a parameter by index.
+ *
+ * \exception out_of_range
+ * The \p idx parameter must be smaller than size() and \p param_idx must
+ * be smaller than get_param_count().
+ *
+ * \param[in] idx  The index of the link.
+ * \param[in] param_idx  The index of the parameter.
+ *
+ * \return A reference to the parameter.
+ */
+http_link_header::param_t const & http_link_header::get_param(std::size_t idx, std::size_t param_idx) const
+{
+    if(param_idx >= get_param_count(idx))
+    {
+        throw out_of_range("link parameter index out of range.");
+    }
+    return f_params[f_links[idx].f_param_start + param_idx];
+}
 
+
+http_link_header::param_t const * http_link_header::find_param(std::size_t idx, std::string_view name) const
+{
+    if(idx >= f_links.size())
+    {
+        throw out_of_range("link index out of range.");
+    }
+    link_t const & link(f_links[idx]);
+    for(std::uint32_t p(0); p < link.f_param_count; ++p)
+    {
+        param_t const & param(f_params[link.f_param_start + p]);
+        if(equal_ignore_case(param.f_name, name))
+        {
+            return &param;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Append a list of links to a buffer.
+ *
+ * This function appends all the \p links to \p out, separated by commas,
+ * as expected in the value of a Link header. The field name is not added.
+ *
+ * When \p redirect is true, only the links marked with
+ * http_link::set_redirect() are added.
+ *
+ * \param[in,out] out  The buffer where the links are appended.
+ * \param[in] links  The links to append.
+ * \param[in] redirect  Whether the links are for a redirect.
+ */
+void append_links(std::string & out, http_link::vector_t const & links, bool redirect)
+{
+    append_link_list(out, links, redirect);
+}
+
+
+/** \brief Append a map of links to a buffer.
+ *
+ * This function is the same as the other append_links() function,
+ * only it works with a map of links.
+ *
+ * \param[in,out] out  The buffer where the links are appended.
+ * \param[in] links  The links to append.
+ * \param[in] redirect  Whether the links are for a redirect.
+ */
+void append_links(std::string & out, http_link::map_t const & links, bool redirect)
+{
+    append_link_list(out, links, redirect);
+}
+
+
+/** \brief Generate the Link header with all the links.
+ *
+ * This function generates the "Link: ..." header with all the
+ * \p links in one string. The string does not include the "\r\n".
+ *
+ * If no link gets added, the function returns an empty string.
+ *
+ * \param[in] links  The links to add to the header.
+ * \param[in] redirect  Whether the links are for a redirect.
+ *
+ * \return The Link header.
+ */
+std::string links_to_http_header(http_link::vector_t const & links, bool redirect)
+{
+    std::string result(g_name_edhttp_field_link);
+    result += ": ";
+    std::size_t const size(result.length());
+    append_link_list(result, links, redirect);
+    if(result.length() == size)
+    {
+        return std::string();
+    }
+    return result;
+}
+
+
+/** \brief Generate the Link header with all the links.
+ *
+ * This function is the same as the other links_to_http_header(),
+ * only it works with a map of links.
+ *
+ * \param[in] links  The links to add to the header.
+ * \param[in] redirect  Whether the links are for a redirect.
+ *
+ * \return The Link header.
+ */
+std::string links_to_http_header(http_link::map_t const & links, bool redirect)
+{
+    std::string result(g_name_edhttp_field_link);
+    result += ": ";
+    std::size_t const size(result.length());
+    append_link_list(result, links, redirect);
+    if(result.length() == size)
+    {
+        return std::string();
+    }
     return result;
 }
 
 
+/** \brief Generate a 103 Early Hints interim response.
+ *
+ * This function appends a complete "103 Early Hints" interim response
+ * (RFC 8297) to \p out. The response includes all the \p links in one
+ * Link header, generally links with "rel=preload" or "rel=preconnect".
+ *
+ * A server can send this buffer as soon as it knows which resources
+ * the page requires and before it computes the final response. The
+ * client can then start loading those resources in parallel.
+ *
+ * \param[in,out] out  The buffer where the interim response is appended.
+ * \param[in] links  The links to add to the response.
+ */
+void append_early_hints(std::string & out, http_link::vector_t const & links)
+{
+    append_early_hints_response(out, links);
+}
+
+
+/** \brief Generate a 103 Early Hints interim response.
+ *
+ * This function is the same as the other append_early_hints(), only it
+ * works with a map of links.
+ *
+ * \param[in,out] out  The buffer where the interim response is appended.
+ * \param[in] links  The links to add to the response.
+ */
+void append_early_hints(std::string & out, http_link::map_t const & links)
+{
+    append_early_hints_response(out, links);
+}
+
+
 
 } // namespace edhttp
 // vim: ts=4 sw=4 et
@@ -19,8 +19,11 @@
 
 // C++
 //
+#include    <cstdint>
 #include    <map>
 #include    <string>
+#include    <string_view>
+#include    <vector>
 
 
 
@@ -33,6 +36,7 @@ class http_link
 {
 public:
     typedef std::map<std::string, http_link>        map_t;
+    typedef std::vector<http_link>                  vector_t;
     typedef std::map<std::string, std::string>      param_t;
 
                         http_link(std::string const & link, std::string const & rel);
@@ -50,6 +54,7 @@ public:
     param_t const &     get_params() const;
 
     std::string         to_http_header() const;
+    void                append_http_header(std::string & out) const;
 
 private:
     std::string         f_link = std::string();     // this link URI
@@ -60,5 +65,54 @@ private:
 
 
 
+class http_link_header
+{
+public:
+    struct param_t
+    {
+        std::string_view    f_name = std::string_view();
+        std::string_view    f_value = std::string_view();   // without the quotes
+        bool                f_quoted = false;               // value may include backslash escapes
+    };
+
+                        http_link_header(std::string_view header = std::string_view());
+
+    bool                parse(std::string_view header);
+    void                clear();
+
+    std::size_t         size() const;
+    bool                empty() const;
+    std::string_view    get_uri(std::size_t idx) const;
+    std::string_view    get_rel(std::size_t idx) const;
+    bool                has_param(std::size_t idx, std::string_view name) const;
+    std::string_view    get_param(std::size_t idx, std::string_view name) const;
+    std::size_t         get_param_count(std::size_t idx) const;
+    param_t const &     get_param(std::size_t idx, std::size_t param_idx) const;
+
+private:
+    struct link_t
+    {
+        std::string_view    f_uri = std::string_view();
+        std::uint32_t       f_param_start = 0;
+        std::uint32_t       f_param_count = 0;
+    };
+
+    param_t const *     find_param(std::size_t idx, std::string_view name) const;
+
+    std::vector<link_t> f_links = std::vector<link_t>();
+    std::vector<param_t>
+                        f_params = std::vector<param_t>();
+};
+
+
+void                    append_links(std::string & out, http_link::vector_t const & links, bool redirect = false);
+void                    append_links(std::string & out, http_link::map_t const & links, bool redirect = false);
+std::string             links_to_http_header(http_link::vector_t const & links, bool redirect = false);
+std::string             links_to_http_header(http_link::map_t const & links, bool redirect = false);
+void                    append_early_hints(std::string & out, http_link::vector_t const & links);
+void                    append_early_hints(std::string & out, http_link::map_t const & links);
+
+
+
 } // namespace edhttp
 // vim: ts=4 sw=4 et
@@ -0,0 +1,407 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/** \file
+ * \brief Timing of the phases of an HTTP request.
+ *
+ * When a trace_sink is attached to an http_client, each request gets
+ * an http_trace object which records the time spent in each phase of
+ * the request. Once the request is done, the trace is sent to the sink.
+ * The trace_ring_buffer is a sink keeping the last N traces in memory.
+ *
+ * The trace can also carry a W3C trace context, in which case the
+ * client sends a `traceparent` header so the server can attach its own
+ * spans to the same trace.
+ */
+
+// self
+//
+#include    "edhttp/http_trace.h"
+
+#include    "edhttp/exception.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <random>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+constexpr char const g_hex_digits[] = "0123456789abcdef";
+
+
+template<std::size_t N>
+void random_id(std::array<std::uint8_t, N> & id)
+{
+    thread_local std::mt19937_64 generator(std::random_device{}());
+
+    do
+    {
+        for(std::size_t idx(0); idx < N; idx += 8)
+        {
+            std::uint64_t const r(generator());
+            for(std::size_t j(0); j < 8 && idx + j < N; ++j)
+            {
+                id[idx + j] = static_cast<std::uint8_t>(r >> (j * 8));
+            }
+        }
+    }
+    while(std::all_of(id.begin(), id.end(), [](std::uint8_t c) { return c == 0; }));
+}
+
+
+int hex_value(char c)
+{
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;  // W3C trace context only accepts lowercase
+}
+
+
+template<std::size_t N>
+bool parse_hex(std::string_view hex, std::array<std::uint8_t, N> & id)
+{
+    bool zero(true);
+    for(std::size_t idx(0); idx < N; ++idx)
+    {
+        int const hi(hex_value(hex[idx * 2]));
+        int const lo(hex_value(hex[idx * 2 + 1]));
+        if(hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        id[idx] = static_cast<std::uint8_t>(hi * 16 + lo);
+        zero = zero && id[idx] == 0;
+    }
+    return !zero;
+}
+
+
+template<std::size_t N>
+void append_hex(std::string & out, std::array<std::uint8_t, N> const & id)
+{
+    for(auto const c : id)
+    {
+        out += g_hex_digits[c >> 4];
+        out += g_hex_digits[c & 15];
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Get the name of a phase.
+ *
+ * \param[in] phase  The phase to convert.
+ *
+ * \return The name of the phase in lowercase.
+ */
+char const * trace_phase_to_string(trace_phase_t phase)
+{
+    switch(phase)
+    {
+    case trace_phase_t::TRACE_PHASE_RESOLVE:
+        return "resolve";
+
+    case trace_phase_t::TRACE_PHASE_CONNECT:
+        return "connect";
+
+    case trace_phase_t::TRACE_PHASE_WRITE:
+        return "write";
+
+    case trace_phase_t::TRACE_PHASE_FIRST_BYTE:
+        return "first_byte";
+
+    case trace_phase_t::TRACE_PHASE_HEADER:
+        return "header";
+
+    case trace_phase_t::TRACE_PHASE_BODY:
+        return "body";
+
+    }
+
+    return "unknown";
+}
+
+
+/** \brief Start timing a request.
+ *
+ * All the timestamps come from the monotonic clock.
+ */
+void http_trace::start()
+{
+    f_start = clock_t::now();
+    f_last_mark = f_start;
+}
+
+
+/** \brief Mark the end of a phase.
+ *
+ * The time elapsed since the previous mark (or the start) is added to
+ * the \p phase. A phase can be marked more than once, for example when
+ * the server sends interim responses.
+ *
+ * \param[in] phase  The phase which just ended.
+ */
+void http_trace::mark(trace_phase_t phase)
+{
+    clock_t::time_point const now(clock_t::now());
+    f_phases[static_cast<std::size_t>(phase)] += now - f_last_mark;
+    f_last_mark = now;
+}
+
+
+/** \brief Stop timing the request.
+ *
+ * This function saves the total duration of the request.
+ */
+void http_trace::finish()
+{
+    f_total = clock_t::now() - f_start;
+}
+
+
+/** \brief Start a new trace.
+ *
+ * This function generates a new random trace identifier and a new
+ * span identifier. The trace is marked as sampled.
+ */
+void http_trace::new_trace()
+{
+    random_id(f_trace_id);
+    random_id(f_span_id);
+    f_parent_id = span_id_t();
+    f_trace_flags = 0x01;
+    f_has_trace_context = true;
+}
+
+
+/** \brief Continue the trace defined in a traceparent header.
+ *
+ * The trace identifier and the flags are kept, the parent identifier
+ * of the header becomes the parent of this span, and a new span
+ * identifier is generated.
+ *
+ * Future versions of the header are accepted as long as they start
+ * with the version 00 fields.
+ *
+ * \param[in] traceparent  The value of a traceparent header.
+ *
+ * \return true if the value was valid, false otherwise (and the trace
+ * is left unchanged).
+ */
+bool http_trace::set_traceparent(std::string_view traceparent)
+{
+    // version "-" trace-id "-" parent-id "-" flags
+    //
+    if(traceparent.length() < 55
+    || traceparent[2] != '-'
+    || traceparent[35] != '-'
+    || traceparent[52] != '-')
+    {
+        return false;
+    }
+    int const v1(hex_value(traceparent[0]));
+    int const v2(hex_value(traceparent[1]));
+    if(v1 < 0
+    || v2 < 0
+    || (v1 == 15 && v2 == 15))
+    {
+        return false;
+    }
+    if(v1 == 0 && v2 == 0)
+    {
+        if(traceparent.length() != 55)
+        {
+            return false;
+        }
+    }
+    else if(traceparent.length() > 55
+         && traceparent[55] != '-')
+    {
+        return false;
+    }
+
+    trace_id_t trace_id;
+    span_id_t parent_id;
+    int const f1(hex_value(traceparent[53]));
+    int const f2(hex_value(traceparent[54]));
+    if(!parse_hex(traceparent.substr(3, 32), trace_id)
+    || !parse_hex(traceparent.substr(36, 16), parent_id)
+    || f1 < 0
+    || f2 < 0)
+    {
+        return false;
+    }
+
+    f_trace_id = trace_id;
+    f_parent_id = parent_id;
+    f_trace_flags = static_cast<std::uint8_t>(f1 * 16 + f2);
+    random_id(f_span_id);
+    f_has_trace_context = true;
+
+    return true;
+}
+
+
+/** \brief Get the traceparent header for this span.
+ *
+ * \return The header value, or an empty string if the trace has no
+ * trace context.
+ */
+std::string http_trace::get_traceparent() const
+{
+    if(!f_has_trace_context)
+    {
+        return std::string();
+    }
+
+    std::string result;
+    result.reserve(55);
+    result += "00-";
+    append_hex(result, f_trace_id);
+    result += '-';
+    append_hex(result, f_span_id);
+    result += '-';
+    append_hex(result, std::array<std::uint8_t, 1>{ f_trace_flags });
+    return result;
+}
+
+
+
+trace_sink::~trace_sink()
+{
+}
+
+
+
+/** \brief Initialize a ring buffer of traces.
+ *
+ * \exception invalid_parameter
+ * The capacity must be at least 1.
+ *
+ * \param[in] capacity  The maximum number of traces kept in memory.
+ */
+trace_ring_buffer::trace_ring_buffer(std::size_t capacity)
+    : f_capacity(capacity)
+{
+    if(capacity == 0)
+    {
+        throw invalid_parameter("the capacity of a trace_ring_buffer must be at least 1.");
+    }
+    f_traces.reserve(capacity);
+}
+
+
+/** \brief Save a trace.
+ *
+ * Once the buffer is full, the oldest trace gets overwritten.
+ *
+ * \param[in] trace  The trace to save.
+ */
+void trace_ring_buffer::record(http_trace const & trace)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    if(f_traces.size() < f_capacity)
+    {
+        f_traces.push_back(trace);
+        return;
+    }
+    f_traces[f_next] = trace;
+    f_next = (f_next + 1) % f_capacity;
+    ++f_overwritten;
+}
+
+
+/** \brief Get a copy of the saved traces.
+ *
+ * \return The traces, the oldest first.
+ */
+std::vector<http_trace> trace_ring_buffer::get_traces() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    std::vector<http_trace> result;
+    result.reserve(f_traces.size());
+    result.insert(result.end(), f_traces.begin() + static_cast<std::ptrdiff_t>(f_next), f_traces.end());
+    result.insert(result.end(), f_traces.begin(), f_traces.begin() + static_cast<std::ptrdiff_t>(f_next));
+    return result;
+}
+
+
+std::size_t trace_ring_buffer::size() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_traces.size();
+}
+
+
+std::size_t trace_ring_buffer::get_capacity() const
+{
+    return f_capacity;
+}
+
+
+/** \brief Get the number of traces which were overwritten.
+ *
+ * \return The number of traces lost because the buffer was full.
+ */
+std::uint64_t trace_ring_buffer::get_overwritten() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_overwritten;
+}
+
+
+void trace_ring_buffer::clear()
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    f_traces.clear();
+    f_next = 0;
+    f_overwritten = 0;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
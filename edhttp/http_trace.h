@@ -0,0 +1,135 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <array>
+#include    <chrono>
+#include    <cstdint>
+#include    <memory>
+#include    <mutex>
+#include    <string>
+#include    <string_view>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+enum class trace_phase_t : std::uint8_t
+{
+    TRACE_PHASE_RESOLVE,        // get the addresses of the host
+    TRACE_PHASE_CONNECT,        // connect, including the TLS handshake
+    TRACE_PHASE_WRITE,          // send the request
+    TRACE_PHASE_FIRST_BYTE,     // wait for the status line
+    TRACE_PHASE_HEADER,         // read the header fields
+    TRACE_PHASE_BODY            // read the body
+};
+
+constexpr std::size_t       TRACE_PHASE_COUNT = 6;
+
+
+char const *                trace_phase_to_string(trace_phase_t phase);
+
+
+struct http_trace
+{
+    typedef std::chrono::steady_clock           clock_t;
+    typedef std::array<std::uint8_t, 16>        trace_id_t;
+    typedef std::array<std::uint8_t, 8>         span_id_t;
+
+    void                start();
+    void                mark(trace_phase_t phase);
+    void                finish();
+
+    void                new_trace();
+    bool                set_traceparent(std::string_view traceparent);
+    std::string         get_traceparent() const;
+
+    std::string         f_method = std::string();
+    std::string         f_host = std::string();
+    int                 f_port = -1;
+    std::string         f_path = std::string();
+    int                 f_response_code = 0;
+    bool                f_reused_connection = false;
+    std::string         f_error = std::string();
+
+    // W3C trace context, only set when the traceparent header is sent
+    //
+    bool                f_has_trace_context = false;
+    trace_id_t          f_trace_id = trace_id_t();
+    span_id_t           f_parent_id = span_id_t();      // zero if this is the root
+    span_id_t           f_span_id = span_id_t();
+    std::uint8_t        f_trace_flags = 0;
+
+    clock_t::time_point f_start = clock_t::time_point();
+    clock_t::time_point f_last_mark = clock_t::time_point();
+    std::array<clock_t::duration, TRACE_PHASE_COUNT>
+                        f_phases = std::array<clock_t::duration, TRACE_PHASE_COUNT>();
+    clock_t::duration   f_total = clock_t::duration();
+};
+
+
+class trace_sink
+{
+public:
+    typedef std::shared_ptr<trace_sink>     pointer_t;
+
+    virtual             ~trace_sink();
+
+    virtual void        record(http_trace const & trace) = 0;
+};
+
+
+class trace_ring_buffer
+    : public trace_sink
+{
+public:
+    typedef std::shared_ptr<trace_ring_buffer>  pointer_t;
+
+    static constexpr std::size_t    DEFAULT_CAPACITY = 1024;
+
+                        trace_ring_buffer(std::size_t capacity = DEFAULT_CAPACITY);
+
+    // trace_sink implementation
+    virtual void        record(http_trace const & trace) override;
+
+    std::vector<http_trace>
+                        get_traces() const;
+    std::size_t         size() const;
+    std::size_t         get_capacity() const;
+    std::uint64_t       get_overwritten() const;
+    void                clear();
+
+private:
+    mutable std::mutex  f_mutex = std::mutex();
+    std::vector<http_trace>
+                        f_traces = std::vector<http_trace>();
+    std::size_t         f_capacity = DEFAULT_CAPACITY;
+    std::size_t         f_next = 0;
+    std::uint64_t       f_overwritten = 0;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,72 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \file
+ * \brief A small vector keeping its first elements inline.
+ *
+ * The header parsers save their results in this vector so parsing a
+ * common header does not allocate. Only headers with more than N
+ * elements use the heap.
+ */
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+template<typename T, std::size_t N>
+class inline_vector
+{
+public:
+    std::size_t     size() const { return f_size; }
+    bool            empty() const { return f_size == 0; }
+    T &             operator [] (std::size_t idx) { return idx < N ? f_inline[idx] : f_overflow[idx - N]; }
+    T const &       operator [] (std::size_t idx) const { return idx < N ? f_inline[idx] : f_overflow[idx - N]; }
+    void            push_back(T const & value)
+                    {
+                        if(f_size < N)
+                        {
+                            f_inline[f_size] = value;
+                        }
+                        else
+                        {
+                            f_overflow.push_back(value);
+                        }
+                        ++f_size;
+                    }
+    void            clear() { f_size = 0; f_overflow.clear(); }
+
+private:
+    std::array<T, N>    f_inline = {};
+    std::vector<T>      f_overflow = std::vector<T>();
+    std::size_t         f_size = 0;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
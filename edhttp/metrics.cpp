@@ -0,0 +1,836 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Counters, gauges and histograms exported in Prometheus format.
+ *
+ * The metrics are updated by the threads doing the work and read when
+ * a scraper queries the `/metrics` path of the health listener. The
+ * updates are lock-free: counters and histograms are split in shards,
+ * a thread always updating the same shard, and the shards are merged
+ * only when the metrics get rendered.
+ *
+ * The histograms use buckets similar to an HDR histogram: small values
+ * are exact and larger values are saved in 8 buckets per power of 2.
+ * This way the buckets cover the entire 64 bit range with a constant
+ * relative precision. The exposition `le` bounds are only applied when
+ * rendering the metrics.
+ */
+
+// self
+//
+#include    "edhttp/metrics.h"
+
+#include    "edhttp/exception.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <bit>
+#include    <charconv>
+#include    <cmath>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+namespace
+{
+
+
+
+/** \brief Get the shard of the calling thread.
+ *
+ * Each thread gets the next shard the first time it updates a metric.
+ * Two threads may share a shard when more than METRIC_SHARDS threads
+ * are running; the updates are atomic so this is only slower.
+ *
+ * \return The index of the shard to update.
+ */
+std::size_t get_shard()
+{
+    static std::atomic<std::size_t> g_next_shard(0);
+    thread_local std::size_t const shard(g_next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS);
+    return shard;
+}
+
+
+void append_number(std::string & out, double value)
+{
+    char buf[32];
+    auto r(std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed));
+    if(r.ec != std::errc())
+    {
+        // very large values do not fit in the fixed notation, the
+        // exposition format also accepts the scientific notation
+        //
+        r = std::to_chars(buf, buf + sizeof(buf), value);
+    }
+    out.append(buf, r.ptr);
+}
+
+
+char const * type_name(metric::type_t type)
+{
+    switch(type)
+    {
+    case metric::type_t::METRIC_TYPE_COUNTER:
+        return "counter";
+
+    case metric::type_t::METRIC_TYPE_GAUGE:
+        return "gauge";
+
+    case metric::type_t::METRIC_TYPE_HISTOGRAM:
+        return "histogram";
+
+    }
+    return "untyped"; // LCOV_EXCL_LINE
+}
+
+
+
+} // no name namespace
+
+
+
+/** \class metric
+ * \brief The base class of all the metrics.
+ *
+ * A metric has a name, a help string and an optional list of labels.
+ * The labels are saved as rendered in the exposition format, without
+ * the curly brackets, for example `method="GET",code="200"`. Use the
+ * label() function to render each label with the proper escaping.
+ */
+
+
+/** \brief Initialize a metric.
+ *
+ * \exception invalid_parameter
+ * The \p name must match `[a-zA-Z_:][a-zA-Z0-9_:]*`.
+ *
+ * \param[in] type  The type of the metric.
+ * \param[in] name  The name of the metric.
+ * \param[in] help  A description of the metric.
+ * \param[in] labels  The rendered labels or an empty string.
+ */
+metric::metric(
+          type_t type
+        , std::string_view name
+        , std::string_view help
+        , std::string_view labels)
+    : f_type(type)
+    , f_name(name)
+    , f_help(help)
+    , f_labels(labels)
+{
+    if(!is_valid_name(name))
+    {
+        throw invalid_parameter(
+                  "\""
+                + f_name
+                + "\" is not a valid metric name.");
+    }
+}
+
+
+metric::~metric()
+{
+}
+
+
+metric::type_t metric::get_type() const
+{
+    return f_type;
+}
+
+
+std::string const & metric::get_name() const
+{
+    return f_name;
+}
+
+
+std::string const & metric::get_help() const
+{
+    return f_help;
+}
+
+
+std::string const & metric::get_labels() const
+{
+    return f_labels;
+}
+
+
+/** \brief Check whether \p name is a valid metric or label name.
+ *
+ * \param[in] name  The name to check.
+ *
+ * \return true if \p name can be used as a metric name.
+ */
+bool metric::is_valid_name(std::string_view name)
+{
+    if(name.empty()
+    || (name[0] >= '0' && name[0] <= '9'))
+    {
+        return false;
+    }
+    for(auto const c : name)
+    {
+        if((c < 'a' || c > 'z')
+        && (c < 'A' || c > 'Z')
+        && (c < '0' || c > '9')
+        && c != '_'
+        && c != ':')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** \brief Render one label.
+ *
+ * The \p value gets escaped as expected by the exposition format
+ * (backslash, double quote and newline). Separate multiple labels
+ * with a comma.
+ *
+ * \exception invalid_parameter
+ * The \p name must be a valid name.
+ *
+ * \param[in] name  The name of the label.
+ * \param[in] value  The value of the label.
+ *
+ * \return The label in the form `name="value"`.
+ */
+std::string metric::label(std::string_view name, std::string_view value)
+{
+    if(!is_valid_name(name))
+    {
+        throw invalid_parameter(
+                  "\""
+                + std::string(name)
+                + "\" is not a valid label name.");
+    }
+
+    std::string result(name);
+    result += "=\"";
+    for(auto const c : value)
+    {
+        switch(c)
+        {
+        case '\\':
+            result += "\\\\";
+            break;
+
+        case '"':
+            result += "\\\"";
+            break;
+
+        case '\n':
+            result += "\\n";
+            break;
+
+        default:
+            result += c;
+            break;
+
+        }
+    }
+    result += '"';
+    return result;
+}
+
+
+void metric::render_name(
+      std::string & out
+    , std::string_view suffix
+    , std::string_view extra_label) const
+{
+    out += f_name;
+    out += suffix;
+    if(!f_labels.empty()
+    || !extra_label.empty())
+    {
+        out += '{';
+        out += f_labels;
+        if(!f_labels.empty()
+        && !extra_label.empty())
+        {
+            out += ',';
+        }
+        out += extra_label;
+        out += '}';
+    }
+    out += ' ';
+}
+
+
+
+/** \class metric_counter
+ * \brief A counter which can only increase.
+ *
+ * Counters are used to count events (i.e. requests) and sizes (i.e. the
+ * number of bytes compressed). By convention, their name ends with
+ * `_total`.
+ */
+
+
+metric_counter::metric_counter(
+          std::string_view name
+        , std::string_view help
+        , std::string_view labels)
+    : metric(type_t::METRIC_TYPE_COUNTER, name, help, labels)
+{
+}
+
+
+/** \brief Increment the counter.
+ *
+ * The function increments the shard of the calling thread without any
+ * lock.
+ *
+ * \param[in] value  The amount to add to the counter.
+ */
+void metric_counter::increment(std::uint64_t value)
+{
+    f_shards[get_shard()].f_value.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+/** \brief Get the current value of the counter.
+ *
+ * \return The sum of all the shards.
+ */
+std::uint64_t metric_counter::get_value() const
+{
+    std::uint64_t result(0);
+    for(auto const & s : f_shards)
+    {
+        result += s.f_value.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+
+void metric_counter::render(std::string & out) const
+{
+    render_name(out, std::string_view());
+    out += std::to_string(get_value());
+    out += '\n';
+}
+
+
+
+/** \class metric_gauge
+ * \brief A value which can go up and down.
+ *
+ * Gauges are used for values such as the number of open connections.
+ * Since a gauge can be set, it is not sharded.
+ */
+
+
+metric_gauge::metric_gauge(
+          std::string_view name
+        , std::string_view help
+        , std::string_view labels)
+    : metric(type_t::METRIC_TYPE_GAUGE, name, help, labels)
+{
+}
+
+
+void metric_gauge::set(std::int64_t value)
+{
+    f_value.store(value, std::memory_order_relaxed);
+}
+
+
+void metric_gauge::add(std::int64_t value)
+{
+    f_value.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+std::int64_t metric_gauge::get_value() const
+{
+    return f_value.load(std::memory_order_relaxed);
+}
+
+
+void metric_gauge::render(std::string & out) const
+{
+    render_name(out, std::string_view());
+    out += std::to_string(get_value());
+    out += '\n';
+}
+
+
+
+/** \class metric_histogram
+ * \brief A distribution of values such as latencies.
+ *
+ * The histogram records integer values, in general durations in
+ * nanoseconds or sizes in bytes. The values are divided by the divisor
+ * when rendering so the exposition uses the base units (i.e. seconds).
+ *
+ * The values are saved in HDR buckets. When rendering, a bucket is
+ * counted under an `le` bound if its highest value is smaller or equal
+ * to that bound. The bounds should therefore not be taken as exact.
+ */
+
+
+/** \brief Record the time spent in a block.
+ *
+ * The constructor saves the current time and the destructor records
+ * the number of nanoseconds elapsed since in the histogram.
+ *
+ * \param[in] histogram  The histogram where the duration gets recorded.
+ */
+metric_histogram::timer::timer(metric_histogram & histogram)
+    : f_histogram(histogram)
+{
+}
+
+
+metric_histogram::timer::~timer()
+{
+    f_histogram.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - f_start).count()));
+}
+
+
+/** \brief Initialize a histogram.
+ *
+ * \exception invalid_parameter
+ * The bounds must be sorted in increasing order.
+ *
+ * \param[in] name  The name of the histogram.
+ * \param[in] help  A description of the histogram.
+ * \param[in] labels  The rendered labels or an empty string.
+ * \param[in] bounds  The `le` bounds used when rendering, in recorded units.
+ * \param[in] divisor  The number of recorded units in one exposition
+ * unit (i.e. 1e9 for nanoseconds rendered as seconds).
+ */
+metric_histogram::metric_histogram(
+          std::string_view name
+        , std::string_view help
+        , std::string_view labels
+        , bounds_t const & bounds
+        , double divisor)
+    : metric(type_t::METRIC_TYPE_HISTOGRAM, name, help, labels)
+    , f_bounds(bounds)
+    , f_divisor(divisor)
+    , f_shards(std::make_unique<shard_t[]>(METRIC_SHARDS))
+{
+    if(!std::is_sorted(f_bounds.begin(), f_bounds.end())
+    || std::adjacent_find(f_bounds.begin(), f_bounds.end()) != f_bounds.end())
+    {
+        throw invalid_parameter("the bounds of histogram \"" + get_name() + "\" must be sorted and unique.");
+    }
+}
+
+
+/** \brief Record one value.
+ *
+ * The function updates the shard of the calling thread without any
+ * lock.
+ *
+ * \param[in] value  The value to record.
+ */
+void metric_histogram::record(std::uint64_t value)
+{
+    shard_t & s(f_shards[get_shard()]);
+    s.f_buckets[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    s.f_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+
+std::uint64_t metric_histogram::get_count() const
+{
+    std::uint64_t result(0);
+    for(auto const c : merge())
+    {
+        result += c;
+    }
+    return result;
+}
+
+
+std::uint64_t metric_histogram::get_sum() const
+{
+    std::uint64_t result(0);
+    for(std::size_t idx(0); idx < METRIC_SHARDS; ++idx)
+    {
+        result += f_shards[idx].f_sum.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+
+/** \brief Get a percentile.
+ *
+ * The result is the highest value of the bucket which includes the
+ * requested percentile so it is at most 12.5% larger than the exact
+ * value.
+ *
+ * \param[in] percent  The percentile, from 0.0 to 100.0.
+ *
+ * \return The value at that percentile or 0 if the histogram is empty.
+ */
+std::uint64_t metric_histogram::get_percentile(double percent) const
+{
+    std::array<std::uint64_t, BUCKET_COUNT> const buckets(merge());
+    std::uint64_t total(0);
+    for(auto const c : buckets)
+    {
+        total += c;
+    }
+    if(total == 0)
+    {
+        return 0;
+    }
+
+    double const p(std::clamp(percent, 0.0, 100.0));
+    std::uint64_t const rank(std::max<std::uint64_t>(
+                  1
+                , static_cast<std::uint64_t>(std::ceil(static_cast<double>(total) * p / 100.0))));
+    std::uint64_t count(0);
+    for(std::size_t idx(0); idx < BUCKET_COUNT; ++idx)
+    {
+        count += buckets[idx];
+        if(count >= rank)
+        {
+            return get_bucket_highest(idx);
+        }
+    }
+    return get_bucket_highest(BUCKET_COUNT - 1); // LCOV_EXCL_LINE
+}
+
+
+metric_histogram::bounds_t const & metric_histogram::get_bounds() const
+{
+    return f_bounds;
+}
+
+
+double metric_histogram::get_divisor() const
+{
+    return f_divisor;
+}
+
+
+void metric_histogram::render(std::string & out) const
+{
+    std::array<std::uint64_t, BUCKET_COUNT> const buckets(merge());
+    std::uint64_t count(0);
+    std::size_t idx(0);
+    std::string le;
+    for(auto const b : f_bounds)
+    {
+        for(; idx < BUCKET_COUNT && get_bucket_highest(idx) <= b; ++idx)
+        {
+            count += buckets[idx];
+        }
+        le = "le=\"";
+        append_number(le, static_cast<double>(b) / f_divisor);
+        le += '"';
+        render_name(out, "_bucket", le);
+        out += std::to_string(count);
+        out += '\n';
+    }
+    for(; idx < BUCKET_COUNT; ++idx)
+    {
+        count += buckets[idx];
+    }
+    render_name(out, "_bucket", "le=\"+Inf\"");
+    out += std::to_string(count);
+    out += '\n';
+
+    // the sum is read after the buckets, it may include a few more values
+    //
+    render_name(out, "_sum");
+    append_number(out, static_cast<double>(get_sum()) / f_divisor);
+    out += '\n';
+    render_name(out, "_count");
+    out += std::to_string(count);
+    out += '\n';
+}
+
+
+/** \brief Get the bucket of a value.
+ *
+ * \param[in] value  The value to convert.
+ *
+ * \return The index of the bucket, from 0 to BUCKET_COUNT - 1.
+ */
+std::size_t metric_histogram::get_bucket(std::uint64_t value)
+{
+    constexpr std::uint64_t const sub_buckets(1ULL << SUB_BUCKET_BITS);
+    if(value < sub_buckets)
+    {
+        return static_cast<std::size_t>(value);
+    }
+    int const exponent(static_cast<int>(std::bit_width(value)) - 1);
+    int const shift(exponent - SUB_BUCKET_BITS);
+    return (static_cast<std::size_t>(exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS)
+         + static_cast<std::size_t>((value >> shift) & (sub_buckets - 1));
+}
+
+
+std::uint64_t metric_histogram::get_bucket_lowest(std::size_t bucket)
+{
+    constexpr std::size_t const sub_buckets(1ULL << SUB_BUCKET_BITS);
+    if(bucket < sub_buckets)
+    {
+        return bucket;
+    }
+    int const shift(static_cast<int>(bucket >> SUB_BUCKET_BITS) - 1);
+    return static_cast<std::uint64_t>(sub_buckets + (bucket & (sub_buckets - 1))) << shift;
+}
+
+
+std::uint64_t metric_histogram::get_bucket_highest(std::size_t bucket)
+{
+    constexpr std::size_t const sub_buckets(1ULL << SUB_BUCKET_BITS);
+    if(bucket < sub_buckets)
+    {
+        return bucket;
+    }
+    int const shift(static_cast<int>(bucket >> SUB_BUCKET_BITS) - 1);
+    return get_bucket_lowest(bucket) + ((1ULL << shift) - 1);
+}
+
+
+/** \brief The default bounds of latency histograms.
+ *
+ * The bounds go from 100us to 10s, in nanoseconds.
+ *
+ * \return The default latency bounds.
+ */
+metric_histogram::bounds_t metric_histogram::latency_bounds()
+{
+    return bounds_t{
+              100'000ULL
+            , 250'000ULL
+            , 500'000ULL
+            , 1'000'000ULL
+            , 2'500'000ULL
+            , 5'000'000ULL
+            , 10'000'000ULL
+            , 25'000'000ULL
+            , 50'000'000ULL
+            , 100'000'000ULL
+            , 250'000'000ULL
+            , 500'000'000ULL
+            , 1'000'000'000ULL
+            , 2'500'000'000ULL
+            , 5'000'000'000ULL
+            , 10'000'000'000ULL
+        };
+}
+
+
+std::array<std::uint64_t, metric_histogram::BUCKET_COUNT> metric_histogram::merge() const
+{
+    std::array<std::uint64_t, BUCKET_COUNT> result = {};
+    for(std::size_t s(0); s < METRIC_SHARDS; ++s)
+    {
+        for(std::size_t idx(0); idx < BUCKET_COUNT; ++idx)
+        {
+            result[idx] += f_shards[s].f_buckets[idx].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+
+
+/** \class metrics_registry
+ * \brief The list of metrics exported by this process.
+ *
+ * The registry owns the metrics. The get_...() functions return the
+ * existing metric when called again with the same name and labels so
+ * each module can retrieve its metrics once and keep the reference.
+ * The references remain valid for the lifetime of the registry.
+ *
+ * The registry mutex is only used to add metrics and render them. The
+ * updates do not use the registry.
+ */
+
+
+metrics_registry::metrics_registry()
+{
+}
+
+
+/** \brief Get the registry used by the library and the health listener.
+ *
+ * \return The process wide registry.
+ */
+metrics_registry & metrics_registry::instance()
+{
+    static metrics_registry registry;
+    return registry;
+}
+
+
+metric_counter & metrics_registry::get_counter(
+      std::string_view name
+    , std::string_view help
+    , std::string_view labels)
+{
+    return get_metric<metric_counter>(metric::type_t::METRIC_TYPE_COUNTER, name, help, labels);
+}
+
+
+metric_gauge & metrics_registry::get_gauge(
+      std::string_view name
+    , std::string_view help
+    , std::string_view labels)
+{
+    return get_metric<metric_gauge>(metric::type_t::METRIC_TYPE_GAUGE, name, help, labels);
+}
+
+
+metric_histogram & metrics_registry::get_histogram(
+      std::string_view name
+    , std::string_view help
+    , std::string_view labels
+    , metric_histogram::bounds_t const & bounds
+    , double divisor)
+{
+    return get_metric<metric_histogram>(metric::type_t::METRIC_TYPE_HISTOGRAM, name, help, labels, bounds, divisor);
+}
+
+
+/** \brief Get the number of metrics in this registry.
+ *
+ * \return The number of metrics, each set of labels counting as one.
+ */
+std::size_t metrics_registry::size() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    std::size_t result(0);
+    for(auto const & family : f_metrics)
+    {
+        result += family.second.size();
+    }
+    return result;
+}
+
+
+/** \brief Render all the metrics in the text exposition format.
+ *
+ * The \p out buffer is cleared first. Pass the same buffer on each
+ * scrape so its memory gets reused.
+ *
+ * \param[in,out] out  The buffer receiving the metrics.
+ */
+void metrics_registry::render(std::string & out) const
+{
+    out.clear();
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+    for(auto const & family : f_metrics)
+    {
+        metric const & first(*family.second.begin()->second);
+        if(!first.get_help().empty())
+        {
+            out += "# HELP ";
+            out += family.first;
+            out += ' ';
+            for(auto const c : first.get_help())
+            {
+                switch(c)
+                {
+                case '\\':
+                    out += "\\\\";
+                    break;
+
+                case '\n':
+                    out += "\\n";
+                    break;
+
+                default:
+                    out += c;
+                    break;
+
+                }
+            }
+            out += '\n';
+        }
+        out += "# TYPE ";
+        out += family.first;
+        out += ' ';
+        out += type_name(first.get_type());
+        out += '\n';
+
+        for(auto const & m : family.second)
+        {
+            m.second->render(out);
+        }
+    }
+}
+
+
+template<typename T, typename ...ARGS>
+T & metrics_registry::get_metric(
+      metric::type_t type
+    , std::string_view name
+    , std::string_view help
+    , std::string_view labels
+    , ARGS const & ...args)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    auto family(f_metrics.find(std::string(name)));
+    if(family != f_metrics.end())
+    {
+        if(family->second.begin()->second->get_type() != type)
+        {
+            throw invalid_parameter(
+                      "metric \""
+                    + std::string(name)
+                    + "\" already exists with a different type.");
+        }
+        auto it(family->second.find(std::string(labels)));
+        if(it != family->second.end())
+        {
+            return static_cast<T &>(*it->second);
+        }
+    }
+
+    std::shared_ptr<T> m(std::make_shared<T>(name, help, labels, args...));
+    f_metrics[std::string(name)][std::string(labels)] = m;
+    return *m;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,252 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// C++
+//
+#include    <array>
+#include    <atomic>
+#include    <chrono>
+#include    <cstdint>
+#include    <map>
+#include    <memory>
+#include    <mutex>
+#include    <string>
+#include    <string_view>
+#include    <vector>
+
+
+
+namespace edhttp
+{
+
+
+
+// updates are spread between that many slots to avoid contention
+//
+constexpr std::size_t const     METRIC_SHARDS = 8;
+
+
+class metric
+{
+public:
+    typedef std::shared_ptr<metric>     pointer_t;
+
+    enum class type_t
+    {
+        METRIC_TYPE_COUNTER,
+        METRIC_TYPE_GAUGE,
+        METRIC_TYPE_HISTOGRAM
+    };
+
+                        metric(
+                              type_t type
+                            , std::string_view name
+                            , std::string_view help
+                            , std::string_view labels);
+                        metric(metric const &) = delete;
+    virtual             ~metric();
+    metric &            operator = (metric const &) = delete;
+
+    type_t              get_type() const;
+    std::string const & get_name() const;
+    std::string const & get_help() const;
+    std::string const & get_labels() const;
+
+    virtual void        render(std::string & out) const = 0;
+
+    static bool         is_valid_name(std::string_view name);
+    static std::string  label(std::string_view name, std::string_view value);
+
+protected:
+    void                render_name(
+                              std::string & out
+                            , std::string_view suffix
+                            , std::string_view extra_label = std::string_view()) const;
+
+private:
+    type_t              f_type = type_t::METRIC_TYPE_COUNTER;
+    std::string         f_name = std::string();
+    std::string         f_help = std::string();
+    std::string         f_labels = std::string();
+};
+
+
+class metric_counter
+    : public metric
+{
+public:
+                        metric_counter(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view());
+
+    void                increment(std::uint64_t value = 1);
+    std::uint64_t       get_value() const;
+
+    virtual void        render(std::string & out) const override;
+
+private:
+    struct alignas(64) shard_t
+    {
+        std::atomic<std::uint64_t>  f_value = 0;
+    };
+
+    std::array<shard_t, METRIC_SHARDS>
+                        f_shards = std::array<shard_t, METRIC_SHARDS>();
+};
+
+
+class metric_gauge
+    : public metric
+{
+public:
+                        metric_gauge(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view());
+
+    void                set(std::int64_t value);
+    void                add(std::int64_t value);
+    std::int64_t        get_value() const;
+
+    virtual void        render(std::string & out) const override;
+
+private:
+    std::atomic<std::int64_t>
+                        f_value = 0;
+};
+
+
+class metric_histogram
+    : public metric
+{
+public:
+    typedef std::vector<std::uint64_t>  bounds_t;
+
+    // values 0 to 7 are exact, larger values are saved in 8 sub-buckets
+    // per power of 2 (a maximum error of 12.5%)
+    //
+    static constexpr int            SUB_BUCKET_BITS = 3;
+    static constexpr std::size_t    BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    class timer
+    {
+    public:
+                            timer(metric_histogram & histogram);
+                            timer(timer const &) = delete;
+                            ~timer();
+        timer &             operator = (timer const &) = delete;
+
+    private:
+        metric_histogram &  f_histogram;
+        std::chrono::steady_clock::time_point
+                            f_start = std::chrono::steady_clock::now();
+    };
+
+                        metric_histogram(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view()
+                            , bounds_t const & bounds = latency_bounds()
+                            , double divisor = 1.0e9);
+
+    void                record(std::uint64_t value);
+    std::uint64_t       get_count() const;
+    std::uint64_t       get_sum() const;
+    std::uint64_t       get_percentile(double percent) const;
+    bounds_t const &    get_bounds() const;
+    double              get_divisor() const;
+
+    virtual void        render(std::string & out) const override;
+
+    static std::size_t  get_bucket(std::uint64_t value);
+    static std::uint64_t
+                        get_bucket_lowest(std::size_t bucket);
+    static std::uint64_t
+                        get_bucket_highest(std::size_t bucket);
+    static bounds_t     latency_bounds();
+
+private:
+    struct alignas(64) shard_t
+    {
+        std::atomic<std::uint64_t>  f_sum = 0;
+        std::array<std::atomic<std::uint64_t>, BUCKET_COUNT>
+                                    f_buckets = {};
+    };
+
+    std::array<std::uint64_t, BUCKET_COUNT>
+                        merge() const;
+
+    bounds_t            f_bounds = bounds_t();
+    double              f_divisor = 1.0e9;
+    std::unique_ptr<shard_t[]>
+                        f_shards = std::unique_ptr<shard_t[]>();
+};
+
+
+class metrics_registry
+{
+public:
+                        metrics_registry();
+                        metrics_registry(metrics_registry const &) = delete;
+    metrics_registry &  operator = (metrics_registry const &) = delete;
+
+    static metrics_registry &
+                        instance();
+
+    metric_counter &    get_counter(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view());
+    metric_gauge &      get_gauge(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view());
+    metric_histogram &  get_histogram(
+                              std::string_view name
+                            , std::string_view help
+                            , std::string_view labels = std::string_view()
+                            , metric_histogram::bounds_t const & bounds = metric_histogram::latency_bounds()
+                            , double divisor = 1.0e9);
+
+    std::size_t         size() const;
+    void                render(std::string & out) const;
+
+private:
+    template<typename T, typename ...ARGS>
+    T &                 get_metric(
+                              metric::type_t type
+                            , std::string_view name
+                            , std::string_view help
+                            , std::string_view labels
+                            , ARGS const & ...args);
+
+    // metrics are sorted by name, then labels
+    //
+    typedef std::map<std::string, std::map<std::string, metric::pointer_t>>
+                                            metric_map_t;
+
+    mutable std::mutex  f_mutex = std::mutex();
+    metric_map_t        f_metrics = metric_map_t();
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -23,10 +23,26 @@
 #include    "edhttp/exception.h"
 
 
+// C++
+//
+#include    <algorithm>
+#include    <array>
+#include    <cstring>
+#include    <fstream>
+#include    <memory>
+#include    <type_traits>
+#include    <unordered_set>
+
+
 // C lib
 //
 #include    <magic.h>
 
+#if defined(__SSE2__)
+#define EDHTTP_SSE2_SIMD
+#include    <emmintrin.h>
+#endif
+
 
 // last include
 //
@@ -39,10 +55,421 @@ namespace edhttp
 
 namespace
 {
-magic_t         g_magic = nullptr;
+
+
+
+struct magic_deleter
+{
+    void operator () (magic_t magic) const
+    {
+        magic_close(magic);
+    }
+};
+
+
+typedef std::unique_ptr<std::remove_pointer_t<magic_t>, magic_deleter>  magic_ptr_t;
+
+
+/** \brief Get the magic handle of the calling thread.
+ *
+ * A libmagic handle cannot be used by more than one thread at a time.
+ * Instead of a global handle protected by a mutex, each thread gets its
+ * own handle, opened on the first call and closed when the thread exits.
+ * The database file is memory mapped by libmagic so the cost of each
+ * additional handle is small.
+ *
+ * \exception mime_type_no_magic
+ * The function raises this exception if the handle cannot be opened or
+ * the default database cannot be loaded.
+ *
+ * \return The magic handle of the calling thread.
+ */
+magic_t get_magic()
+{
+    thread_local magic_ptr_t magic;
+    if(magic == nullptr)
+    {
+        magic_ptr_t m(magic_open(MAGIC_COMPRESS | MAGIC_MIME));
+        if(m == nullptr)
+        {
+            throw mime_type_no_magic("Magic MIME type cannot be opened (magic_open() failed)");
+        }
+
+        // load the default magic database
+        //
+        if(magic_load(m.get(), nullptr) != 0)
+        {
+            throw mime_type_no_magic(
+                      std::string("Magic MIME database cannot be loaded (magic_load() failed: ")
+                    + magic_error(m.get())
+                    + ")");
+        }
+        magic = std::move(m);
+    }
+    return magic.get();
+}
+
+
+
+/** \brief One signature of the WHATWG sniffing tables.
+ *
+ * The pattern and mask are padded with zeroes to 48 bytes so the
+ * comparison can always work on 16 byte blocks. The pattern bytes are
+ * already masked.
+ */
+struct signature_t
+{
+    static constexpr std::size_t    MAX_LENGTH = 48;
+
+    static constexpr std::uint8_t   FLAG_SKIP_WHITESPACE = 0x01;  // ignore leading whitespace
+    static constexpr std::uint8_t   FLAG_TAG_TERMINATED  = 0x02;  // followed by ' ' or '>'
+    static constexpr std::uint8_t   FLAG_AMBIGUOUS       = 0x04;  // text or container, libmagic is more specific
+
+    std::uint8_t        f_pattern[MAX_LENGTH] = {};
+    std::uint8_t        f_mask[MAX_LENGTH] = {};
+    std::size_t         f_length = 0;
+    std::uint8_t        f_flags = 0;
+    char const *        f_mime_type = nullptr;
+    char const *        f_magic_type = nullptr;     // libmagic name when it differs
+};
+
+
+/** \brief Create a signature from a pattern and its mask.
+ *
+ * \param[in] mime_type  The MIME type of the resources matching.
+ * \param[in] pattern  The bytes to match.
+ * \param[in] mask  The mask of each byte, must be the same size.
+ * \param[in] flags  The FLAG_... flags.
+ *
+ * \return The signature.
+ */
+template<std::size_t N>
+constexpr signature_t sig(
+      char const * mime_type
+    , char const (&pattern)[N]
+    , char const (&mask)[N]
+    , std::uint8_t flags = 0)
+{
+    static_assert(N - 1 <= signature_t::MAX_LENGTH);
+
+    signature_t result;
+    for(std::size_t idx(0); idx < N - 1; ++idx)
+    {
+        result.f_mask[idx] = static_cast<std::uint8_t>(mask[idx]);
+        result.f_pattern[idx] = static_cast<std::uint8_t>(pattern[idx]) & result.f_mask[idx];
+    }
+    result.f_length = N - 1;
+    result.f_flags = flags;
+    result.f_mime_type = mime_type;
+    return result;
+}
+
+
+template<std::size_t N>
+constexpr signature_t sig(char const * mime_type, char const (&pattern)[N], std::uint8_t flags = 0)
+{
+    char mask[N] = {};
+    for(std::size_t idx(0); idx < N - 1; ++idx)
+    {
+        mask[idx] = '\xFF';
+    }
+    return sig(mime_type, pattern, mask, flags);
+}
+
+
+/** \brief Attach the name libmagic uses to a signature.
+ *
+ * The WHATWG names of a few formats differ from the names returned by
+ * libmagic (i.e. "audio/wave" versus "audio/x-wav"). get_mime_type()
+ * used to only return libmagic names so it returns \p magic_type
+ * instead of the WHATWG name for those formats.
+ *
+ * \param[in] magic_type  The MIME type libmagic returns for this format.
+ * \param[in] s  The signature.
+ *
+ * \return The signature with its libmagic name.
+ */
+constexpr signature_t magic_name(char const * magic_type, signature_t s)
+{
+    s.f_magic_type = magic_type;
+    return s;
+}
+
+
+constexpr std::uint8_t const    WS_TAG = signature_t::FLAG_SKIP_WHITESPACE
+                                       | signature_t::FLAG_TAG_TERMINATED
+                                       | signature_t::FLAG_AMBIGUOUS;
+
+
+// the tables of the "Identifying a resource with an unknown MIME type"
+// algorithm (https://mimesniff.spec.whatwg.org/), in order
+//
+constexpr signature_t const g_signatures[] =
+{
+    // scriptable types
+    //
+    sig("text/html", "<!DOCTYPE HTML", "\xFF\xFF\xDF\xDF\xDF\xDF\xDF\xDF\xDF\xFF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<HTML", "\xFF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<HEAD", "\xFF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<SCRIPT", "\xFF\xDF\xDF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<IFRAME", "\xFF\xDF\xDF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<H1", "\xFF\xDF\xFF", WS_TAG),
+    sig("text/html", "<DIV", "\xFF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<FONT", "\xFF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<TABLE", "\xFF\xDF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<A", "\xFF\xDF", WS_TAG),
+    sig("text/html", "<STYLE", "\xFF\xDF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<TITLE", "\xFF\xDF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<B", "\xFF\xDF", WS_TAG),
+    sig("text/html", "<BODY", "\xFF\xDF\xDF\xDF\xDF", WS_TAG),
+    sig("text/html", "<BR", "\xFF\xDF\xDF", WS_TAG),
+    sig("text/html", "<P", "\xFF\xDF", WS_TAG),
+    sig("text/html", "<!--", WS_TAG),
+    sig("text/xml", "<?xml", signature_t::FLAG_SKIP_WHITESPACE | signature_t::FLAG_AMBIGUOUS),
+    sig("application/pdf", "%PDF-"),
+
+    // not scriptable
+    //
+    sig("application/postscript", "%!PS-Adobe-", signature_t::FLAG_AMBIGUOUS),
+    sig("text/plain", "\xFE\xFF", signature_t::FLAG_AMBIGUOUS),
+    sig("text/plain", "\xFF\xFE", signature_t::FLAG_AMBIGUOUS),
+    sig("text/plain", "\xEF\xBB\xBF", signature_t::FLAG_AMBIGUOUS),
+
+    // images
+    //
+    magic_name("image/vnd.microsoft.icon", sig("image/x-icon", "\x00\x00\x01\x00")),
+    magic_name("image/x-win-bitmap", sig("image/x-icon", "\x00\x00\x02\x00")),
+    sig("image/bmp", "BM"),
+    sig("image/gif", "GIF87a"),
+    sig("image/gif", "GIF89a"),
+    sig("image/webp", "RIFF\x00\x00\x00\x00WEBPVP", "\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"),
+    sig("image/png", "\x89PNG\r\n\x1A\n"),
+    sig("image/jpeg", "\xFF\xD8\xFF"),
+
+    // audio and video
+    //
+    sig("audio/basic", ".snd"),
+    magic_name("audio/x-aiff", sig("audio/aiff", "FORM\x00\x00\x00\x00" "AIFF", "\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF")),
+    sig("audio/mpeg", "ID3"),
+    sig("application/ogg", "OggS\x00", signature_t::FLAG_AMBIGUOUS),      // libmagic says audio/ogg, video/ogg...
+    sig("audio/midi", "MThd\x00\x00\x00\x06"),
+    magic_name("video/x-msvideo", sig("video/avi", "RIFF\x00\x00\x00\x00" "AVI ", "\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF")),
+    magic_name("audio/x-wav", sig("audio/wave", "RIFF\x00\x00\x00\x00WAVE", "\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF")),
+
+    // fonts
+    //
+    sig("application/vnd.ms-fontobject",
+          "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00LP"
+        , "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00\xFF\xFF"),
+    magic_name("font/sfnt", sig("font/ttf", "\x00\x01\x00\x00")),
+    magic_name("application/vnd.ms-opentype", sig("font/otf", "OTTO")),
+    magic_name("font/ttf", sig("font/collection", "ttcf")),
+    sig("font/woff", "wOFF"),
+    sig("font/woff2", "wOF2"),
+
+    // archives
+    //
+    sig("application/x-gzip", "\x1F\x8B\x08", signature_t::FLAG_AMBIGUOUS),   // libmagic decompresses (MAGIC_COMPRESS)
+    sig("application/zip", "PK\x03\x04", signature_t::FLAG_AMBIGUOUS),   // also OOXML, ODF, EPUB, JAR...
+    magic_name("application/x-rar", sig("application/x-rar-compressed", "Rar!\x1A\x07\x00")),
+};
+
+
+constexpr bool is_whitespace_byte(std::uint8_t c)
+{
+    return c == 0x09 || c == 0x0A || c == 0x0C || c == 0x0D || c == 0x20;
+}
+
+
+/** \brief Compare the header at \p s against a signature.
+ *
+ * The header buffer is padded with enough zeroes so reading 48 bytes
+ * at \p s is always valid.
+ *
+ * \param[in] s  The bytes to compare.
+ * \param[in] signature  The pattern and mask to compare against.
+ *
+ * \return true if the masked bytes are equal to the pattern.
+ */
+bool masked_equal(std::uint8_t const * s, signature_t const & signature)
+{
+#ifdef EDHTTP_SSE2_SIMD
+    for(std::size_t idx(0); idx < signature.f_length; idx += 16)
+    {
+        __m128i const data(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + idx)));
+        __m128i const mask(_mm_loadu_si128(reinterpret_cast<__m128i const *>(signature.f_mask + idx)));
+        __m128i const pattern(_mm_loadu_si128(reinterpret_cast<__m128i const *>(signature.f_pattern + idx)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(data, mask), pattern)) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+#else
+    for(std::size_t idx(0); idx < signature.f_length; ++idx)
+    {
+        if((s[idx] & signature.f_mask[idx]) != signature.f_pattern[idx])
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+
+std::uint32_t read_uint32(std::uint8_t const * s)
+{
+    return (static_cast<std::uint32_t>(s[0]) << 24)
+         | (static_cast<std::uint32_t>(s[1]) << 16)
+         | (static_cast<std::uint32_t>(s[2]) <<  8)
+         | (static_cast<std::uint32_t>(s[3]) <<  0);
+}
+
+
+/** \brief Check for an MP4 file.
+ *
+ * This is the "matches the signature for MP4" algorithm which verifies
+ * the brands of the "ftyp" box.
+ *
+ * \param[in] s  The resource header.
+ * \param[in] length  The length of the header.
+ *
+ * \return true if the header is an MP4 header.
+ */
+bool is_mp4(std::uint8_t const * s, std::size_t length)
+{
+    if(length < 12)
+    {
+        return false;
+    }
+    std::uint32_t const box_size(read_uint32(s));
+    if(length < box_size
+    || box_size % 4 != 0
+    || memcmp(s + 4, "ftyp", 4) != 0)
+    {
+        return false;
+    }
+    if(memcmp(s + 8, "mp4", 3) == 0)
+    {
+        return true;
+    }
+    for(std::size_t pos(16); pos + 3 <= box_size; pos += 4)
+    {
+        if(memcmp(s + pos, "mp4", 3) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** \brief Mix a hash with a seed.
+ *
+ * This is the finalizer of splitmix64, used to derive the hashes of the
+ * perfect hash table from the one FNV-1a hash of the extension.
+ *
+ * \param[in] hash  The hash of the key.
+ * \param[in] seed  The seed (bucket displacement).
+ *
+ * \return The mixed hash.
+ */
+std::uint64_t mix(std::uint64_t hash, std::uint64_t seed)
+{
+    std::uint64_t z(hash + seed * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+std::uint64_t hash_extension(std::string_view extension)
+{
+    std::uint64_t h(0xCBF29CE484222325ULL);
+    for(auto const c : extension)
+    {
+        h ^= static_cast<std::uint8_t>(c);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+
+/** \brief Search the signature matching \p data.
+ *
+ * See sniff_mime_type() for details.
+ *
+ * \param[in] data  The data to sniff.
+ * \param[out] ambiguous  Set to true if the signature found is a text
+ * or container format for which libmagic may return a more specific
+ * MIME type.
+ * \param[in] libmagic_names  Return the libmagic name of the formats
+ * which have one instead of their WHATWG name.
+ *
+ * \return The MIME type or an empty string if not recognized.
+ */
+std::string_view sniff(std::span<char const> data, bool & ambiguous, bool libmagic_names)
+{
+    ambiguous = false;
+
+    // copy the resource header in a padded buffer so the comparisons
+    // never need to check the length of the data
+    //
+    std::size_t const length(std::min(data.size(), MIME_TYPE_SNIFF_SIZE));
+    std::uint8_t header[MIME_TYPE_SNIFF_SIZE + signature_t::MAX_LENGTH + 1];
+    memcpy(header, data.data(), length);
+    memset(header + length, 0, sizeof(header) - length);
+
+    std::size_t start(0);
+    while(start < length && is_whitespace_byte(header[start]))
+    {
+        ++start;
+    }
+
+    for(auto const & signature : g_signatures)
+    {
+        std::size_t const pos((signature.f_flags & signature_t::FLAG_SKIP_WHITESPACE) != 0 ? start : 0);
+        std::size_t const needed(pos + signature.f_length
+                    + ((signature.f_flags & signature_t::FLAG_TAG_TERMINATED) != 0 ? 1 : 0));
+        if(needed > length
+        || !masked_equal(header + pos, signature))
+        {
+            continue;
+        }
+        if((signature.f_flags & signature_t::FLAG_TAG_TERMINATED) != 0)
+        {
+            std::uint8_t const c(header[pos + signature.f_length]);
+            if(c != ' ' && c != '>')
+            {
+                continue;
+            }
+        }
+        ambiguous = (signature.f_flags & signature_t::FLAG_AMBIGUOUS) != 0;
+        if(libmagic_names
+        && signature.f_magic_type != nullptr)
+        {
+            return signature.f_magic_type;
+        }
+        return signature.f_mime_type;
+    }
+
+    if(is_mp4(header, length))
+    {
+        return "video/mp4";
+    }
+
+    return std::string_view();
 }
 
 
+} // no name namespace
+
+
 /** \brief Generate a MIME type from a buffer.
  *
  * This function determines the MIME type of a buffer (std::string)
@@ -51,13 +478,19 @@ magic_t         g_magic = nullptr;
  * website (within reason, of course).
  *
  * This function runs against the specified buffer (\p data) from
- * memory.
+ * memory. The whole buffer is passed to the magic library. Use the
+ * std::span overload to limit the number of bytes inspected.
  *
  * The function returns the computed MIME type such as text/html or
  * image/png.
  *
  * \note
- * Compressed files get their type determined after decompression.
+ * The binary formats recognized by sniff_mime_type() (images, audio,
+ * video, fonts, PDF...) are returned with the "; charset=binary"
+ * parameter like libmagic does. They are returned under the name
+ * libmagic gives them (i.e. "audio/x-wav" and not the WHATWG
+ * "audio/wave"). Text, container and compressed formats (HTML, XML,
+ * zip, Ogg, gzip...) are always determined by libmagic.
  *
  * \exception mime_type_no_magic
  * The function generates an exception if it cannot access the
@@ -71,20 +504,373 @@ magic_t         g_magic = nullptr;
  */
 std::string get_mime_type(std::string const & data)
 {
-    if(g_magic == nullptr)
+    return get_mime_type(std::span<char const>(data.data(), data.length()), data.length());
+}
+
+
+/** \brief Generate a MIME type from the beginning of a buffer.
+ *
+ * This function determines the MIME type of \p data without copying it.
+ * The common binary formats are first recognized with sniff_mime_type(),
+ * which is much faster than libmagic. The magic library is used when the
+ * sniffer does not recognize the data or finds a text or container
+ * format, such as XML or zip, which libmagic can identify more
+ * precisely (i.e. SVG or OOXML). Only the first \p max_bytes are
+ * inspected. The magic of nearly all
+ * formats is found in the first few kilobytes so the default of 64Kb is
+ * enough and it avoids scanning a large upload in full (the text
+ * detection of libmagic otherwise reads the whole buffer).
+ *
+ * The function is thread safe: each thread uses its own magic handle.
+ * A server can call prewarm_mime_type() when starting its worker threads
+ * so the first request of each thread does not have to load the
+ * database.
+ *
+ * \exception mime_type_no_magic
+ * The function generates an exception if it cannot access the
+ * magic library.
+ *
+ * \param[in] data  The buffer to be transformed in a MIME type.
+ * \param[in] max_bytes  The maximum number of bytes to inspect.
+ *
+ * \return The MIME type of the input buffer.
+ */
+std::string get_mime_type(std::span<char const> data, std::size_t max_bytes)
+{
+    // the text and container formats are left to libmagic which knows
+    // about SVG, OOXML, ODF, etc. and adds the charset of text files
+    //
+    bool ambiguous(false);
+    std::string_view const sniffed(sniff(data.first(std::min(data.size(), max_bytes)), ambiguous, true));
+    if(!sniffed.empty()
+    && !ambiguous)
+    {
+        std::string result(sniffed);
+        result += "; charset=binary";
+        return result;
+    }
+
+    char const * type(magic_buffer(get_magic(), data.data(), std::min(data.size(), max_bytes)));
+    if(type == nullptr)
+    {
+        return "application/octet-stream";
+    }
+    return type;
+}
+
+
+/** \brief Load the magic database in the calling thread.
+ *
+ * Opening a magic handle and loading its database takes much longer
+ * than detecting a MIME type. Call this function once in each thread
+ * which is expected to call get_mime_type() so the cost is paid at
+ * startup instead of on the first request.
+ *
+ * \exception mime_type_no_magic
+ * The function generates an exception if it cannot access the
+ * magic library.
+ */
+void prewarm_mime_type()
+{
+    get_magic();
+}
+
+
+
+/** \brief Recognize the common formats by their signature.
+ *
+ * This function implements the "identifying a resource with an unknown
+ * MIME type" algorithm of the WHATWG MIME Sniffing standard
+ * (https://mimesniff.spec.whatwg.org/). It compares the first 512 bytes
+ * of \p data against the table of signatures of the HTML, XML, PDF,
+ * image, audio, video, font and archive formats. The masked comparisons
+ * are done 16 bytes at a time when SSE2 is available.
+ *
+ * Contrary to the standard, the function does not decide between
+ * "text/plain" and "application/octet-stream" when no signature
+ * matches. It returns an empty string instead so the caller can try
+ * a more thorough method, such as libmagic. The WebM and MP3 without ID3
+ * algorithms are not implemented either.
+ *
+ * The returned names are the WHATWG names. A few of them differ from
+ * the names returned by get_mime_type(), which sticks to the libmagic
+ * names (i.e. "video/avi" instead of "video/x-msvideo").
+ *
+ * \param[in] data  The data to sniff.
+ *
+ * \return The MIME type or an empty string if not recognized.
+ */
+std::string_view sniff_mime_type(std::span<char const> data)
+{
+    bool ambiguous(false);
+    return sniff(data, ambiguous, false);
+}
+
+
+/** \brief Load a mime.types file.
+ *
+ * The file is expected to use the format of /etc/mime.types: one MIME
+ * type per line followed by zero or more extensions. Empty lines and
+ * lines starting with '#' are ignored. When an extension appears more
+ * than once, the first MIME type wins.
+ *
+ * The function calls build() once the file was read.
+ *
+ * \param[in] filename  The name of the file to load.
+ *
+ * \return false if the file could not be opened.
+ */
+bool mime_extensions::load(std::string const & filename)
+{
+    std::ifstream in(filename);
+    if(!in)
+    {
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(in, line))
     {
-        g_magic = magic_open(MAGIC_COMPRESS | MAGIC_MIME);
-        if(g_magic == nullptr)
+        std::string_view l(line);
+        std::string_view::size_type const hash(l.find('#'));
+        if(hash != std::string_view::npos)
         {
-            throw mime_type_no_magic("Magic MIME type cannot be opened (magic_open() failed)");
+            l = l.substr(0, hash);
         }
 
-        // load the default magic database
+        std::string_view mime_type;
+        while(!l.empty())
+        {
+            std::string_view::size_type const begin(l.find_first_not_of(" \t\r"));
+            if(begin == std::string_view::npos)
+            {
+                break;
+            }
+            l.remove_prefix(begin);
+            std::string_view::size_type const end(std::min(l.find_first_of(" \t\r"), l.length()));
+            std::string_view const word(l.substr(0, end));
+            l.remove_prefix(end);
+            if(mime_type.empty())
+            {
+                mime_type = word;
+            }
+            else
+            {
+                add(word, mime_type);
+            }
+        }
+    }
+
+    build();
+    return true;
+}
+
+
+/** \brief Add an extension.
+ *
+ * The extension is saved in lowercase. If it already exists, build()
+ * keeps the first one. Call build() once all the extensions were
+ * added.
+ *
+ * \param[in] extension  The extension, without the period.
+ * \param[in] mime_type  The corresponding MIME type.
+ */
+void mime_extensions::add(std::string_view extension, std::string_view mime_type)
+{
+    std::string ext(extension);
+    for(auto & c : ext)
+    {
+        if(c >= 'A' && c <= 'Z')
+        {
+            c |= 0x20;
+        }
+    }
+    f_entries.push_back(entry_t{ext, std::string(mime_type)});
+}
+
+
+/** \brief Build the perfect hash table.
+ *
+ * The table uses the "hash and displace" method: the extensions are
+ * first distributed in buckets, then, starting with the largest
+ * bucket, a displacement is searched so all the extensions of the
+ * bucket land in free slots of the table. A lookup computes one hash
+ * of the extension, reads the displacement of its bucket and compares
+ * the one extension found in the resulting slot.
+ */
+void mime_extensions::build()
+{
+    // remove the duplicates, the first definition wins
+    //
+    {
+        // the views point into `unique` which never gets reallocated
         //
-        magic_load(g_magic, nullptr);
+        std::vector<entry_t> unique;
+        unique.reserve(f_entries.size());
+        std::unordered_set<std::string_view> seen;
+        seen.reserve(f_entries.size());
+        for(auto & e : f_entries)
+        {
+            if(!seen.contains(e.f_extension))
+            {
+                unique.push_back(std::move(e));
+                seen.insert(unique.back().f_extension);
+            }
+        }
+        f_entries.swap(unique);
+    }
+
+    std::size_t const count(f_entries.size());
+    f_displacements.assign(std::max<std::size_t>(1, count / 4 + 1), 0);
+    std::size_t slot_count(16);
+    while(slot_count < count * 2)
+    {
+        slot_count *= 2;
+    }
+    f_slots.assign(slot_count, -1);
+    if(count == 0)
+    {
+        return;
+    }
+
+    std::vector<std::uint64_t> hashes(count);
+    std::vector<std::vector<std::uint32_t>> buckets(f_displacements.size());
+    for(std::size_t idx(0); idx < count; ++idx)
+    {
+        hashes[idx] = hash_extension(f_entries[idx].f_extension);
+        buckets[mix(hashes[idx], 0) % buckets.size()].push_back(static_cast<std::uint32_t>(idx));
+    }
+
+    std::vector<std::uint32_t> order(buckets.size());
+    for(std::size_t idx(0); idx < order.size(); ++idx)
+    {
+        order[idx] = static_cast<std::uint32_t>(idx);
+    }
+    std::stable_sort(
+          order.begin()
+        , order.end()
+        , [&buckets](std::uint32_t a, std::uint32_t b)
+          {
+              return buckets[a].size() > buckets[b].size();
+          });
+
+    std::vector<std::size_t> slots;
+    for(auto const b : order)
+    {
+        if(buckets[b].empty())
+        {
+            break;
+        }
+        for(std::uint32_t d(1);; ++d)
+        {
+            slots.clear();
+            bool found(true);
+            for(auto const idx : buckets[b])
+            {
+                std::size_t const slot(mix(hashes[idx], d) & (slot_count - 1));
+                if(f_slots[slot] != -1
+                || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                {
+                    found = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if(found)
+            {
+                for(std::size_t idx(0); idx < slots.size(); ++idx)
+                {
+                    f_slots[slots[idx]] = static_cast<std::int32_t>(buckets[b][idx]);
+                }
+                f_displacements[b] = d;
+                break;
+            }
+        }
+    }
+}
+
+
+/** \brief Search the MIME type of a file from its extension.
+ *
+ * The \p filename can be a full filename or path, in which case the
+ * part after the last period is used, or just the extension. The
+ * search is case insensitive.
+ *
+ * \param[in] filename  The filename or extension.
+ *
+ * \return The MIME type or an empty string if the extension is unknown.
+ */
+std::string_view mime_extensions::find(std::string_view filename) const
+{
+    if(f_slots.empty())
+    {
+        return std::string_view();
+    }
+
+    std::string_view::size_type const pos(filename.find_last_of("./"));
+    if(pos != std::string_view::npos)
+    {
+        if(filename[pos] == '/')
+        {
+            return std::string_view();
+        }
+        filename.remove_prefix(pos + 1);
+    }
+
+    char ext[32];
+    if(filename.empty()
+    || filename.length() > sizeof(ext))
+    {
+        return std::string_view();
+    }
+    for(std::size_t idx(0); idx < filename.length(); ++idx)
+    {
+        char const c(filename[idx]);
+        ext[idx] = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
     }
+    std::string_view const extension(ext, filename.length());
+
+    std::uint64_t const h(hash_extension(extension));
+    std::uint32_t const d(f_displacements[mix(h, 0) % f_displacements.size()]);
+    std::int32_t const idx(f_slots[mix(h, d) & (f_slots.size() - 1)]);
+    if(idx < 0
+    || f_entries[idx].f_extension != extension)
+    {
+        return std::string_view();
+    }
+    return f_entries[idx].f_mime_type;
+}
+
+
+/** \brief Get the number of extensions.
+ *
+ * \return The number of extensions in the table.
+ */
+std::size_t mime_extensions::size() const
+{
+    return f_entries.size();
+}
+
 
-    return magic_buffer(g_magic, data.data(), data.length());
+/** \brief Get the MIME type of a file from its extension.
+ *
+ * This function searches the extension of \p filename in the
+ * /etc/mime.types file. The file is loaded once, the first time the
+ * function gets called, and kept in a perfect hash table.
+ *
+ * \param[in] filename  The filename or extension.
+ *
+ * \return The MIME type or an empty string if the extension is unknown.
+ */
+std::string_view get_mime_type_from_extension(std::string_view filename)
+{
+    static mime_extensions const extensions = []()
+        {
+            mime_extensions e;
+            e.load();
+            return e;
+        }();
+    return extensions.find(filename);
 }
 
 
@@ -19,7 +19,11 @@
 
 // C++
 //
+#include    <cstdint>
+#include    <span>
 #include    <string>
+#include    <string_view>
+#include    <vector>
 
 
 
@@ -28,9 +32,45 @@ namespace edhttp
 
 
 
+constexpr std::size_t const     MIME_TYPE_INSPECT_SIZE = 64 * 1024;
+constexpr std::size_t const     MIME_TYPE_SNIFF_SIZE = 512;
+
+
+class mime_extensions
+{
+public:
+    static constexpr char const *   DEFAULT_MIME_TYPES = "/etc/mime.types";
+
+    bool                load(std::string const & filename = DEFAULT_MIME_TYPES);
+    void                add(std::string_view extension, std::string_view mime_type);
+    void                build();
+
+    std::string_view    find(std::string_view filename) const;
+    std::size_t         size() const;
+
+private:
+    struct entry_t
+    {
+        std::string         f_extension = std::string();
+        std::string         f_mime_type = std::string();
+    };
+
+    std::vector<entry_t>
+                        f_entries = std::vector<entry_t>();
+    std::vector<std::uint32_t>
+                        f_displacements = std::vector<std::uint32_t>();
+    std::vector<std::int32_t>
+                        f_slots = std::vector<std::int32_t>();
+};
+
+
 // the actual function that generates a MIME type from a buffer
 //
-std::string get_mime_type(std::string const & data);
+std::string         get_mime_type(std::string const & data);
+std::string         get_mime_type(std::span<char const> data, std::size_t max_bytes = MIME_TYPE_INSPECT_SIZE);
+void                prewarm_mime_type();
+std::string_view    sniff_mime_type(std::span<char const> data);
+std::string_view    get_mime_type_from_extension(std::string_view filename);
 
 }
 // vim: ts=4 sw=4 et
@@ -0,0 +1,542 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Cache of the MIME types detected by get_mime_type().
+ *
+ * A server sends the same files and receives the same buffers over and
+ * over again. The mime_type_cache class remembers the MIME type of each
+ * file, identified by its device, inode, modification time and size,
+ * and of each buffer, identified by a hash of the bytes that the
+ * detection inspects. The entries are evicted in LRU order.
+ */
+
+// self
+//
+#include    "edhttp/mime_type_cache.h"
+
+#include    "edhttp/exception.h"
+
+
+// C++
+//
+#include    <cstring>
+#include    <random>
+
+
+// C
+//
+#include    <errno.h>
+#include    <fcntl.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+constexpr std::uint64_t const   HASH_PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t const   HASH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t const   HASH_PRIME3 = 0x165667B19E3779F9ULL;
+
+
+std::uint64_t rotl(std::uint64_t v, int bits)
+{
+    return (v << bits) | (v >> (64 - bits));
+}
+
+
+std::uint64_t read64(char const * s)
+{
+    std::uint64_t v;
+    memcpy(&v, s, sizeof(v));
+    return v;
+}
+
+
+std::uint64_t round64(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * HASH_PRIME2;
+    acc = rotl(acc, 31);
+    return acc * HASH_PRIME1;
+}
+
+
+std::uint64_t avalanche(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+
+/** \brief Close a file descriptor on exit.
+ */
+class fd_guard
+{
+public:
+    fd_guard(int fd)
+        : f_fd(fd)
+    {
+    }
+
+    fd_guard(fd_guard const &) = delete;
+
+    ~fd_guard()
+    {
+        if(f_fd != -1)
+        {
+            close(f_fd);
+        }
+    }
+
+    fd_guard & operator = (fd_guard const &) = delete;
+
+    int get() const
+    {
+        return f_fd;
+    }
+
+private:
+    int         f_fd = -1;
+};
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a MIME type cache.
+ *
+ * The cache keeps at most \p max_entries results. When full, the least
+ * recently used entry is evicted.
+ *
+ * The hash of the buffers uses a random seed so a client cannot craft
+ * a buffer which collides with the hash of another buffer to poison
+ * the cache.
+ *
+ * \exception invalid_parameter
+ * The \p max_entries parameter must be at least 1.
+ *
+ * \param[in] max_entries  The maximum number of entries in the cache.
+ */
+mime_type_cache::mime_type_cache(std::size_t max_entries)
+    : f_max_entries(max_entries)
+{
+    if(max_entries == 0)
+    {
+        throw invalid_parameter("the maximum number of entries in a mime_type_cache must be at least 1.");
+    }
+
+    std::random_device rd;
+    f_seed = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+}
+
+
+/** \brief Get the MIME type of a buffer.
+ *
+ * This function hashes the first \p max_bytes of \p data, which are the
+ * bytes that edhttp::get_mime_type() inspects, and searches the result
+ * in the cache. On a miss, the detection runs and the result is saved.
+ *
+ * The key is the hash and length of the inspected bytes so the same
+ * buffer checked with a different \p max_bytes gets its own entry,
+ * unless the buffer is shorter than both limits in which case the
+ * same bytes are inspected and the entry is shared.
+ *
+ * The lock is not held while the detection runs so other threads are
+ * not blocked by a slow libmagic call.
+ *
+ * \param[in] data  The buffer to check.
+ * \param[in] max_bytes  The maximum number of bytes to inspect.
+ *
+ * \return The MIME type of the buffer.
+ */
+std::string mime_type_cache::get_mime_type(std::span<char const> data, std::size_t max_bytes)
+{
+    std::span<char const> const prefix(data.first(std::min(data.size(), max_bytes)));
+
+    key_t key;
+    key.f_kind = kind_t::KIND_BUFFER;
+    key.f_a = hash_prefix(prefix, f_seed);
+    key.f_b = prefix.size();
+
+    std::string mime_type;
+    if(find(key, mime_type))
+    {
+        return mime_type;
+    }
+
+    mime_type = edhttp::get_mime_type(prefix, max_bytes);
+    insert(key, mime_type);
+    return mime_type;
+}
+
+
+/** \brief Get the MIME type of a file.
+ *
+ * This function identifies the file by its device, inode, modification
+ * time (in nanoseconds), size and the number of bytes to inspect. If
+ * the file was not modified since the last call with the same
+ * \p max_bytes, the cached MIME type is returned without reading the
+ * file. Otherwise the first \p max_bytes of the file are read and
+ * inspected.
+ *
+ * \exception mime_type_io_error
+ * The file cannot be opened or read.
+ *
+ * \param[in] filename  The name of the file to check.
+ * \param[in] max_bytes  The maximum number of bytes to inspect.
+ *
+ * \return The MIME type of the file.
+ */
+std::string mime_type_cache::get_file_mime_type(std::string const & filename, std::size_t max_bytes)
+{
+    fd_guard fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if(fd.get() == -1)
+    {
+        int const e(errno);
+        throw mime_type_io_error(
+                  "could not open \""
+                + filename
+                + "\" to determine its MIME type: "
+                + strerror(e)
+                + ".");
+    }
+
+    struct stat s = {};
+    if(fstat(fd.get(), &s) != 0)
+    {
+        int const e(errno);
+        throw mime_type_io_error(
+                  "could not stat \""
+                + filename
+                + "\": "
+                + strerror(e)
+                + ".");
+    }
+
+    key_t key;
+    key.f_kind = kind_t::KIND_FILE;
+    key.f_a = s.st_dev;
+    key.f_b = std::min(static_cast<std::size_t>(s.st_size), max_bytes);
+    key.f_c = s.st_ino;
+    key.f_d = static_cast<std::uint64_t>(s.st_mtim.tv_sec) * 1'000'000'000ULL + s.st_mtim.tv_nsec;
+    key.f_e = s.st_size;
+
+    std::string mime_type;
+    if(find(key, mime_type))
+    {
+        return mime_type;
+    }
+
+    std::string buffer(std::min(static_cast<std::size_t>(s.st_size), max_bytes), '\0');
+    std::size_t size(0);
+    while(size < buffer.length())
+    {
+        ssize_t const r(pread(fd.get(), buffer.data() + size, buffer.length() - size, size));
+        if(r < 0)
+        {
+            int const e(errno);
+            if(e == EINTR)
+            {
+                continue;
+            }
+            throw mime_type_io_error(
+                      "could not read \""
+                    + filename
+                    + "\": "
+                    + strerror(e)
+                    + ".");
+        }
+        if(r == 0)
+        {
+            break;
+        }
+        size += r;
+    }
+    buffer.resize(size);
+
+    mime_type = edhttp::get_mime_type(std::span<char const>(buffer.data(), buffer.length()), max_bytes);
+    insert(key, mime_type);
+    return mime_type;
+}
+
+
+/** \brief Remove the entries of a file.
+ *
+ * A modified file gets a new modification time so its old entry is not
+ * used anymore. However, the entry remains in the cache until evicted.
+ * A server watching its files (i.e. with inotify) can call this function
+ * to remove the entries of a file immediately.
+ *
+ * \param[in] dev  The device of the file.
+ * \param[in] ino  The inode of the file.
+ *
+ * \return The number of entries removed.
+ */
+std::size_t mime_type_cache::invalidate_file(dev_t dev, ino_t ino)
+{
+    std::size_t count(0);
+    std::unique_lock<std::mutex> lock(f_mutex);
+    for(auto it(f_lru.begin()); it != f_lru.end();)
+    {
+        if(it->f_key.f_kind == kind_t::KIND_FILE
+        && it->f_key.f_a == dev
+        && it->f_key.f_c == ino)
+        {
+            f_entries.erase(it->f_key);
+            it = f_lru.erase(it);
+            ++count;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return count;
+}
+
+
+/** \brief Remove the entries of a file by name.
+ *
+ * This function gets the device and inode of \p filename and removes
+ * the corresponding entries. If the file does not exist anymore,
+ * nothing happens; its entries get evicted over time.
+ *
+ * \param[in] filename  The name of the file.
+ *
+ * \return The number of entries removed.
+ */
+std::size_t mime_type_cache::invalidate_file(std::string const & filename)
+{
+    struct stat s = {};
+    if(stat(filename.c_str(), &s) != 0)
+    {
+        return 0;
+    }
+    return invalidate_file(s.st_dev, s.st_ino);
+}
+
+
+/** \brief Remove all the entries.
+ *
+ * The statistics are not reset. Use reset_statistics() for that.
+ */
+void mime_type_cache::clear()
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    f_entries.clear();
+    f_lru.clear();
+}
+
+
+/** \brief Get the number of entries in the cache.
+ *
+ * \return The number of entries.
+ */
+std::size_t mime_type_cache::size() const
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    return f_lru.size();
+}
+
+
+/** \brief Get the maximum number of entries.
+ *
+ * \return The maximum number of entries defined in the constructor.
+ */
+std::size_t mime_type_cache::get_max_entries() const
+{
+    return f_max_entries;
+}
+
+
+/** \brief Get the number of times a MIME type was found in the cache.
+ *
+ * \return The number of hits.
+ */
+std::uint64_t mime_type_cache::get_hits() const
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    return f_hits;
+}
+
+
+/** \brief Get the number of times a MIME type had to be detected.
+ *
+ * \return The number of misses.
+ */
+std::uint64_t mime_type_cache::get_misses() const
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    return f_misses;
+}
+
+
+/** \brief Get the ratio of hits.
+ *
+ * \return The number of hits divided by the number of requests, 0.0 if
+ * no requests were made yet.
+ */
+double mime_type_cache::get_hit_rate() const
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    std::uint64_t const total(f_hits + f_misses);
+    if(total == 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(f_hits) / static_cast<double>(total);
+}
+
+
+/** \brief Reset the hits and misses counters.
+ */
+void mime_type_cache::reset_statistics()
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    f_hits = 0;
+    f_misses = 0;
+}
+
+
+/** \brief Hash a buffer.
+ *
+ * This is a fast non-cryptographic hash working on four 64 bit lanes
+ * so the multiplications of 32 consecutive bytes run in parallel
+ * (the same structure as XXH64). Hashing the 64Kb inspected by default
+ * takes a few microseconds, a tiny fraction of a libmagic call.
+ *
+ * \param[in] data  The data to hash.
+ * \param[in] seed  The seed of the hash.
+ *
+ * \return The 64 bit hash of \p data.
+ */
+std::uint64_t mime_type_cache::hash_prefix(std::span<char const> data, std::uint64_t seed)
+{
+    char const * s(data.data());
+    std::size_t size(data.size());
+    std::uint64_t h(0);
+
+    if(size >= 32)
+    {
+        std::uint64_t v1(seed + HASH_PRIME1 + HASH_PRIME2);
+        std::uint64_t v2(seed + HASH_PRIME2);
+        std::uint64_t v3(seed);
+        std::uint64_t v4(seed - HASH_PRIME1);
+        for(; size >= 32; s += 32, size -= 32)
+        {
+            v1 = round64(v1, read64(s +  0));
+            v2 = round64(v2, read64(s +  8));
+            v3 = round64(v3, read64(s + 16));
+            v4 = round64(v4, read64(s + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    }
+    else
+    {
+        h = seed + HASH_PRIME3;
+    }
+    h += data.size();
+
+    for(; size >= 8; s += 8, size -= 8)
+    {
+        h ^= round64(0, read64(s));
+        h = rotl(h, 27) * HASH_PRIME1 + HASH_PRIME2;
+    }
+    for(; size > 0; ++s, --size)
+    {
+        h ^= static_cast<std::uint8_t>(*s) * HASH_PRIME3;
+        h = rotl(h, 11) * HASH_PRIME1;
+    }
+
+    return avalanche(h);
+}
+
+
+std::size_t mime_type_cache::key_hash_t::operator () (key_t const & key) const
+{
+    std::uint64_t h(static_cast<std::uint64_t>(key.f_kind));
+    h = round64(h, key.f_a);
+    h = round64(h, key.f_b);
+    h = round64(h, key.f_c);
+    h = round64(h, key.f_d);
+    h = round64(h, key.f_e);
+    return avalanche(h);
+}
+
+
+bool mime_type_cache::find(key_t const & key, std::string & mime_type)
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    auto it(f_entries.find(key));
+    if(it == f_entries.end())
+    {
+        ++f_misses;
+        return false;
+    }
+    ++f_hits;
+    f_lru.splice(f_lru.begin(), f_lru, it->second);
+    mime_type = it->second->f_mime_type;
+    return true;
+}
+
+
+void mime_type_cache::insert(key_t const & key, std::string const & mime_type)
+{
+    std::unique_lock<std::mutex> lock(f_mutex);
+    auto it(f_entries.find(key));
+    if(it != f_entries.end())
+    {
+        // another thread added it while we were detecting the type
+        //
+        f_lru.splice(f_lru.begin(), f_lru, it->second);
+        return;
+    }
+
+    if(f_lru.size() >= f_max_entries)
+    {
+        f_entries.erase(f_lru.back().f_key);
+        f_lru.pop_back();
+    }
+    f_lru.push_front(entry_t{key, mime_type});
+    f_entries[key] = f_lru.begin();
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
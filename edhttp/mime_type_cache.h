@@ -0,0 +1,124 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/mime_type.h>
+
+
+// C++
+//
+#include    <cstdint>
+#include    <list>
+#include    <memory>
+#include    <mutex>
+#include    <span>
+#include    <string>
+#include    <unordered_map>
+
+
+// C
+//
+#include    <sys/types.h>
+
+
+
+namespace edhttp
+{
+
+
+
+class mime_type_cache
+{
+public:
+    typedef std::shared_ptr<mime_type_cache>    pointer_t;
+
+    static constexpr std::size_t    DEFAULT_MAX_ENTRIES = 4096;
+
+                        mime_type_cache(std::size_t max_entries = DEFAULT_MAX_ENTRIES);
+
+                        mime_type_cache(mime_type_cache const &) = delete;
+    mime_type_cache &   operator = (mime_type_cache const &) = delete;
+
+    std::string         get_mime_type(std::span<char const> data, std::size_t max_bytes = MIME_TYPE_INSPECT_SIZE);
+    std::string         get_file_mime_type(std::string const & filename, std::size_t max_bytes = MIME_TYPE_INSPECT_SIZE);
+
+    std::size_t         invalidate_file(dev_t dev, ino_t ino);
+    std::size_t         invalidate_file(std::string const & filename);
+    void                clear();
+
+    std::size_t         size() const;
+    std::size_t         get_max_entries() const;
+    std::uint64_t       get_hits() const;
+    std::uint64_t       get_misses() const;
+    double              get_hit_rate() const;
+    void                reset_statistics();
+
+    static std::uint64_t
+                        hash_prefix(std::span<char const> data, std::uint64_t seed);
+
+private:
+    enum class kind_t : std::uint8_t
+    {
+        KIND_BUFFER,
+        KIND_FILE
+    };
+
+    struct key_t
+    {
+        bool                operator == (key_t const & rhs) const = default;
+
+        kind_t              f_kind = kind_t::KIND_BUFFER;
+        std::uint64_t       f_a = 0;    // hash of the inspected bytes or device
+        std::uint64_t       f_b = 0;    // number of inspected bytes
+        std::uint64_t       f_c = 0;    // 0 or inode
+        std::uint64_t       f_d = 0;    // 0 or mtime in ns
+        std::uint64_t       f_e = 0;    // 0 or file size
+    };
+
+    struct key_hash_t
+    {
+        std::size_t         operator () (key_t const & key) const;
+    };
+
+    struct entry_t
+    {
+        key_t               f_key = key_t();
+        std::string         f_mime_type = std::string();
+    };
+
+    typedef std::list<entry_t>  lru_t;
+
+    bool                find(key_t const & key, std::string & mime_type);
+    void                insert(key_t const & key, std::string const & mime_type);
+
+    mutable std::mutex  f_mutex = std::mutex();
+    std::size_t         f_max_entries = DEFAULT_MAX_ENTRIES;
+    std::uint64_t       f_seed = 0;
+    lru_t               f_lru = lru_t();        // most recently used first
+    std::unordered_map<key_t, lru_t::iterator, key_hash_t>
+                        f_entries = std::unordered_map<key_t, lru_t::iterator, key_hash_t>();
+    std::uint64_t       f_hits = 0;
+    std::uint64_t       f_misses = 0;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,95 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Convert a broken down UTC time to a Unix time.
+ *
+ * The mkgmtime() function is the UTC equivalent of mktime(). It used
+ * to be a copy of the newlib implementation which loops over the
+ * years and months. It now uses the constant time civil calendar
+ * functions.
+ */
+
+// self
+//
+#include    "edhttp/mkgmtime.h"
+
+#include    "edhttp/civil_time.h"
+
+
+// C++
+//
+#include    <limits>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+/** \brief Convert a broken down UTC time to a Unix time.
+ *
+ * The tm_wday and tm_yday fields are ignored on input. The other fields
+ * can be out of range (i.e. 93 seconds or -3 months) in which case they
+ * get normalized. On return, all the fields of \p tim_p are set to
+ * represent the resulting time, including tm_wday and tm_yday.
+ *
+ * The tm_isdst field is ignored since UTC has no daylight saving time.
+ * A positive value is changed to 1 as mktime() does.
+ *
+ * \param[in,out] tim_p  The time to convert.
+ *
+ * \return The Unix time or -1 if the resulting year does not fit in
+ * the tm_year field.
+ */
+extern "C" time_t mkgmtime(struct tm * tim_p)
+{
+    std::int64_t const t(edhttp::time_from_civil(
+              tim_p->tm_year + 1900LL
+            , tim_p->tm_mon + 1LL
+            , tim_p->tm_mday
+            , tim_p->tm_hour
+            , tim_p->tm_min
+            , tim_p->tm_sec));
+
+    edhttp::civil_time_t const c(edhttp::civil_from_time(t));
+    if(c.f_year - 1900 > std::numeric_limits<int>::max()
+    || c.f_year - 1900 < std::numeric_limits<int>::min())
+    {
+        return static_cast<time_t>(-1);
+    }
+
+    tim_p->tm_year = static_cast<int>(c.f_year - 1900);
+    tim_p->tm_mon = c.f_month - 1;
+    tim_p->tm_mday = c.f_day;
+    tim_p->tm_hour = c.f_hour;
+    tim_p->tm_min = c.f_minute;
+    tim_p->tm_sec = c.f_second;
+    tim_p->tm_wday = c.f_week_day;
+    tim_p->tm_yday = c.f_year_day;
+    if(tim_p->tm_isdst > 0)
+    {
+        tim_p->tm_isdst = 1;
+    }
+
+    return static_cast<time_t>(t);
+}
+
+
+// vim: ts=4 sw=4 et
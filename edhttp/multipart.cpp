@@ -0,0 +1,811 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Streaming parser and builder of multipart/... bodies.
+ *
+ * The multipart_parser class reads a multipart body (RFC 2046) as it
+ * arrives, in buffers of any size. The delimiter is searched with the
+ * Boyer-Moore-Horspool algorithm and the part data is passed back as
+ * string views inside the buffers given to feed() so the bodies are
+ * never copied. Only the headers of each part are saved.
+ *
+ * The multipart_builder class generates a multipart body one part at
+ * a time, optionally encoding the data of each part using the
+ * quoted-printable or base64 transfer encodings. The output is
+ * appended to a string which the caller can send and clear between
+ * calls so the memory used remains constant.
+ *
+ * These are used for HTTP form uploads (multipart/form-data) as well
+ * as emails (multipart/mixed, multipart/alternative).
+ */
+
+// self
+//
+#include    "edhttp/multipart.h"
+
+#include    "edhttp/exception.h"
+#include    "edhttp/names.h"
+
+
+// snapdev
+//
+#include    <snapdev/to_lower.h>
+#include    <snapdev/trim_string.h>
+
+
+// C++
+//
+#include    <algorithm>
+#include    <cstring>
+#include    <random>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+namespace
+{
+
+
+
+// RFC 2045 limits encoded lines to 76 characters
+//
+constexpr std::size_t const g_base64_line_length = 76;
+
+
+bool is_boundary_char(char c)
+{
+    if((c >= 'a' && c <= 'z')
+    || (c >= 'A' && c <= 'Z')
+    || (c >= '0' && c <= '9'))
+    {
+        return true;
+    }
+    switch(c)
+    {
+    case '\'':
+    case '(':
+    case ')':
+    case '+':
+    case '_':
+    case ',':
+    case '-':
+    case '.':
+    case '/':
+    case ':':
+    case '=':
+    case '?':
+    case ' ':
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+bool is_space(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a multipart parser.
+ *
+ * The \p boundary is the parameter of the same name found in the
+ * Content-Type of the message. See get_parameter() to extract it.
+ *
+ * \exception invalid_parameter
+ * The boundary must be 1 to 70 characters as defined in RFC 2046.
+ *
+ * \param[in] boundary  The boundary separating each part.
+ */
+multipart_parser::multipart_parser(std::string_view boundary)
+{
+    if(!is_valid_boundary(boundary))
+    {
+        throw invalid_parameter(
+                  "invalid multipart boundary \""
+                + std::string(boundary)
+                + "\".");
+    }
+
+    f_delimiter = "\r\n--";
+    f_delimiter += boundary;
+
+    // Boyer-Moore-Horspool skip table; the delimiter is at most 74
+    // characters so the skips fit in a byte
+    //
+    std::size_t const length(f_delimiter.length());
+    f_skip.fill(static_cast<std::uint8_t>(length));
+    for(std::size_t idx(0); idx < length - 1; ++idx)
+    {
+        f_skip[static_cast<std::uint8_t>(f_delimiter[idx])] = static_cast<std::uint8_t>(length - 1 - idx);
+    }
+
+    // the very first boundary does not need to be preceeded by a CRLF,
+    // act as if we already had received one
+    //
+    f_partial = 2;
+}
+
+
+multipart_parser::~multipart_parser()
+{
+}
+
+
+/** \brief Parse the next buffer of data.
+ *
+ * This function parses \p data and calls the process_part_begin(),
+ * process_part_data(), and process_part_end() functions as the parts
+ * are found.
+ *
+ * The data views passed to process_part_data() point inside \p data
+ * (or inside the delimiter when a few bytes looked like the start of
+ * a delimiter at the end of the previous buffer). They are only valid
+ * for the duration of that call.
+ *
+ * Anything found after the closing delimiter (the epilogue) is ignored.
+ *
+ * \exception multipart_error
+ * This exception is raised when the data after a delimiter is not
+ * valid or when the headers of a part are too large.
+ *
+ * \param[in] data  The next buffer of data.
+ */
+void multipart_parser::feed(std::span<char const> data)
+{
+    char const * s(data.data());
+    char const * const end(s + data.size());
+    while(s < end)
+    {
+        switch(f_state)
+        {
+        case state_t::STATE_PREAMBLE:
+            if(find_delimiter(s, end))
+            {
+                f_state = state_t::STATE_BOUNDARY_END;
+            }
+            break;
+
+        case state_t::STATE_BODY:
+            if(find_delimiter(s, end))
+            {
+                process_part_end();
+                f_state = state_t::STATE_BOUNDARY_END;
+            }
+            break;
+
+        case state_t::STATE_BOUNDARY_END:
+            // the delimiter may be followed by "--" (close delimiter),
+            // or some transport padding and a CRLF
+            //
+            if(*s == '-')
+            {
+                f_state = state_t::STATE_CLOSE_DASH;
+            }
+            else if(*s == '\r')
+            {
+                f_state = state_t::STATE_BOUNDARY_CR;
+            }
+            else if(*s == '\n')
+            {
+                f_state = state_t::STATE_HEADERS;
+            }
+            else if(!is_space(*s))
+            {
+                throw multipart_error("unexpected character after a multipart boundary.");
+            }
+            ++s;
+            break;
+
+        case state_t::STATE_BOUNDARY_CR:
+            if(*s != '\n')
+            {
+                throw multipart_error("a multipart boundary must be followed by CRLF.");
+            }
+            ++s;
+            f_state = state_t::STATE_HEADERS;
+            break;
+
+        case state_t::STATE_CLOSE_DASH:
+            if(*s != '-')
+            {
+                throw multipart_error("a multipart close delimiter must end with \"--\".");
+            }
+            ++s;
+            f_state = state_t::STATE_EPILOGUE;
+            break;
+
+        case state_t::STATE_HEADERS:
+            {
+                char const * eol(static_cast<char const *>(memchr(s, '\n', static_cast<std::size_t>(end - s))));
+                char const * const stop(eol == nullptr ? end : eol);
+                f_header_size += static_cast<std::size_t>(stop - s);
+                if(f_header_size > MAX_HEADER_SIZE)
+                {
+                    throw multipart_error("the headers of a multipart part are too large.");
+                }
+                f_line.append(s, stop);
+                if(eol == nullptr)
+                {
+                    return;
+                }
+                s = eol + 1;
+                if(!f_line.empty() && f_line.back() == '\r')
+                {
+                    f_line.pop_back();
+                }
+                if(f_line.empty())
+                {
+                    ++f_part_count;
+                    process_part_begin(f_headers);
+                    f_headers.clear();
+                    f_last_header.clear();
+                    f_header_size = 0;
+                    f_state = state_t::STATE_BODY;
+                }
+                else
+                {
+                    add_header_line();
+                    f_line.clear();
+                }
+            }
+            break;
+
+        case state_t::STATE_EPILOGUE:
+            return;
+
+        }
+    }
+}
+
+
+/** \brief Signal the end of the data.
+ *
+ * \exception multipart_error
+ * This exception is raised if the closing delimiter was not found.
+ */
+void multipart_parser::finish()
+{
+    if(f_state != state_t::STATE_EPILOGUE)
+    {
+        throw multipart_error("multipart data ended before its closing delimiter.");
+    }
+}
+
+
+/** \brief Check whether the closing delimiter was found.
+ *
+ * \return true once the closing delimiter was parsed.
+ */
+bool multipart_parser::is_done() const
+{
+    return f_state == state_t::STATE_EPILOGUE;
+}
+
+
+/** \brief Retrieve the number of parts found so far.
+ *
+ * \return The number of times process_part_begin() was called.
+ */
+std::size_t multipart_parser::get_part_count() const
+{
+    return f_part_count;
+}
+
+
+/** \brief Retrieve a parameter from a header value.
+ *
+ * Header values such as the Content-Type and Content-Disposition
+ * accept parameters after a semicolon:
+ *
+ * \code
+ *     multipart/form-data; boundary="abc"
+ *     form-data; name="upload"; filename="image.png"
+ * \endcode
+ *
+ * This function searches for the parameter named \p name (case
+ * insensitive) and returns its value, unquoted.
+ *
+ * \param[in] value  The header value.
+ * \param[in] name  The name of the parameter to retrieve.
+ *
+ * \return The value of the parameter or an empty string if not found.
+ */
+std::string multipart_parser::get_parameter(std::string_view value, std::string_view name)
+{
+    std::string const lower_name(snapdev::to_lower(std::string(name)));
+    std::string::size_type pos(value.find(';'));
+    while(pos != std::string_view::npos)
+    {
+        ++pos;
+        std::string::size_type const equal(value.find_first_of("=;", pos));
+        if(equal == std::string_view::npos || value[equal] == ';')
+        {
+            pos = equal;
+            continue;
+        }
+        std::string const param(snapdev::to_lower(snapdev::trim_string(std::string(value.substr(pos, equal - pos)))));
+
+        std::string result;
+        pos = equal + 1;
+        while(pos < value.length() && is_space(value[pos]))
+        {
+            ++pos;
+        }
+        if(pos < value.length() && value[pos] == '"')
+        {
+            for(++pos; pos < value.length() && value[pos] != '"'; ++pos)
+            {
+                if(value[pos] == '\\' && pos + 1 < value.length())
+                {
+                    ++pos;
+                }
+                result += value[pos];
+            }
+            pos = value.find(';', pos);
+        }
+        else
+        {
+            std::string::size_type const next(value.find(';', pos));
+            result = snapdev::trim_string(std::string(value.substr(pos, next == std::string_view::npos ? std::string_view::npos : next - pos)));
+            pos = next;
+        }
+
+        if(param == lower_name)
+        {
+            return result;
+        }
+    }
+
+    return std::string();
+}
+
+
+/** \brief Check whether a boundary is valid.
+ *
+ * RFC 2046 limits the boundary to 1 to 70 characters among letters,
+ * digits, spaces, and <tt>'()+_,-./:=?</tt>. The last character cannot
+ * be a space.
+ *
+ * \param[in] boundary  The boundary to check.
+ *
+ * \return true if \p boundary is valid.
+ */
+bool multipart_parser::is_valid_boundary(std::string_view boundary)
+{
+    if(boundary.empty()
+    || boundary.length() > MAX_BOUNDARY_LENGTH
+    || boundary.back() == ' ')
+    {
+        return false;
+    }
+    return std::all_of(boundary.begin(), boundary.end(), is_boundary_char);
+}
+
+
+/** \brief Search the next delimiter.
+ *
+ * This function searches the delimiter in [s, end). The data before the
+ * delimiter is sent to process_part_data() when in the body of a part.
+ *
+ * When the buffer ends with the beginning of a delimiter, the length of
+ * that beginning is saved in f_partial and the next call first checks
+ * whether the rest of the delimiter follows. If not, those bytes were
+ * data; since they are equal to the start of the delimiter, they are
+ * sent from the f_delimiter string instead of being saved. The boundary
+ * cannot include a '\\r' so a partial match which fails can never hide
+ * a shorter one.
+ *
+ * \param[in,out] s  The start of the data, moved after the delimiter
+ * or to \p end.
+ * \param[in] end  The end of the data.
+ *
+ * \return true if the delimiter was found.
+ */
+bool multipart_parser::find_delimiter(char const * & s, char const * end)
+{
+    std::size_t const length(f_delimiter.length());
+    std::size_t size(static_cast<std::size_t>(end - s));
+
+    if(f_partial > 0)
+    {
+        std::size_t const count(std::min(length - f_partial, size));
+        if(memcmp(s, f_delimiter.data() + f_partial, count) == 0)
+        {
+            s += count;
+            f_partial += count;
+            if(f_partial == length)
+            {
+                f_partial = 0;
+                return true;
+            }
+            return false;
+        }
+        emit_data(f_delimiter.data(), f_partial);
+        f_partial = 0;
+    }
+
+    char const last(f_delimiter[length - 1]);
+    std::size_t pos(0);
+    while(pos + length <= size)
+    {
+        char const c(s[pos + length - 1]);
+        if(c == last
+        && memcmp(s + pos, f_delimiter.data(), length - 1) == 0)
+        {
+            emit_data(s, pos);
+            s += pos + length;
+            return true;
+        }
+        pos += f_skip[static_cast<std::uint8_t>(c)];
+    }
+
+    // the end of the buffer may be the start of a delimiter
+    //
+    pos = size >= length ? size - length + 1 : 0;
+    for(;;)
+    {
+        char const * cr(static_cast<char const *>(memchr(s + pos, '\r', size - pos)));
+        if(cr == nullptr)
+        {
+            break;
+        }
+        pos = static_cast<std::size_t>(cr - s);
+        if(memcmp(cr, f_delimiter.data(), size - pos) == 0)
+        {
+            f_partial = size - pos;
+            size = pos;
+            break;
+        }
+        ++pos;
+    }
+
+    emit_data(s, size);
+    s = end;
+    return false;
+}
+
+
+void multipart_parser::emit_data(char const * s, std::size_t size)
+{
+    if(size > 0 && f_state == state_t::STATE_BODY)
+    {
+        process_part_data(std::string_view(s, size));
+    }
+}
+
+
+void multipart_parser::add_header_line()
+{
+    if(is_space(f_line[0]))
+    {
+        // continuation of the previous header
+        //
+        if(f_last_header.empty())
+        {
+            throw multipart_error("a multipart part cannot start with a header continuation.");
+        }
+        f_headers[f_last_header] += ' ';
+        f_headers[f_last_header] += snapdev::trim_string(f_line);
+        return;
+    }
+
+    std::string::size_type const colon(f_line.find(':'));
+    if(colon == std::string::npos || colon == 0)
+    {
+        throw multipart_error("invalid header \"" + f_line + "\" in a multipart part.");
+    }
+    f_last_header = snapdev::to_lower(snapdev::trim_string(f_line.substr(0, colon)));
+    std::string & value(f_headers[f_last_header]);
+    if(!value.empty())
+    {
+        value += ", ";
+    }
+    value += snapdev::trim_string(f_line.substr(colon + 1));
+}
+
+
+
+
+
+
+/** \brief Initialize a multipart builder.
+ *
+ * \exception invalid_parameter
+ * The boundary, if specified, must be valid (see
+ * multipart_parser::is_valid_boundary()).
+ *
+ * \param[in] boundary  The boundary to use between each part. If empty,
+ * a random boundary is generated.
+ */
+multipart_builder::multipart_builder(std::string_view boundary)
+    : f_boundary(boundary.empty() ? generate_boundary() : std::string(boundary))
+{
+    if(!multipart_parser::is_valid_boundary(f_boundary))
+    {
+        throw invalid_parameter(
+                  "invalid multipart boundary \""
+                + f_boundary
+                + "\".");
+    }
+}
+
+
+/** \brief Retrieve the boundary.
+ *
+ * \return The boundary used between each part.
+ */
+std::string const & multipart_builder::get_boundary() const
+{
+    return f_boundary;
+}
+
+
+/** \brief Generate the Content-Type of the message.
+ *
+ * \param[in] type  The multipart type such as "multipart/form-data".
+ * Defaults to "multipart/mixed".
+ *
+ * \return The Content-Type with the boundary parameter.
+ */
+std::string multipart_builder::get_content_type(std::string_view type) const
+{
+    std::string result(type.empty() ? std::string_view(g_name_edhttp_param_multipart_mixed) : type);
+    result += "; ";
+    result += g_name_edhttp_param_boundary;
+    result += "=\"";
+    result += f_boundary;
+    result += '"';
+    return result;
+}
+
+
+/** \brief Change the flags used with the quoted-printable encoding.
+ *
+ * The flags are used by the following parts using the
+ * TRANSFER_ENCODING_QUOTED_PRINTABLE encoding.
+ *
+ * \param[in] flags  A set of QUOTED_PRINTABLE_FLAG_... flags.
+ */
+void multipart_builder::set_quoted_printable_flags(int flags)
+{
+    f_quoted_printable_flags = flags;
+}
+
+
+/** \brief Start a new part.
+ *
+ * This function writes the delimiter and the headers of the part to
+ * \p output. When \p encoding is not TRANSFER_ENCODING_NONE, the
+ * Content-Transfer-Encoding header is added and the data passed to
+ * write() gets encoded.
+ *
+ * If a part is still open, it gets closed first.
+ *
+ * \exception logic_error
+ * The builder was already finished.
+ *
+ * \exception invalid_parameter
+ * A header name or value includes a CR or LF.
+ *
+ * \param[in] headers  The headers of this part.
+ * \param[in] encoding  The transfer encoding of this part.
+ * \param[in,out] output  The string where the data gets appended.
+ */
+void multipart_builder::begin_part(
+      multipart_header_map_t const & headers
+    , transfer_encoding_t encoding
+    , std::string & output)
+{
+    if(f_finished)
+    {
+        throw logic_error("multipart_builder::begin_part() called after finish().");
+    }
+    if(f_in_part)
+    {
+        end_part(output);
+    }
+
+    if(f_part_count > 0)
+    {
+        output += "\r\n";
+    }
+    output += "--";
+    output += f_boundary;
+    output += "\r\n";
+
+    for(auto const & h : headers)
+    {
+        if(h.first.find_first_of("\r\n:") != std::string::npos
+        || h.second.find_first_of("\r\n") != std::string::npos)
+        {
+            throw invalid_parameter("invalid multipart header \"" + h.first + "\".");
+        }
+        output += h.first;
+        output += ": ";
+        output += h.second;
+        output += "\r\n";
+    }
+
+    switch(encoding)
+    {
+    case transfer_encoding_t::TRANSFER_ENCODING_NONE:
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE:
+        output += g_name_edhttp_field_content_transfer_encoding;
+        output += ": ";
+        output += g_name_edhttp_param_quoted_printable;
+        output += "\r\n";
+        f_quoted_printable = quoted_printable_encoder(f_quoted_printable_flags);
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_BASE64:
+        output += g_name_edhttp_field_content_transfer_encoding;
+        output += ": ";
+        output += g_name_edhttp_param_base64;
+        output += "\r\n";
+        f_base64 = base64_encoder(
+                  base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                , 0
+                , g_base64_line_length);
+        break;
+
+    }
+    output += "\r\n";
+
+    f_encoding = encoding;
+    f_in_part = true;
+    ++f_part_count;
+}
+
+
+/** \brief Write data to the current part.
+ *
+ * The data gets encoded as specified in begin_part() and appended to
+ * \p output.
+ *
+ * \exception logic_error
+ * No part is currently open.
+ *
+ * \param[in] data  The data to add to the current part.
+ * \param[in,out] output  The string where the data gets appended.
+ */
+void multipart_builder::write(std::span<char const> data, std::string & output)
+{
+    if(!f_in_part)
+    {
+        throw logic_error("multipart_builder::write() called outside of a part.");
+    }
+
+    switch(f_encoding)
+    {
+    case transfer_encoding_t::TRANSFER_ENCODING_NONE:
+        output.append(data.data(), data.size());
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE:
+        f_quoted_printable.encode(data, output);
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_BASE64:
+        f_base64.encode(data, output);
+        break;
+
+    }
+}
+
+
+/** \brief End the current part.
+ *
+ * This function flushes the transfer encoder. The delimiter itself is
+ * written by the next begin_part() or by finish().
+ *
+ * \param[in,out] output  The string where the data gets appended.
+ */
+void multipart_builder::end_part(std::string & output)
+{
+    if(!f_in_part)
+    {
+        return;
+    }
+
+    switch(f_encoding)
+    {
+    case transfer_encoding_t::TRANSFER_ENCODING_NONE:
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE:
+        f_quoted_printable.finish(output);
+        break;
+
+    case transfer_encoding_t::TRANSFER_ENCODING_BASE64:
+        f_base64.finish(output);
+        break;
+
+    }
+    f_in_part = false;
+}
+
+
+/** \brief Write the closing delimiter.
+ *
+ * The current part, if any, is closed first.
+ *
+ * \param[in,out] output  The string where the data gets appended.
+ */
+void multipart_builder::finish(std::string & output)
+{
+    if(f_finished)
+    {
+        return;
+    }
+    end_part(output);
+
+    if(f_part_count > 0)
+    {
+        output += "\r\n";
+    }
+    output += "--";
+    output += f_boundary;
+    output += "--\r\n";
+    f_finished = true;
+}
+
+
+/** \brief Generate a random boundary.
+ *
+ * The boundary is long enough that it is not expected to appear in
+ * the data of the parts.
+ *
+ * \return A new random boundary.
+ */
+std::string multipart_builder::generate_boundary()
+{
+    constexpr char const characters[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+    std::random_device rd;
+    std::string result("=_edhttp_");
+    for(int idx(0); idx < 32; ++idx)
+    {
+        result += characters[rd() % (sizeof(characters) - 1)];
+    }
+    return result;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
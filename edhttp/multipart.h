@@ -0,0 +1,140 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/base64.h>
+#include    <edhttp/quoted_printable.h>
+
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <map>
+#include    <span>
+#include    <string>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+typedef std::map<std::string, std::string>      multipart_header_map_t;
+
+
+class multipart_parser
+{
+public:
+    static constexpr std::size_t    MAX_BOUNDARY_LENGTH = 70;
+    static constexpr std::size_t    MAX_HEADER_SIZE = 16 * 1024;
+
+                        multipart_parser(std::string_view boundary);
+                        multipart_parser(multipart_parser const &) = delete;
+    virtual             ~multipart_parser();
+    multipart_parser &  operator = (multipart_parser const &) = delete;
+
+    void                feed(std::span<char const> data);
+    void                finish();
+    bool                is_done() const;
+    std::size_t         get_part_count() const;
+
+    static std::string  get_parameter(std::string_view value, std::string_view name);
+    static bool         is_valid_boundary(std::string_view boundary);
+
+protected:
+    virtual void        process_part_begin(multipart_header_map_t const & headers) = 0;
+    virtual void        process_part_data(std::string_view data) = 0;
+    virtual void        process_part_end() = 0;
+
+private:
+    enum class state_t
+    {
+        STATE_PREAMBLE,
+        STATE_BOUNDARY_END,
+        STATE_BOUNDARY_CR,
+        STATE_CLOSE_DASH,
+        STATE_HEADERS,
+        STATE_BODY,
+        STATE_EPILOGUE
+    };
+
+    bool                find_delimiter(char const * & s, char const * end);
+    void                add_header_line();
+    void                emit_data(char const * s, std::size_t size);
+
+    std::string         f_delimiter = std::string();    // "\r\n--" + boundary
+    std::array<std::uint8_t, 256>
+                        f_skip = std::array<std::uint8_t, 256>();
+    state_t             f_state = state_t::STATE_PREAMBLE;
+    std::size_t         f_partial = 0;
+    std::string         f_line = std::string();
+    std::size_t         f_header_size = 0;
+    std::string         f_last_header = std::string();
+    multipart_header_map_t
+                        f_headers = multipart_header_map_t();
+    std::size_t         f_part_count = 0;
+};
+
+
+class multipart_builder
+{
+public:
+    enum class transfer_encoding_t
+    {
+        TRANSFER_ENCODING_NONE,
+        TRANSFER_ENCODING_QUOTED_PRINTABLE,
+        TRANSFER_ENCODING_BASE64
+    };
+
+                        multipart_builder(std::string_view boundary = std::string_view());
+
+    std::string const & get_boundary() const;
+    std::string         get_content_type(std::string_view type = std::string_view()) const;
+    void                set_quoted_printable_flags(int flags);
+
+    void                begin_part(
+                              multipart_header_map_t const & headers
+                            , transfer_encoding_t encoding
+                            , std::string & output);
+    void                write(std::span<char const> data, std::string & output);
+    void                end_part(std::string & output);
+    void                finish(std::string & output);
+
+    static std::string  generate_boundary();
+
+private:
+    std::string         f_boundary = std::string();
+    int                 f_quoted_printable_flags = 0;
+    quoted_printable_encoder
+                        f_quoted_printable = quoted_printable_encoder();
+    base64_encoder      f_base64 = base64_encoder();
+    transfer_encoding_t f_encoding = transfer_encoding_t::TRANSFER_ENCODING_NONE;
+    std::size_t         f_part_count = 0;
+    bool                f_in_part = false;
+    bool                f_finished = false;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
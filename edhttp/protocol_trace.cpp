@@ -0,0 +1,66 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+/** \file
+ * \brief Switch for the HTTP protocol traces.
+ *
+ * The client logs the status line, each header field and the body of
+ * the responses it reads when the protocol traces are turned on. These
+ * messages are useful to debug a connection with a server but they are
+ * way too costly to be built for every response, even if the logger
+ * then drops them. The EDHTTP_TRACE() macro only builds the message
+ * after checking the flag defined here.
+ */
+
+// self
+//
+#include    "edhttp/protocol_trace.h"
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+std::atomic<bool>   g_protocol_trace = false;
+
+
+/** \brief Turn the protocol traces on or off.
+ *
+ * The traces are off by default. When on, the messages are sent to
+ * the logger with the TRACE severity, so the logger must also accept
+ * that severity for the messages to appear.
+ *
+ * \param[in] enable  Whether the protocol traces are turned on.
+ */
+void set_protocol_trace(bool enable)
+{
+    g_protocol_trace.store(enable, std::memory_order_relaxed);
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
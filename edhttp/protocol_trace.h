@@ -0,0 +1,88 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/version.h>
+
+
+// snaplogger
+//
+#include    <snaplogger/message.h>
+
+
+// C++
+//
+#include    <atomic>
+
+
+
+namespace edhttp
+{
+
+
+
+extern std::atomic<bool>    g_protocol_trace;
+
+
+inline bool is_protocol_trace_enabled()
+{
+    return g_protocol_trace.load(std::memory_order_relaxed);
+}
+
+
+void                        set_protocol_trace(bool enable);
+
+
+
+} // namespace edhttp
+
+
+
+/** \brief Log a trace of the HTTP protocol.
+ *
+ * The \p message is a list of values separated by `<<` as with the
+ * snaplogger macros. It is only evaluated when the protocol traces
+ * are turned on with set_protocol_trace(), otherwise the macro costs
+ * one test. When the library is built with the EDHTTP_PROTOCOL_TRACE
+ * option turned off, version.h defines EDHTTP_PROTOCOL_TRACE to 0 and
+ * the macro generates no code at all.
+ *
+ * \code
+ *     EDHTTP_TRACE("got protocol: " << protocol);
+ * \endcode
+ */
+#if EDHTTP_PROTOCOL_TRACE
+#define EDHTTP_TRACE(message) \
+    do \
+    { \
+        if(::edhttp::is_protocol_trace_enabled()) [[unlikely]] \
+        { \
+            SNAP_LOG_TRACE << message << SNAP_LOG_SEND; \
+        } \
+    } \
+    while(false)
+#else
+#define EDHTTP_TRACE(message) \
+    do \
+    { \
+    } \
+    while(false)
+#endif
+// vim: ts=4 sw=4 et
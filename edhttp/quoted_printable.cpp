@@ -21,9 +21,18 @@
 #include    "edhttp/quoted_printable.h"
 
 
-// snapdev lib
+// C++
 //
-#include    <snapdev/not_reached.h>
+#include    <algorithm>
+#include    <cstring>
+
+
+// C
+//
+#if defined(__SSE2__)
+#define EDHTTP_SSE2_SIMD
+#include    <emmintrin.h>
+#endif
 
 
 // last include
@@ -35,347 +44,644 @@
 namespace edhttp
 {
 
+namespace
+{
 
 
-std::string quoted_printable_encode(std::string const & input, int flags)
+
+// the maximum line length is 76
+// it is not clear whether that includes the CR+LF or not
+// "=\r\n" is 3 characters so we keep 75 characters of data per line
+//
+constexpr std::size_t const     g_max_line_length = 75;
+
+
+constexpr char const            g_hex_digits[] = "0123456789ABCDEF";
+
+
+int from_hex(char c)
 {
-    class result
+    if(c >= '0' && c <= '9')
     {
-    public:
-        result(size_t input_length, int flags)
-            : f_flags(flags)
-        {
-            f_result.reserve(input_length * 2);
-        }
+        return c - '0';
+    }
+    // note that the documentation clearly says that only capitalized
+    // (A-F) characters are acceptable...
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
 
-        char to_hex(int c)
+/** \brief Count the number of bytes which can be copied as is.
+ *
+ * This function returns the length of the run of bytes, starting at \p s,
+ * which are all marked as safe in the \p safe table.
+ *
+ * When SSE2 is available and the EDBIC flag is not set, the bytes are
+ * checked 16 at a time: a byte is safe if it is between ' ' and '~'
+ * (or a tab) and not '='. In binary mode, the space and tab characters
+ * are not safe.
+ *
+ * \param[in] s  The bytes to check.
+ * \param[in] size  The number of bytes in \p s.
+ * \param[in] safe  The table of safe bytes.
+ * \param[in] flags  The encoder flags.
+ *
+ * \return The number of safe bytes at the start of \p s.
+ */
+std::size_t scan_safe(
+      char const * s
+    , std::size_t size
+    , bool const * safe
+    , int flags)
+{
+    std::size_t pos(0);
+#ifdef EDHTTP_SSE2_SIMD
+    if((flags & QUOTED_PRINTABLE_FLAG_EDBIC) == 0)
+    {
+        bool const binary((flags & QUOTED_PRINTABLE_FLAG_BINARY) != 0);
+        __m128i const space(_mm_set1_epi8(' '));
+        __m128i const tilde(_mm_set1_epi8('~'));
+        __m128i const equal(_mm_set1_epi8('='));
+        __m128i const tab(_mm_set1_epi8('\t'));
+        for(; pos + 16 <= size; pos += 16)
         {
-            c &= 15;
-            if(c >= 0 && c <= 9)
+            __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)));
+
+            // signed comparisons so bytes 0x80 to 0xFF are less than ' '
+            //
+            __m128i bad(_mm_or_si128(
+                      _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpgt_epi8(v, tilde))
+                    , _mm_cmpeq_epi8(v, equal)));
+            if(binary)
             {
-                return static_cast<char>(c + '0');
+                bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, space));
             }
-            return static_cast<char>(c + 'A' - 10);
-        }
-
-        void add_byte(char c)
-        {
-            if(c == '\n' || c == '\r')
+            else
             {
-                if(c != '\r' || (f_flags & QUOTED_PRINTABLE_FLAG_LFONLY) == 0)
-                {
-                    f_result += c;
-                }
-                f_line = 0;
-                return;
+                bad = _mm_andnot_si128(_mm_cmpeq_epi8(v, tab), bad);
             }
-            // the maximum line length is 76
-            // it is not clear whether that includes the CR+LF or not
-            // "=\r\n" is 3 characters
-            if(f_line >= 75)
+            int const mask(_mm_movemask_epi8(bad));
+            if(mask != 0)
             {
-                if((f_flags & QUOTED_PRINTABLE_FLAG_LFONLY) == 0)
-                {
-                    f_result += "=\r\n";
-                }
-                else
-                {
-                    f_result += "=\n";
-                }
-                f_line = 0;
+                return pos + __builtin_ctz(mask);
             }
-            f_result += c;
-            ++f_line;
         }
-
-        void add_hex(int c)
+    }
+#else
+    static_cast<void>(flags);
+#endif
+    for(; pos < size; ++pos)
+    {
+        if(!safe[static_cast<std::uint8_t>(s[pos])])
         {
-            // make sure there is enough space on the current line before
-            // adding the 3 encoded bytes
-            if(f_line >= 73)
-            {
-                // IMPORTANT: we cannot call add_byte while adding
-                // an '=' as character 75 otherwise it will add "=\r\n"!
-                if((f_flags & QUOTED_PRINTABLE_FLAG_LFONLY) == 0)
-                {
-                    f_result += "=\r\n";
-                }
-                else
-                {
-                    f_result += "=\n";
-                }
-                f_line = 0;
-            }
-            add_byte('=');
-            add_byte(to_hex(c >> 4));
-            add_byte(to_hex(c));
+            break;
         }
+    }
+    return pos;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Encode a string using quoted-printable.
+ *
+ * This function encodes the whole \p input string at once. It is a
+ * wrapper around the quoted_printable_encoder class.
+ *
+ * \param[in] input  The string to encode.
+ * \param[in] flags  A set of QUOTED_PRINTABLE_FLAG_... flags.
+ *
+ * \return The encoded string.
+ */
+std::string quoted_printable_encode(std::string const & input, int flags)
+{
+    std::string result;
+    result.reserve(input.length() + input.length() / 16 + 16);
+
+    quoted_printable_encoder encoder(flags);
+    encoder.encode(input, result);
+    encoder.finish(result);
+
+    return result;
+}
 
-        void add_data(char c)
+
+/** \brief Decode a quoted-printable string.
+ *
+ * This function decodes the whole \p input string at once. It is a
+ * wrapper around the quoted_printable_decoder class.
+ *
+ * Invalid escape sequences are replaced by a question mark.
+ *
+ * \param[in] input  The string to decode.
+ *
+ * \return The decoded string.
+ */
+std::string quoted_printable_decode(std::string const & input)
+{
+    std::string result;
+    result.reserve(input.length());
+
+    quoted_printable_decoder decoder;
+    decoder.decode(input, result);
+    decoder.finish(result);
+
+    return result;
+}
+
+
+
+/** \class quoted_printable_encoder
+ * \brief Streaming quoted-printable encoder.
+ *
+ * The encoder accepts its input in chunks of any size and appends the
+ * encoded data to an output string. The state (current line length,
+ * a space or tab which cannot yet be written, a CR which may be followed
+ * by an LF) is kept between calls so the output is the same whatever
+ * the chunk boundaries are.
+ *
+ * Runs of bytes which do not need to be encoded are copied to the
+ * output as a whole, one line at a time.
+ *
+ * Once all the data was passed to encode(), call finish() to write
+ * the last space, tab, or period which the encoder may still hold.
+ */
+
+
+/** \brief Initialize the encoder.
+ *
+ * \param[in] flags  A set of QUOTED_PRINTABLE_FLAG_... flags.
+ */
+quoted_printable_encoder::quoted_printable_encoder(int flags)
+    : f_flags(flags)
+{
+    for(int c(' '); c <= '~'; ++c)
+    {
+        f_safe[c] = c != '=';
+    }
+    f_safe[static_cast<int>('\t')] = true;
+
+    if((f_flags & QUOTED_PRINTABLE_FLAG_BINARY) != 0)
+    {
+        f_safe[static_cast<int>(' ')] = false;
+        f_safe[static_cast<int>('\t')] = false;
+    }
+
+    if((f_flags & QUOTED_PRINTABLE_FLAG_EDBIC) != 0)
+    {
+        for(char const * s("!\"#$@[\\]^`{|}~"); *s != '\0'; ++s)
         {
-            if(c == ' ' || c == '\t')
-            {
-                // we have to buffer the last space or tab because they
-                // cannot appear as the last character on a line (i.e.
-                // when followed by \r or \n)
-                if(f_buffer != '\0')
-                {
-                    add_byte(f_buffer);
-                }
-                f_buffer = c;
-                return;
-            }
-            if(c == '\r')
-            {
-                f_cr = true;
-            }
-            else if(c == '\n' && f_cr)
-            {
-                // CR+LF already taken cared of
-                f_cr = false;
-                return;
-            }
-            else
-            {
-                f_cr = false;
-            }
-            if(c == '\n' || c == '\r')
-            {
-                // spaces and tabs must be encoded in this case
-                if(f_buffer != '\0')
-                {
-                    add_hex(f_buffer);
-                    f_buffer = '\0';
-                }
-                // force the CR+LF sequence
-                add_byte('\r');
-                add_byte('\n');
-                return;
-            }
-            if(f_buffer != '\0')
-            {
-                add_byte(f_buffer);
-                f_buffer = '\0';
-            }
-            add_byte(c);
+            f_safe[static_cast<std::uint8_t>(*s)] = false;
         }
+    }
+}
 
-        bool encode_char(char c)
-        {
-            switch(c)
-            {
-            case '\n':
-            case '\r':
-            case '\t':
-            case ' ':
-                return (f_flags & QUOTED_PRINTABLE_FLAG_BINARY) != 0;
-
-            case '=':
-                return true;
-
-            case '!': // !"#$@[\]^`{|}~
-            case '"':
-            case '#':
-            case '$':
-            case '@':
-            case '[':
-            case '\\':
-            case ']':
-            case '^':
-            case '`':
-            case '{':
-            case '|':
-            case '}':
-            case '~':
-                return (f_flags & QUOTED_PRINTABLE_FLAG_EDBIC) != 0;
-
-            default:
-                // note: the following won't match ' ' and '~' which are
-                //       already captured by other cases
-                return !(c >= ' ' && c <= '~');
 
-            }
-            snapdev::NOT_REACHED();
-        }
+/** \brief Retrieve the flags used by this encoder.
+ *
+ * \return The flags passed to the constructor.
+ */
+int quoted_printable_encoder::get_flags() const
+{
+    return f_flags;
+}
 
-        void add_char(char c)
+
+/** \brief Encode one chunk of data.
+ *
+ * This function encodes \p input and appends the result to \p output.
+ * The last few bytes may be kept in the encoder until the next call
+ * or the call to finish().
+ *
+ * \param[in] input  The chunk of data to encode.
+ * \param[in,out] output  The string where the encoded data gets appended.
+ */
+void quoted_printable_encoder::encode(std::span<char const> input, std::string & output)
+{
+    char const * s(input.data());
+    std::size_t const size(input.size());
+    bool const binary((f_flags & QUOTED_PRINTABLE_FLAG_BINARY) != 0);
+    std::size_t pos(0);
+    while(pos < size)
+    {
+        std::size_t const run(scan_safe(s + pos, size - pos, f_safe, f_flags));
+        if(run > 0)
         {
-            // a few controls are allowed as is
-            if(encode_char(c))
-            {
-                // needs to be encoded
-                add_hex(c);
-            }
-            else
-            {
-                add_data(c);
-            }
+            add_run(output, s + pos, run);
+            pos += run;
         }
-
-        void add_string(char const * s)
+        std::size_t end(pos);
+        while(end < size
+           && !f_safe[static_cast<std::uint8_t>(s[end])]
+           && (binary || (s[end] != '\r' && s[end] != '\n')))
         {
-            bool const lone_periods((f_flags & QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD) != 0);
-            // reset the buffer, just in case
-            f_buffer = '\0';
-            for(; *s != '\0'; ++s)
-            {
-                if(lone_periods
-                && *s == '.'
-                && (s[1] == '\r' || s[1] == '\n' || s[1] == '\0')
-                && (f_line == 0 || f_line >= 75))
-                {
-                    // special case of a lone period at the start of a line
-                    add_hex('.');
-                }
-                else
-                {
-                    add_char(*s);
-                }
-            }
+            ++end;
+        }
+        if(end > pos)
+        {
+            add_hex_run(output, s + pos, end - pos);
+            pos = end;
+        }
+        else if(pos < size)
+        {
+            // a new line in text mode
+            //
+            add_char(output, s[pos]);
+            ++pos;
+        }
+    }
+}
 
-            // at the end we may still have a space or tab to add
-            if(f_buffer != '\0')
-            {
-                add_hex(f_buffer);
-                f_buffer = '\0';
-            }
+
+/** \brief Terminate the encoding.
+ *
+ * A space or a tab at the very end of the input must be encoded. The
+ * same applies to a lone period when the QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD
+ * flag is set. This function writes those to \p output and then resets
+ * the encoder so it can be reused.
+ *
+ * \param[in,out] output  The string where the encoded data gets appended.
+ */
+void quoted_printable_encoder::finish(std::string & output)
+{
+    if(f_whitespace != '\0')
+    {
+        add_hex(output, static_cast<std::uint8_t>(f_whitespace));
+    }
+    if(f_period)
+    {
+        add_hex(output, '.');
+    }
+    reset();
+}
+
+
+/** \brief Reset the encoder.
+ *
+ * This function drops any pending data and restarts at the beginning
+ * of a line. The flags are kept.
+ */
+void quoted_printable_encoder::reset()
+{
+    f_line = 0;
+    f_whitespace = '\0';
+    f_period = false;
+    f_cr = false;
+}
+
+
+void quoted_printable_encoder::add_break(std::string & output)
+{
+    if((f_flags & QUOTED_PRINTABLE_FLAG_LFONLY) == 0)
+    {
+        output += "=\r\n";
+    }
+    else
+    {
+        output += "=\n";
+    }
+    f_line = 0;
+}
+
+
+void quoted_printable_encoder::add_hex(std::string & output, std::uint8_t c)
+{
+    // make sure there is enough space on the current line before
+    // adding the 3 encoded bytes
+    if(f_line + 3 > g_max_line_length)
+    {
+        add_break(output);
+    }
+    char const hex[3] = { '=', g_hex_digits[c >> 4], g_hex_digits[c & 15] };
+    output.append(hex, 3);
+    f_line += 3;
+}
+
+
+/** \brief Encode a run of bytes which all need an escape sequence.
+ *
+ * The escape sequences of one line are written at once.
+ *
+ * \param[in,out] output  The string where the data gets appended.
+ * \param[in] s  The bytes to encode, none of which is a new line in text
+ * mode.
+ * \param[in] size  The number of bytes in \p s.
+ */
+void quoted_printable_encoder::add_hex_run(std::string & output, char const * s, std::size_t size)
+{
+    f_cr = false;
+    flush_pending(output);
+
+    while(size > 0)
+    {
+        if(f_line + 3 > g_max_line_length)
+        {
+            add_break(output);
         }
+        std::size_t const count(std::min((g_max_line_length - f_line) / 3, size));
+        std::size_t const start(output.length());
+        output.resize(start + count * 3);
+        char * d(output.data() + start);
+        for(std::size_t idx(0); idx < count; ++idx, d += 3)
+        {
+            std::uint8_t const c(static_cast<std::uint8_t>(s[idx]));
+            d[0] = '=';
+            d[1] = g_hex_digits[c >> 4];
+            d[2] = g_hex_digits[c & 15];
+        }
+        s += count;
+        size -= count;
+        f_line += count * 3;
+    }
+}
+
+
+void quoted_printable_encoder::add_newline(std::string & output)
+{
+    if((f_flags & QUOTED_PRINTABLE_FLAG_LFONLY) == 0)
+    {
+        output += '\r';
+    }
+    output += '\n';
+    f_line = 0;
+}
+
+
+/** \brief Add a run of safe bytes.
+ *
+ * The bytes in \p s are all safe so they get copied as is, with a soft
+ * line break each time the line is full.
+ *
+ * A space or tab at the end of the run is kept back since it has to be
+ * encoded if the next byte ends the line. Similarly, a period at the
+ * end of the run may be a lone period so it goes through add_char().
+ *
+ * \param[in,out] output  The string where the data gets appended.
+ * \param[in] s  The safe bytes.
+ * \param[in] size  The number of bytes in \p s, at least 1.
+ */
+void quoted_printable_encoder::add_run(std::string & output, char const * s, std::size_t size)
+{
+    f_cr = false;
+    flush_pending(output);
+
+    char const last(s[size - 1]);
+    bool const whitespace(last == ' ' || last == '\t');
+    bool const period(last == '.'
+                && (f_flags & QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD) != 0);
+    if(whitespace || period)
+    {
+        --size;
+    }
 
-        std::string get_result() const
+    while(size > 0)
+    {
+        if(f_line >= g_max_line_length)
         {
-            return f_result;
+            add_break(output);
         }
+        std::size_t const length(std::min(g_max_line_length - f_line, size));
+        output.append(s, length);
+        s += length;
+        size -= length;
+        f_line += length;
+    }
+
+    if(whitespace)
+    {
+        f_whitespace = last;
+    }
+    else if(period)
+    {
+        add_char(output, '.');
+    }
+}
+
 
-    private:
-        int32_t         f_flags = 0;
-        char            f_buffer = 0;
-        std::string     f_result = std::string();
-        int32_t         f_line = 0;
-        bool            f_cr = false;
-    };
-
-    result r(input.length(), flags);
-    r.add_string(input.c_str());
-    return r.get_result();
+/** \brief Write the pending space, tab, or period as is.
+ *
+ * This function is called when the next byte does not end the line so
+ * the pending character does not need to be encoded.
+ *
+ * \param[in,out] output  The string where the data gets appended.
+ */
+void quoted_printable_encoder::flush_pending(std::string & output)
+{
+    char c('\0');
+    if(f_whitespace != '\0')
+    {
+        c = f_whitespace;
+        f_whitespace = '\0';
+    }
+    else if(f_period)
+    {
+        c = '.';
+        f_period = false;
+    }
+    else
+    {
+        return;
+    }
+
+    if(f_line >= g_max_line_length)
+    {
+        add_break(output);
+    }
+    output += c;
+    ++f_line;
 }
 
 
-std::string quoted_printable_decode(std::string const & input)
+void quoted_printable_encoder::add_char(std::string & output, char c)
 {
-    class result
+    if((f_flags & QUOTED_PRINTABLE_FLAG_BINARY) == 0
+    && (c == '\r' || c == '\n'))
     {
-    public:
-        result(std::string const & input)
-            //: f_result("") -- auto-initiazlied
-            : f_input(input)
-            , f_str(f_input.c_str())
+        if(c == '\n' && f_cr)
+        {
+            // CR+LF already taken cared of
+            f_cr = false;
+            return;
+        }
+        f_cr = c == '\r';
+
+        // spaces, tabs, and lone periods must be encoded in this case
+        if(f_whitespace != '\0')
+        {
+            add_hex(output, static_cast<std::uint8_t>(f_whitespace));
+            f_whitespace = '\0';
+        }
+        if(f_period)
         {
+            add_hex(output, '.');
+            f_period = false;
         }
 
-        result(result const & rhs) = delete;
-        result & operator = (result const & rhs) = delete;
+        // force the CR+LF sequence
+        add_newline(output);
+        return;
+    }
+    f_cr = false;
+
+    flush_pending(output);
 
-        int from_hex(int c)
+    if(c == '.')
+    {
+        if(f_line == 0 || f_line >= g_max_line_length)
         {
-            if(c >= '0' && c <= '9')
+            // special case of a lone period at the start of a line,
+            // we know what to do with it once we see the next byte
+            f_period = true;
+            return;
+        }
+        output += c;
+        ++f_line;
+        return;
+    }
+
+    add_hex(output, static_cast<std::uint8_t>(c));
+}
+
+
+
+/** \class quoted_printable_decoder
+ * \brief Streaming quoted-printable decoder.
+ *
+ * The decoder accepts its input in chunks of any size and appends the
+ * decoded data to an output string. An escape sequence or a soft line
+ * break can be split between two chunks.
+ *
+ * The data between two '=' characters is copied as a whole.
+ *
+ * Invalid escape sequences are replaced by a question mark. Once all
+ * the data was passed to decode(), call finish() so an escape sequence
+ * cut short by the end of the input also generates a question mark.
+ */
+
+
+/** \brief Decode one chunk of data.
+ *
+ * This function decodes \p input and appends the result to \p output.
+ *
+ * \param[in] input  The chunk of data to decode.
+ * \param[in,out] output  The string where the decoded data gets appended.
+ */
+void quoted_printable_decoder::decode(std::span<char const> input, std::string & output)
+{
+    char const * s(input.data());
+    char const * const end(s + input.size());
+    while(s < end)
+    {
+        switch(f_state)
+        {
+        case state_t::STATE_DATA:
             {
-                return c - '0';
+                char const * equal(static_cast<char const *>(memchr(s, '=', static_cast<std::size_t>(end - s))));
+                if(equal == nullptr)
+                {
+                    output.append(s, end);
+                    return;
+                }
+                output.append(s, equal);
+                s = equal + 1;
+                f_state = state_t::STATE_EQUAL;
             }
-            // note that the documentation clearly says that only capitalized
-            // (A-F) characters are acceptable...
-            if(c >= 'a' && c <= 'f')
+            break;
+
+        case state_t::STATE_EQUAL:
+            // all equal must be followed by a newline (soft line break)
+            // or 2 hex digits
+            if(*s == '\r')
             {
-                return c - 'a' + 10;
+                f_state = state_t::STATE_SOFT_CR;
             }
-            if(c >= 'A' && c <= 'F')
+            else if(*s == '\n')
             {
-                return c - 'A' + 10;
+                f_state = state_t::STATE_DATA;
             }
-            return -1;
-        }
-
-        int get_byte()
-        {
-            for(;;)
+            else
             {
-                if(*f_str == '\0')
+                f_high = from_hex(*s);
+                if(f_high == -1)
                 {
-                    return '\0';
+                    output += '?';
+                    f_state = state_t::STATE_DATA;
                 }
-                if(*f_str == '=')
+                else
                 {
-                    if(f_str[1] == '\r')
-                    {
-                        if(f_str[2] == '\n')
-                        {
-                            f_str += 3;
-                        }
-                        else
-                        {
-                            f_str += 2;
-                        }
-                        continue;
-                    }
-                    if(f_str[1] == '\n')
-                    {
-                        f_str += 2;
-                        continue;
-                    }
+                    f_state = state_t::STATE_HEX;
                 }
-                return *f_str++;
             }
-        }
+            ++s;
+            break;
 
-        int getc()
-        {
-            int c(get_byte());
-            if(c == '\0')
-            {
-                return '\0';
-            }
-            if(c == '=')
+        case state_t::STATE_HEX:
             {
-                // all equal must be followed by a newline (taken care
-                // off already) or a 2 hex digits
-                c = get_byte();
-                int const p(from_hex(c));
-                if(p == -1)
+                int const low(from_hex(*s));
+                ++s;
+                if(low == -1)
                 {
-                    return '?';
+                    output += '?';
                 }
-                c = get_byte();
-                int const q(from_hex(c));
-                if(q == -1)
+                else
                 {
-                    return '?';
+                    output += static_cast<char>(f_high * 16 + low);
                 }
-                return p * 16 + q;
+                f_state = state_t::STATE_DATA;
             }
-            return c;
-        }
+            break;
 
-        void process()
-        {
-            for(int c(getc()); c != '\0'; c = getc())
+        case state_t::STATE_SOFT_CR:
+            if(*s == '\n')
             {
-                f_result += static_cast<char>(c);
+                ++s;
             }
-        }
+            f_state = state_t::STATE_DATA;
+            break;
 
-        std::string get_result() const
-        {
-            return f_result;
         }
+    }
+}
 
-    private:
-        std::string     f_input = std::string();
-        std::string     f_result = std::string();
-        char const *    f_str = nullptr;
-    };
 
-    result r(input);
-    r.process();
-    return r.get_result();
+/** \brief Terminate the decoding.
+ *
+ * If the input ended in the middle of an escape sequence, this function
+ * appends a question mark to \p output. The decoder is then reset so it
+ * can be reused.
+ *
+ * \param[in,out] output  The string where the decoded data gets appended.
+ */
+void quoted_printable_decoder::finish(std::string & output)
+{
+    if(f_state == state_t::STATE_EQUAL
+    || f_state == state_t::STATE_HEX)
+    {
+        output += '?';
+    }
+    reset();
+}
+
+
+/** \brief Reset the decoder.
+ *
+ * Any partial escape sequence is dropped.
+ */
+void quoted_printable_decoder::reset()
+{
+    f_state = state_t::STATE_DATA;
+    f_high = 0;
 }
 
 
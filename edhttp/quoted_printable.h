@@ -17,8 +17,10 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
-// C
+// C++
 //
+#include    <cstdint>
+#include    <span>
 #include    <string>
 
 
@@ -36,6 +38,55 @@ std::string quoted_printable_encode(std::string const & text, int flags = 0);
 std::string quoted_printable_decode(std::string const & text);
 
 
+class quoted_printable_encoder
+{
+public:
+                        quoted_printable_encoder(int flags = 0);
+
+    int                 get_flags() const;
+    void                encode(std::span<char const> input, std::string & output);
+    void                finish(std::string & output);
+    void                reset();
+
+private:
+    void                add_break(std::string & output);
+    void                add_hex(std::string & output, std::uint8_t c);
+    void                add_hex_run(std::string & output, char const * s, std::size_t size);
+    void                add_newline(std::string & output);
+    void                add_run(std::string & output, char const * s, std::size_t size);
+    void                flush_pending(std::string & output);
+    void                add_char(std::string & output, char c);
+
+    int                 f_flags = 0;
+    bool                f_safe[256] = {};
+    std::size_t         f_line = 0;
+    char                f_whitespace = '\0';  // space or tab not yet written
+    bool                f_period = false;     // lone period candidate not yet written
+    bool                f_cr = false;         // last byte was a '\r'
+};
+
+
+class quoted_printable_decoder
+{
+public:
+    void                decode(std::span<char const> input, std::string & output);
+    void                finish(std::string & output);
+    void                reset();
+
+private:
+    enum class state_t
+    {
+        STATE_DATA,
+        STATE_EQUAL,
+        STATE_HEX,
+        STATE_SOFT_CR
+    };
+
+    state_t             f_state = state_t::STATE_DATA;
+    int                 f_high = 0;
+};
+
+
 
 } // namespace edhttp
 // vim: ts=4 sw=4 et
@@ -0,0 +1,893 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Signed and encrypted session cookies.
+ *
+ * The session_cookie class encodes a payload (i.e. a session identifier
+ * and a few flags) in a cookie value which the server can verify without
+ * looking anything up in a session store. The value is either signed
+ * with HMAC-SHA256 or encrypted with AES-256-GCM.
+ *
+ * The decoded token looks like this:
+ *
+ * \code
+ *     +-----------+--------+-----------------+-----------------------+
+ *     | algorithm | key id | issued (64 bit) | payload and signature |
+ *     +-----------+--------+-----------------+-----------------------+
+ * \endcode
+ *
+ * With HMAC-SHA256, the payload is followed by the 32 byte signature of
+ * everything before it. With AES-256-GCM, the payload is replaced by
+ * a 12 byte nonce, the encrypted payload and the 16 byte tag; the first
+ * 10 bytes are authenticated as additional data. The token is then
+ * encoded with the base64url alphabet, without padding, so it only
+ * uses valid cookie-octet characters.
+ *
+ * The key identifier makes it possible to rotate the keys: new cookies
+ * get signed with the current key while cookies signed with the previous
+ * keys remain valid until those keys get removed.
+ *
+ * The AES-256-GCM nonces are 96 random bits. To keep the probability
+ * of a nonce collision (which would break GCM) negligible, a key must
+ * not be used to encrypt more than about 2^32 cookies. Rotate the keys
+ * well before reaching that many cookies.
+ *
+ * A token is accepted from its creation time minus the clock skew up
+ * to its creation time plus max-age. This is the only replay window:
+ * browsers send the same session cookie with every request so a token
+ * is expected to be used many times and no record of the tokens already
+ * seen is kept. Keep max-age short and re-issue the cookie to limit the
+ * time a stolen cookie can be used.
+ */
+
+// self
+//
+#include    "edhttp/session_cookie.h"
+
+#include    "edhttp/base64.h"
+#include    "edhttp/exception.h"
+
+
+// C++
+//
+#include    <atomic>
+#include    <cstring>
+
+
+// OpenSSL
+//
+#include    <openssl/crypto.h>
+#include    <openssl/evp.h>
+#include    <openssl/rand.h>
+
+
+// C
+//
+#include    <time.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+constexpr std::size_t const     HEADER_SIZE = 1 + 1 + 8;
+constexpr std::size_t const     HMAC_SIZE = 32;
+constexpr std::size_t const     SHA256_BLOCK_SIZE = 64;
+constexpr std::size_t const     GCM_NONCE_SIZE = 12;
+constexpr std::size_t const     GCM_TAG_SIZE = 16;
+constexpr std::size_t const     AES_KEY_SIZE = 32;
+
+
+// the generations are unique within the process so a codec allocated
+// where a deleted codec was does not match the cache of the old one
+//
+std::atomic<std::uint64_t>      g_next_generation(1);
+
+
+std::uint64_t next_generation()
+{
+    return g_next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void write_int64(unsigned char * out, std::int64_t value)
+{
+    std::uint64_t const v(static_cast<std::uint64_t>(value));
+    for(int idx(0); idx < 8; ++idx)
+    {
+        out[idx] = static_cast<unsigned char>(v >> (56 - idx * 8));
+    }
+}
+
+
+std::int64_t read_int64(unsigned char const * in)
+{
+    std::uint64_t v(0);
+    for(int idx(0); idx < 8; ++idx)
+    {
+        v = (v << 8) | in[idx];
+    }
+    return static_cast<std::int64_t>(v);
+}
+
+
+struct md_ctx_deleter
+{
+    void operator () (EVP_MD_CTX * ctx) const
+    {
+        EVP_MD_CTX_free(ctx);
+    }
+};
+
+
+struct cipher_ctx_deleter
+{
+    void operator () (EVP_CIPHER_CTX * ctx) const
+    {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+};
+
+
+typedef std::unique_ptr<EVP_MD_CTX, md_ctx_deleter>         md_ctx_t;
+typedef std::unique_ptr<EVP_CIPHER_CTX, cipher_ctx_deleter> cipher_ctx_t;
+
+
+/** \brief Get the digest context of this thread.
+ *
+ * The HMAC states of the keys are copied in this context so encoding
+ * and decoding do not allocate a new context each time.
+ *
+ * \return The digest context of the calling thread.
+ */
+EVP_MD_CTX * thread_md_ctx()
+{
+    thread_local md_ctx_t ctx(EVP_MD_CTX_new());
+    if(ctx == nullptr)
+    {
+        throw session_cookie_error("could not allocate a digest context.");
+    }
+    return ctx.get();
+}
+
+
+EVP_CIPHER_CTX * thread_cipher_ctx()
+{
+    thread_local cipher_ctx_t ctx(EVP_CIPHER_CTX_new());
+    if(ctx == nullptr)
+    {
+        throw session_cookie_error("could not allocate a cipher context.");
+    }
+    return ctx.get();
+}
+
+
+std::string & thread_buffer()
+{
+    thread_local std::string buffer;
+    return buffer;
+}
+
+
+/** \brief Clear the thread buffer on exit.
+ *
+ * The thread buffer holds the plain token (header, payload, signature)
+ * while encoding and decoding. This object makes sure it gets cleansed
+ * whatever the exit path, including exceptions.
+ */
+class buffer_cleanser
+{
+public:
+    buffer_cleanser(std::string & buffer)
+        : f_buffer(buffer)
+    {
+    }
+
+    buffer_cleanser(buffer_cleanser const &) = delete;
+    buffer_cleanser & operator = (buffer_cleanser const &) = delete;
+
+    ~buffer_cleanser()
+    {
+        OPENSSL_cleanse(f_buffer.data(), f_buffer.length());
+    }
+
+private:
+    std::string &   f_buffer;
+};
+
+
+void clear_payload(std::string & payload)
+{
+    OPENSSL_cleanse(payload.data(), payload.length());
+    payload.clear();
+}
+
+
+time_t get_now(time_t now)
+{
+    return now == -1 ? time(nullptr) : now;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief The data of one key.
+ *
+ * The HMAC is computed with the inner and outer digest states saved
+ * after the key blocks were hashed (RFC 2104). Computing a signature
+ * means copying those states and hashing the message, which is much
+ * faster than initializing a new HMAC each time.
+ *
+ * The AES key is derived from the secret so the same secret can be
+ * used with both algorithms.
+ */
+struct session_cookie::key_t
+{
+                        key_t(std::string_view secret);
+                        key_t(key_t const &) = delete;
+                        ~key_t();
+    key_t &             operator = (key_t const &) = delete;
+
+    void                hmac(unsigned char const * data, std::size_t size, unsigned char * digest) const;
+
+    md_ctx_t            f_inner = md_ctx_t();
+    md_ctx_t            f_outer = md_ctx_t();
+    unsigned char       f_aes_key[AES_KEY_SIZE] = {};
+};
+
+
+session_cookie::key_t::key_t(std::string_view secret)
+    : f_inner(EVP_MD_CTX_new())
+    , f_outer(EVP_MD_CTX_new())
+{
+    if(f_inner == nullptr
+    || f_outer == nullptr)
+    {
+        throw session_cookie_error("could not allocate a digest context.");
+    }
+
+    unsigned char block[SHA256_BLOCK_SIZE] = {};
+    if(secret.length() > SHA256_BLOCK_SIZE)
+    {
+        unsigned int size(0);
+        if(EVP_Digest(secret.data(), secret.length(), block, &size, EVP_sha256(), nullptr) != 1)
+        {
+            throw session_cookie_error("could not hash the session cookie secret.");
+        }
+    }
+    else
+    {
+        memcpy(block, secret.data(), secret.length());
+    }
+
+    unsigned char pad[SHA256_BLOCK_SIZE];
+    for(std::size_t idx(0); idx < SHA256_BLOCK_SIZE; ++idx)
+    {
+        pad[idx] = block[idx] ^ 0x36;
+    }
+    if(EVP_DigestInit_ex(f_inner.get(), EVP_sha256(), nullptr) != 1
+    || EVP_DigestUpdate(f_inner.get(), pad, sizeof(pad)) != 1)
+    {
+        throw session_cookie_error("could not initialize the HMAC inner state.");
+    }
+    for(std::size_t idx(0); idx < SHA256_BLOCK_SIZE; ++idx)
+    {
+        pad[idx] = block[idx] ^ 0x5C;
+    }
+    if(EVP_DigestInit_ex(f_outer.get(), EVP_sha256(), nullptr) != 1
+    || EVP_DigestUpdate(f_outer.get(), pad, sizeof(pad)) != 1)
+    {
+        throw session_cookie_error("could not initialize the HMAC outer state.");
+    }
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(pad, sizeof(pad));
+
+    char const aes_label[] = "edhttp session cookie AES-256-GCM key";
+    hmac(reinterpret_cast<unsigned char const *>(aes_label), sizeof(aes_label) - 1, f_aes_key);
+}
+
+
+session_cookie::key_t::~key_t()
+{
+    OPENSSL_cleanse(f_aes_key, sizeof(f_aes_key));
+}
+
+
+void session_cookie::key_t::hmac(unsigned char const * data, std::size_t size, unsigned char * digest) const
+{
+    EVP_MD_CTX * ctx(thread_md_ctx());
+    unsigned char inner[HMAC_SIZE];
+    if(EVP_MD_CTX_copy_ex(ctx, f_inner.get()) != 1
+    || EVP_DigestUpdate(ctx, data, size) != 1
+    || EVP_DigestFinal_ex(ctx, inner, nullptr) != 1
+    || EVP_MD_CTX_copy_ex(ctx, f_outer.get()) != 1
+    || EVP_DigestUpdate(ctx, inner, sizeof(inner)) != 1
+    || EVP_DigestFinal_ex(ctx, digest, nullptr) != 1)
+    {
+        throw session_cookie_error("could not compute the HMAC of a session cookie.");
+    }
+}
+
+
+
+/** \brief Initialize a session cookie codec.
+ *
+ * The codec has no keys by default. Add at least one key with add_key()
+ * before encoding or decoding cookies.
+ *
+ * The object is expected to be setup once and then shared between
+ * threads. The encode() and decode() functions can be called from any
+ * number of threads simultaneously, but the keys must not be changed
+ * while other threads use the codec. To rotate keys in a running server,
+ * create a new codec and swap the pointer.
+ *
+ * \param[in] algorithm  The algorithm used to protect the cookies.
+ */
+session_cookie::session_cookie(algorithm_t algorithm)
+    : f_algorithm(algorithm)
+    , f_generation(next_generation())
+{
+    if(algorithm != algorithm_t::ALGORITHM_HMAC_SHA256
+    && algorithm != algorithm_t::ALGORITHM_AES_256_GCM)
+    {
+        throw invalid_parameter("unknown session cookie algorithm.");
+    }
+}
+
+
+session_cookie::~session_cookie()
+{
+}
+
+
+/** \brief Get the algorithm used to encode the cookies.
+ *
+ * \return The algorithm passed to the constructor.
+ */
+session_cookie::algorithm_t session_cookie::get_algorithm() const
+{
+    return f_algorithm;
+}
+
+
+/** \brief Add a key.
+ *
+ * The \p id is saved in each cookie so decode() knows which key to use.
+ * The first key added becomes the current key. Adding a key with the
+ * same \p id as an existing key replaces that key.
+ *
+ * \exception invalid_parameter
+ * The secret must be at least MIN_SECRET_LENGTH bytes.
+ *
+ * \param[in] id  The identifier of the key.
+ * \param[in] secret  The random secret of this key.
+ */
+void session_cookie::add_key(std::uint8_t id, std::string_view secret)
+{
+    if(secret.length() < MIN_SECRET_LENGTH)
+    {
+        throw invalid_parameter(
+                  "a session cookie secret must be at least "
+                + std::to_string(MIN_SECRET_LENGTH)
+                + " bytes.");
+    }
+
+    f_keys[id] = std::make_shared<key_t>(secret);
+    if(!f_has_current_key)
+    {
+        f_current_key = id;
+        f_has_current_key = true;
+    }
+    f_generation = next_generation();
+}
+
+
+/** \brief Remove a key.
+ *
+ * Once removed, the cookies signed with that key are rejected with
+ * STATUS_UNKNOWN_KEY.
+ *
+ * \exception invalid_parameter
+ * The current key cannot be removed. Select another key first.
+ *
+ * \param[in] id  The identifier of the key to remove.
+ */
+void session_cookie::remove_key(std::uint8_t id)
+{
+    if(f_has_current_key && id == f_current_key)
+    {
+        throw invalid_parameter("the current session cookie key cannot be removed.");
+    }
+    f_keys[id].reset();
+    f_generation = next_generation();
+}
+
+
+/** \brief Check whether a key is defined.
+ *
+ * \param[in] id  The identifier of the key.
+ *
+ * \return true if the key was added.
+ */
+bool session_cookie::has_key(std::uint8_t id) const
+{
+    return f_keys[id] != nullptr;
+}
+
+
+/** \brief Select the key used to encode new cookies.
+ *
+ * To rotate keys, add the new key, make it current and remove the old
+ * key once all the cookies it signed have expired (i.e. after max-age
+ * seconds).
+ *
+ * \exception invalid_parameter
+ * The key must have been added with add_key().
+ *
+ * \param[in] id  The identifier of the new current key.
+ */
+void session_cookie::set_current_key(std::uint8_t id)
+{
+    if(f_keys[id] == nullptr)
+    {
+        throw invalid_parameter("session cookie key " + std::to_string(static_cast<int>(id)) + " is not defined.");
+    }
+    f_current_key = id;
+    f_has_current_key = true;
+    f_generation = next_generation();
+}
+
+
+/** \brief Get the identifier of the current key.
+ *
+ * \return The key used to encode new cookies.
+ */
+std::uint8_t session_cookie::get_current_key() const
+{
+    return f_current_key;
+}
+
+
+/** \brief Get a number which changes each time the keys change.
+ *
+ * This is used by the session_cookie_cache to know whether a cached
+ * payload is still valid. The generations come from a counter shared
+ * by all the codecs so two codecs never have the same generation, even
+ * if one gets allocated at the address of a deleted one.
+ *
+ * \return The current generation.
+ */
+std::uint64_t session_cookie::get_generation() const
+{
+    return f_generation;
+}
+
+
+/** \brief Change the lifetime of the cookies.
+ *
+ * The cookies save the time when they were created. They are considered
+ * expired \p max_age seconds later. The set_cookie() function also uses
+ * this value for the cookie expiration.
+ *
+ * \exception invalid_parameter
+ * The \p max_age must be positive.
+ *
+ * \param[in] max_age  The number of seconds a cookie remains valid.
+ */
+void session_cookie::set_max_age(time_t max_age)
+{
+    if(max_age <= 0)
+    {
+        throw invalid_parameter("the max-age of a session cookie must be positive.");
+    }
+    f_max_age = max_age;
+    f_generation = next_generation();
+}
+
+
+/** \brief Get the lifetime of the cookies.
+ *
+ * \return The number of seconds a cookie remains valid.
+ */
+time_t session_cookie::get_max_age() const
+{
+    return f_max_age;
+}
+
+
+/** \brief Set the accepted clock difference between servers.
+ *
+ * When several servers share the keys, a cookie may be created by a
+ * server with a clock slightly ahead. Such a cookie is accepted if its
+ * creation time is at most \p skew seconds in the future.
+ *
+ * \exception invalid_parameter
+ * The \p skew cannot be negative.
+ *
+ * \param[in] skew  The number of seconds of tolerance.
+ */
+void session_cookie::set_clock_skew(time_t skew)
+{
+    if(skew < 0)
+    {
+        throw invalid_parameter("the clock skew of a session cookie cannot be negative.");
+    }
+    f_clock_skew = skew;
+    f_generation = next_generation();
+}
+
+
+/** \brief Get the accepted clock difference.
+ *
+ * \return The number of seconds of tolerance.
+ */
+time_t session_cookie::get_clock_skew() const
+{
+    return f_clock_skew;
+}
+
+
+/** \brief Encode a payload.
+ *
+ * This function signs or encrypts \p payload with the current key and
+ * returns the base64url encoded result, ready to be used as the value
+ * of a cookie.
+ *
+ * Keep in mind that browsers limit cookies to about 4Kb. The token adds
+ * 42 bytes (HMAC) or 38 bytes (GCM) to the payload and base64url adds
+ * a third of the total.
+ *
+ * \exception invalid_parameter
+ * A key must be defined.
+ *
+ * \param[in] payload  The data to protect.
+ * \param[in] now  The creation time of the cookie, -1 for the current time.
+ *
+ * \return The cookie value.
+ */
+std::string session_cookie::encode(std::string_view payload, time_t now) const
+{
+    if(!f_has_current_key)
+    {
+        throw invalid_parameter("a session cookie key must be added before encoding cookies.");
+    }
+    key_t const & key(*f_keys[f_current_key]);
+
+    std::string & token(thread_buffer());
+    buffer_cleanser const cleanser(token);
+    token.resize(HEADER_SIZE);
+    unsigned char * header(reinterpret_cast<unsigned char *>(token.data()));
+    header[0] = static_cast<unsigned char>(f_algorithm);
+    header[1] = f_current_key;
+    write_int64(header + 2, get_now(now));
+
+    switch(f_algorithm)
+    {
+    case algorithm_t::ALGORITHM_HMAC_SHA256:
+        token.append(payload);
+        token.resize(token.length() + HMAC_SIZE);
+        key.hmac(
+              reinterpret_cast<unsigned char const *>(token.data())
+            , token.length() - HMAC_SIZE
+            , reinterpret_cast<unsigned char *>(token.data()) + token.length() - HMAC_SIZE);
+        break;
+
+    case algorithm_t::ALGORITHM_AES_256_GCM:
+        {
+            token.resize(HEADER_SIZE + GCM_NONCE_SIZE + payload.length() + GCM_TAG_SIZE);
+            unsigned char * const data(reinterpret_cast<unsigned char *>(token.data()));
+            unsigned char * const nonce(data + HEADER_SIZE);
+            unsigned char * const cipher(nonce + GCM_NONCE_SIZE);
+            if(RAND_bytes(nonce, GCM_NONCE_SIZE) != 1)
+            {
+                throw session_cookie_error("could not generate a session cookie nonce.");
+            }
+
+            EVP_CIPHER_CTX * ctx(thread_cipher_ctx());
+            int size(0);
+            int final_size(0);
+            if(EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.f_aes_key, nonce) != 1
+            || EVP_EncryptUpdate(ctx, nullptr, &size, data, HEADER_SIZE) != 1
+            || EVP_EncryptUpdate(
+                      ctx
+                    , cipher
+                    , &size
+                    , reinterpret_cast<unsigned char const *>(payload.data())
+                    , static_cast<int>(payload.length())) != 1
+            || EVP_EncryptFinal_ex(ctx, cipher + size, &final_size) != 1
+            || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, cipher + payload.length()) != 1)
+            {
+                throw session_cookie_error("could not encrypt a session cookie.");
+            }
+        }
+        break;
+
+    }
+
+    std::string result;
+    base64_encode(
+              std::string_view(token.data(), token.length())
+            , result
+            , base64_alphabet_t::BASE64_ALPHABET_URL
+            , BASE64_FLAG_NO_PADDING);
+    return result;
+}
+
+
+/** \brief Set the value and expiration of a cookie.
+ *
+ * This function encodes \p payload and saves the result as the value
+ * of \p cookie. The expiration of the cookie is set to the max-age of
+ * this codec. The cookie is also marked as Secure and HttpOnly since
+ * session cookies should never be sent in clear or be visible to
+ * scripts.
+ *
+ * \param[in,out] cookie  The cookie to update.
+ * \param[in] payload  The data to protect.
+ */
+void session_cookie::set_cookie(http_cookie & cookie, std::string_view payload) const
+{
+    cookie.set_value(encode(payload));
+    cookie.set_expire_in(f_max_age);
+    cookie.set_secure();
+    cookie.set_http_only();
+}
+
+
+/** \brief Verify and decode a cookie value.
+ *
+ * This function verifies the signature or decrypts the \p value of a
+ * cookie created by encode(). The signature is compared in constant
+ * time. When the function returns STATUS_VALID, \p payload is set to
+ * the data passed to encode(). Otherwise \p payload is cleared.
+ *
+ * \param[in] value  The cookie value.
+ * \param[out] payload  The decoded payload.
+ * \param[in] now  The current time, -1 to use time().
+ *
+ * \return STATUS_VALID if the cookie can be trusted, the reason why it
+ * was rejected otherwise.
+ */
+session_cookie::status_t session_cookie::decode(std::string_view value, std::string & payload, time_t now) const
+{
+    payload.clear();
+
+    std::string & token(thread_buffer());
+    buffer_cleanser const cleanser(token);
+    token.clear();
+    if(!base64_decode(value, token, base64_alphabet_t::BASE64_ALPHABET_URL, BASE64_FLAG_NO_PADDING))
+    {
+        return status_t::STATUS_MALFORMED;
+    }
+    std::size_t const overhead(HEADER_SIZE + (f_algorithm == algorithm_t::ALGORITHM_HMAC_SHA256
+                                                    ? HMAC_SIZE
+                                                    : GCM_NONCE_SIZE + GCM_TAG_SIZE));
+    unsigned char const * const data(reinterpret_cast<unsigned char const *>(token.data()));
+    if(token.length() < overhead
+    || data[0] != static_cast<unsigned char>(f_algorithm))
+    {
+        return status_t::STATUS_MALFORMED;
+    }
+    key_t const * key(f_keys[data[1]].get());
+    if(key == nullptr)
+    {
+        return status_t::STATUS_UNKNOWN_KEY;
+    }
+
+    std::size_t const size(token.length() - overhead);
+    switch(f_algorithm)
+    {
+    case algorithm_t::ALGORITHM_HMAC_SHA256:
+        {
+            unsigned char digest[HMAC_SIZE];
+            key->hmac(data, HEADER_SIZE + size, digest);
+            if(CRYPTO_memcmp(digest, data + HEADER_SIZE + size, HMAC_SIZE) != 0)
+            {
+                return status_t::STATUS_BAD_SIGNATURE;
+            }
+            payload.assign(reinterpret_cast<char const *>(data + HEADER_SIZE), size);
+        }
+        break;
+
+    case algorithm_t::ALGORITHM_AES_256_GCM:
+        {
+            unsigned char const * const nonce(data + HEADER_SIZE);
+            unsigned char const * const cipher(nonce + GCM_NONCE_SIZE);
+            payload.resize(size);
+
+            // the tag parameter is not const in the OpenSSL API
+            //
+            unsigned char tag[GCM_TAG_SIZE];
+            memcpy(tag, cipher + size, GCM_TAG_SIZE);
+
+            EVP_CIPHER_CTX * ctx(thread_cipher_ctx());
+            int out_size(0);
+            if(EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key->f_aes_key, nonce) != 1
+            || EVP_DecryptUpdate(ctx, nullptr, &out_size, data, HEADER_SIZE) != 1
+            || EVP_DecryptUpdate(
+                      ctx
+                    , reinterpret_cast<unsigned char *>(payload.data())
+                    , &out_size
+                    , cipher
+                    , static_cast<int>(size)) != 1
+            || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, tag) != 1
+            || EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char *>(payload.data()) + out_size, &out_size) != 1)
+            {
+                clear_payload(payload);
+                return status_t::STATUS_BAD_SIGNATURE;
+            }
+        }
+        break;
+
+    }
+
+    // only trust the time once the signature was verified
+    //
+    now = get_now(now);
+    std::int64_t const issued(read_int64(data + 2));
+    if(issued > now + f_clock_skew)
+    {
+        clear_payload(payload);
+        return status_t::STATUS_NOT_YET_VALID;
+    }
+    if(now - issued >= f_max_age)
+    {
+        clear_payload(payload);
+        return status_t::STATUS_EXPIRED;
+    }
+
+    return status_t::STATUS_VALID;
+}
+
+
+/** \brief Get the time when a cookie expires.
+ *
+ * This function reads the creation time of the cookie and adds the
+ * max-age. The cookie is not verified so the result must only be used
+ * with a cookie that decode() accepted.
+ *
+ * \param[in] value  The cookie value.
+ *
+ * \return The expiration time or -1 if \p value is not a valid token.
+ */
+time_t session_cookie::get_expire(std::string_view value) const
+{
+    // the header is 10 bytes, the first 16 characters are enough
+    //
+    std::string header;
+    if(value.length() < 16
+    || !base64_decode(value.substr(0, 16), header, base64_alphabet_t::BASE64_ALPHABET_URL, BASE64_FLAG_NO_PADDING)
+    || header.length() < HEADER_SIZE)
+    {
+        return -1;
+    }
+    return read_int64(reinterpret_cast<unsigned char const *>(header.data()) + 2) + f_max_age;
+}
+
+
+
+/** \brief Decode a session cookie unless it was already verified.
+ *
+ * A connection object keeps one of these caches. Browsers send the same
+ * session cookie with each request so in most cases only the first
+ * request of a connection needs to verify the signature. The following
+ * requests compare the value against the cached one and reuse the
+ * payload as long as the cookie did not expire and \p codec is the codec
+ * which verified it with the same keys (see session_cookie::get_generation()).
+ *
+ * Only valid cookies are cached.
+ *
+ * \param[in] codec  The codec used to verify the cookie.
+ * \param[in] value  The value of the session cookie.
+ * \param[in] now  The current time, -1 to use time().
+ *
+ * \return The decoding status. The payload is available with
+ * get_payload() when the status is STATUS_VALID.
+ */
+session_cookie::status_t session_cookie_cache::decode(session_cookie const & codec, std::string_view value, time_t now)
+{
+    now = get_now(now);
+    if(f_generation == codec.get_generation()
+    && now < f_expire
+    && f_value == value)
+    {
+        ++f_hits;
+        return session_cookie::status_t::STATUS_VALID;
+    }
+
+    ++f_misses;
+    session_cookie::status_t const status(codec.decode(value, f_payload, now));
+    if(status == session_cookie::status_t::STATUS_VALID)
+    {
+        f_generation = codec.get_generation();
+        f_value = value;
+        f_expire = codec.get_expire(value);
+    }
+    else
+    {
+        f_generation = 0;
+        f_value.clear();
+    }
+    return status;
+}
+
+
+/** \brief Get the payload of the last valid cookie.
+ *
+ * \return The payload returned by the last successful decode().
+ */
+std::string const & session_cookie_cache::get_payload() const
+{
+    return f_payload;
+}
+
+
+/** \brief Forget about the cached cookie.
+ *
+ * Call this function when the session gets closed so the payload does
+ * not remain in memory.
+ */
+void session_cookie_cache::clear()
+{
+    f_generation = 0;
+    f_value.clear();
+    OPENSSL_cleanse(f_payload.data(), f_payload.length());
+    f_payload.clear();
+    f_expire = 0;
+}
+
+
+/** \brief Get the number of times the cached payload was reused.
+ *
+ * \return The number of decode() calls which did not verify the cookie.
+ */
+std::uint64_t session_cookie_cache::get_hits() const
+{
+    return f_hits;
+}
+
+
+/** \brief Get the number of times a cookie had to be verified.
+ *
+ * \return The number of decode() calls which verified the cookie.
+ */
+std::uint64_t session_cookie_cache::get_misses() const
+{
+    return f_misses;
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,125 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/http_cookie.h>
+
+
+// C++
+//
+#include    <array>
+#include    <cstdint>
+#include    <memory>
+#include    <string>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+class session_cookie
+{
+public:
+    typedef std::shared_ptr<session_cookie>     pointer_t;
+
+    static constexpr std::size_t    MIN_SECRET_LENGTH = 32;
+    static constexpr time_t         DEFAULT_MAX_AGE = 86400;
+    static constexpr time_t         DEFAULT_CLOCK_SKEW = 60;
+
+    enum class algorithm_t : std::uint8_t
+    {
+        ALGORITHM_HMAC_SHA256 = 1,      // signed, payload visible
+        ALGORITHM_AES_256_GCM = 2       // encrypted and authenticated
+    };
+
+    enum class status_t
+    {
+        STATUS_VALID,
+        STATUS_MALFORMED,
+        STATUS_UNKNOWN_KEY,
+        STATUS_BAD_SIGNATURE,
+        STATUS_EXPIRED,
+        STATUS_NOT_YET_VALID
+    };
+
+                        session_cookie(algorithm_t algorithm = algorithm_t::ALGORITHM_HMAC_SHA256);
+                        session_cookie(session_cookie const &) = delete;
+                        ~session_cookie();
+    session_cookie &    operator = (session_cookie const &) = delete;
+
+    algorithm_t         get_algorithm() const;
+    void                add_key(std::uint8_t id, std::string_view secret);
+    void                remove_key(std::uint8_t id);
+    bool                has_key(std::uint8_t id) const;
+    void                set_current_key(std::uint8_t id);
+    std::uint8_t        get_current_key() const;
+    std::uint64_t       get_generation() const;
+
+    void                set_max_age(time_t max_age);
+    time_t              get_max_age() const;
+    void                set_clock_skew(time_t skew);
+    time_t              get_clock_skew() const;
+
+    std::string         encode(std::string_view payload, time_t now = -1) const;
+    void                set_cookie(http_cookie & cookie, std::string_view payload) const;
+    status_t            decode(std::string_view value, std::string & payload, time_t now = -1) const;
+    time_t              get_expire(std::string_view value) const;
+
+private:
+    struct key_t;
+
+    algorithm_t         f_algorithm = algorithm_t::ALGORITHM_HMAC_SHA256;
+    std::array<std::shared_ptr<key_t>, 256>
+                        f_keys = std::array<std::shared_ptr<key_t>, 256>();
+    std::uint8_t        f_current_key = 0;
+    bool                f_has_current_key = false;
+    std::uint64_t       f_generation = 0;
+    time_t              f_max_age = DEFAULT_MAX_AGE;
+    time_t              f_clock_skew = DEFAULT_CLOCK_SKEW;
+};
+
+
+class session_cookie_cache
+{
+public:
+    session_cookie::status_t
+                        decode(session_cookie const & codec, std::string_view value, time_t now = -1);
+    std::string const & get_payload() const;
+    void                clear();
+
+    std::uint64_t       get_hits() const;
+    std::uint64_t       get_misses() const;
+
+private:
+    std::uint64_t       f_generation = 0;
+    std::string         f_value = std::string();
+    std::string         f_payload = std::string();
+    time_t              f_expire = 0;
+    std::uint64_t       f_hits = 0;
+    std::uint64_t       f_misses = 0;
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
@@ -0,0 +1,1122 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Structured Field Values for HTTP (RFC 8941).
+ *
+ * Many modern HTTP headers (Priority, Cache-Status, Client Hints,
+ * Signature, etc.) are defined as Structured Fields. This file
+ * implements a parser and a serializer for such fields.
+ *
+ * The parser does not copy the input. Keys, tokens, strings, and byte
+ * sequences are kept as views in the input buffer which must remain
+ * valid as long as the structured_field object is used. The nodes are
+ * saved in small inline arrays so parsing a common header does not
+ * allocate memory.
+ */
+
+// self
+//
+#include    "edhttp/structured_field.h"
+
+#include    "edhttp/base64.h"
+#include    "edhttp/exception.h"
+#include    "edhttp/token.h"
+
+
+// C++
+//
+#include    <cmath>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace edhttp
+{
+
+
+
+namespace
+{
+
+
+
+bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+
+bool is_lcalpha(char c)
+{
+    return c >= 'a' && c <= 'z';
+}
+
+
+bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z')
+        || (c >= 'A' && c <= 'Z');
+}
+
+
+bool is_key_char(char c)
+{
+    return is_lcalpha(c)
+        || is_digit(c)
+        || c == '_'
+        || c == '-'
+        || c == '.'
+        || c == '*';
+}
+
+
+void skip_sp(char const * & s, char const * end)
+{
+    while(s < end && *s == ' ')
+    {
+        ++s;
+    }
+}
+
+
+void skip_ows(char const * & s, char const * end)
+{
+    while(s < end && (*s == ' ' || *s == '\t'))
+    {
+        ++s;
+    }
+}
+
+
+bool parse_key(char const * & s, char const * end, std::string_view & key)
+{
+    if(s >= end
+    || (!is_lcalpha(*s) && *s != '*'))
+    {
+        return false;
+    }
+    char const * const start(s);
+    do
+    {
+        ++s;
+    }
+    while(s < end && is_key_char(*s));
+    key = std::string_view(start, s - start);
+    return true;
+}
+
+
+std::size_t scan_sf_token(std::string_view s)
+{
+    // sf-token = ( ALPHA / "*" ) *( tchar / ":" / "/" )
+    //
+    std::size_t pos(0);
+    for(;;)
+    {
+        pos += scan_token(s.substr(pos));
+        if(pos >= s.length()
+        || (s[pos] != ':' && s[pos] != '/'))
+        {
+            return pos;
+        }
+        ++pos;
+    }
+}
+
+
+void append_thousandths(std::string & out, std::int64_t value)
+{
+    if(value < 0)
+    {
+        out += '-';
+        value = -value;
+    }
+    out += std::to_string(value / 1000);
+    out += '.';
+    int fraction(static_cast<int>(value % 1000));
+    out += static_cast<char>(fraction / 100 + '0');
+    fraction = fraction % 100;
+    if(fraction != 0)
+    {
+        out += static_cast<char>(fraction / 10 + '0');
+        fraction = fraction % 10;
+        if(fraction != 0)
+        {
+            out += static_cast<char>(fraction + '0');
+        }
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Get the string value of a String item.
+ *
+ * The f_value field of a String item is a view of the input with
+ * the escape sequences still present. This function returns the
+ * string with the escape sequences removed.
+ *
+ * \return The unescaped string.
+ */
+std::string structured_field::item_t::get_string() const
+{
+    if(!f_escaped)
+    {
+        return std::string(f_value);
+    }
+
+    std::string result;
+    result.reserve(f_value.length());
+    for(std::size_t idx(0); idx < f_value.length(); ++idx)
+    {
+        if(f_value[idx] == '\\')
+        {
+            ++idx;
+        }
+        result += f_value[idx];
+    }
+    return result;
+}
+
+
+/** \brief Get the decoded bytes of a Byte Sequence item.
+ *
+ * The f_value field of a Byte Sequence item is the base64 string as
+ * found in the input. This function returns the decoded bytes.
+ *
+ * \return The decoded bytes.
+ */
+std::string structured_field::item_t::get_byte_sequence() const
+{
+    // the parser already verified the characters; as allowed by RFC 8941,
+    // bad padding and non-zero pad bits are accepted
+    //
+    std::string result;
+    base64_decode(f_value, result, base64_alphabet_t::BASE64_ALPHABET_STANDARD, BASE64_FLAG_IGNORE_INVALID);
+    return result;
+}
+
+
+/** \brief Get the value of a Decimal item as a double.
+ *
+ * Decimals are saved in thousandths in f_integer so the value gets
+ * serialized back exactly. This function converts that value to a
+ * double.
+ *
+ * \return The decimal value.
+ */
+double structured_field::item_t::get_decimal() const
+{
+    return static_cast<double>(f_integer) / 1000.0;
+}
+
+
+/** \brief Get the value of a Boolean item.
+ *
+ * \return true if the item represents true (`?1`).
+ */
+bool structured_field::item_t::get_boolean() const
+{
+    return f_integer != 0;
+}
+
+
+/** \brief Initialize an empty structured field.
+ *
+ * The field is an empty Item. Use the parse() function to parse a
+ * field value.
+ */
+structured_field::structured_field()
+{
+}
+
+
+/** \brief Initialize a structured field by parsing \p field.
+ *
+ * This constructor calls parse(). If the field is invalid, the object
+ * is left empty.
+ *
+ * \param[in] field  The field value to parse.
+ * \param[in] type  The type of the field (Item, List, or Dictionary).
+ */
+structured_field::structured_field(std::string_view field, field_type_t type)
+{
+    parse(field, type);
+}
+
+
+/** \brief Parse a structured field value.
+ *
+ * This function parses \p field as defined in RFC 8941 section 4.2.
+ * The type of a field is not defined in the field itself, it is
+ * defined by the specification of each header so it has to be
+ * specified here.
+ *
+ * The parser keeps views in \p field. The buffer has to stay valid
+ * as long as this object is used.
+ *
+ * \param[in] field  The field value to parse.
+ * \param[in] type  The type of the field (Item, List, or Dictionary).
+ *
+ * \return true if the field was valid. On an error, the object is
+ * cleared.
+ */
+bool structured_field::parse(std::string_view field, field_type_t type)
+{
+    clear();
+    f_field_type = type;
+
+    char const * s(field.data());
+    char const * end(s + field.length());
+    skip_sp(s, end);
+    while(end > s && end[-1] == ' ')
+    {
+        --end;
+    }
+
+    bool valid(true);
+    switch(type)
+    {
+    case field_type_t::FIELD_TYPE_ITEM:
+        {
+            item_t item;
+            valid = parse_item(s, end, item);
+            if(valid)
+            {
+                f_items.push_back(item);
+                f_members.push_back(0);
+            }
+        }
+        break;
+
+    case field_type_t::FIELD_TYPE_LIST:
+    case field_type_t::FIELD_TYPE_DICTIONARY:
+        while(s < end)
+        {
+            if(type == field_type_t::FIELD_TYPE_LIST)
+            {
+                valid = parse_member(s, end, std::string_view());
+            }
+            else
+            {
+                std::string_view key;
+                valid = parse_key(s, end, key);
+                if(valid)
+                {
+                    if(s < end && *s == '=')
+                    {
+                        ++s;
+                        valid = parse_member(s, end, key);
+                    }
+                    else
+                    {
+                        item_t member;
+                        member.f_key = key;
+                        member.f_type = item_type_t::ITEM_TYPE_BOOLEAN;
+                        member.f_integer = 1;
+                        valid = parse_params(s, end, member);
+                        if(valid)
+                        {
+                            f_items.push_back(member);
+                            add_member(f_items.size() - 1);
+                        }
+                    }
+                }
+            }
+            if(!valid)
+            {
+                break;
+            }
+            skip_ows(s, end);
+            if(s >= end)
+            {
+                break;
+            }
+            if(*s != ',')
+            {
+                valid = false;
+                break;
+            }
+            ++s;
+            skip_ows(s, end);
+            if(s >= end)
+            {
+                // trailing comma
+                //
+                valid = false;
+                break;
+            }
+        }
+        break;
+
+    }
+
+    if(!valid || s != end)
+    {
+        clear();
+        f_field_type = type;
+        return false;
+    }
+
+    return true;
+}
+
+
+/** \brief Clear the structured field.
+ *
+ * The memory used by items which did not fit in the inline arrays
+ * is released.
+ */
+void structured_field::clear()
+{
+    f_members.clear();
+    f_items.clear();
+    f_params.clear();
+}
+
+
+/** \brief Get the type of field.
+ *
+ * \return The type specified on the last call to parse().
+ */
+structured_field::field_type_t structured_field::get_field_type() const
+{
+    return f_field_type;
+}
+
+
+/** \brief Get the number of members.
+ *
+ * For an Item, this is 1 once a valid field was parsed. For a List or
+ * a Dictionary, this is the number of members.
+ *
+ * \return The number of members.
+ */
+std::size_t structured_field::size() const
+{
+    return f_members.size();
+}
+
+
+/** \brief Check whether the field has no members.
+ *
+ * \return true if the field is empty.
+ */
+bool structured_field::empty() const
+{
+    return f_members.size() == 0;
+}
+
+
+/** \brief Get a member.
+ *
+ * For an Item field, use index 0. The member may be an inner list.
+ *
+ * \exception out_of_range
+ * The index must be smaller than size().
+ *
+ * \param[in] idx  The index of the member.
+ *
+ * \return A reference to the member.
+ */
+structured_field::item_t const & structured_field::get_member(std::size_t idx) const
+{
+    if(idx >= f_members.size())
+    {
+        throw out_of_range("structured field member index out of range.");
+    }
+    return f_items[f_members[idx]];
+}
+
+
+/** \brief Search a Dictionary member by key.
+ *
+ * \param[in] key  The key of the member to search.
+ *
+ * \return A pointer to the member or nullptr if not found.
+ */
+structured_field::item_t const * structured_field::find_member(std::string_view key) const
+{
+    for(std::size_t idx(0); idx < f_members.size(); ++idx)
+    {
+        item_t const & member(f_items[f_members[idx]]);
+        if(member.f_key == key)
+        {
+            return &member;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Get an item of an inner list.
+ *
+ * \exception invalid_parameter
+ * The \p inner_list parameter must be an inner list.
+ *
+ * \exception out_of_range
+ * The index must be smaller than the size of the inner list, which is
+ * saved in the f_integer field.
+ *
+ * \param[in] inner_list  The inner list member.
+ * \param[in] idx  The index of the item in the inner list.
+ *
+ * \return A reference to the item.
+ */
+structured_field::item_t const & structured_field::get_inner_item(item_t const & inner_list, std::size_t idx) const
+{
+    if(inner_list.f_type != item_type_t::ITEM_TYPE_INNER_LIST)
+    {
+        throw invalid_parameter("get_inner_item() called with an item which is not an inner list.");
+    }
+    if(idx >= static_cast<std::size_t>(inner_list.f_integer))
+    {
+        throw out_of_range("structured field inner list index out of range.");
+    }
+    return f_items[inner_list.f_item_start + idx];
+}
+
+
+/** \brief Get a parameter of an item or inner list.
+ *
+ * \exception out_of_range
+ * The index must be smaller than the f_param_count of \p item.
+ *
+ * \param[in] item  The item with parameters.
+ * \param[in] idx  The index of the parameter.
+ *
+ * \return A reference to the parameter.
+ */
+structured_field::item_t const & structured_field::get_param(item_t const & item, std::size_t idx) const
+{
+    if(idx >= item.f_param_count)
+    {
+        throw out_of_range("structured field parameter index out of range.");
+    }
+    return f_params[item.f_param_start + idx];
+}
+
+
+/** \brief Search a parameter by key.
+ *
+ * \param[in] item  The item with parameters.
+ * \param[in] key  The key of the parameter to search.
+ *
+ * \return A pointer to the parameter or nullptr if not found.
+ */
+structured_field::item_t const * structured_field::find_param(item_t const & item, std::string_view key) const
+{
+    for(std::uint32_t idx(0); idx < item.f_param_count; ++idx)
+    {
+        item_t const & param(f_params[item.f_param_start + idx]);
+        if(param.f_key == key)
+        {
+            return &param;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Serialize the field.
+ *
+ * This function appends the canonical serialization of the field
+ * to \p out (RFC 8941 section 4.1).
+ *
+ * \param[in,out] out  The string where the field gets appended.
+ */
+void structured_field::serialize(std::string & out) const
+{
+    switch(f_field_type)
+    {
+    case field_type_t::FIELD_TYPE_ITEM:
+        if(f_members.size() > 0)
+        {
+            serialize_item(out, f_items[f_members[0]]);
+        }
+        break;
+
+    case field_type_t::FIELD_TYPE_LIST:
+        for(std::size_t idx(0); idx < f_members.size(); ++idx)
+        {
+            if(idx != 0)
+            {
+                out += ", ";
+            }
+            serialize_item(out, f_items[f_members[idx]]);
+        }
+        break;
+
+    case field_type_t::FIELD_TYPE_DICTIONARY:
+        for(std::size_t idx(0); idx < f_members.size(); ++idx)
+        {
+            if(idx != 0)
+            {
+                out += ", ";
+            }
+            item_t const & member(f_items[f_members[idx]]);
+            out += member.f_key;
+            if(member.f_type == item_type_t::ITEM_TYPE_BOOLEAN
+            && member.f_integer != 0)
+            {
+                serialize_params(out, member);
+            }
+            else
+            {
+                out += '=';
+                serialize_item(out, member);
+            }
+        }
+        break;
+
+    }
+}
+
+
+/** \brief Serialize the field in a new string.
+ *
+ * \return The canonical serialization of the field.
+ */
+std::string structured_field::to_string() const
+{
+    std::string result;
+    serialize(result);
+    return result;
+}
+
+
+/** \brief Serialize an Integer.
+ *
+ * \exception invalid_parameter
+ * The integer must be between -999,999,999,999,999 and
+ * 999,999,999,999,999 inclusive.
+ *
+ * \param[in,out] out  The string where the integer gets appended.
+ * \param[in] value  The integer to serialize.
+ */
+void structured_field::serialize_integer(std::string & out, std::int64_t value)
+{
+    if(value < -MAX_INTEGER || value > MAX_INTEGER)
+    {
+        throw invalid_parameter("structured field integer out of range.");
+    }
+    out += std::to_string(value);
+}
+
+
+/** \brief Serialize a Decimal.
+ *
+ * The value is rounded to three decimal digits (ties to even).
+ *
+ * \exception invalid_parameter
+ * The integer part of the decimal must have at most 12 digits.
+ *
+ * \param[in,out] out  The string where the decimal gets appended.
+ * \param[in] value  The decimal to serialize.
+ */
+void structured_field::serialize_decimal(std::string & out, double value)
+{
+    double const thousandths(std::nearbyint(value * 1000.0));
+    if(!(std::fabs(thousandths) <= static_cast<double>(MAX_DECIMAL)))
+    {
+        throw invalid_parameter("structured field decimal out of range.");
+    }
+    append_thousandths(out, static_cast<std::int64_t>(thousandths));
+}
+
+
+/** \brief Serialize a String.
+ *
+ * \exception invalid_parameter
+ * Strings are limited to printable ASCII characters.
+ *
+ * \param[in,out] out  The string where the quoted string gets appended.
+ * \param[in] value  The string to serialize.
+ */
+void structured_field::serialize_string(std::string & out, std::string_view value)
+{
+    out += '"';
+    for(auto const c : value)
+    {
+        if(c < 0x20 || c > 0x7E)
+        {
+            throw invalid_parameter("structured field strings are limited to printable ASCII characters.");
+        }
+        if(c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+
+/** \brief Serialize a Token.
+ *
+ * \exception invalid_parameter
+ * The token must start with a letter or '*' and be followed by token
+ * characters, ':' or '/'.
+ *
+ * \param[in,out] out  The string where the token gets appended.
+ * \param[in] value  The token to serialize.
+ */
+void structured_field::serialize_token(std::string & out, std::string_view value)
+{
+    if(value.empty()
+    || (!is_alpha(value[0]) && value[0] != '*')
+    || scan_sf_token(value) != value.length())
+    {
+        throw invalid_parameter("invalid structured field token.");
+    }
+    out += value;
+}
+
+
+/** \brief Serialize a Byte Sequence.
+ *
+ * \param[in,out] out  The string where the byte sequence gets appended.
+ * \param[in] value  The bytes to serialize.
+ */
+void structured_field::serialize_byte_sequence(std::string & out, std::string_view value)
+{
+    out += ':';
+    base64_encode(value, out);
+    out += ':';
+}
+
+
+/** \brief Serialize a Boolean.
+ *
+ * \param[in,out] out  The string where the boolean gets appended.
+ * \param[in] value  The boolean to serialize.
+ */
+void structured_field::serialize_boolean(std::string & out, bool value)
+{
+    out += value ? "?1" : "?0";
+}
+
+
+/** \brief Serialize a Key.
+ *
+ * \exception invalid_parameter
+ * The key must start with a lowercase letter or '*' and be followed by
+ * lowercase letters, digits, '_', '-', '.' or '*'.
+ *
+ * \param[in,out] out  The string where the key gets appended.
+ * \param[in] key  The key to serialize.
+ */
+void structured_field::serialize_key(std::string & out, std::string_view key)
+{
+    char const * s(key.data());
+    std::string_view found;
+    if(!parse_key(s, key.data() + key.length(), found)
+    || found.length() != key.length())
+    {
+        throw invalid_parameter("invalid structured field key.");
+    }
+    out += key;
+}
+
+
+void structured_field::add_member(std::uint32_t index)
+{
+    // dictionary keys are unique; a duplicate overwrites the value
+    // but keeps the position of the first occurrence
+    //
+    std::string_view const key(f_items[index].f_key);
+    if(!key.empty())
+    {
+        for(std::size_t idx(0); idx < f_members.size(); ++idx)
+        {
+            if(f_items[f_members[idx]].f_key == key)
+            {
+                f_members[idx] = index;
+                return;
+            }
+        }
+    }
+    f_members.push_back(index);
+}
+
+
+bool structured_field::parse_member(char const * & s, char const * end, std::string_view key)
+{
+    std::uint32_t const index(static_cast<std::uint32_t>(f_items.size()));
+    item_t member;
+    member.f_key = key;
+    if(s < end && *s == '(')
+    {
+        ++s;
+        member.f_type = item_type_t::ITEM_TYPE_INNER_LIST;
+        member.f_item_start = index + 1;
+        f_items.push_back(member);
+        for(;;)
+        {
+            skip_sp(s, end);
+            if(s >= end)
+            {
+                return false;
+            }
+            if(*s == ')')
+            {
+                ++s;
+                break;
+            }
+            item_t item;
+            if(!parse_item(s, end, item))
+            {
+                return false;
+            }
+            f_items.push_back(item);
+            ++member.f_integer;
+            if(s >= end
+            || (*s != ' ' && *s != ')'))
+            {
+                return false;
+            }
+        }
+        if(!parse_params(s, end, member))
+        {
+            return false;
+        }
+        f_items[index] = member;
+    }
+    else
+    {
+        if(!parse_item(s, end, member))
+        {
+            return false;
+        }
+        f_items.push_back(member);
+    }
+
+    add_member(index);
+    return true;
+}
+
+
+bool structured_field::parse_item(char const * & s, char const * end, item_t & item)
+{
+    return parse_bare_item(s, end, item)
+        && parse_params(s, end, item);
+}
+
+
+bool structured_field::parse_bare_item(char const * & s, char const * end, item_t & item)
+{
+    if(s >= end)
+    {
+        return false;
+    }
+
+    if(*s == '-' || is_digit(*s))
+    {
+        bool const negative(*s == '-');
+        if(negative)
+        {
+            ++s;
+        }
+        if(s >= end || !is_digit(*s))
+        {
+            return false;
+        }
+        std::int64_t integer(0);
+        int digits(0);
+        while(s < end && is_digit(*s))
+        {
+            ++digits;
+            if(digits > 15)
+            {
+                return false;
+            }
+            integer = integer * 10 + (*s - '0');
+            ++s;
+        }
+        if(s < end && *s == '.')
+        {
+            if(digits > 12)
+            {
+                return false;
+            }
+            ++s;
+            int fraction_digits(0);
+            while(s < end && is_digit(*s))
+            {
+                ++fraction_digits;
+                if(fraction_digits > 3)
+                {
+                    return false;
+                }
+                integer = integer * 10 + (*s - '0');
+                ++s;
+            }
+            if(fraction_digits == 0)
+            {
+                return false;
+            }
+            for(; fraction_digits < 3; ++fraction_digits)
+            {
+                integer *= 10;
+            }
+            item.f_type = item_type_t::ITEM_TYPE_DECIMAL;
+        }
+        else
+        {
+            item.f_type = item_type_t::ITEM_TYPE_INTEGER;
+        }
+        item.f_integer = negative ? -integer : integer;
+        return true;
+    }
+
+    switch(*s)
+    {
+    case '"':
+        {
+            ++s;
+            char const * const start(s);
+            for(;; ++s)
+            {
+                if(s >= end)
+                {
+                    return false;
+                }
+                if(*s == '"')
+                {
+                    break;
+                }
+                if(*s == '\\')
+                {
+                    ++s;
+                    if(s >= end
+                    || (*s != '"' && *s != '\\'))
+                    {
+                        return false;
+                    }
+                    item.f_escaped = true;
+                }
+                else if(*s < 0x20 || *s > 0x7E)
+                {
+                    return false;
+                }
+            }
+            item.f_type = item_type_t::ITEM_TYPE_STRING;
+            item.f_value = std::string_view(start, s - start);
+            ++s;
+        }
+        return true;
+
+    case ':':
+        {
+            ++s;
+            char const * const start(s);
+            int padding(0);
+            for(; s < end && *s != ':'; ++s)
+            {
+                if(*s == '=')
+                {
+                    ++padding;
+                    if(padding > 2)
+                    {
+                        return false;
+                    }
+                }
+                else if(padding != 0
+                     || base64_value(*s) < 0)
+                {
+                    return false;
+                }
+            }
+            if(s >= end)
+            {
+                return false;
+            }
+            item.f_type = item_type_t::ITEM_TYPE_BYTE_SEQUENCE;
+            item.f_value = std::string_view(start, s - start);
+            ++s;
+        }
+        return true;
+
+    case '?':
+        ++s;
+        if(s >= end
+        || (*s != '0' && *s != '1'))
+        {
+            return false;
+        }
+        item.f_type = item_type_t::ITEM_TYPE_BOOLEAN;
+        item.f_integer = *s - '0';
+        ++s;
+        return true;
+
+    default:
+        if(is_alpha(*s) || *s == '*')
+        {
+            std::size_t const length(scan_sf_token(std::string_view(s + 1, end - s - 1)) + 1);
+            item.f_type = item_type_t::ITEM_TYPE_TOKEN;
+            item.f_value = std::string_view(s, length);
+            s += length;
+            return true;
+        }
+        return false;
+
+    }
+}
+
+
+bool structured_field::parse_params(char const * & s, char const * end, item_t & item)
+{
+    item.f_param_start = static_cast<std::uint32_t>(f_params.size());
+    item.f_param_count = 0;
+    while(s < end && *s == ';')
+    {
+        ++s;
+        skip_sp(s, end);
+
+        item_t param;
+        if(!parse_key(s, end, param.f_key))
+        {
+            return false;
+        }
+        if(s < end && *s == '=')
+        {
+            ++s;
+            if(!parse_bare_item(s, end, param))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            param.f_type = item_type_t::ITEM_TYPE_BOOLEAN;
+            param.f_integer = 1;
+        }
+
+        // a duplicate key overwrites the existing value
+        //
+        bool found(false);
+        for(std::uint32_t idx(0); idx < item.f_param_count; ++idx)
+        {
+            if(f_params[item.f_param_start + idx].f_key == param.f_key)
+            {
+                f_params[item.f_param_start + idx] = param;
+                found = true;
+                break;
+            }
+        }
+        if(!found)
+        {
+            f_params.push_back(param);
+            ++item.f_param_count;
+        }
+    }
+    return true;
+}
+
+
+void structured_field::serialize_item(std::string & out, item_t const & item) const
+{
+    if(item.f_type == item_type_t::ITEM_TYPE_INNER_LIST)
+    {
+        out += '(';
+        for(std::int64_t idx(0); idx < item.f_integer; ++idx)
+        {
+            if(idx != 0)
+            {
+                out += ' ';
+            }
+            serialize_item(out, f_items[item.f_item_start + idx]);
+        }
+        out += ')';
+    }
+    else
+    {
+        serialize_bare_item(out, item);
+    }
+    serialize_params(out, item);
+}
+
+
+void structured_field::serialize_bare_item(std::string & out, item_t const & item) const
+{
+    switch(item.f_type)
+    {
+    case item_type_t::ITEM_TYPE_INTEGER:
+        out += std::to_string(item.f_integer);
+        break;
+
+    case item_type_t::ITEM_TYPE_DECIMAL:
+        append_thousandths(out, item.f_integer);
+        break;
+
+    case item_type_t::ITEM_TYPE_STRING:
+        // the parser only accepts \" and \\ so the escaped view is
+        // already canonical
+        //
+        out += '"';
+        out += item.f_value;
+        out += '"';
+        break;
+
+    case item_type_t::ITEM_TYPE_TOKEN:
+        out += item.f_value;
+        break;
+
+    case item_type_t::ITEM_TYPE_BYTE_SEQUENCE:
+        serialize_byte_sequence(out, item.get_byte_sequence());
+        break;
+
+    case item_type_t::ITEM_TYPE_BOOLEAN:
+        serialize_boolean(out, item.f_integer != 0);
+        break;
+
+    case item_type_t::ITEM_TYPE_INNER_LIST:
+        throw invalid_parameter("an inner list is not a bare item.");
+
+    }
+}
+
+
+void structured_field::serialize_params(std::string & out, item_t const & item) const
+{
+    for(std::uint32_t idx(0); idx < item.f_param_count; ++idx)
+    {
+        item_t const & param(f_params[item.f_param_start + idx]);
+        out += ';';
+        out += param.f_key;
+        if(param.f_type != item_type_t::ITEM_TYPE_BOOLEAN
+        || param.f_integer == 0)
+        {
+            out += '=';
+            serialize_bare_item(out, param);
+        }
+    }
+}
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
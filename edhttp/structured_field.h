@@ -0,0 +1,129 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+// self
+//
+#include    <edhttp/inline_vector.h>
+
+
+// C++
+//
+#include    <cstdint>
+#include    <string>
+#include    <string_view>
+
+
+
+namespace edhttp
+{
+
+
+
+class structured_field
+{
+public:
+    static std::int64_t const   MAX_INTEGER = 999'999'999'999'999LL;
+    static std::int64_t const   MAX_DECIMAL = 999'999'999'999'999LL;    // in thousandths
+
+    enum class field_type_t
+    {
+        FIELD_TYPE_ITEM,
+        FIELD_TYPE_LIST,
+        FIELD_TYPE_DICTIONARY
+    };
+
+    enum class item_type_t
+    {
+        ITEM_TYPE_INTEGER,
+        ITEM_TYPE_DECIMAL,
+        ITEM_TYPE_STRING,
+        ITEM_TYPE_TOKEN,
+        ITEM_TYPE_BYTE_SEQUENCE,
+        ITEM_TYPE_BOOLEAN,
+        ITEM_TYPE_INNER_LIST
+    };
+
+    struct item_t
+    {
+        std::string         get_string() const;
+        std::string         get_byte_sequence() const;
+        double              get_decimal() const;
+        bool                get_boolean() const;
+
+        std::string_view    f_key = std::string_view();         // dictionary or parameter key
+        std::string_view    f_value = std::string_view();       // string (escaped, no quotes), token, or base64
+        std::int64_t        f_integer = 0;                      // integer, decimal in thousandths, boolean, inner list size
+        item_type_t         f_type = item_type_t::ITEM_TYPE_BOOLEAN;
+        bool                f_escaped = false;                  // string includes backslashes
+        std::uint32_t       f_item_start = 0;                   // first item of an inner list
+        std::uint32_t       f_param_start = 0;
+        std::uint32_t       f_param_count = 0;
+    };
+
+                        structured_field();
+                        structured_field(std::string_view field, field_type_t type);
+
+    bool                parse(std::string_view field, field_type_t type);
+    void                clear();
+
+    field_type_t        get_field_type() const;
+    std::size_t         size() const;
+    bool                empty() const;
+    item_t const &      get_member(std::size_t idx) const;
+    item_t const *      find_member(std::string_view key) const;
+    item_t const &      get_inner_item(item_t const & inner_list, std::size_t idx) const;
+    item_t const &      get_param(item_t const & item, std::size_t idx) const;
+    item_t const *      find_param(item_t const & item, std::string_view key) const;
+
+    void                serialize(std::string & out) const;
+    std::string         to_string() const;
+
+    static void         serialize_integer(std::string & out, std::int64_t value);
+    static void         serialize_decimal(std::string & out, double value);
+    static void         serialize_string(std::string & out, std::string_view value);
+    static void         serialize_token(std::string & out, std::string_view value);
+    static void         serialize_byte_sequence(std::string & out, std::string_view value);
+    static void         serialize_boolean(std::string & out, bool value);
+    static void         serialize_key(std::string & out, std::string_view key);
+
+private:
+    static std::size_t const    INLINE_SIZE = 16;
+
+    void                add_member(std::uint32_t index);
+    bool                parse_member(char const * & s, char const * end, std::string_view key);
+    bool                parse_item(char const * & s, char const * end, item_t & item);
+    bool                parse_bare_item(char const * & s, char const * end, item_t & item);
+    bool                parse_params(char const * & s, char const * end, item_t & item);
+    void                serialize_item(std::string & out, item_t const & item) const;
+    void                serialize_bare_item(std::string & out, item_t const & item) const;
+    void                serialize_params(std::string & out, item_t const & item) const;
+
+    field_type_t        f_field_type = field_type_t::FIELD_TYPE_ITEM;
+    inline_vector<std::uint32_t, INLINE_SIZE>
+                        f_members = inline_vector<std::uint32_t, INLINE_SIZE>();
+    inline_vector<item_t, INLINE_SIZE>
+                        f_items = inline_vector<item_t, INLINE_SIZE>();
+    inline_vector<item_t, INLINE_SIZE>
+                        f_params = inline_vector<item_t, INLINE_SIZE>();
+};
+
+
+
+} // namespace edhttp
+// vim: ts=4 sw=4 et
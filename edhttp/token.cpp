@@ -26,7 +26,18 @@
 
 // C++
 //
+#include    <algorithm>
+#include    <atomic>
 #include    <cstdint>
+#include    <string>
+
+
+// C
+//
+#if defined(__x86_64__) || defined(__i386__)
+#define EDHTTP_X86_SIMD
+#include    <immintrin.h>
+#endif
 
 
 // last include
@@ -42,6 +53,13 @@ namespace edhttp
 namespace
 {
 
+
+
+constexpr std::uint8_t const    CHAR_CLASS_TOKEN        = 0x01;
+constexpr std::uint8_t const    CHAR_CLASS_FIELD_VALUE  = 0x02;
+constexpr std::uint8_t const    CHAR_CLASS_PATH         = 0x04;
+
+
 //     CHAR           = <any US-ASCII character (octets 0 - 127)>
 //     token          = 1*<any CHAR except CTLs or separators>
 //     separators     = "(" | ")" | "<" | ">" | "@"
@@ -49,100 +67,469 @@ namespace
 //                    | "/" | "[" | "]" | "?" | "="
 //                    | "{" | "}" | SP | HT
 //
-#define EDHTTP_TOKEN_CHAR(base, c) (static_cast<std::uint32_t>(1)<<(((c)-(base))&0x1F))
-constexpr std::uint32_t const g_http_token[4] =
-{
-    /* 00-1F */ 0x00000000,
-    /* 20-3F */
-          EDHTTP_TOKEN_CHAR(0x20, '!')
-        | EDHTTP_TOKEN_CHAR(0x20, '#')
-        | EDHTTP_TOKEN_CHAR(0x20, '$')
-        | EDHTTP_TOKEN_CHAR(0x20, '%')
-        | EDHTTP_TOKEN_CHAR(0x20, '&')
-        | EDHTTP_TOKEN_CHAR(0x20, '\'')
-        | EDHTTP_TOKEN_CHAR(0x20, '*')
-        | EDHTTP_TOKEN_CHAR(0x20, '+')
-        | EDHTTP_TOKEN_CHAR(0x20, '-')
-        | EDHTTP_TOKEN_CHAR(0x20, '.')
-        | EDHTTP_TOKEN_CHAR(0x20, '0')
-        | EDHTTP_TOKEN_CHAR(0x20, '1')
-        | EDHTTP_TOKEN_CHAR(0x20, '2')
-        | EDHTTP_TOKEN_CHAR(0x20, '3')
-        | EDHTTP_TOKEN_CHAR(0x20, '4')
-        | EDHTTP_TOKEN_CHAR(0x20, '5')
-        | EDHTTP_TOKEN_CHAR(0x20, '6')
-        | EDHTTP_TOKEN_CHAR(0x20, '7')
-        | EDHTTP_TOKEN_CHAR(0x20, '8')
-        | EDHTTP_TOKEN_CHAR(0x20, '9')
-    ,
-    /* 40-5F */
-          EDHTTP_TOKEN_CHAR(0x40, 'A')
-        | EDHTTP_TOKEN_CHAR(0x40, 'B')
-        | EDHTTP_TOKEN_CHAR(0x40, 'C')
-        | EDHTTP_TOKEN_CHAR(0x40, 'D')
-        | EDHTTP_TOKEN_CHAR(0x40, 'E')
-        | EDHTTP_TOKEN_CHAR(0x40, 'F')
-        | EDHTTP_TOKEN_CHAR(0x40, 'G')
-        | EDHTTP_TOKEN_CHAR(0x40, 'H')
-        | EDHTTP_TOKEN_CHAR(0x40, 'I')
-        | EDHTTP_TOKEN_CHAR(0x40, 'J')
-        | EDHTTP_TOKEN_CHAR(0x40, 'K')
-        | EDHTTP_TOKEN_CHAR(0x40, 'L')
-        | EDHTTP_TOKEN_CHAR(0x40, 'M')
-        | EDHTTP_TOKEN_CHAR(0x40, 'N')
-        | EDHTTP_TOKEN_CHAR(0x40, 'O')
-        | EDHTTP_TOKEN_CHAR(0x40, 'P')
-        | EDHTTP_TOKEN_CHAR(0x40, 'Q')
-        | EDHTTP_TOKEN_CHAR(0x40, 'R')
-        | EDHTTP_TOKEN_CHAR(0x40, 'S')
-        | EDHTTP_TOKEN_CHAR(0x40, 'T')
-        | EDHTTP_TOKEN_CHAR(0x40, 'U')
-        | EDHTTP_TOKEN_CHAR(0x40, 'V')
-        | EDHTTP_TOKEN_CHAR(0x40, 'W')
-        | EDHTTP_TOKEN_CHAR(0x40, 'X')
-        | EDHTTP_TOKEN_CHAR(0x40, 'Y')
-        | EDHTTP_TOKEN_CHAR(0x40, 'Z')
-        | EDHTTP_TOKEN_CHAR(0x40, '^')
-        | EDHTTP_TOKEN_CHAR(0x40, '_')
-    ,
-    /* 60-7F */
-          EDHTTP_TOKEN_CHAR(0x60, '`')
-        | EDHTTP_TOKEN_CHAR(0x60, 'a')
-        | EDHTTP_TOKEN_CHAR(0x60, 'b')
-        | EDHTTP_TOKEN_CHAR(0x60, 'c')
-        | EDHTTP_TOKEN_CHAR(0x60, 'd')
-        | EDHTTP_TOKEN_CHAR(0x60, 'e')
-        | EDHTTP_TOKEN_CHAR(0x60, 'f')
-        | EDHTTP_TOKEN_CHAR(0x60, 'g')
-        | EDHTTP_TOKEN_CHAR(0x60, 'h')
-        | EDHTTP_TOKEN_CHAR(0x60, 'i')
-        | EDHTTP_TOKEN_CHAR(0x60, 'j')
-        | EDHTTP_TOKEN_CHAR(0x60, 'k')
-        | EDHTTP_TOKEN_CHAR(0x60, 'l')
-        | EDHTTP_TOKEN_CHAR(0x60, 'm')
-        | EDHTTP_TOKEN_CHAR(0x60, 'n')
-        | EDHTTP_TOKEN_CHAR(0x60, 'o')
-        | EDHTTP_TOKEN_CHAR(0x60, 'p')
-        | EDHTTP_TOKEN_CHAR(0x60, 'q')
-        | EDHTTP_TOKEN_CHAR(0x60, 'r')
-        | EDHTTP_TOKEN_CHAR(0x60, 's')
-        | EDHTTP_TOKEN_CHAR(0x60, 't')
-        | EDHTTP_TOKEN_CHAR(0x60, 'u')
-        | EDHTTP_TOKEN_CHAR(0x60, 'v')
-        | EDHTTP_TOKEN_CHAR(0x60, 'w')
-        | EDHTTP_TOKEN_CHAR(0x60, 'x')
-        | EDHTTP_TOKEN_CHAR(0x60, 'y')
-        | EDHTTP_TOKEN_CHAR(0x60, 'z')
-        | EDHTTP_TOKEN_CHAR(0x60, '|')
-        | EDHTTP_TOKEN_CHAR(0x60, '~')
+constexpr bool is_token_char(int c)
+{
+    if(c <= ' ' || c >= 0x7F)
+    {
+        return false;
+    }
+    switch(c)
+    {
+    case '(':
+    case ')':
+    case '<':
+    case '>':
+    case '@':
+    case ',':
+    case ';':
+    case ':':
+    case '\\':
+    case '"':
+    case '/':
+    case '[':
+    case ']':
+    case '?':
+    case '=':
+    case '{':
+    case '}':
+        return false;
+
+    default:
+        return true;
+
+    }
+}
+
+
+//     field-value    = *field-content
+//     field-content  = field-vchar [ 1*( SP / HTAB / field-vchar ) field-vchar ]
+//     field-vchar    = VCHAR / obs-text
+//     obs-text       = %x80-FF
+//
+constexpr bool is_field_value_char(int c)
+{
+    return c == '\t' || (c >= ' ' && c != 0x7F);
+}
+
+
+//     path           = *( "/" / pchar )
+//     pchar          = unreserved / pct-encoded / sub-delims / ":" / "@"
+//     unreserved     = ALPHA / DIGIT / "-" / "." / "_" / "~"
+//     sub-delims     = "!" / "$" / "&" / "'" / "(" / ")"
+//                    / "*" / "+" / "," / ";" / "="
+//
+// pct-encoded is only verified as far as the '%' character goes; the
+// two hexadecimal digits are just alphanumeric characters here
+//
+constexpr bool is_path_char(int c)
+{
+    if((c >= 'a' && c <= 'z')
+    || (c >= 'A' && c <= 'Z')
+    || (c >= '0' && c <= '9'))
+    {
+        return true;
+    }
+    switch(c)
+    {
+    case '-':
+    case '.':
+    case '_':
+    case '~':
+    case '!':
+    case '$':
+    case '&':
+    case '\'':
+    case '(':
+    case ')':
+    case '*':
+    case '+':
+    case ',':
+    case ';':
+    case '=':
+    case ':':
+    case '@':
+    case '/':
+    case '%':
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+/** \brief The character class tables.
+ *
+ * The f_class table gives the classes of each one of the 256 octets.
+ *
+ * The nibble tables are used by the SIMD kernels. The entry at index
+ * \em lo has bit \em hi set when the character `(hi << 4) | lo` is part
+ * of the class. Only 8 bits are available so the classes represented
+ * this way cannot include characters 0x80 to 0xFF.
+ */
+struct char_class_table_t
+{
+    std::uint8_t        f_class[256] = {};
+    std::uint8_t        f_token_nibbles[16] = {};
+    std::uint8_t        f_path_nibbles[16] = {};
+};
+
+
+constexpr char_class_table_t generate_char_class_table()
+{
+    char_class_table_t table;
+    for(int c(0); c < 256; ++c)
+    {
+        std::uint8_t char_class(0);
+        if(is_token_char(c))
+        {
+            char_class |= CHAR_CLASS_TOKEN;
+            table.f_token_nibbles[c & 0x0F] |= 1 << (c >> 4);
+        }
+        if(is_field_value_char(c))
+        {
+            char_class |= CHAR_CLASS_FIELD_VALUE;
+        }
+        if(is_path_char(c))
+        {
+            char_class |= CHAR_CLASS_PATH;
+            table.f_path_nibbles[c & 0x0F] |= 1 << (c >> 4);
+        }
+        table.f_class[c] = char_class;
+    }
+    return table;
+}
+
+
+constexpr char_class_table_t const g_char_class = generate_char_class_table();
+
+
+std::size_t scan_scalar(
+      char const * s
+    , std::size_t size
+    , std::uint8_t char_class)
+{
+    for(std::size_t pos(0); pos < size; ++pos)
+    {
+        if((g_char_class.f_class[static_cast<std::uint8_t>(s[pos])] & char_class) == 0)
+        {
+            return pos;
+        }
+    }
+    return size;
+}
+
+
+#ifdef EDHTTP_X86_SIMD
+// the entry at index hi is (1 << hi) for the 8 nibbles representing ASCII
+//
+alignas(16) constexpr std::uint8_t const g_high_nibble_bits[16] =
+{
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 };
-#undef EDHTTP_TOKEN_CHAR
+
+
+__attribute__((target("ssse3")))
+std::size_t scan_nibbles_ssse3(
+      char const * s
+    , std::size_t size
+    , std::uint8_t const * nibbles
+    , std::uint8_t char_class)
+{
+    __m128i const low_table(_mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles)));
+    __m128i const high_table(_mm_load_si128(reinterpret_cast<__m128i const *>(g_high_nibble_bits)));
+    __m128i const mask(_mm_set1_epi8(0x0F));
+    __m128i const zero(_mm_setzero_si128());
+
+    std::size_t pos(0);
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)));
+        __m128i const low(_mm_and_si128(v, mask));
+        __m128i const high(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i const bits(_mm_and_si128(
+                  _mm_shuffle_epi8(low_table, low)
+                , _mm_shuffle_epi8(high_table, high)));
+        int const invalid(_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)));
+        if(invalid != 0)
+        {
+            return pos + __builtin_ctz(invalid);
+        }
+    }
+
+    return pos + scan_scalar(s + pos, size - pos, char_class);
+}
+
+
+__attribute__((target("avx2")))
+std::size_t scan_nibbles_avx2(
+      char const * s
+    , std::size_t size
+    , std::uint8_t const * nibbles
+    , std::uint8_t char_class)
+{
+    __m256i const low_table(_mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<__m128i const *>(nibbles))));
+    __m256i const high_table(_mm256_broadcastsi128_si256(
+                _mm_load_si128(reinterpret_cast<__m128i const *>(g_high_nibble_bits))));
+    __m256i const mask(_mm256_set1_epi8(0x0F));
+    __m256i const zero(_mm256_setzero_si256());
+
+    std::size_t pos(0);
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i const v(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + pos)));
+        __m256i const low(_mm256_and_si256(v, mask));
+        __m256i const high(_mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i const bits(_mm256_and_si256(
+                  _mm256_shuffle_epi8(low_table, low)
+                , _mm256_shuffle_epi8(high_table, high)));
+        std::uint32_t const invalid(static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(bits, zero))));
+        if(invalid != 0)
+        {
+            return pos + __builtin_ctz(invalid);
+        }
+    }
+
+    return pos + scan_scalar(s + pos, size - pos, char_class);
+}
+
+
+// the field value is a range check: CTLs are invalid except HT, and
+// DEL is invalid; using signed comparisons, the obs-text characters
+// are negative and thus never viewed as CTLs
+//
+__attribute__((target("ssse3")))
+std::size_t scan_field_value_ssse3(char const * s, std::size_t size)
+{
+    __m128i const space(_mm_set1_epi8(' '));
+    __m128i const minus_one(_mm_set1_epi8(-1));
+    __m128i const tab(_mm_set1_epi8('\t'));
+    __m128i const del(_mm_set1_epi8(0x7F));
+
+    std::size_t pos(0);
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)));
+        __m128i const ctl(_mm_and_si128(
+                  _mm_cmplt_epi8(v, space)
+                , _mm_cmpgt_epi8(v, minus_one)));
+        __m128i const bad(_mm_or_si128(
+                  _mm_andnot_si128(_mm_cmpeq_epi8(v, tab), ctl)
+                , _mm_cmpeq_epi8(v, del)));
+        int const invalid(_mm_movemask_epi8(bad));
+        if(invalid != 0)
+        {
+            return pos + __builtin_ctz(invalid);
+        }
+    }
+
+    return pos + scan_scalar(s + pos, size - pos, CHAR_CLASS_FIELD_VALUE);
+}
+
+
+__attribute__((target("avx2")))
+std::size_t scan_field_value_avx2(char const * s, std::size_t size)
+{
+    __m256i const space(_mm256_set1_epi8(' '));
+    __m256i const minus_one(_mm256_set1_epi8(-1));
+    __m256i const tab(_mm256_set1_epi8('\t'));
+    __m256i const del(_mm256_set1_epi8(0x7F));
+
+    std::size_t pos(0);
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i const v(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + pos)));
+        __m256i const ctl(_mm256_and_si256(
+                  _mm256_cmpgt_epi8(space, v)
+                , _mm256_cmpgt_epi8(v, minus_one)));
+        __m256i const bad(_mm256_or_si256(
+                  _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), ctl)
+                , _mm256_cmpeq_epi8(v, del)));
+        std::uint32_t const invalid(static_cast<std::uint32_t>(_mm256_movemask_epi8(bad)));
+        if(invalid != 0)
+        {
+            return pos + __builtin_ctz(invalid);
+        }
+    }
+
+    return pos + scan_scalar(s + pos, size - pos, CHAR_CLASS_FIELD_VALUE);
+}
+#endif
+
+
+simd_level_t detect_simd_level()
+{
+#ifdef EDHTTP_X86_SIMD
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return simd_level_t::SIMD_LEVEL_AVX2;
+    }
+    if(__builtin_cpu_supports("ssse3"))
+    {
+        return simd_level_t::SIMD_LEVEL_SSSE3;
+    }
+#endif
+    return simd_level_t::SIMD_LEVEL_SCALAR;
+}
+
+
+std::atomic<simd_level_t> & current_simd_level()
+{
+    static std::atomic<simd_level_t> g_simd_level(detect_simd_level());
+    return g_simd_level;
+}
+
+
+std::size_t scan_nibbles(
+      std::string_view s
+    , std::uint8_t const * nibbles
+    , std::uint8_t char_class)
+{
+#ifdef EDHTTP_X86_SIMD
+    if(s.length() >= 16)
+    {
+        switch(current_simd_level().load(std::memory_order_relaxed))
+        {
+        case simd_level_t::SIMD_LEVEL_AVX2:
+            if(s.length() >= 32)
+            {
+                return scan_nibbles_avx2(s.data(), s.length(), nibbles, char_class);
+            }
+            [[fallthrough]];
+        case simd_level_t::SIMD_LEVEL_SSSE3:
+            return scan_nibbles_ssse3(s.data(), s.length(), nibbles, char_class);
+
+        case simd_level_t::SIMD_LEVEL_SCALAR:
+            break;
+
+        }
+    }
+#else
+    static_cast<void>(nibbles);
+#endif
+    return scan_scalar(s.data(), s.length(), char_class);
+}
+
 
 
 } // no name namespace
 
 
 
+/** \brief Get the SIMD level used by the scanners.
+ *
+ * The scan functions and the base64 codec detect the instructions
+ * available on the running processor once and use the best kernel
+ * available. This function returns the level currently in use.
+ *
+ * \return The SIMD level used by the scan functions.
+ */
+simd_level_t get_simd_level()
+{
+    return current_simd_level().load(std::memory_order_relaxed);
+}
+
+
+/** \brief Change the SIMD level used by the scanners.
+ *
+ * This function is mainly used by tests and benchmarks to compare the
+ * results and speed of the scalar and vectorized kernels. The level
+ * cannot be raised above what the processor supports; a higher level
+ * is clamped to the detected level.
+ *
+ * \param[in] level  The new SIMD level.
+ *
+ * \return The previous SIMD level.
+ */
+simd_level_t set_simd_level(simd_level_t level)
+{
+    return current_simd_level().exchange(
+                  std::min(level, detect_simd_level())
+                , std::memory_order_relaxed);
+}
+
+
+/** \brief Scan the longest sequence of token characters.
+ *
+ * This function returns the position of the first character in \p s
+ * which is not a valid HTTP token character. If all the characters
+ * are valid, the function returns `s.length()`.
+ *
+ * Parsers use this function to find the end of a name or an unquoted
+ * value in one call instead of checking the characters one by one.
+ *
+ * \param[in] s  The string to scan.
+ *
+ * \return The length of the token found at the start of \p s.
+ */
+std::size_t scan_token(std::string_view s)
+{
+    return scan_nibbles(s, g_char_class.f_token_nibbles, CHAR_CLASS_TOKEN);
+}
+
+
+/** \brief Scan the longest sequence of field value characters.
+ *
+ * This function returns the position of the first character in \p s
+ * which is not valid in an HTTP field value (VCHAR, obs-text, SP
+ * and HT are accepted). If all the characters are valid, the function
+ * returns `s.length()`.
+ *
+ * \param[in] s  The string to scan.
+ *
+ * \return The length of the valid field value found at the start of \p s.
+ */
+std::size_t scan_field_value(std::string_view s)
+{
+#ifdef EDHTTP_X86_SIMD
+    if(s.length() >= 16)
+    {
+        switch(current_simd_level().load(std::memory_order_relaxed))
+        {
+        case simd_level_t::SIMD_LEVEL_AVX2:
+            if(s.length() >= 32)
+            {
+                return scan_field_value_avx2(s.data(), s.length());
+            }
+            [[fallthrough]];
+        case simd_level_t::SIMD_LEVEL_SSSE3:
+            return scan_field_value_ssse3(s.data(), s.length());
+
+        case simd_level_t::SIMD_LEVEL_SCALAR:
+            break;
+
+        }
+    }
+#endif
+    return scan_scalar(s.data(), s.length(), CHAR_CLASS_FIELD_VALUE);
+}
+
+
+/** \brief Scan the longest sequence of path characters.
+ *
+ * This function returns the position of the first character in \p s
+ * which is not a valid URI path character (pchar or "/"). If all the
+ * characters are valid, the function returns `s.length()`.
+ *
+ * \note
+ * The '%' character is accepted but the function does not verify that
+ * it is followed by two hexadecimal digits.
+ *
+ * \param[in] s  The string to scan.
+ *
+ * \return The length of the path found at the start of \p s.
+ */
+std::size_t scan_path(std::string_view s)
+{
+    return scan_nibbles(s, g_char_class.f_path_nibbles, CHAR_CLASS_PATH);
+}
+
+
 /** \brief Check whether \p token represents a valid token as per HTTP.
  *
  * HTTP headers make use of tokens for field names. These also appear
@@ -153,11 +540,14 @@ constexpr std::uint32_t const g_http_token[4] =
  *     User-Agent: <token>/<version> <comment>
  * \endcode
  *
+ * \exception invalid_token
+ * An empty token is not considered valid and raises this exception.
+ *
  * \param[in] token  The string to verify.
  *
  * \return true if \p token is considered to be a valid token.
  */
-bool is_token(std::string const & token)
+bool is_token(std::string_view token)
 {
     if(token.empty())
     {
@@ -171,17 +561,55 @@ bool is_token(std::string const & token)
         return false;
     }
 
-    for(auto const t : token)
-    {
-        std::uint8_t const c(static_cast<std::uint8_t>(t));
-        if(c >= 127
-        || (g_http_token[c >> 5] & (1 << (c & 0x1F))) == 0)
-        {
-            return false;
-        }
-    }
+    return scan_token(token) == token.length();
+}
+
+
+/** \brief Check whether \p token is a valid HTTP token.
+ *
+ * This is the previous signature of is_token(). It is not declared in
+ * the header anymore (a `char const *` would then be ambiguous) but it
+ * remains exported so binaries linked against an older version of the
+ * library keep working without a soname change.
+ *
+ * \param[in] token  The string to verify.
+ *
+ * \return true if \p token is considered to be a valid token.
+ */
+bool is_token(std::string const & token);
+bool is_token(std::string const & token)
+{
+    return is_token(std::string_view(token));
+}
+
 
-    return true;
+/** \brief Check whether \p value is a valid HTTP field value.
+ *
+ * This function verifies that all the characters in \p value are
+ * valid in an HTTP field value. An empty value is valid.
+ *
+ * \param[in] value  The string to verify.
+ *
+ * \return true if \p value only includes valid field value characters.
+ */
+bool is_field_value(std::string_view value)
+{
+    return scan_field_value(value) == value.length();
+}
+
+
+/** \brief Check whether \p path is a valid URI path.
+ *
+ * This function verifies that all the characters in \p path are
+ * valid in a URI path. An empty path is valid.
+ *
+ * \param[in] path  The string to verify.
+ *
+ * \return true if \p path only includes valid path characters.
+ */
+bool is_path(std::string_view path)
+{
+    return scan_path(path) == path.length();
 }
 
 
@@ -19,7 +19,8 @@
 
 // C++
 //
-#include    <string>
+#include    <cstddef>
+#include    <string_view>
 
 
 
@@ -28,7 +29,24 @@ namespace edhttp
 
 
 
-bool is_token(std::string const & token);
+enum class simd_level_t
+{
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSSE3,
+    SIMD_LEVEL_AVX2
+};
+
+
+simd_level_t        get_simd_level();
+simd_level_t        set_simd_level(simd_level_t level);
+
+std::size_t         scan_token(std::string_view s);
+std::size_t         scan_field_value(std::string_view s);
+std::size_t         scan_path(std::string_view s);
+
+bool                is_token(std::string_view token);
+bool                is_field_value(std::string_view value);
+bool                is_path(std::string_view path);
 
 
 
@@ -0,0 +1,344 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the base64 encoder and decoder.
+ *
+ * This file implements tests to verify the RFC 4648 vectors, the error
+ * handling, and that the scalar and SIMD kernels as well as the
+ * streaming classes all generate the same results.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/base64.h"
+#include    "edhttp/exception.h"
+#include    "edhttp/token.h"
+
+
+// C++
+//
+#include    <random>
+
+
+
+namespace
+{
+
+
+
+std::string random_bytes(std::mt19937 & generator, std::size_t size)
+{
+    std::string result(size, '\0');
+    for(auto & c : result)
+    {
+        c = static_cast<char>(generator());
+    }
+    return result;
+}
+
+
+std::string decode(std::string_view data, edhttp::base64_alphabet_t alphabet = edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, int flags = 0)
+{
+    std::string result;
+    if(!edhttp::base64_decode(data, result, alphabet, flags))
+    {
+        return "<error>";
+    }
+    return result;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("base64_encode", "[base64]")
+{
+    CATCH_START_SECTION("base64_encode: RFC 4648 test vectors")
+    {
+        CATCH_REQUIRE(edhttp::base64_encode("") == "");
+        CATCH_REQUIRE(edhttp::base64_encode("f") == "Zg==");
+        CATCH_REQUIRE(edhttp::base64_encode("fo") == "Zm8=");
+        CATCH_REQUIRE(edhttp::base64_encode("foo") == "Zm9v");
+        CATCH_REQUIRE(edhttp::base64_encode("foob") == "Zm9vYg==");
+        CATCH_REQUIRE(edhttp::base64_encode("fooba") == "Zm9vYmE=");
+        CATCH_REQUIRE(edhttp::base64_encode("foobar") == "Zm9vYmFy");
+
+        CATCH_REQUIRE(edhttp::base64_encode("fooba", edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_NO_PADDING) == "Zm9vYmE");
+        CATCH_REQUIRE(edhttp::base64_encode("foob", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL, edhttp::BASE64_FLAG_NO_PADDING) == "Zm9vYg");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_encode: alphabets and binary data")
+    {
+        std::string const data("\xFB\xFF\0\xFE", 4);
+        CATCH_REQUIRE(edhttp::base64_encode(data) == "+/8A/g==");
+        CATCH_REQUIRE(edhttp::base64_encode(data, edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == "-_8A_g==");
+
+        // the user name and password of a basic authorization may
+        // include a NUL character
+        //
+        CATCH_REQUIRE(edhttp::base64_encode(std::string("user:\0pass", 10)) == "dXNlcjoAcGFzcw==");
+
+        std::string out("prefix:");
+        edhttp::base64_encode("foo", out);
+        CATCH_REQUIRE(out == "prefix:Zm9v");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_encode: sizes and values")
+    {
+        for(std::size_t size(0); size < 100; ++size)
+        {
+            std::string const data(size, 'x');
+            CATCH_REQUIRE(edhttp::base64_encoded_size(size) == edhttp::base64_encode(data).length());
+            CATCH_REQUIRE(edhttp::base64_encoded_size(size, edhttp::BASE64_FLAG_NO_PADDING)
+                    == edhttp::base64_encode(data, edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_NO_PADDING).length());
+        }
+
+        CATCH_REQUIRE(edhttp::base64_value('A') == 0);
+        CATCH_REQUIRE(edhttp::base64_value('z') == 51);
+        CATCH_REQUIRE(edhttp::base64_value('9') == 61);
+        CATCH_REQUIRE(edhttp::base64_value('+') == 62);
+        CATCH_REQUIRE(edhttp::base64_value('/') == 63);
+        CATCH_REQUIRE(edhttp::base64_value('-') == -1);
+        CATCH_REQUIRE(edhttp::base64_value('=') == -1);
+        CATCH_REQUIRE(edhttp::base64_value('-', edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == 62);
+        CATCH_REQUIRE(edhttp::base64_value('_', edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == 63);
+        CATCH_REQUIRE(edhttp::base64_value('+', edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == -1);
+        CATCH_REQUIRE(edhttp::base64_value('\xC1') == -1);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("base64_decode", "[base64]")
+{
+    CATCH_START_SECTION("base64_decode: RFC 4648 test vectors")
+    {
+        CATCH_REQUIRE(decode("") == "");
+        CATCH_REQUIRE(decode("Zg==") == "f");
+        CATCH_REQUIRE(decode("Zm8=") == "fo");
+        CATCH_REQUIRE(decode("Zm9v") == "foo");
+        CATCH_REQUIRE(decode("Zm9vYg==") == "foob");
+        CATCH_REQUIRE(decode("Zm9vYmE=") == "fooba");
+        CATCH_REQUIRE(decode("Zm9vYmFy") == "foobar");
+
+        // padding is optional
+        //
+        CATCH_REQUIRE(decode("Zg") == "f");
+        CATCH_REQUIRE(decode("Zm9vYmE") == "fooba");
+
+        CATCH_REQUIRE(decode("+/8A/g==") == std::string("\xFB\xFF\0\xFE", 4));
+        CATCH_REQUIRE(decode("-_8A_g", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == std::string("\xFB\xFF\0\xFE", 4));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_decode: invalid data")
+    {
+        CATCH_REQUIRE(decode("Z") == "<error>");
+        CATCH_REQUIRE(decode("Z===") == "<error>");
+        CATCH_REQUIRE(decode("Zg=") == "<error>");
+        CATCH_REQUIRE(decode("Zg===") == "<error>");
+        CATCH_REQUIRE(decode("Zm8==") == "<error>");
+        CATCH_REQUIRE(decode("Zg==Zg==") == "<error>");
+        CATCH_REQUIRE(decode("Zm9v Zm9v") == "<error>");
+        CATCH_REQUIRE(decode("Zm9v\r\nZm9v") == "<error>");
+        CATCH_REQUIRE(decode("-_8A") == "<error>");
+        CATCH_REQUIRE(decode("+/8A", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL) == "<error>");
+        CATCH_REQUIRE(decode(std::string("Zm9v\0Zm9v", 9)) == "<error>");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_decode: refuse padding")
+    {
+        CATCH_REQUIRE(decode("Zm9vYg", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL, edhttp::BASE64_FLAG_NO_PADDING) == "foob");
+        CATCH_REQUIRE(decode("Zm9vYg==", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL, edhttp::BASE64_FLAG_NO_PADDING) == "<error>");
+        CATCH_REQUIRE(decode("Zm9vYmE=", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL, edhttp::BASE64_FLAG_NO_PADDING) == "<error>");
+        CATCH_REQUIRE(decode("Zm9vY", edhttp::base64_alphabet_t::BASE64_ALPHABET_URL, edhttp::BASE64_FLAG_NO_PADDING) == "<error>");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_decode: ignore invalid characters")
+    {
+        CATCH_REQUIRE(decode("Zm9v\r\nYmFy", edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_IGNORE_INVALID) == "foobar");
+        CATCH_REQUIRE(decode(" Zm9v Ym E= ", edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_IGNORE_INVALID) == "fooba");
+        CATCH_REQUIRE(decode("Zg=", edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_IGNORE_INVALID) == "f");
+        CATCH_REQUIRE(decode("Zm9vY", edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, edhttp::BASE64_FLAG_IGNORE_INVALID) == "foo");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_decode: every character in every position")
+    {
+        edhttp::simd_level_t const detected(edhttp::get_simd_level());
+        for(int level(0); level < 3; ++level)
+        {
+            edhttp::set_simd_level(static_cast<edhttp::simd_level_t>(level));
+            for(int alphabet(0); alphabet < 2; ++alphabet)
+            {
+                edhttp::base64_alphabet_t const a(static_cast<edhttp::base64_alphabet_t>(alphabet));
+                for(int c(0); c < 256; ++c)
+                {
+                    for(std::size_t pos(0); pos < 64; pos += 7)
+                    {
+                        std::string data(64, 'Q');
+                        data[pos] = static_cast<char>(c);
+                        std::string out;
+                        bool const valid(edhttp::base64_value(static_cast<char>(c), a) >= 0);
+                        bool const padding(c == '=' && pos == data.length() - 1);
+                        CATCH_REQUIRE(edhttp::base64_decode(data, out, a) == (valid || padding));
+                        if(valid)
+                        {
+                            CATCH_REQUIRE(edhttp::base64_encode(out, a) == data);
+                        }
+                    }
+                }
+            }
+        }
+        edhttp::set_simd_level(detected);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("base64_streaming", "[base64]")
+{
+    CATCH_START_SECTION("base64_streaming: scalar and SIMD kernels agree")
+    {
+        edhttp::simd_level_t const detected(edhttp::get_simd_level());
+        std::mt19937 generator(11);
+        for(int repeat(0); repeat < 500; ++repeat)
+        {
+            std::string const data(random_bytes(generator, generator() % 300));
+            edhttp::base64_alphabet_t const alphabet(static_cast<edhttp::base64_alphabet_t>(generator() % 2));
+
+            std::string encoded[3];
+            std::string decoded[3];
+            for(int level(0); level < 3; ++level)
+            {
+                edhttp::set_simd_level(static_cast<edhttp::simd_level_t>(level));
+                encoded[level] = edhttp::base64_encode(data, alphabet);
+                CATCH_REQUIRE(edhttp::base64_decode(encoded[level], decoded[level], alphabet));
+            }
+            edhttp::set_simd_level(detected);
+
+            for(int level(0); level < 3; ++level)
+            {
+                CATCH_REQUIRE(encoded[level] == encoded[0]);
+                CATCH_REQUIRE(decoded[level] == data);
+            }
+        }
+        CATCH_REQUIRE(edhttp::get_simd_level() == detected);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_streaming: chunk boundaries do not matter")
+    {
+        std::mt19937 generator(12);
+        for(int repeat(0); repeat < 500; ++repeat)
+        {
+            std::string const data(random_bytes(generator, generator() % 1000));
+            int const flags(generator() % 2 == 0 ? 0 : edhttp::BASE64_FLAG_NO_PADDING);
+            std::size_t const line_length(generator() % 3 == 0 ? 0 : (generator() % 20 + 1) * 4);
+
+            edhttp::base64_encoder encoder(edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, flags, line_length);
+            std::string encoded;
+            std::size_t const chunk_size(generator() % 70 + 1);
+            for(std::size_t pos(0); pos < data.length(); pos += chunk_size)
+            {
+                encoder.encode(std::span<char const>(data.data() + pos, std::min(chunk_size, data.length() - pos)), encoded);
+            }
+            encoder.finish(encoded);
+
+            std::string const expected(edhttp::base64_encode(data, edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, flags));
+            if(line_length == 0)
+            {
+                CATCH_REQUIRE(encoded == expected);
+            }
+            else
+            {
+                std::string joined;
+                for(std::size_t pos(0); pos < encoded.length(); )
+                {
+                    std::string::size_type const eol(encoded.find("\r\n", pos));
+                    std::string const line(encoded.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos));
+                    CATCH_REQUIRE(line.length() <= line_length);
+                    if(eol != std::string::npos)
+                    {
+                        CATCH_REQUIRE(line.length() == line_length);
+                    }
+                    joined += line;
+                    pos = eol == std::string::npos ? encoded.length() : eol + 2;
+                }
+                CATCH_REQUIRE(joined == expected);
+            }
+
+            edhttp::base64_decoder decoder(
+                      edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD
+                    , line_length == 0 ? 0 : edhttp::BASE64_FLAG_IGNORE_INVALID);
+            std::string decoded;
+            std::size_t const decode_chunk_size(generator() % 70 + 1);
+            for(std::size_t pos(0); pos < encoded.length(); pos += decode_chunk_size)
+            {
+                CATCH_REQUIRE(decoder.decode(std::span<char const>(encoded.data() + pos, std::min(decode_chunk_size, encoded.length() - pos)), decoded));
+            }
+            CATCH_REQUIRE(decoder.finish(decoded));
+            CATCH_REQUIRE(decoded == data);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("base64_streaming: errors are sticky until reset()")
+    {
+        edhttp::base64_decoder decoder;
+        std::string out;
+        CATCH_REQUIRE_FALSE(decoder.decode(std::string_view("Zm9v!"), out));
+        CATCH_REQUIRE_FALSE(decoder.decode(std::string_view("Zm9v"), out));
+        decoder.reset();
+        out.clear();
+        CATCH_REQUIRE(decoder.decode(std::string_view("Zm"), out));
+        CATCH_REQUIRE(decoder.decode(std::string_view("9v"), out));
+        CATCH_REQUIRE(decoder.finish(out));
+        CATCH_REQUIRE(out == "foo");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("base64_errors", "[base64][error]")
+{
+    CATCH_START_SECTION("base64_errors: invalid line length")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::base64_encoder(edhttp::base64_alphabet_t::BASE64_ALPHABET_STANDARD, 0, 75)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the base64 line length (75) must be a multiple of 4."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
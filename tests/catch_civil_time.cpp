@@ -0,0 +1,127 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the civil time functions.
+ *
+ * This file implements tests to verify that the conversions between
+ * Unix time and the civil calendar match the C library functions.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    <edhttp/civil_time.h>
+
+
+// C
+//
+#include    <time.h>
+
+
+
+CATCH_TEST_CASE("civil_time", "[time]")
+{
+    CATCH_START_SECTION("civil_time: every day from year 1 to 9999 against timegm()")
+    {
+        std::int64_t const first(edhttp::days_from_civil(1, 1, 1));
+        std::int64_t const last(edhttp::days_from_civil(9999, 12, 31));
+        for(std::int64_t days(first); days <= last; ++days)
+        {
+            time_t const seconds(days * edhttp::detail::SECONDS_PER_DAY);
+            struct tm tim;
+            gmtime_r(&seconds, &tim);
+
+            edhttp::civil_date_t const date(edhttp::civil_from_days(days));
+            CATCH_REQUIRE(date.f_year == tim.tm_year + 1900);
+            CATCH_REQUIRE(date.f_month == tim.tm_mon + 1);
+            CATCH_REQUIRE(date.f_day == tim.tm_mday);
+            CATCH_REQUIRE(edhttp::week_day_from_days(days) == tim.tm_wday);
+            CATCH_REQUIRE(edhttp::days_from_civil(date.f_year, date.f_month, date.f_day) == days);
+            CATCH_REQUIRE(edhttp::time_from_civil(date.f_year, date.f_month, date.f_day) == timegm(&tim));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("civil_time: random 64 bit times against gmtime_r()")
+    {
+        for(int i(0); i < 100'000; ++i)
+        {
+            // +/- 2^50 seconds is about +/- 35 million years
+            //
+            time_t t(0);
+            SNAP_CATCH2_NAMESPACE::random(t);
+            t %= 1LL << 50;
+
+            struct tm tim;
+            gmtime_r(&t, &tim);
+
+            edhttp::civil_time_t const c(edhttp::civil_from_time(t));
+            CATCH_REQUIRE(c.f_year == tim.tm_year + 1900LL);
+            CATCH_REQUIRE(c.f_month == tim.tm_mon + 1);
+            CATCH_REQUIRE(c.f_day == tim.tm_mday);
+            CATCH_REQUIRE(c.f_hour == tim.tm_hour);
+            CATCH_REQUIRE(c.f_minute == tim.tm_min);
+            CATCH_REQUIRE(c.f_second == tim.tm_sec);
+            CATCH_REQUIRE(c.f_week_day == tim.tm_wday);
+            CATCH_REQUIRE(c.f_year_day == tim.tm_yday);
+
+            CATCH_REQUIRE(edhttp::time_from_civil(
+                      c.f_year
+                    , c.f_month
+                    , c.f_day
+                    , c.f_hour
+                    , c.f_minute
+                    , c.f_second) == t);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("civil_time: out of range fields are normalized")
+    {
+        std::int64_t const t(edhttp::time_from_civil(2024, 10, 29, 3, 20, 51));
+        CATCH_REQUIRE(t == 0x67205493);
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10, 29, 3, 20, 51 + 93) == t + 93);
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10, 29, 3, 20 - 93, 51) == t - 93 * 60);
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10, 29, 3 + 93, 20, 51) == t + 93 * 3600);
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10, 29 + 400, 3, 20, 51) == t + 400 * edhttp::detail::SECONDS_PER_DAY);
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10 + 24, 29, 3, 20, 51) == edhttp::time_from_civil(2026, 10, 29, 3, 20, 51));
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 10 - 24, 29, 3, 20, 51) == edhttp::time_from_civil(2022, 10, 29, 3, 20, 51));
+        CATCH_REQUIRE(edhttp::time_from_civil(2024, 0, 1) == edhttp::time_from_civil(2023, 12, 1));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("civil_time: month length")
+    {
+        CATCH_REQUIRE(edhttp::days_in_month(2024, 2) == 29);
+        CATCH_REQUIRE(edhttp::days_in_month(2023, 2) == 28);
+        CATCH_REQUIRE(edhttp::days_in_month(2000, 2) == 29);
+        CATCH_REQUIRE(edhttp::days_in_month(1900, 2) == 28);
+        CATCH_REQUIRE(edhttp::days_in_month(-4, 2) == 29);
+        CATCH_REQUIRE(edhttp::days_in_month(2023, 4) == 30);
+        CATCH_REQUIRE(edhttp::days_in_month(2023, 12) == 31);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,306 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the cookie_jar class.
+ *
+ * This file implements tests to verify that the cookie jar saves the
+ * cookies following RFC 6265 and returns the right cookies for each
+ * request.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/cookie_jar.h"
+#include    "edhttp/exception.h"
+
+
+
+namespace
+{
+
+
+
+time_t const g_now = 1700000000;
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("cookie_jar", "[cookie]")
+{
+    CATCH_START_SECTION("cookie_jar: host only cookies")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE(jar.get_max_cookies() == edhttp::cookie_jar::DEFAULT_MAX_COOKIES);
+        CATCH_REQUIRE(jar.set_cookie("sid=123; HttpOnly", "Example.COM", "/account/login", false, g_now));
+        CATCH_REQUIRE(jar.size() == 1);
+
+        edhttp::cookie_jar::cookie_t const * c(jar.find_cookie("example.com", "/account", "sid"));
+        CATCH_REQUIRE(c != nullptr);
+        CATCH_REQUIRE(c->f_value == "123");
+        CATCH_REQUIRE(c->f_host_only);
+        CATCH_REQUIRE(c->f_http_only);
+        CATCH_REQUIRE_FALSE(c->f_secure);
+        CATCH_REQUIRE(c->f_expire == -1);
+
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/account", false, g_now) == "sid=123");
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/account/settings?tab=1", false, g_now) == "sid=123");
+        CATCH_REQUIRE(jar.get_cookies("EXAMPLE.com", "/account/", false, g_now) == "sid=123");
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/accounts", false, g_now).empty());
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now).empty());
+        CATCH_REQUIRE(jar.get_cookies("www.example.com", "/account", false, g_now).empty());
+        CATCH_REQUIRE(jar.get_cookies("example.org", "/account", false, g_now).empty());
+
+        std::string out("a=b");
+        jar.append_cookies(out, "example.com", "/account", false, g_now);
+        CATCH_REQUIRE(out == "a=b; sid=123");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: domain cookies")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE(jar.set_cookie("lang=en; Domain=.Example.com; Path=/", "www.example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("theme=dark; Path=/", "www.example.com", "/", false, g_now));
+
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "lang=en");
+        CATCH_REQUIRE(jar.get_cookies("www.example.com", "/", false, g_now) == "lang=en; theme=dark");
+        CATCH_REQUIRE(jar.get_cookies("api.example.com", "/x", false, g_now) == "lang=en");
+        CATCH_REQUIRE(jar.get_cookies("a.b.example.com", "/", false, g_now) == "lang=en");
+        CATCH_REQUIRE(jar.get_cookies("badexample.com", "/", false, g_now).empty());
+
+        // domain does not match the host
+        //
+        CATCH_REQUIRE_FALSE(jar.set_cookie("x=1; Domain=other.com", "www.example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("x=1; Domain=ww.example.com", "www.example.com", "/", false, g_now));
+
+        // public suffixes are refused
+        //
+        CATCH_REQUIRE(edhttp::cookie_jar::is_public_suffix("com"));
+        CATCH_REQUIRE(edhttp::cookie_jar::is_public_suffix("co.uk"));
+        CATCH_REQUIRE_FALSE(edhttp::cookie_jar::is_public_suffix("example.co.uk"));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("x=1; Domain=com", "www.example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("x=1; Domain=co.uk", "shop.example.co.uk", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("x=1; Domain=example.co.uk", "shop.example.co.uk", "/", false, g_now));
+
+        // IP addresses only accept host only cookies
+        //
+        CATCH_REQUIRE(jar.set_cookie("ip=1", "192.168.1.1", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("ip=2; Domain=168.1.1", "192.168.1.1", "/", false, g_now));
+        CATCH_REQUIRE(jar.get_cookies("192.168.1.1", "/", false, g_now) == "ip=1");
+        CATCH_REQUIRE(jar.get_cookies("10.192.168.1.1", "/", false, g_now).empty());
+
+        CATCH_REQUIRE(jar.size() == 4);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: paths and order")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE(jar.set_cookie("a=1; Path=/", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("b=2; Path=/docs/api", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("c=3; Path=/docs", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("d=4; Path=/", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("e=5; Path=invalid", "example.com", "/docs/index.html", false, g_now));
+
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/docs/api/v1", false, g_now) == "b=2; c=3; e=5; a=1; d=4");
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/docs", false, g_now) == "c=3; e=5; a=1; d=4");
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/doc", false, g_now) == "a=1; d=4");
+
+        // replacing keeps the creation order
+        //
+        CATCH_REQUIRE(jar.set_cookie("a=10", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "a=10; d=4");
+        CATCH_REQUIRE(jar.size() == 5);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: secure cookies")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE_FALSE(jar.set_cookie("s=1; Secure", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("s=1; Secure; SameSite=Strict", "example.com", "/", true, g_now));
+        CATCH_REQUIRE(jar.set_cookie("p=2", "example.com", "/", true, g_now));
+        CATCH_REQUIRE(jar.find_cookie("example.com", "/", "s")->f_same_site == edhttp::cookie_jar::same_site_t::SAME_SITE_STRICT);
+
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", true, g_now) == "s=1; p=2");
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "p=2");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: expiration")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE(jar.set_cookie("a=1; Max-Age=60", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("b=2; Expires=Wed, 15 Nov 2023 00:00:00 GMT", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("c=3; Expires=Wed, 15 Nov 2023 00:00:00 GMT; Max-Age=10", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("d=4; Expires=bad date", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.find_cookie("example.com", "/", "a")->f_expire == g_now + 60);
+        CATCH_REQUIRE(jar.find_cookie("example.com", "/", "b")->f_expire == 1700006400);
+        CATCH_REQUIRE(jar.find_cookie("example.com", "/", "c")->f_expire == g_now + 10);
+        CATCH_REQUIRE(jar.find_cookie("example.com", "/", "d")->f_expire == -1);
+        CATCH_REQUIRE(jar.size() == 4);
+
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now + 30) == "a=1; b=2; d=4");
+
+        // a newer expiration date is not purged with the old one
+        //
+        CATCH_REQUIRE(jar.set_cookie("a=1; Max-Age=3600", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.purge_expired(g_now + 100) == 1);
+        CATCH_REQUIRE(jar.size() == 3);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now + 100) == "a=1; b=2; d=4");
+
+        // delete with a past date or a zero Max-Age
+        //
+        CATCH_REQUIRE(jar.set_cookie("b=; Max-Age=0", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("a=; Expires=Thu, 01 Jan 1970 00:00:00 GMT", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.size() == 1);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "d=4");
+
+        jar.clear();
+        CATCH_REQUIRE(jar.size() == 0);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now).empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: eviction when full")
+    {
+        edhttp::cookie_jar jar(3);
+        CATCH_REQUIRE(jar.set_cookie("session=1", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("late=1; Max-Age=1000", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("soon=1; Max-Age=10", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("new=1; Max-Age=500", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.size() == 3);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "session=1; late=1; new=1");
+
+        // expired cookies go first
+        //
+        CATCH_REQUIRE(jar.set_cookie("other=1", "example.com", "/", false, g_now + 600));
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now + 600) == "session=1; late=1; other=1");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: full of session cookies")
+    {
+        edhttp::cookie_jar jar(2);
+        CATCH_REQUIRE(jar.set_cookie("a=1", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("b=1", "example.com", "/", false, g_now));
+
+        // session cookies are never evicted so the new cookie is dropped
+        //
+        CATCH_REQUIRE_FALSE(jar.set_cookie("c=1; Max-Age=60", "example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("d=1", "example.org", "/", false, g_now));
+        CATCH_REQUIRE(jar.size() == 2);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "a=1; b=1");
+        CATCH_REQUIRE(jar.get_cookies("example.org", "/", false, g_now).empty());
+
+        // replacing and deleting existing cookies still works
+        //
+        CATCH_REQUIRE(jar.set_cookie("a=2", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("b=; Max-Age=0", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.set_cookie("c=1; Max-Age=60", "example.com", "/", false, g_now));
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now) == "a=2; c=1");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: refreshed cookies")
+    {
+        edhttp::cookie_jar jar;
+        for(int i(0); i < 1000; ++i)
+        {
+            CATCH_REQUIRE(jar.set_cookie("sid=" + std::to_string(i) + "; Max-Age=60", "example.com", "/", false, g_now + i));
+        }
+        CATCH_REQUIRE(jar.size() == 1);
+        CATCH_REQUIRE(jar.get_cookies("example.com", "/", false, g_now + 1000) == "sid=999");
+        CATCH_REQUIRE(jar.purge_expired(g_now + 1000) == 0);
+        CATCH_REQUIRE(jar.size() == 1);
+        CATCH_REQUIRE(jar.purge_expired(g_now + 999 + 60) == 1);
+        CATCH_REQUIRE(jar.size() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: large jar")
+    {
+        edhttp::cookie_jar jar(10000);
+        for(int i(0); i < 5000; ++i)
+        {
+            std::string const host("www.site" + std::to_string(i % 1000) + ".com");
+            CATCH_REQUIRE(jar.set_cookie("c" + std::to_string(i) + "=" + std::to_string(i) + "; Max-Age=3600", host, "/", false, g_now));
+        }
+        CATCH_REQUIRE(jar.size() == 5000);
+        CATCH_REQUIRE(jar.get_cookies("www.site7.com", "/", false, g_now) == "c7=7; c1007=1007; c2007=2007; c3007=3007; c4007=4007");
+        CATCH_REQUIRE(jar.purge_expired(g_now + 3600) == 5000);
+        CATCH_REQUIRE(jar.size() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: path helpers")
+    {
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("") == "/");
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("docs") == "/");
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("/") == "/");
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("/index.html") == "/");
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("/docs/") == "/docs");
+        CATCH_REQUIRE(edhttp::cookie_jar::default_path("/docs/api/index.html?q=/a/b") == "/docs/api");
+
+        CATCH_REQUIRE(edhttp::cookie_jar::path_match("/docs", "/docs"));
+        CATCH_REQUIRE(edhttp::cookie_jar::path_match("/docs/a", "/docs"));
+        CATCH_REQUIRE(edhttp::cookie_jar::path_match("/docs/a", "/docs/"));
+        CATCH_REQUIRE(edhttp::cookie_jar::path_match("/docs/a", "/"));
+        CATCH_REQUIRE_FALSE(edhttp::cookie_jar::path_match("/docsa", "/docs"));
+        CATCH_REQUIRE_FALSE(edhttp::cookie_jar::path_match("/doc", "/docs"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_jar: invalid Set-Cookie")
+    {
+        edhttp::cookie_jar jar;
+        CATCH_REQUIRE_FALSE(jar.set_cookie("", "example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("novalue", "example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("=value", "example.com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("a=1", "example..com", "/", false, g_now));
+        CATCH_REQUIRE_FALSE(jar.set_cookie("a=1", "", "/", false, g_now));
+        CATCH_REQUIRE(jar.size() == 0);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("cookie_jar_error", "[cookie][error]")
+{
+    CATCH_START_SECTION("cookie_jar: invalid maximum")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::cookie_jar(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the maximum number of cookies in a cookie_jar must be at least 1."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,119 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the cookie_view class.
+ *
+ * This file implements tests to verify that Cookie headers get parsed
+ * as expected.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/cookie_view.h"
+#include    "edhttp/exception.h"
+
+
+
+CATCH_TEST_CASE("cookie_view", "[cookie]")
+{
+    CATCH_START_SECTION("cookie_view: parse a Cookie header")
+    {
+        edhttp::cookie_view cookies("sid=31d4d96e407aad42; lang=en-US;theme = \"dark\" ;empty=; sid=other");
+        CATCH_REQUIRE(cookies.size() == 5);
+        CATCH_REQUIRE_FALSE(cookies.empty());
+
+        CATCH_REQUIRE(cookies.get_cookie(0).f_name == "sid");
+        CATCH_REQUIRE(cookies.get_cookie(0).f_value == "31d4d96e407aad42");
+        CATCH_REQUIRE(cookies.get_cookie(2).f_name == "theme");
+        CATCH_REQUIRE(cookies.get_cookie(2).f_value == "dark");
+        CATCH_REQUIRE(cookies.get_cookie(4).f_value == "other");
+
+        // the first one wins
+        //
+        CATCH_REQUIRE(cookies.get_value("sid") == "31d4d96e407aad42");
+        CATCH_REQUIRE(cookies.get_value("lang") == "en-US");
+        CATCH_REQUIRE(cookies.has_cookie("empty"));
+        CATCH_REQUIRE(cookies.get_value("empty").empty());
+        CATCH_REQUIRE_FALSE(cookies.has_cookie("Lang"));
+        CATCH_REQUIRE(cookies.get_value("missing").empty());
+
+        cookies.clear();
+        CATCH_REQUIRE(cookies.empty());
+        CATCH_REQUIRE(cookies.parse(""));
+        CATCH_REQUIRE(cookies.parse(" ; ;"));
+        CATCH_REQUIRE(cookies.empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_view: many cookies")
+    {
+        std::string header;
+        for(int i(0); i < 100; ++i)
+        {
+            if(i != 0)
+            {
+                header += "; ";
+            }
+            header += "c" + std::to_string(i) + "=v" + std::to_string(i);
+        }
+        edhttp::cookie_view cookies(header);
+        CATCH_REQUIRE(cookies.size() == 100);
+        for(int i(0); i < 100; ++i)
+        {
+            CATCH_REQUIRE(cookies.get_value("c" + std::to_string(i)) == "v" + std::to_string(i));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_view: percent decoding")
+    {
+        edhttp::cookie_view cookies("name=John%20Doe%3B%20Jr; plus=a+b; bad=100%; partial=%4g%41");
+        CATCH_REQUIRE(cookies.get_value("name") == "John%20Doe%3B%20Jr");
+        CATCH_REQUIRE(cookies.get_decoded_value("name") == "John Doe; Jr");
+        CATCH_REQUIRE(cookies.get_decoded_value("plus") == "a+b");
+        CATCH_REQUIRE(cookies.get_decoded_value("bad") == "100%");
+        CATCH_REQUIRE(cookies.get_decoded_value("partial") == "%4gA");
+        CATCH_REQUIRE(cookies.get_decoded_value("missing").empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("cookie_view: invalid pairs are skipped")
+    {
+        edhttp::cookie_view cookies;
+        CATCH_REQUIRE_FALSE(cookies.parse("a=1; novalue; =2; b=3"));
+        CATCH_REQUIRE(cookies.size() == 2);
+        CATCH_REQUIRE(cookies.get_value("a") == "1");
+        CATCH_REQUIRE(cookies.get_value("b") == "3");
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  cookies.get_cookie(2)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: cookie index out of range."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
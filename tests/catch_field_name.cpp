@@ -0,0 +1,95 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the field name interning table.
+ *
+ * This file implements tests to verify that all the field names defined
+ * in names.an get a unique identifier.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/field_name.h"
+#include    "edhttp/names.h"
+
+
+// C++
+//
+#include    <algorithm>
+
+
+
+// the lookup is constexpr
+//
+static_assert(edhttp::get_field_name_id("Host") == edhttp::field_name_t::FIELD_NAME_HOST);
+static_assert(edhttp::get_field_name(edhttp::field_name_t::FIELD_NAME_SET_COOKIE) == "Set-Cookie");
+
+
+
+CATCH_TEST_CASE("field_name", "[field_name]")
+{
+    CATCH_START_SECTION("field_name: all names round trip")
+    {
+        for(std::size_t idx(0); idx < static_cast<std::size_t>(edhttp::field_name_t::FIELD_NAME_UNKNOWN); ++idx)
+        {
+            edhttp::field_name_t const id(static_cast<edhttp::field_name_t>(idx));
+            std::string name(edhttp::get_field_name(id));
+            CATCH_REQUIRE_FALSE(name.empty());
+            CATCH_REQUIRE(edhttp::get_field_name_id(name) == id);
+
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            CATCH_REQUIRE(edhttp::get_field_name_id(name) == id);
+
+            std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+            CATCH_REQUIRE(edhttp::get_field_name_id(name) == id);
+
+            // a similar name which differs in more than the case
+            //
+            name[0] ^= 0x20;
+            name += '-';
+            CATCH_REQUIRE(edhttp::get_field_name_id(name) == edhttp::field_name_t::FIELD_NAME_UNKNOWN);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("field_name: names.an entries")
+    {
+        CATCH_REQUIRE(edhttp::get_field_name_id(g_name_edhttp_field_content_length_lowercase) == edhttp::field_name_t::FIELD_NAME_CONTENT_LENGTH);
+        CATCH_REQUIRE(edhttp::get_field_name_id(g_name_edhttp_field_user_agent) == edhttp::field_name_t::FIELD_NAME_USER_AGENT);
+        CATCH_REQUIRE(edhttp::get_field_name(edhttp::field_name_t::FIELD_NAME_LINK) == g_name_edhttp_field_link);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("field_name: unknown names")
+    {
+        CATCH_REQUIRE(edhttp::get_field_name_id("") == edhttp::field_name_t::FIELD_NAME_UNKNOWN);
+        CATCH_REQUIRE(edhttp::get_field_name_id("X-Custom-Field") == edhttp::field_name_t::FIELD_NAME_UNKNOWN);
+        CATCH_REQUIRE(edhttp::get_field_name_id("Content\rLength") == edhttp::field_name_t::FIELD_NAME_UNKNOWN);
+        CATCH_REQUIRE(edhttp::get_field_name(edhttp::field_name_t::FIELD_NAME_UNKNOWN).empty());
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
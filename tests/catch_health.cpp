@@ -0,0 +1,435 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the health status and the pre-rendered responses.
+ *
+ * This file implements tests to verify the responses sent back to
+ * health probes and that the status can be changed while probes are
+ * being answered.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/health.h"
+#include    "edhttp/metrics.h"
+
+
+// C++
+//
+#include    <atomic>
+#include    <thread>
+#include    <vector>
+
+
+
+namespace
+{
+
+
+
+std::string get_body(std::string_view response)
+{
+    std::string_view::size_type const pos(response.find("\r\n\r\n"));
+    if(pos == std::string_view::npos)
+    {
+        return "<no body>";
+    }
+    return std::string(response.substr(pos + 4));
+}
+
+
+std::string get_status_line(std::string_view response)
+{
+    return std::string(response.substr(0, response.find("\r\n")));
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("health_status", "[health]")
+{
+    CATCH_START_SECTION("health_status: starting by default")
+    {
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_STARTING);
+
+        std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(get_body(response) == "STARTING\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_status: OK")
+    {
+        edhttp::set_status(edhttp::HEALTH_OK);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(response ==
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/plain; charset=utf-8\r\n"
+                "Content-Length: 3\r\n"
+                "Cache-Control: no-store\r\n"
+                "Connection: close\r\n"
+                "\r\n"
+                "OK\n");
+
+        // the same buffer is returned as long as the status does not change
+        //
+        edhttp::set_status(edhttp::HEALTH_OK);
+        CATCH_REQUIRE(edhttp::get_health_response("GET /health?full=1 HTTP/1.0").data() == response.data());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_status: errors")
+    {
+        edhttp::set_status(edhttp::HEALTH_ERROR);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+        std::string_view response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(get_body(response) == "ERROR\n");
+
+        edhttp::set_status(edhttp::HEALTH_FAILED);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_FAILED);
+        response = edhttp::get_health_response("GET /health HTTP/1.1");
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(get_body(response) == "FAILED\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_status: custom status")
+    {
+        edhttp::set_status("MAINTENANCE");
+        CATCH_REQUIRE(edhttp::get_status() == "MAINTENANCE");
+        std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(response.find("\r\nContent-Length: 12\r\n") != std::string_view::npos);
+        CATCH_REQUIRE(get_body(response) == "MAINTENANCE\n");
+
+        // a custom status gets rendered only once
+        //
+        edhttp::set_status(edhttp::HEALTH_OK);
+        edhttp::set_status("MAINTENANCE");
+        CATCH_REQUIRE(edhttp::get_health_response("GET /health HTTP/1.1").data() == response.data());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_status: number of custom statuses is limited")
+    {
+        // other sections may already have used some custom statuses
+        //
+        std::size_t const max(edhttp::HEALTH_MAX_CUSTOM_STATUSES + 1);
+        std::size_t count(0);
+        for(; count < max; ++count)
+        {
+            std::string const status("STEP-" + std::to_string(count));
+            edhttp::set_status(status);
+            if(edhttp::get_status() != status)
+            {
+                break;
+            }
+        }
+        CATCH_REQUIRE(count < max);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+        std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(get_body(response) == "ERROR\n");
+
+        // the statuses rendered before the limit are still available
+        //
+        if(count > 0)
+        {
+            edhttp::set_status("STEP-0");
+            CATCH_REQUIRE(edhttp::get_status() == "STEP-0");
+        }
+        edhttp::set_status(edhttp::HEALTH_OK);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("health_response", "[health]")
+{
+    CATCH_START_SECTION("health_response: HEAD has no body")
+    {
+        edhttp::set_status(edhttp::HEALTH_OK);
+        std::string_view const get(edhttp::get_health_response("GET /health HTTP/1.1"));
+        std::string_view const head(edhttp::get_health_response("HEAD /health HTTP/1.1"));
+        CATCH_REQUIRE(head.length() + 3 == get.length());
+        CATCH_REQUIRE(get.starts_with(head));
+        CATCH_REQUIRE(head.ends_with("\r\n\r\n"));
+        CATCH_REQUIRE(head.find("\r\nContent-Length: 3\r\n") != std::string_view::npos);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_response: errors")
+    {
+        std::string_view response(edhttp::get_health_response("POST /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 405 Method Not Allowed");
+        CATCH_REQUIRE(response.find("\r\nAllow: GET, HEAD\r\n") != std::string_view::npos);
+
+        response = edhttp::get_health_response("GET / HTTP/1.1");
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 404 Not Found");
+        CATCH_REQUIRE(get_body(response) == "404 Not Found\n");
+
+        CATCH_REQUIRE(get_status_line(edhttp::get_health_response("GET /healthy HTTP/1.1")) == "HTTP/1.1 404 Not Found");
+        CATCH_REQUIRE(get_status_line(edhttp::get_health_response("POST /status HTTP/1.1")) == "HTTP/1.1 404 Not Found");
+
+        char const * bad_requests[] =
+        {
+            "",
+            "GET",
+            "GET /health",
+            "GET /health HTTP/2",
+            "GET /health FTP/1.1",
+            "GET  /health HTTP/1.1",
+        };
+        for(auto const & r : bad_requests)
+        {
+            CATCH_REQUIRE(get_status_line(edhttp::get_health_response(r)) == "HTTP/1.1 400 Bad Request");
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_response: metrics")
+    {
+        edhttp::metrics_registry::instance().get_counter("test_health_probes_total", "Probes.").increment(3);
+
+        std::string_view response(edhttp::get_health_response("GET /metrics HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 200 OK");
+        CATCH_REQUIRE(response.find("\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n") != std::string_view::npos);
+        std::string const body(get_body(response));
+        CATCH_REQUIRE(body.find("# TYPE test_health_probes_total counter\ntest_health_probes_total 3\n") != std::string::npos);
+        CATCH_REQUIRE(response.find("\r\nContent-Length: " + std::to_string(body.length()) + "\r\n") != std::string_view::npos);
+
+        response = edhttp::get_health_response("HEAD /metrics HTTP/1.1");
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 200 OK");
+        CATCH_REQUIRE(response.ends_with("\r\n\r\n"));
+
+        response = edhttp::get_health_response("DELETE /metrics HTTP/1.1");
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 405 Method Not Allowed");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_response: change status while reading")
+    {
+        std::atomic<bool> done(false);
+        std::vector<std::thread> workers;
+        for(int idx(0); idx < 4; ++idx)
+        {
+            workers.emplace_back([&done, idx]()
+                {
+                    char const * statuses[] = { edhttp::HEALTH_OK, edhttp::HEALTH_ERROR };
+                    for(int count(0); count < 10000; ++count)
+                    {
+                        edhttp::set_status(statuses[(count + idx) % 2]);
+                    }
+                    done = true;
+                });
+        }
+
+        std::size_t probes(0);
+        while(!done || probes < 1000)
+        {
+            std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+            std::string const body(get_body(response));
+            if(body == "OK\n")
+            {
+                CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 200 OK");
+            }
+            else
+            {
+                CATCH_REQUIRE(body == "ERROR\n");
+                CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+            }
+            ++probes;
+        }
+
+        for(auto & w : workers)
+        {
+            w.join();
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("health_workers", "[health]")
+{
+    CATCH_START_SECTION("health_workers: stalled busy worker")
+    {
+        edhttp::set_status(edhttp::HEALTH_OK);
+        int const worker(edhttp::register_health_worker("test-worker", std::chrono::milliseconds(100)));
+        std::chrono::steady_clock::time_point const now(std::chrono::steady_clock::now());
+
+        CATCH_REQUIRE(edhttp::check_health_workers(now) == 0);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        // idle workers are never stalled
+        //
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::seconds(10)) == 0);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_BUSY);
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::milliseconds(20'000)) == 0);
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::milliseconds(20'050)) == 0);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::milliseconds(20'200)) == 1);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+        std::string_view const response(edhttp::get_health_response("GET /health HTTP/1.1"));
+        CATCH_REQUIRE(get_status_line(response) == "HTTP/1.1 503 Service Unavailable");
+        CATCH_REQUIRE(get_body(response) == "ERROR\n");
+
+        // still stalled on the next tick
+        //
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::milliseconds(21'000)) == 1);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+
+        std::string metrics;
+        edhttp::metrics_registry::instance().render(metrics);
+        CATCH_REQUIRE(metrics.find("edhttp_health_stalled_workers 1\n") != std::string::npos);
+
+        edhttp::health_heartbeat(worker);
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::milliseconds(21'050)) == 0);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        edhttp::unregister_health_worker(worker);
+        CATCH_REQUIRE(edhttp::check_health_workers(now + std::chrono::seconds(60)) == 0);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_workers: worst status wins")
+    {
+        edhttp::set_status(edhttp::HEALTH_OK);
+        int const worker(edhttp::register_health_worker("failing-worker", std::chrono::milliseconds(100)));
+
+        edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_ERROR);
+        edhttp::check_health_workers();
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+
+        edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_FAILED);
+        edhttp::check_health_workers();
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_FAILED);
+
+        // the service cannot hide a failed worker
+        //
+        edhttp::set_status(edhttp::HEALTH_ERROR);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_FAILED);
+
+        edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_IDLE);
+        edhttp::check_health_workers();
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_ERROR);
+
+        edhttp::set_status(edhttp::HEALTH_FAILED);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_FAILED);
+
+        edhttp::set_status(edhttp::HEALTH_OK);
+        CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+
+        edhttp::unregister_health_worker(worker);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_workers: concurrent heartbeats")
+    {
+        edhttp::set_status(edhttp::HEALTH_OK);
+
+        std::atomic<bool> done(false);
+        std::vector<std::thread> workers;
+        for(int idx(0); idx < 4; ++idx)
+        {
+            workers.emplace_back([&done, idx]()
+                {
+                    int const worker(edhttp::register_health_worker(
+                              "worker-" + std::to_string(idx)
+                            , std::chrono::seconds(10)));
+                    edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_BUSY);
+                    while(!done.load())
+                    {
+                        edhttp::health_heartbeat(worker);
+                    }
+                    edhttp::set_health_worker_state(worker, edhttp::worker_state_t::WORKER_STATE_IDLE);
+                    edhttp::unregister_health_worker(worker);
+                });
+        }
+
+        for(int tick(0); tick < 1000; ++tick)
+        {
+            CATCH_REQUIRE(edhttp::check_health_workers() == 0);
+            CATCH_REQUIRE(edhttp::get_status() == edhttp::HEALTH_OK);
+        }
+        done = true;
+
+        for(auto & w : workers)
+        {
+            w.join();
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_workers: errors")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::health_heartbeat(-1)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: health worker identifier -1 is out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::set_health_worker_state(static_cast<int>(edhttp::HEALTH_MAX_WORKERS), edhttp::worker_state_t::WORKER_STATE_BUSY)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: health worker identifier 64 is out of range."));
+
+        std::vector<int> ids;
+        for(std::size_t idx(0); idx < edhttp::HEALTH_MAX_WORKERS; ++idx)
+        {
+            ids.push_back(edhttp::register_health_worker("filler", std::chrono::seconds(1)));
+        }
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::register_health_worker("one-too-many", std::chrono::seconds(1))
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: too many health workers, cannot register \"one-too-many\"."));
+
+        // once freed, a slot can be reused
+        //
+        edhttp::unregister_health_worker(ids[10]);
+        CATCH_REQUIRE(edhttp::register_health_worker("reused", std::chrono::seconds(1)) == ids[10]);
+
+        for(auto id : ids)
+        {
+            edhttp::unregister_health_worker(id);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,300 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the health checker client.
+ *
+ * This file implements tests to verify the parsing of the health
+ * statuses, the settings of the health checker, and that unreachable
+ * targets do not block a check for longer than the timeout.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/health.h"
+#include    "edhttp/health_checker.h"
+
+
+// C++
+//
+#include    <array>
+#include    <filesystem>
+#include    <iterator>
+
+
+// C
+//
+#include    <arpa/inet.h>
+#include    <netinet/in.h>
+#include    <sys/socket.h>
+#include    <unistd.h>
+
+
+
+namespace
+{
+
+
+
+/** \brief A loopback server which never answers connections.
+ *
+ * The listen queue gets filled and the server never calls accept()
+ * so the kernel drops the SYN of any further connection, the same
+ * as a blackholed address.
+ */
+class blackhole_server
+{
+public:
+    blackhole_server()
+    {
+        f_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length(sizeof(a));
+        CATCH_REQUIRE(bind(f_socket, reinterpret_cast<sockaddr *>(&a), sizeof(a)) == 0);
+        CATCH_REQUIRE(getsockname(f_socket, reinterpret_cast<sockaddr *>(&a), &length) == 0);
+        CATCH_REQUIRE(listen(f_socket, 0) == 0);
+        f_port = ntohs(a.sin_port);
+
+        for(std::size_t idx(0); idx < f_fillers.size(); ++idx)
+        {
+            f_fillers[idx] = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            connect(f_fillers[idx], reinterpret_cast<sockaddr *>(&a), sizeof(a));
+        }
+    }
+
+    blackhole_server(blackhole_server const &) = delete;
+    blackhole_server & operator = (blackhole_server const &) = delete;
+
+    ~blackhole_server()
+    {
+        for(auto s : f_fillers)
+        {
+            close(s);
+        }
+        close(f_socket);
+    }
+
+    int get_port() const
+    {
+        return f_port;
+    }
+
+private:
+    int                 f_socket = -1;
+    int                 f_port = 0;
+    std::array<int, 4>  f_fillers = {};
+};
+
+
+std::size_t thread_count()
+{
+    return std::distance(
+                  std::filesystem::directory_iterator("/proc/self/task")
+                , std::filesystem::directory_iterator());
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("health_checker", "[health]")
+{
+    CATCH_START_SECTION("health_checker: parse statuses")
+    {
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("OK\n") == edhttp::health_checker::result_t::RESULT_OK);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("OK\r\n") == edhttp::health_checker::result_t::RESULT_OK);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status(edhttp::HEALTH_OK) == edhttp::health_checker::result_t::RESULT_OK);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("STARTING\n") == edhttp::health_checker::result_t::RESULT_STARTING);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("ERROR\n") == edhttp::health_checker::result_t::RESULT_ERROR);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("FAILED\n") == edhttp::health_checker::result_t::RESULT_FAILED);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("MAINTENANCE\n") == edhttp::health_checker::result_t::RESULT_UNKNOWN);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("ok\n") == edhttp::health_checker::result_t::RESULT_UNKNOWN);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("OK OK\n") == edhttp::health_checker::result_t::RESULT_UNKNOWN);
+        CATCH_REQUIRE(edhttp::health_checker::parse_status("") == edhttp::health_checker::result_t::RESULT_UNKNOWN);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker: result names")
+    {
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_OK)) == "OK");
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_STARTING)) == "STARTING");
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_UNKNOWN)) == "UNKNOWN");
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_ERROR)) == "ERROR");
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_FAILED)) == "FAILED");
+        CATCH_REQUIRE(std::string(edhttp::health_checker::result_to_string(edhttp::health_checker::result_t::RESULT_UNREACHABLE)) == "UNREACHABLE");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker: settings")
+    {
+        edhttp::health_checker checker;
+        CATCH_REQUIRE(checker.get_concurrency() == edhttp::health_checker::DEFAULT_CONCURRENCY);
+        CATCH_REQUIRE(checker.get_timeout() == edhttp::health_checker::DEFAULT_TIMEOUT);
+        CATCH_REQUIRE(checker.size() == 0);
+
+        checker.set_concurrency(1'000);
+        CATCH_REQUIRE(checker.get_concurrency() == 1'000);
+
+        checker.set_timeout(std::chrono::milliseconds(250));
+        CATCH_REQUIRE(checker.get_timeout() == std::chrono::milliseconds(250));
+
+        // no targets, nothing to check
+        //
+        CATCH_REQUIRE(checker.check().empty());
+        CATCH_REQUIRE(checker.get_overall() == edhttp::health_checker::result_t::RESULT_OK);
+        CATCH_REQUIRE(checker.count(edhttp::health_checker::result_t::RESULT_OK) == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker: unreachable targets")
+    {
+        // nothing listens on port 1 of the loopback
+        //
+        edhttp::health_checker checker(4, std::chrono::milliseconds(500));
+        for(int idx(0); idx < 10; ++idx)
+        {
+            checker.add_target("http://127.0.0.1:1/health");
+        }
+        CATCH_REQUIRE(checker.size() == 10);
+
+        edhttp::health_checker::probe_vector_t const & probes(checker.check());
+        CATCH_REQUIRE(probes.size() == 10);
+        for(auto const & p : probes)
+        {
+            CATCH_REQUIRE(p.f_uri == "http://127.0.0.1:1/health");
+            CATCH_REQUIRE(p.f_result == edhttp::health_checker::result_t::RESULT_UNREACHABLE);
+            CATCH_REQUIRE_FALSE(p.f_error.empty());
+        }
+        CATCH_REQUIRE(checker.count(edhttp::health_checker::result_t::RESULT_UNREACHABLE) == 10);
+        CATCH_REQUIRE(checker.get_overall() == edhttp::health_checker::result_t::RESULT_UNREACHABLE);
+
+        checker.clear();
+        CATCH_REQUIRE(checker.size() == 0);
+        CATCH_REQUIRE(checker.get_probes().empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker: blackholed targets time out")
+    {
+        blackhole_server server;
+        std::chrono::milliseconds const timeout(300);
+        edhttp::health_checker checker(2, timeout);
+        checker.add_target("http://127.0.0.1:" + std::to_string(server.get_port()) + "/health");
+        checker.add_target("http://10.255.255.1:80/health");
+
+        std::chrono::steady_clock::time_point const start(std::chrono::steady_clock::now());
+        edhttp::health_checker::probe_vector_t const & probes(checker.check());
+        std::chrono::steady_clock::duration const duration(std::chrono::steady_clock::now() - start);
+
+        CATCH_REQUIRE(probes.size() == 2);
+        for(auto const & p : probes)
+        {
+            CATCH_REQUIRE(p.f_result == edhttp::health_checker::result_t::RESULT_UNREACHABLE);
+            CATCH_REQUIRE_FALSE(p.f_error.empty());
+            CATCH_REQUIRE(p.f_duration < timeout + std::chrono::milliseconds(200));
+        }
+        CATCH_REQUIRE(duration < timeout + std::chrono::milliseconds(200));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker: threads are reused")
+    {
+        edhttp::health_checker checker(4, std::chrono::milliseconds(250));
+        for(int idx(0); idx < 10; ++idx)
+        {
+            checker.add_target("http://127.0.0.1:1/health");
+        }
+
+        std::size_t const before(thread_count());
+        checker.check();
+        std::size_t const running(thread_count());
+        CATCH_REQUIRE(running == before + 3);
+        for(int idx(0); idx < 5; ++idx)
+        {
+            checker.check();
+            CATCH_REQUIRE(thread_count() == running);
+            CATCH_REQUIRE(checker.count(edhttp::health_checker::result_t::RESULT_UNREACHABLE) == 10);
+        }
+
+        // fewer threads than the pool has
+        //
+        checker.set_concurrency(2);
+        CATCH_REQUIRE(thread_count() == before);
+        checker.check();
+        CATCH_REQUIRE(thread_count() == before + 1);
+        CATCH_REQUIRE(checker.count(edhttp::health_checker::result_t::RESULT_UNREACHABLE) == 10);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("health_checker_errors", "[health][error]")
+{
+    CATCH_START_SECTION("health_checker_errors: invalid settings")
+    {
+        edhttp::health_checker checker;
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  checker.set_concurrency(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the health checker concurrency must be at least 1."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  checker.set_timeout(std::chrono::milliseconds(0))
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the health checker timeout must be positive."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::health_checker(1, std::chrono::milliseconds(-5))
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the health checker timeout must be positive."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("health_checker_errors: unsupported scheme")
+    {
+        edhttp::health_checker checker;
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  checker.add_target("ftp://127.0.0.1/health")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: health target \"ftp://127.0.0.1/health\" must use the http or https scheme."));
+        CATCH_REQUIRE(checker.size() == 0);
+
+        checker.add_target("https://127.0.0.1/health");
+        CATCH_REQUIRE(checker.size() == 1);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
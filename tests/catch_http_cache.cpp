@@ -0,0 +1,259 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the http_cache class.
+ *
+ * This file implements tests to verify that the http_cache class saves,
+ * evicts, and purges entries as expected.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/http_cache.h"
+
+
+
+CATCH_TEST_CASE("http_cache", "[cache]")
+{
+    CATCH_START_SECTION("http_cache: store and lookup")
+    {
+        edhttp::http_cache cache(1024 * 1024, 4);
+        CATCH_REQUIRE(cache.get_byte_budget() == 1024 * 1024);
+        CATCH_REQUIRE(cache.get_entry_count() == 0);
+        CATCH_REQUIRE(cache.get_byte_size() == 0);
+
+        edhttp::cache_control_settings settings("max-age=60", false);
+        CATCH_REQUIRE(cache.store("/index.html", "<html>index</html>", settings, 1000));
+        CATCH_REQUIRE(cache.get_entry_count() == 1);
+        CATCH_REQUIRE(cache.get_byte_size() > 0);
+
+        std::string response;
+        CATCH_REQUIRE(cache.lookup("/index.html", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+        CATCH_REQUIRE(response == "<html>index</html>");
+        CATCH_REQUIRE(cache.lookup("/index.html", response, 1059) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+        CATCH_REQUIRE(cache.lookup("/missing.html", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+
+        // expired and no stale-while-revalidate
+        //
+        CATCH_REQUIRE(cache.lookup("/index.html", response, 1060) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+        CATCH_REQUIRE(cache.get_entry_count() == 0);
+        CATCH_REQUIRE(cache.get_byte_size() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: responses that cannot be saved")
+    {
+        edhttp::http_cache cache(1024 * 1024);
+
+        edhttp::cache_control_settings no_store("max-age=60,no-store", false);
+        CATCH_REQUIRE_FALSE(cache.store("/a", "a", no_store, 1000));
+
+        edhttp::cache_control_settings private_cache("max-age=60,private", false);
+        CATCH_REQUIRE_FALSE(cache.store("/b", "b", private_cache, 1000));
+
+        edhttp::cache_control_settings zero("max-age=0", false);
+        CATCH_REQUIRE_FALSE(cache.store("/c", "c", zero, 1000));
+
+        CATCH_REQUIRE(cache.get_entry_count() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: s-maxage has priority")
+    {
+        edhttp::http_cache cache(1024 * 1024);
+
+        edhttp::cache_control_settings settings("max-age=600,s-maxage=10", false);
+        CATCH_REQUIRE(cache.store("/a", "a", settings, 1000));
+
+        std::string response;
+        CATCH_REQUIRE(cache.lookup("/a", response, 1009) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+        CATCH_REQUIRE(cache.lookup("/a", response, 1010) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: stale-while-revalidate")
+    {
+        edhttp::http_cache cache(1024 * 1024);
+
+        edhttp::cache_control_settings settings("max-age=10", false);
+        CATCH_REQUIRE(settings.get_stale_while_revalidate() < 0);
+        settings.set_stale_while_revalidate(20);
+        CATCH_REQUIRE(settings.get_stale_while_revalidate() == 20);
+        CATCH_REQUIRE(cache.store("/a", "old", settings, 1000));
+
+        std::string response;
+        CATCH_REQUIRE(cache.lookup("/a", response, 1005) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+
+        // first caller has to revalidate, the others get the stale data
+        //
+        CATCH_REQUIRE(cache.lookup("/a", response, 1015) == edhttp::http_cache::lookup_t::LOOKUP_REVALIDATE);
+        CATCH_REQUIRE(response == "old");
+        CATCH_REQUIRE(cache.lookup("/a", response, 1016) == edhttp::http_cache::lookup_t::LOOKUP_STALE);
+        CATCH_REQUIRE(response == "old");
+
+        CATCH_REQUIRE(cache.store("/a", "new", settings, 1017));
+        CATCH_REQUIRE(cache.lookup("/a", response, 1018) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+        CATCH_REQUIRE(response == "new");
+
+        CATCH_REQUIRE(cache.lookup("/a", response, 1017 + 30) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: failed revalidation")
+    {
+        edhttp::http_cache cache(1024 * 1024);
+        CATCH_REQUIRE(cache.get_revalidation_lease() == edhttp::http_cache::DEFAULT_REVALIDATION_LEASE);
+        cache.set_revalidation_lease(5);
+        CATCH_REQUIRE(cache.get_revalidation_lease() == 5);
+
+        edhttp::cache_control_settings settings("max-age=10", false);
+        settings.set_stale_while_revalidate(60);
+        CATCH_REQUIRE(cache.store("/a", "old", settings, 1000));
+
+        std::string response;
+        CATCH_REQUIRE_FALSE(cache.cancel_revalidation("/a"));
+        CATCH_REQUIRE_FALSE(cache.cancel_revalidation("/unknown"));
+
+        // the revalidating caller gives up, the next caller takes over
+        //
+        CATCH_REQUIRE(cache.lookup("/a", response, 1015) == edhttp::http_cache::lookup_t::LOOKUP_REVALIDATE);
+        CATCH_REQUIRE(cache.lookup("/a", response, 1016) == edhttp::http_cache::lookup_t::LOOKUP_STALE);
+        CATCH_REQUIRE(cache.cancel_revalidation("/a"));
+        CATCH_REQUIRE_FALSE(cache.cancel_revalidation("/a"));
+        CATCH_REQUIRE(cache.lookup("/a", response, 1016) == edhttp::http_cache::lookup_t::LOOKUP_REVALIDATE);
+
+        // the revalidating caller never comes back, the lease expires
+        //
+        CATCH_REQUIRE(cache.lookup("/a", response, 1020) == edhttp::http_cache::lookup_t::LOOKUP_STALE);
+        CATCH_REQUIRE(cache.lookup("/a", response, 1021) == edhttp::http_cache::lookup_t::LOOKUP_REVALIDATE);
+        CATCH_REQUIRE(cache.lookup("/a", response, 1022) == edhttp::http_cache::lookup_t::LOOKUP_STALE);
+        CATCH_REQUIRE(response == "old");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: purge by tag")
+    {
+        edhttp::http_cache cache(1024 * 1024);
+
+        edhttp::cache_control_settings product("max-age=60", false);
+        product.add_tag("product-33");
+        product.add_tag("products");
+
+        edhttp::cache_control_settings other_product("max-age=60", false);
+        other_product.add_tag("product-45");
+        other_product.add_tag("products");
+
+        edhttp::cache_control_settings untagged("max-age=60", false);
+
+        CATCH_REQUIRE(cache.store("/product/33", "33", product, 1000));
+        CATCH_REQUIRE(cache.store("/product/33/reviews", "33 reviews", product, 1000));
+        CATCH_REQUIRE(cache.store("/product/45", "45", other_product, 1000));
+        CATCH_REQUIRE(cache.store("/about", "about", untagged, 1000));
+        CATCH_REQUIRE(cache.get_entry_count() == 4);
+
+        CATCH_REQUIRE(cache.purge_tag("unknown") == 0);
+        CATCH_REQUIRE(cache.purge_tag("product-33") == 2);
+        CATCH_REQUIRE(cache.get_entry_count() == 2);
+        CATCH_REQUIRE(cache.purge_tag("product-33") == 0);
+
+        std::string response;
+        CATCH_REQUIRE(cache.lookup("/product/33", response, 1001) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+        CATCH_REQUIRE(cache.lookup("/product/45", response, 1001) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+
+        CATCH_REQUIRE(cache.purge_tag("products") == 1);
+        CATCH_REQUIRE(cache.get_entry_count() == 1);
+        CATCH_REQUIRE(cache.lookup("/about", response, 1001) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+
+        CATCH_REQUIRE(cache.erase("/about"));
+        CATCH_REQUIRE_FALSE(cache.erase("/about"));
+        CATCH_REQUIRE(cache.get_entry_count() == 0);
+        CATCH_REQUIRE(cache.get_byte_size() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cache: byte budget eviction keeps hot entries")
+    {
+        // one shard so we know exactly what gets evicted
+        //
+        edhttp::http_cache cache(4096, 1);
+        edhttp::cache_control_settings settings("max-age=60", false);
+
+        std::string const data(500, 'x');
+        CATCH_REQUIRE(cache.store("/hot", data, settings, 1000));
+
+        std::string response;
+        CATCH_REQUIRE(cache.lookup("/hot", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+
+        // a scan of many one time entries does not evict the hot entry
+        //
+        for(int i(0); i < 100; ++i)
+        {
+            CATCH_REQUIRE(cache.store("/cold/" + std::to_string(i), data, settings, 1000));
+            CATCH_REQUIRE(cache.get_byte_size() <= 4096);
+        }
+        CATCH_REQUIRE(cache.lookup("/hot", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+        CATCH_REQUIRE(cache.lookup("/cold/0", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_MISS);
+        CATCH_REQUIRE(cache.lookup("/cold/99", response, 1000) == edhttp::http_cache::lookup_t::LOOKUP_FRESH);
+
+        // too large for the budget
+        //
+        CATCH_REQUIRE_FALSE(cache.store("/large", std::string(5000, 'y'), settings, 1000));
+
+        cache.clear();
+        CATCH_REQUIRE(cache.get_entry_count() == 0);
+        CATCH_REQUIRE(cache.get_byte_size() == 0);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_cache_error", "[cache][error]")
+{
+    CATCH_START_SECTION("http_cache: invalid parameters")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::http_cache(1024, 0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the number of shards of an http_cache must be at least 1."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::http_cache(1024, 16)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the byte budget of an http_cache is too small for the number of shards."));
+
+        edhttp::http_cache cache(1024 * 1024);
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  cache.set_revalidation_lease(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the revalidation lease of an http_cache must be at least 1 second."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,162 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the serialization of the http_cookie class.
+ *
+ * This file implements tests to verify that cookies get serialized as
+ * expected in Set-Cookie headers, one at a time or in batches.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/http_cookie.h"
+#include    "edhttp/http_date.h"
+
+
+
+CATCH_TEST_CASE("http_cookie", "[cookie]")
+{
+    CATCH_START_SECTION("http_cookie: session cookie")
+    {
+        edhttp::http_cookie cookie("sid", "abc123");
+        cookie.set_domain("example.com");
+        cookie.set_secure();
+        cookie.set_http_only();
+        CATCH_REQUIRE(cookie.to_http_header() == "Set-Cookie: sid=abc123; Domain=example.com; Path=/; Secure; HttpOnly");
+
+        std::string out("prefix:");
+        cookie.append_http_header(out);
+        CATCH_REQUIRE(out == "prefix:sid=abc123; Domain=example.com; Path=/; Secure; HttpOnly");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cookie: percent encoding")
+    {
+        edhttp::http_cookie cookie("v");
+        cookie.set_value(std::string("a b;c,d\\e\"f\x7F\x80\xFF\x01!#+-:<[]~", 24));
+        cookie.set_path(std::string());
+        std::string out;
+        cookie.append_http_header(out);
+        CATCH_REQUIRE(out == "v=a%20b%3Bc%2Cd%5Ce%22f%7F%80%FF%01!#+-:<[]~");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cookie: permanent and deleted cookies")
+    {
+        edhttp::http_cookie cookie("p", "1");
+        cookie.set_expire_in(3600);
+        time_t const expire(cookie.get_expire());
+        char date[edhttp::HTTP_DATE_LENGTH];
+        std::string const expected_date(edhttp::format_http_date(expire, date));
+
+        std::string out;
+        cookie.append_http_header(out, expire - 100);
+        CATCH_REQUIRE(out == "p=1; Expires=" + expected_date + "; Max-Age=100; Path=/");
+
+        // no Max-Age once the date is passed
+        //
+        out.clear();
+        cookie.append_http_header(out, expire);
+        CATCH_REQUIRE(out == "p=1; Expires=" + expected_date + "; Path=/");
+
+        cookie.set_delete();
+        out.clear();
+        cookie.append_http_header(out);
+        CATCH_REQUIRE(out == "p=1; Expires=Thu, 01-Jan-1970 00:00:01 GMT; Path=/");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_cookie: batch of cookies")
+    {
+        edhttp::http_cookie::vector_t cookies;
+        for(int i(0); i < 20; ++i)
+        {
+            edhttp::http_cookie cookie("c" + std::to_string(i), "v" + std::to_string(i));
+            if(i % 2 == 0)
+            {
+                cookie.set_expire_in(3600 + i % 6);
+            }
+            cookies.push_back(cookie);
+        }
+        time_t const now(cookies[0].get_expire() - 3600);
+
+        std::string expected;
+        for(auto const & c : cookies)
+        {
+            expected += c.to_http_header();
+            expected += "\r\n";
+        }
+
+        std::string out;
+        edhttp::append_set_cookies(out, cookies, now);
+        CATCH_REQUIRE(out.length() == expected.length());
+
+        // the Max-Age of to_http_header() depends on the current time,
+        // compare the lines without it
+        //
+        std::string::size_type pos(0);
+        for(auto const & c : cookies)
+        {
+            std::string::size_type const end(out.find("\r\n", pos));
+            CATCH_REQUIRE(end != std::string::npos);
+            std::string const line(out.substr(pos, end - pos));
+            std::string single;
+            c.append_http_header(single, now);
+            CATCH_REQUIRE(line == "Set-Cookie: " + single);
+            pos = end + 2;
+        }
+        CATCH_REQUIRE(pos == out.length());
+
+        edhttp::http_cookie::map_t map;
+        for(auto const & c : cookies)
+        {
+            map[c.get_name()] = c;
+        }
+        std::string map_out;
+        edhttp::append_set_cookies(map_out, map, now);
+        CATCH_REQUIRE(map_out.length() == out.length());
+
+        std::string empty;
+        edhttp::append_set_cookies(empty, edhttp::http_cookie::vector_t());
+        CATCH_REQUIRE(empty.empty());
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+CATCH_TEST_CASE("http_cookie_errors", "[cookie][error]")
+{
+    CATCH_START_SECTION("http_cookie_errors: invalid names")
+    {
+        CATCH_REQUIRE_THROWS_AS(edhttp::http_cookie(""), edhttp::edhttp_exception);
+        CATCH_REQUIRE_THROWS_AS(edhttp::http_cookie("a b"), edhttp::cookie_parse_exception);
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,229 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the HTTP date functions.
+ *
+ * This file implements tests to verify that dates get formatted and
+ * parsed as expected.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/http_date.h"
+
+
+// C
+//
+#include    <time.h>
+
+
+
+namespace
+{
+
+
+
+std::string strftime_http(time_t seconds)
+{
+    struct tm t;
+    gmtime_r(&seconds, &t);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &t);
+    return buf;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("http_date_format", "[date]")
+{
+    CATCH_START_SECTION("http_date: format known dates")
+    {
+        char buf[edhttp::HTTP_DATE_LENGTH];
+        CATCH_REQUIRE(edhttp::format_http_date(784111777, buf) == "Sun, 06 Nov 1994 08:49:37 GMT");
+        CATCH_REQUIRE(edhttp::format_http_date(0, buf) == "Thu, 01 Jan 1970 00:00:00 GMT");
+        CATCH_REQUIRE(edhttp::format_http_date(-1, buf) == "Wed, 31 Dec 1969 23:59:59 GMT");
+        CATCH_REQUIRE(edhttp::format_http_date(951782400, buf) == "Tue, 29 Feb 2000 00:00:00 GMT");
+        CATCH_REQUIRE(edhttp::format_http_date(253402300799, buf) == "Fri, 31 Dec 9999 23:59:59 GMT");
+        CATCH_REQUIRE(edhttp::format_http_date(-62167219200, buf) == "Sat, 01 Jan 0000 00:00:00 GMT");
+
+        // the same second twice uses the cache
+        //
+        CATCH_REQUIRE(edhttp::format_http_date(-62167219200, buf) == "Sat, 01 Jan 0000 00:00:00 GMT");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: compare with strftime()")
+    {
+        char buf[edhttp::HTTP_DATE_LENGTH];
+        for(int i(0); i < 100'000; ++i)
+        {
+            // years 1000 to 9999 (strftime() does not pad %Y)
+            //
+            time_t const seconds(static_cast<time_t>(
+                      ((static_cast<std::uint64_t>(rand()) << 32) ^ rand())
+                    % 284012524800LL) - 30610224000LL);
+            CATCH_REQUIRE(std::string(edhttp::format_http_date(seconds, buf)) == strftime_http(seconds));
+        }
+
+        // every second around a leap day
+        //
+        for(time_t seconds(951696000); seconds < 951696000 + 86400 * 3; seconds += 7)
+        {
+            CATCH_REQUIRE(std::string(edhttp::format_http_date(seconds, buf)) == strftime_http(seconds));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: date_to_string()")
+    {
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_HTTP) == "Sun, 06 Nov 1994 08:49:37 GMT");
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_EMAIL) == "06 Nov 1994 08:49:37 +0000");
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_SHORT) == "1994-11-06");
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_SHORT_US) == "11-06-1994");
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_LONG) == "1994-11-06T08:49:37Z");
+        CATCH_REQUIRE(edhttp::date_to_string(784111777, edhttp::date_format_t::DATE_FORMAT_TIME) == "08:49:37");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_date_parse", "[date]")
+{
+    CATCH_START_SECTION("http_date: parse the three HTTP formats")
+    {
+        CATCH_REQUIRE(edhttp::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT") == 784111777);
+        CATCH_REQUIRE(edhttp::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT") == 784111777);
+        CATCH_REQUIRE(edhttp::parse_http_date("Sun Nov  6 08:49:37 1994") == 784111777);
+        CATCH_REQUIRE(edhttp::parse_http_date("Wednesday, 01-Jan-20 00:00:00 GMT") == 1577836800);
+        CATCH_REQUIRE(edhttp::parse_http_date("Thu Jan 01 00:00:00 1970") == 0);
+        CATCH_REQUIRE(edhttp::parse_http_date("Wed, 31 Dec 1969 23:59:59 GMT") == -1);
+        CATCH_REQUIRE(edhttp::parse_http_date("Thu, 29 Feb 2024 12:00:00 GMT") == 1709208000);
+        CATCH_REQUIRE(edhttp::parse_http_date("Sat, 31 Dec 2016 23:59:60 GMT") == 1483228800);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: round trip with format_http_date()")
+    {
+        char buf[edhttp::HTTP_DATE_LENGTH];
+        for(int i(0); i < 100'000; ++i)
+        {
+            time_t const seconds(static_cast<time_t>(rand()) * 100 % 253402300800);
+            CATCH_REQUIRE(edhttp::parse_http_date(edhttp::format_http_date(seconds, buf)) == seconds);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: invalid dates")
+    {
+        char const * const invalid_dates[] =
+        {
+            "",
+            "Sun, 06 Nov 1994 08:49:37 UTC",
+            "sun, 06 Nov 1994 08:49:37 GMT",
+            "Sun, 06 nov 1994 08:49:37 GMT",
+            "Sun, 6 Nov 1994 08:49:37 GMT ",
+            "Sun, 06 Nov 1994 24:00:00 GMT",
+            "Sun, 06 Nov 1994 08:60:00 GMT",
+            "Sun, 06 Nov 1994 08:49:61 GMT",
+            "Sun, 00 Nov 1994 08:49:37 GMT",
+            "Sun, 31 Nov 1994 08:49:37 GMT",
+            "Thu, 29 Feb 2100 08:49:37 GMT",
+            "Sun, 06 Nov 1994 08.49:37 GMT",
+            "Sun, 06 Nov 19a4 08:49:37 GMT",
+            "Sunday, 06-Nov-94 08:49:37 UTC",
+            "Sun, 06-Nov-94 08:49:37 GMT",
+            "Sunday, 06 Nov 94 08:49:37 GMT",
+            "Sunday, 06-Nov-1994 08:49:37 GMT",
+            "Sun Nov 6 08:49:37 1994",
+            "Sun Nov  6 08:49:37 94  ",
+            "Sun Nov 06 08:49:37 1994 ",
+            "Sun, Nov  6 08:49:37 1994",
+        };
+        for(auto const & d : invalid_dates)
+        {
+            CATCH_REQUIRE(edhttp::parse_http_date(d) == -1);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: string_to_date() lenient formats")
+    {
+        CATCH_REQUIRE(edhttp::string_to_date("Sun, 06 Nov 1994 08:49:37 GMT") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("Sunday, 06-Nov-94 08:49:37 GMT") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("Sun Nov  6 08:49:37 1994") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("sun, 06 nov 1994 08:49:37 gmt") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("Wednesday, 09 Nov 1994 08:49:37 GMT") == 784111777 + 3 * 86400);
+        CATCH_REQUIRE(edhttp::string_to_date("06 March 1994 08:49:37 GMT") == 762943777);
+        CATCH_REQUIRE(edhttp::string_to_date("Sun, 06 Nov 1994 03:49:37 EST") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("Sun, 06 Nov 1994 01:49:37 -0700") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("Sat, 05 Nov 1994 23:49:37 -0900") == 784111777);
+        CATCH_REQUIRE(edhttp::string_to_date("bad date") == -1);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_date: both parsers use the proleptic Gregorian calendar")
+    {
+        // 1700 is a leap year with the Julian rule, not the Gregorian rule
+        //
+        CATCH_REQUIRE(edhttp::parse_http_date("Sun, 28 Feb 1700 00:00:00 GMT") == -8515324800);
+        CATCH_REQUIRE(edhttp::string_to_date("sun, 28 feb 1700 00:00:00 gmt") == -8515324800);
+        CATCH_REQUIRE(edhttp::parse_http_date("Mon, 01 Mar 1700 00:00:00 GMT") == -8515238400);
+        CATCH_REQUIRE(edhttp::string_to_date("mon, 01 mar 1700 00:00:00 gmt") == -8515238400);
+        CATCH_REQUIRE(edhttp::parse_http_date("Mon, 29 Feb 1700 00:00:00 GMT") == -1);
+        CATCH_REQUIRE(edhttp::string_to_date("Mon, 29 Feb 1700 00:00:00 GMT") == -1);
+        CATCH_REQUIRE(edhttp::string_to_date("mon, 29 feb 1700 00:00:00 gmt") == -1);
+
+        CATCH_REQUIRE(edhttp::parse_http_date("Tue, 29 Feb 1600 00:00:00 GMT") == -11670998400);
+        CATCH_REQUIRE(edhttp::string_to_date("tue, 29 feb 1600 00:00:00 gmt") == -11670998400);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_date_format_error", "[date][error]")
+{
+    CATCH_START_SECTION("http_date: year out of range")
+    {
+        char buf[edhttp::HTTP_DATE_LENGTH];
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::format_http_date(253402300800, buf)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: year out of range for an HTTP date."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::format_http_date(-62167219201, buf)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: year out of range for an HTTP date."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
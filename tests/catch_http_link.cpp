@@ -0,0 +1,175 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the http_link and http_link_header classes.
+ *
+ * This file implements tests to verify that links get serialized and
+ * that Link headers get parsed as expected.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/http_link.h"
+
+
+
+CATCH_TEST_CASE("http_link", "[link]")
+{
+    CATCH_START_SECTION("http_link: serialize one link")
+    {
+        edhttp::http_link link("https://example.com/style.css", "preload");
+        link.add_param("as", "style");
+        CATCH_REQUIRE(link.get_name() == "preload");
+        CATCH_REQUIRE(link.has_param("as"));
+        CATCH_REQUIRE(link.get_param("as") == "style");
+        CATCH_REQUIRE(link.to_http_header() == "<https://example.com/style.css>; rel=preload; as=\"style\"");
+
+        std::string out("prefix: ");
+        link.append_http_header(out);
+        CATCH_REQUIRE(out == "prefix: <https://example.com/style.css>; rel=preload; as=\"style\"");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_link: serialize many links")
+    {
+        edhttp::http_link::vector_t links;
+        links.emplace_back("https://example.com/style.css", "preload");
+        links.back().add_param("as", "style");
+        links.emplace_back("https://example.com/app.js", "preload");
+        links.back().add_param("as", "script");
+        links.back().set_redirect();
+
+        CATCH_REQUIRE(edhttp::links_to_http_header(links)
+                == "Link: <https://example.com/style.css>; rel=preload; as=\"style\""
+                   ", <https://example.com/app.js>; rel=preload; as=\"script\"");
+        CATCH_REQUIRE(edhttp::links_to_http_header(links, true)
+                == "Link: <https://example.com/app.js>; rel=preload; as=\"script\"");
+        CATCH_REQUIRE(edhttp::links_to_http_header(edhttp::http_link::vector_t()).empty());
+
+        edhttp::http_link::map_t map;
+        map.emplace("next", edhttp::http_link("https://example.com/page/3", "next"));
+        map.emplace("prev", edhttp::http_link("https://example.com/page/1", "prev"));
+        std::string out;
+        edhttp::append_links(out, map);
+        CATCH_REQUIRE(out == "<https://example.com/page/3>; rel=next, <https://example.com/page/1>; rel=prev");
+        CATCH_REQUIRE(edhttp::links_to_http_header(map, true).empty());
+
+        std::string hints;
+        edhttp::append_early_hints(hints, links);
+        CATCH_REQUIRE(hints == "HTTP/1.1 103 Early Hints\r\n"
+                               "Link: <https://example.com/style.css>; rel=preload; as=\"style\""
+                               ", <https://example.com/app.js>; rel=preload; as=\"script\"\r\n"
+                               "\r\n");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_link_header", "[link]")
+{
+    CATCH_START_SECTION("http_link_header: parse a Link header")
+    {
+        std::string const header(
+                  "<https://example.com/style.css>; rel=preload; as=style"
+                ", <https://example.com/font.woff2> ;REL=\"preload\"; as=font; crossorigin"
+                ",, <https://example.com/q>; title=\"a \\\"quoted\\\", title\"");
+        edhttp::http_link_header links(header);
+        CATCH_REQUIRE(links.size() == 3);
+        CATCH_REQUIRE_FALSE(links.empty());
+
+        CATCH_REQUIRE(links.get_uri(0) == "https://example.com/style.css");
+        CATCH_REQUIRE(links.get_rel(0) == "preload");
+        CATCH_REQUIRE(links.get_param(0, "as") == "style");
+        CATCH_REQUIRE(links.get_param_count(0) == 2);
+
+        CATCH_REQUIRE(links.get_uri(1) == "https://example.com/font.woff2");
+        CATCH_REQUIRE(links.get_rel(1) == "preload");
+        CATCH_REQUIRE(links.get_param(1, 0).f_quoted);
+        CATCH_REQUIRE(links.get_param(1, "As") == "font");
+        CATCH_REQUIRE(links.has_param(1, "crossorigin"));
+        CATCH_REQUIRE(links.get_param(1, "crossorigin").empty());
+        CATCH_REQUIRE_FALSE(links.has_param(1, "title"));
+
+        CATCH_REQUIRE(links.get_uri(2) == "https://example.com/q");
+        CATCH_REQUIRE(links.get_rel(2).empty());
+        CATCH_REQUIRE(links.get_param(2, "title") == "a \\\"quoted\\\", title");
+
+        links.clear();
+        CATCH_REQUIRE(links.empty());
+        CATCH_REQUIRE(links.parse(""));
+        CATCH_REQUIRE(links.empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_link_header: round trip")
+    {
+        edhttp::http_link::vector_t links;
+        links.emplace_back("https://example.com/a.js", "preload");
+        links.back().add_param("as", "script");
+        links.emplace_back("https://example.com/b.css", "preload");
+        links.back().add_param("as", "style");
+
+        std::string value;
+        edhttp::append_links(value, links);
+
+        edhttp::http_link_header parsed;
+        CATCH_REQUIRE(parsed.parse(value));
+        CATCH_REQUIRE(parsed.size() == 2);
+        CATCH_REQUIRE(parsed.get_uri(1) == "https://example.com/b.css");
+        CATCH_REQUIRE(parsed.get_param(1, "as") == "style");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_link_header: invalid headers")
+    {
+        edhttp::http_link_header links;
+        CATCH_REQUIRE_FALSE(links.parse("https://example.com/"));
+        CATCH_REQUIRE_FALSE(links.parse("<https://example.com/"));
+        CATCH_REQUIRE_FALSE(links.parse("<https://example.com/> rel=next"));
+        CATCH_REQUIRE_FALSE(links.parse("<https://example.com/>; =next"));
+        CATCH_REQUIRE_FALSE(links.parse("<https://example.com/>; title=\"open"));
+        CATCH_REQUIRE(links.empty());
+
+        // links parsed before the error are kept
+        //
+        CATCH_REQUIRE_FALSE(links.parse("<https://example.com/a>; rel=next, bad"));
+        CATCH_REQUIRE(links.size() == 1);
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  links.get_uri(1)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: link index out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  links.get_param(0, 5)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: link parameter index out of range."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
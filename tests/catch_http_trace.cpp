@@ -0,0 +1,223 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the HTTP request traces.
+ *
+ * This file implements tests to verify the phase timings, the W3C
+ * traceparent header support, and the trace ring buffer.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/http_trace.h"
+
+
+// C++
+//
+#include    <thread>
+
+
+
+CATCH_TEST_CASE("http_trace", "[trace]")
+{
+    CATCH_START_SECTION("http_trace: phase names")
+    {
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_RESOLVE)) == "resolve");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_CONNECT)) == "connect");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_WRITE)) == "write");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_FIRST_BYTE)) == "first_byte");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_HEADER)) == "header");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(edhttp::trace_phase_t::TRACE_PHASE_BODY)) == "body");
+        CATCH_REQUIRE(std::string(edhttp::trace_phase_to_string(static_cast<edhttp::trace_phase_t>(100))) == "unknown");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_trace: phase timings")
+    {
+        edhttp::http_trace trace;
+        trace.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        trace.mark(edhttp::trace_phase_t::TRACE_PHASE_CONNECT);
+        trace.mark(edhttp::trace_phase_t::TRACE_PHASE_WRITE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        trace.mark(edhttp::trace_phase_t::TRACE_PHASE_FIRST_BYTE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        trace.mark(edhttp::trace_phase_t::TRACE_PHASE_FIRST_BYTE);
+        trace.finish();
+
+        auto const & phases(trace.f_phases);
+        CATCH_REQUIRE(phases[static_cast<std::size_t>(edhttp::trace_phase_t::TRACE_PHASE_RESOLVE)].count() == 0);
+        CATCH_REQUIRE(phases[static_cast<std::size_t>(edhttp::trace_phase_t::TRACE_PHASE_CONNECT)] >= std::chrono::milliseconds(2));
+        CATCH_REQUIRE(phases[static_cast<std::size_t>(edhttp::trace_phase_t::TRACE_PHASE_FIRST_BYTE)] >= std::chrono::milliseconds(3));
+        CATCH_REQUIRE(phases[static_cast<std::size_t>(edhttp::trace_phase_t::TRACE_PHASE_HEADER)].count() == 0);
+
+        edhttp::http_trace::clock_t::duration sum(edhttp::http_trace::clock_t::duration::zero());
+        for(auto const & d : phases)
+        {
+            sum += d;
+        }
+        CATCH_REQUIRE(trace.f_total >= sum);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_trace: new trace")
+    {
+        edhttp::http_trace trace;
+        CATCH_REQUIRE(trace.get_traceparent().empty());
+
+        trace.new_trace();
+        CATCH_REQUIRE(trace.f_has_trace_context);
+        CATCH_REQUIRE(trace.f_trace_flags == 0x01);
+        CATCH_REQUIRE(trace.f_parent_id == edhttp::http_trace::span_id_t());
+        CATCH_REQUIRE(trace.f_trace_id != edhttp::http_trace::trace_id_t());
+        CATCH_REQUIRE(trace.f_span_id != edhttp::http_trace::span_id_t());
+
+        std::string const traceparent(trace.get_traceparent());
+        CATCH_REQUIRE(traceparent.length() == 55);
+        CATCH_REQUIRE(traceparent.substr(0, 3) == "00-");
+        CATCH_REQUIRE(traceparent.substr(52) == "-01");
+
+        // a server receiving that header continues the same trace
+        //
+        edhttp::http_trace child;
+        CATCH_REQUIRE(child.set_traceparent(traceparent));
+        CATCH_REQUIRE(child.f_trace_id == trace.f_trace_id);
+        CATCH_REQUIRE(child.f_parent_id == trace.f_span_id);
+        CATCH_REQUIRE(child.f_span_id != trace.f_span_id);
+        CATCH_REQUIRE(child.get_traceparent().substr(0, 36) == traceparent.substr(0, 36));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_trace: parse traceparent")
+    {
+        edhttp::http_trace trace;
+        CATCH_REQUIRE(trace.set_traceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"));
+        CATCH_REQUIRE(trace.f_trace_id == edhttp::http_trace::trace_id_t{
+                  0x4b, 0xf9, 0x2f, 0x35, 0x77, 0xb3, 0x4d, 0xa6
+                , 0xa3, 0xce, 0x92, 0x9d, 0x0e, 0x0e, 0x47, 0x36 });
+        CATCH_REQUIRE(trace.f_parent_id == edhttp::http_trace::span_id_t{
+                  0x00, 0xf0, 0x67, 0xaa, 0x0b, 0xa9, 0x02, 0xb7 });
+        CATCH_REQUIRE(trace.f_trace_flags == 0x01);
+        CATCH_REQUIRE(trace.get_traceparent().substr(0, 36) == "00-4bf92f3577b34da6a3ce929d0e0e4736-");
+
+        // not sampled
+        //
+        CATCH_REQUIRE(trace.set_traceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00"));
+        CATCH_REQUIRE(trace.f_trace_flags == 0x00);
+        CATCH_REQUIRE(trace.get_traceparent().substr(52) == "-00");
+
+        // future versions may add fields
+        //
+        CATCH_REQUIRE(trace.set_traceparent("cc-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-09-what-the-future-will-be-like"));
+        CATCH_REQUIRE(trace.f_trace_flags == 0x09);
+        CATCH_REQUIRE(trace.set_traceparent("cc-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-09"));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_trace_ring_buffer", "[trace]")
+{
+    CATCH_START_SECTION("http_trace_ring_buffer: keep the last traces")
+    {
+        edhttp::trace_ring_buffer buffer(3);
+        CATCH_REQUIRE(buffer.get_capacity() == 3);
+        CATCH_REQUIRE(buffer.size() == 0);
+        CATCH_REQUIRE(buffer.get_traces().empty());
+
+        edhttp::trace_sink & sink(buffer);
+        for(int idx(1); idx <= 5; ++idx)
+        {
+            edhttp::http_trace trace;
+            trace.f_path = "/" + std::to_string(idx);
+            sink.record(trace);
+            CATCH_REQUIRE(buffer.size() == static_cast<std::size_t>(std::min(idx, 3)));
+        }
+        CATCH_REQUIRE(buffer.get_overwritten() == 2);
+
+        std::vector<edhttp::http_trace> const traces(buffer.get_traces());
+        CATCH_REQUIRE(traces.size() == 3);
+        CATCH_REQUIRE(traces[0].f_path == "/3");
+        CATCH_REQUIRE(traces[1].f_path == "/4");
+        CATCH_REQUIRE(traces[2].f_path == "/5");
+
+        buffer.clear();
+        CATCH_REQUIRE(buffer.size() == 0);
+        CATCH_REQUIRE(buffer.get_overwritten() == 0);
+
+        edhttp::http_trace trace;
+        trace.f_path = "/6";
+        buffer.record(trace);
+        CATCH_REQUIRE(buffer.get_traces().size() == 1);
+        CATCH_REQUIRE(buffer.get_traces()[0].f_path == "/6");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("http_trace_errors", "[trace][error]")
+{
+    CATCH_START_SECTION("http_trace_errors: invalid traceparent")
+    {
+        char const * const invalid[] =
+        {
+            "",
+            "00",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-0",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra",
+            "ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+            "0g-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+            "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01",
+            "00-00000000000000000000000000000000-00f067aa0ba902b7-01",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-0x",
+            "00_4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736_00f067aa0ba902b7-01",
+            "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7_01",
+            "cc-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01.",
+        };
+        for(auto const & v : invalid)
+        {
+            edhttp::http_trace trace;
+            CATCH_REQUIRE_FALSE(trace.set_traceparent(v));
+            CATCH_REQUIRE_FALSE(trace.f_has_trace_context);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("http_trace_errors: ring buffer capacity")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::trace_ring_buffer(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the capacity of a trace_ring_buffer must be at least 1."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
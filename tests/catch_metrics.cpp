@@ -0,0 +1,331 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the metrics and their rendering.
+ *
+ * This file implements tests to verify the counters, gauges and
+ * histograms, the registry and the text exposition format.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/metrics.h"
+
+
+// C++
+//
+#include    <limits>
+#include    <thread>
+#include    <vector>
+
+
+
+CATCH_TEST_CASE("metrics_counter", "[metrics]")
+{
+    CATCH_START_SECTION("metrics_counter: increment from many threads")
+    {
+        edhttp::metric_counter counter("test_counter_total", "A test counter.");
+        CATCH_REQUIRE(counter.get_type() == edhttp::metric::type_t::METRIC_TYPE_COUNTER);
+        CATCH_REQUIRE(counter.get_name() == "test_counter_total");
+        CATCH_REQUIRE(counter.get_help() == "A test counter.");
+        CATCH_REQUIRE(counter.get_labels().empty());
+        CATCH_REQUIRE(counter.get_value() == 0);
+
+        std::vector<std::thread> threads;
+        for(int idx(0); idx < 12; ++idx)
+        {
+            threads.emplace_back([&counter]()
+                {
+                    for(int count(0); count < 10000; ++count)
+                    {
+                        counter.increment();
+                    }
+                    counter.increment(5);
+                });
+        }
+        for(auto & t : threads)
+        {
+            t.join();
+        }
+        CATCH_REQUIRE(counter.get_value() == 12 * 10005);
+
+        std::string out;
+        counter.render(out);
+        CATCH_REQUIRE(out == "test_counter_total 120060\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_gauge: set and add")
+    {
+        edhttp::metric_gauge gauge("test_gauge", "A test gauge.", edhttp::metric::label("pool", "main"));
+        gauge.set(10);
+        gauge.add(-15);
+        CATCH_REQUIRE(gauge.get_value() == -5);
+
+        std::string out;
+        gauge.render(out);
+        CATCH_REQUIRE(out == "test_gauge{pool=\"main\"} -5\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_label: escaping")
+    {
+        CATCH_REQUIRE(edhttp::metric::label("path", "/a\"b\\c\nd") == "path=\"/a\\\"b\\\\c\\nd\"");
+        CATCH_REQUIRE(edhttp::metric::is_valid_name("edhttp:requests_total"));
+        CATCH_REQUIRE(edhttp::metric::is_valid_name("_x9"));
+        CATCH_REQUIRE_FALSE(edhttp::metric::is_valid_name(""));
+        CATCH_REQUIRE_FALSE(edhttp::metric::is_valid_name("9x"));
+        CATCH_REQUIRE_FALSE(edhttp::metric::is_valid_name("x-y"));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("metrics_histogram", "[metrics]")
+{
+    CATCH_START_SECTION("metrics_histogram: buckets cover all the values")
+    {
+        CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(0) == 0);
+        CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(7) == 7);
+        CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(8) == 8);
+        CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(std::numeric_limits<std::uint64_t>::max())
+                        == edhttp::metric_histogram::BUCKET_COUNT - 1);
+
+        for(std::size_t b(0); b < edhttp::metric_histogram::BUCKET_COUNT; ++b)
+        {
+            std::uint64_t const lowest(edhttp::metric_histogram::get_bucket_lowest(b));
+            std::uint64_t const highest(edhttp::metric_histogram::get_bucket_highest(b));
+            CATCH_REQUIRE(lowest <= highest);
+            CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(lowest) == b);
+            CATCH_REQUIRE(edhttp::metric_histogram::get_bucket(highest) == b);
+            if(b + 1 < edhttp::metric_histogram::BUCKET_COUNT)
+            {
+                CATCH_REQUIRE(edhttp::metric_histogram::get_bucket_lowest(b + 1) == highest + 1);
+            }
+
+            // the relative error is at most 12.5%
+            //
+            CATCH_REQUIRE(static_cast<double>(highest - lowest) <= static_cast<double>(lowest) / 8.0);
+        }
+        CATCH_REQUIRE(edhttp::metric_histogram::get_bucket_highest(edhttp::metric_histogram::BUCKET_COUNT - 1)
+                        == std::numeric_limits<std::uint64_t>::max());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_histogram: percentiles")
+    {
+        edhttp::metric_histogram histogram("test_histogram", "A test histogram.");
+        CATCH_REQUIRE(histogram.get_percentile(50.0) == 0);
+
+        for(std::uint64_t value(1); value <= 1000; ++value)
+        {
+            histogram.record(value * 1000);
+        }
+        CATCH_REQUIRE(histogram.get_count() == 1000);
+        CATCH_REQUIRE(histogram.get_sum() == 500500 * 1000);
+
+        struct percentile_t
+        {
+            double      f_percent = 0.0;
+            std::uint64_t
+                        f_exact = 0;
+        };
+        percentile_t const percentiles[] =
+        {
+            { 0.0, 1000 },
+            { 50.0, 500000 },
+            { 90.0, 900000 },
+            { 99.0, 990000 },
+            { 100.0, 1000000 },
+        };
+        for(auto const & p : percentiles)
+        {
+            std::uint64_t const value(histogram.get_percentile(p.f_percent));
+            CATCH_REQUIRE(value >= p.f_exact);
+            CATCH_REQUIRE(static_cast<double>(value) <= static_cast<double>(p.f_exact) * 1.125);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_histogram: render")
+    {
+        edhttp::metric_histogram histogram(
+                  "test_size_bytes"
+                , "Sizes."
+                , edhttp::metric::label("kind", "a")
+                , edhttp::metric_histogram::bounds_t{ 10, 100, 1000 }
+                , 1000.0);
+        histogram.record(5);
+        histogram.record(10);
+        histogram.record(50);
+        histogram.record(500);
+        histogram.record(5000);
+
+        std::string out;
+        histogram.render(out);
+        CATCH_REQUIRE(out ==
+                "test_size_bytes_bucket{kind=\"a\",le=\"0.01\"} 2\n"
+                "test_size_bytes_bucket{kind=\"a\",le=\"0.1\"} 3\n"
+                "test_size_bytes_bucket{kind=\"a\",le=\"1\"} 4\n"
+                "test_size_bytes_bucket{kind=\"a\",le=\"+Inf\"} 5\n"
+                "test_size_bytes_sum{kind=\"a\"} 5.565\n"
+                "test_size_bytes_count{kind=\"a\"} 5\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_histogram: render very large values")
+    {
+        edhttp::metric_histogram histogram(
+                  "test_huge"
+                , "Huge values."
+                , std::string()
+                , edhttp::metric_histogram::bounds_t{ 1 }
+                , 1.0e-40);
+        histogram.record(1);
+
+        std::string out;
+        histogram.render(out);
+        CATCH_REQUIRE(out ==
+                "test_huge_bucket{le=\"1e+40\"} 1\n"
+                "test_huge_bucket{le=\"+Inf\"} 1\n"
+                "test_huge_sum 1e+40\n"
+                "test_huge_count 1\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_histogram: timer")
+    {
+        edhttp::metric_histogram histogram("test_duration_seconds", "Durations.");
+        {
+            edhttp::metric_histogram::timer t(histogram);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        CATCH_REQUIRE(histogram.get_count() == 1);
+        CATCH_REQUIRE(histogram.get_sum() >= 2'000'000);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("metrics_registry", "[metrics]")
+{
+    CATCH_START_SECTION("metrics_registry: families are rendered once")
+    {
+        edhttp::metrics_registry registry;
+        edhttp::metric_counter & get(registry.get_counter("test_requests_total", "Requests.", edhttp::metric::label("method", "GET")));
+        edhttp::metric_counter & post(registry.get_counter("test_requests_total", "Requests.", edhttp::metric::label("method", "POST")));
+        edhttp::metric_gauge & open(registry.get_gauge("test_open", "Open\nconnections."));
+        CATCH_REQUIRE(&get != &post);
+        CATCH_REQUIRE(&registry.get_counter("test_requests_total", "Requests.", edhttp::metric::label("method", "GET")) == &get);
+        CATCH_REQUIRE(registry.size() == 3);
+
+        get.increment(3);
+        post.increment();
+        open.set(7);
+
+        std::string out("old data");
+        registry.render(out);
+        CATCH_REQUIRE(out ==
+                "# HELP test_open Open\\nconnections.\n"
+                "# TYPE test_open gauge\n"
+                "test_open 7\n"
+                "# HELP test_requests_total Requests.\n"
+                "# TYPE test_requests_total counter\n"
+                "test_requests_total{method=\"GET\"} 3\n"
+                "test_requests_total{method=\"POST\"} 1\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_registry: histogram family")
+    {
+        edhttp::metrics_registry registry;
+        edhttp::metric_histogram & h(registry.get_histogram(
+                  "test_latency_seconds"
+                , "Latency."
+                , std::string_view()
+                , edhttp::metric_histogram::bounds_t{ 1'000'000 }));
+        h.record(1'500'000);
+
+        std::string out;
+        registry.render(out);
+        CATCH_REQUIRE(out ==
+                "# HELP test_latency_seconds Latency.\n"
+                "# TYPE test_latency_seconds histogram\n"
+                "test_latency_seconds_bucket{le=\"0.001\"} 0\n"
+                "test_latency_seconds_bucket{le=\"+Inf\"} 1\n"
+                "test_latency_seconds_sum 0.0015\n"
+                "test_latency_seconds_count 1\n");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("metrics_errors", "[metrics][error]")
+{
+    CATCH_START_SECTION("metrics_errors: invalid names")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::metric_counter("bad-name", "help")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: \"bad-name\" is not a valid metric name."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::metric::label("a b", "value")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: \"a b\" is not a valid label name."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_errors: unsorted bounds")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::metric_histogram("test_h", "help", std::string_view(), edhttp::metric_histogram::bounds_t{ 10, 5 })
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the bounds of histogram \"test_h\" must be sorted and unique."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::metric_histogram("test_h", "help", std::string_view(), edhttp::metric_histogram::bounds_t{ 10, 10 })
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the bounds of histogram \"test_h\" must be sorted and unique."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("metrics_errors: type mismatch")
+    {
+        edhttp::metrics_registry registry;
+        registry.get_counter("test_value", "help");
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  registry.get_gauge("test_value", "help", edhttp::metric::label("a", "b"))
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: metric \"test_value\" already exists with a different type."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
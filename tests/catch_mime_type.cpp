@@ -0,0 +1,384 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the MIME type detection.
+ *
+ * This file implements tests to verify that get_mime_type() detects
+ * a few common formats and can be used from many threads.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/mime_type.h"
+
+
+// C++
+//
+#include    <atomic>
+#include    <fstream>
+#include    <thread>
+#include    <vector>
+
+
+
+namespace
+{
+
+
+
+std::string const g_png("\x89PNG\r\n\x1a\n\0\0\0\rIHDR\0\0\0\x01\0\0\0\x01\x08\x02\0\0\0", 29);
+
+
+bool starts_with(std::string const & s, std::string const & prefix)
+{
+    return s.compare(0, prefix.length(), prefix) == 0;
+}
+
+
+std::string_view sniff(std::string const & data)
+{
+    return edhttp::sniff_mime_type(std::span<char const>(data.data(), data.length()));
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("mime_type", "[mime]")
+{
+    CATCH_START_SECTION("mime_type: common formats")
+    {
+        edhttp::prewarm_mime_type();
+
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(g_png), "image/png"));
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(std::string("Hello world!\n")), "text/plain"));
+
+        std::string const pdf("%PDF-1.4\n%\xe2\xe3\xcf\xd3\n1 0 obj\n<< >>\nendobj\n");
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(std::span<char const>(pdf.data(), pdf.length())), "application/pdf"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type: only inspect the first bytes")
+    {
+        // text followed by binary data is seen as text when only the
+        // text gets inspected
+        //
+        std::string data(1000, 'a');
+        data += '\n';
+        for(int i(0); i < 1000; ++i)
+        {
+            data += static_cast<char>(i * 37 % 256);
+        }
+        std::span<char const> const span(data.data(), data.length());
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(span, 1001), "text/plain"));
+        CATCH_REQUIRE_FALSE(starts_with(edhttp::get_mime_type(span), "text/plain"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type: many threads")
+    {
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for(int t(0); t < 8; ++t)
+        {
+            threads.emplace_back([&errors]()
+                {
+                    for(int i(0); i < 200; ++i)
+                    {
+                        if(!starts_with(edhttp::get_mime_type(g_png), "image/png"))
+                        {
+                            ++errors;
+                        }
+                    }
+                });
+        }
+        for(auto & t : threads)
+        {
+            t.join();
+        }
+        CATCH_REQUIRE(errors == 0);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("mime_type_sniffer", "[mime]")
+{
+    CATCH_START_SECTION("mime_type_sniffer: signatures")
+    {
+        struct sample_t
+        {
+            std::string     f_data = std::string();
+            char const *    f_mime_type = nullptr;
+        };
+        std::vector<sample_t> const samples{
+            { "<!DOCTYPE html>\n<html>", "text/html" },
+            { "  \r\n\t<!doctype HTML>", "text/html" },
+            { "<html lang=\"en\">", "text/html" },
+            { "<HeAd>", "text/html" },
+            { "<script>alert(1)</script>", "text/html" },
+            { "<iframe src=x>", "text/html" },
+            { "<h1>Title</h1>", "text/html" },
+            { "<div>", "text/html" },
+            { "<font>", "text/html" },
+            { "<table>", "text/html" },
+            { "<a href=x>", "text/html" },
+            { "<style>", "text/html" },
+            { "<title>", "text/html" },
+            { "<b>", "text/html" },
+            { "<body>", "text/html" },
+            { "<br>", "text/html" },
+            { "<p>", "text/html" },
+            { "<!-- comment -->", "text/html" },
+            { "\n<?xml version=\"1.0\"?>", "text/xml" },
+            { "%PDF-1.7", "application/pdf" },
+            { "%!PS-Adobe-3.0", "application/postscript" },
+            { std::string("\xFE\xFF" "ab", 4), "text/plain" },
+            { std::string("\xFF\xFE" "ab", 4), "text/plain" },
+            { "\xEF\xBB\xBFtext", "text/plain" },
+            { "\xFE\xFF", "text/plain" },
+            { "\xFF\xFE", "text/plain" },
+            { "\xEF\xBB\xBF", "text/plain" },
+            { std::string("\0\0\1\0\1\0", 6), "image/x-icon" },
+            { std::string("\0\0\2\0\1\0", 6), "image/x-icon" },
+            { "BM\x36\x10", "image/bmp" },
+            { "GIF87a", "image/gif" },
+            { "GIF89a\x01", "image/gif" },
+            { std::string("RIFF\x10\0\0\0WEBPVP8 ", 16), "image/webp" },
+            { g_png, "image/png" },
+            { "\xFF\xD8\xFF\xE0", "image/jpeg" },
+            { ".snd", "audio/basic" },
+            { std::string("FORM\0\0\0\x10" "AIFF", 12), "audio/aiff" },
+            { "ID3\x03", "audio/mpeg" },
+            { std::string("OggS\0\x02", 6), "application/ogg" },
+            { std::string("MThd\0\0\0\x06\0\x01", 10), "audio/midi" },
+            { std::string("RIFF\x10\0\0\0" "AVI LIST", 16), "video/avi" },
+            { std::string("RIFF\x10\0\0\0WAVEfmt ", 16), "audio/wave" },
+            { std::string(34, '\x01') + "LP", "application/vnd.ms-fontobject" },
+            { std::string("\0\1\0\0\0\x10", 6), "font/ttf" },
+            { "OTTO", "font/otf" },
+            { "ttcf", "font/collection" },
+            { "wOFF", "font/woff" },
+            { "wOF2", "font/woff2" },
+            { "\x1F\x8B\x08\x00", "application/x-gzip" },
+            { "PK\x03\x04\x14", "application/zip" },
+            { std::string("Rar!\x1A\x07\0\x01", 8), "application/x-rar-compressed" },
+            { std::string("\0\0\0\x18" "ftypisom\0\0\0\0isommp42", 24), "video/mp4" },
+            { std::string("\0\0\0\x10" "ftypmp42\0\0\0\0", 16), "video/mp4" },
+        };
+        for(auto const & sample : samples)
+        {
+            CATCH_REQUIRE(sniff(sample.f_data) == sample.f_mime_type);
+
+            // the result does not change when more data follows
+            //
+            CATCH_REQUIRE(sniff(sample.f_data + std::string(600, ' ')) == sample.f_mime_type);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_sniffer: unknown data")
+    {
+        CATCH_REQUIRE(sniff("").empty());
+        CATCH_REQUIRE(sniff("Hello world!").empty());
+        CATCH_REQUIRE(sniff("<htmlx>").empty());            // not tag terminated
+        CATCH_REQUIRE(sniff("<html").empty());              // too short for the terminator
+        CATCH_REQUIRE(sniff("x<html>").empty());
+        CATCH_REQUIRE(sniff(" %PDF-1.7").empty());          // PDF does not skip whitespace
+        CATCH_REQUIRE(sniff("GIF87").empty());
+        CATCH_REQUIRE(sniff(std::string(33, '\x01') + "LP").empty());
+        CATCH_REQUIRE(sniff(std::string("\0\0\0\x10" "ftypqt  \0\0\0\0", 16)).empty());
+        CATCH_REQUIRE(sniff(std::string("\0\0\0\x20" "ftypmp42\0\0\0\0", 16)).empty());
+
+        // only the first 512 bytes are checked
+        //
+        CATCH_REQUIRE(sniff(std::string(512, ' ') + "<html>").empty());
+        CATCH_REQUIRE(sniff(std::string(505, ' ') + "<html>") == "text/html");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_sniffer: get_mime_type() uses the sniffer first")
+    {
+        CATCH_REQUIRE(edhttp::get_mime_type(g_png) == "image/png; charset=binary");
+        CATCH_REQUIRE(edhttp::get_mime_type(std::string("%PDF-1.7\n")) == "application/pdf; charset=binary");
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(std::string("<!DOCTYPE html><html></html>")), "text/html; charset="));
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(std::string("plain text\n")), "text/plain; charset="));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_sniffer: get_mime_type() returns the libmagic names")
+    {
+        struct name_t
+        {
+            std::string     f_data = std::string();
+            char const *    f_whatwg = nullptr;
+            char const *    f_magic = nullptr;
+        };
+        name_t const names[] =
+        {
+            { std::string("\0\0\1\0\1\0", 6), "image/x-icon", "image/vnd.microsoft.icon; charset=binary" },
+            { std::string("\0\0\2\0\1\0", 6), "image/x-icon", "image/x-win-bitmap; charset=binary" },
+            { "BM\x36\x10", "image/bmp", "image/bmp; charset=binary" },
+            { std::string("FORM\0\0\0\x10" "AIFF", 12), "audio/aiff", "audio/x-aiff; charset=binary" },
+            { std::string("RIFF\x10\0\0\0" "AVI LIST", 16), "video/avi", "video/x-msvideo; charset=binary" },
+            { std::string("RIFF\x10\0\0\0WAVEfmt ", 16), "audio/wave", "audio/x-wav; charset=binary" },
+            { std::string("\0\1\0\0\0\x10", 6), "font/ttf", "font/sfnt; charset=binary" },
+            { "OTTO", "font/otf", "application/vnd.ms-opentype; charset=binary" },
+            { "ttcf", "font/collection", "font/ttf; charset=binary" },
+            { std::string("Rar!\x1A\x07\0\x01", 8), "application/x-rar-compressed", "application/x-rar; charset=binary" },
+        };
+        for(auto const & name : names)
+        {
+            CATCH_REQUIRE(sniff(name.f_data) == name.f_whatwg);
+            CATCH_REQUIRE(edhttp::get_mime_type(name.f_data) == name.f_magic);
+        }
+
+        // libmagic is more specific about Ogg streams
+        //
+        std::string const vorbis(std::string(
+                  "OggS\0\2\0\0\0\0\0\0\0\0\1\0\0\0\0\0\0\0\0\0\0\0\1\x1E"
+                  "\x01vorbis\0\0\0\0\2\x44\xAC\0\0", 42) + std::string(100, '\0'));
+        CATCH_REQUIRE(sniff(vorbis) == "application/ogg");
+        CATCH_REQUIRE(edhttp::get_mime_type(vorbis) == "audio/ogg; charset=binary");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_sniffer: text and container formats are left to libmagic")
+    {
+        // an SVG image starts like any XML file
+        //
+        std::string const svg(
+                  "<?xml version=\"1.0\"?>\n"
+                  "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1\" height=\"1\"/>\n");
+        CATCH_REQUIRE(sniff(svg) == "text/xml");
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(svg), "image/svg+xml"));
+
+        // a docx document is a zip file, libmagic checks the filenames
+        // (the CRC is required because libmagic tries to decompress zip
+        // files; some versions then report a decompression error in
+        // front of the type so we only search for it)
+        //
+        std::string docx;
+        for(auto const & name : { "[Content_Types].xml", "_rels/.rels", "word/document.xml" })
+        {
+            std::string const content("<?xml version=\"1.0\"?><x/>");
+            std::string const filename(name);
+            docx += std::string("PK\x03\x04\x14\0\0\0\0\0\0\0\0\0\xCD\x76\x18\x6A", 18);
+            for(int i(0); i < 2; ++i)
+            {
+                docx += static_cast<char>(content.length());
+                docx += std::string("\0\0\0", 3);
+            }
+            docx += static_cast<char>(filename.length());
+            docx += std::string("\0\0\0", 3);
+            docx += filename;
+            docx += content;
+        }
+        CATCH_REQUIRE(sniff(docx) == "application/zip");
+        CATCH_REQUIRE(edhttp::get_mime_type(docx).find(
+                  "application/vnd.openxmlformats-officedocument.wordprocessingml.document") != std::string::npos);
+
+        // text which happens to start like an HTML tag
+        //
+        std::string const text("<p is the parameter name\n");
+        CATCH_REQUIRE(sniff(text) == "text/html");
+        CATCH_REQUIRE(starts_with(edhttp::get_mime_type(text), "text/plain; charset="));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("mime_type_extensions", "[mime]")
+{
+    CATCH_START_SECTION("mime_type_extensions: perfect hash table")
+    {
+        edhttp::mime_extensions extensions;
+        CATCH_REQUIRE(extensions.size() == 0);
+        CATCH_REQUIRE(extensions.find("index.html").empty());
+
+        for(int i(0); i < 3000; ++i)
+        {
+            extensions.add("ext" + std::to_string(i), "application/x-type" + std::to_string(i));
+        }
+        extensions.add("EXT5", "duplicate/ignored");
+        extensions.build();
+        CATCH_REQUIRE(extensions.size() == 3000);
+        for(int i(0); i < 3000; ++i)
+        {
+            CATCH_REQUIRE(extensions.find("ext" + std::to_string(i)) == "application/x-type" + std::to_string(i));
+        }
+        CATCH_REQUIRE(extensions.find("ext3000").empty());
+        CATCH_REQUIRE(extensions.find("file.EXT5") == "application/x-type5");
+        CATCH_REQUIRE(extensions.find("/a.b/file.ext7") == "application/x-type7");
+        CATCH_REQUIRE(extensions.find("/a.ext7/file").empty());
+        CATCH_REQUIRE(extensions.find("file.").empty());
+        CATCH_REQUIRE(extensions.find(std::string(40, 'e')).empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_extensions: load a mime.types file")
+    {
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/test.mime.types");
+        {
+            std::ofstream out(filename);
+            out << "# comment line\n"
+                   "\n"
+                   "text/html\t\t\thtml htm shtml\n"
+                   "image/png\t\t\tpng\n"
+                   "application/x-empty\n"
+                   "text/x-other\t\thtm   # already defined\n"
+                   "text/css css\r\n";
+        }
+        edhttp::mime_extensions extensions;
+        CATCH_REQUIRE(extensions.load(filename));
+        CATCH_REQUIRE(extensions.size() == 5);
+        CATCH_REQUIRE(extensions.find("index.HTML") == "text/html");
+        CATCH_REQUIRE(extensions.find("htm") == "text/html");
+        CATCH_REQUIRE(extensions.find("shtml") == "text/html");
+        CATCH_REQUIRE(extensions.find("logo.png") == "image/png");
+        CATCH_REQUIRE(extensions.find("style.css") == "text/css");
+        CATCH_REQUIRE(extensions.find("comment").empty());
+
+        CATCH_REQUIRE_FALSE(extensions.load(filename + ".does-not-exist"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_extensions: system file")
+    {
+        edhttp::mime_extensions extensions;
+        if(extensions.load())
+        {
+            CATCH_REQUIRE(edhttp::get_mime_type_from_extension("image.png") == "image/png");
+            CATCH_REQUIRE(edhttp::get_mime_type_from_extension("JPG") == "image/jpeg");
+        }
+        CATCH_REQUIRE(edhttp::get_mime_type_from_extension("file.no-such-extension").empty());
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+// vim: ts=4 sw=4 et
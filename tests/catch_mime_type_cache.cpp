@@ -0,0 +1,242 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the MIME type cache.
+ *
+ * This file implements tests to verify that the MIME types of buffers
+ * and files get cached, evicted and invalidated.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/mime_type_cache.h"
+
+
+// C++
+//
+#include    <fstream>
+
+
+// C
+//
+#include    <fcntl.h>
+#include    <sys/stat.h>
+#include    <unistd.h>
+
+
+
+namespace
+{
+
+
+
+std::string const g_png("\x89PNG\r\n\x1a\n\0\0\0\rIHDR\0\0\0\x01\0\0\0\x01\x08\x02\0\0\0", 29);
+
+
+std::span<char const> as_span(std::string const & s)
+{
+    return std::span<char const>(s.data(), s.length());
+}
+
+
+void write_file(std::string const & filename, std::string const & content)
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("mime_type_cache", "[mime][cache]")
+{
+    CATCH_START_SECTION("mime_type_cache: buffers")
+    {
+        edhttp::mime_type_cache cache;
+        CATCH_REQUIRE(cache.get_max_entries() == edhttp::mime_type_cache::DEFAULT_MAX_ENTRIES);
+        CATCH_REQUIRE(cache.get_hit_rate() == 0.0);
+
+        CATCH_REQUIRE(cache.get_mime_type(as_span(g_png)) == "image/png; charset=binary");
+        CATCH_REQUIRE(cache.get_misses() == 1);
+        CATCH_REQUIRE(cache.get_hits() == 0);
+        for(int i(0); i < 9; ++i)
+        {
+            CATCH_REQUIRE(cache.get_mime_type(as_span(g_png)) == "image/png; charset=binary");
+        }
+        CATCH_REQUIRE(cache.get_misses() == 1);
+        CATCH_REQUIRE(cache.get_hits() == 9);
+        CATCH_REQUIRE(cache.get_hit_rate() == 0.9);
+        CATCH_REQUIRE(cache.size() == 1);
+
+        // a different prefix is a different entry
+        //
+        std::string const html("<!DOCTYPE html><html></html>");
+        std::string const html_type(cache.get_mime_type(as_span(html)));
+        CATCH_REQUIRE(html_type.starts_with("text/html"));
+        CATCH_REQUIRE(cache.size() == 2);
+
+        // only the inspected bytes count
+        //
+        std::string const long_html(html + std::string(100, 'x'));
+        CATCH_REQUIRE(cache.get_mime_type(as_span(long_html), html.length()) == html_type);
+        CATCH_REQUIRE(cache.get_hits() == 10);
+
+        cache.reset_statistics();
+        CATCH_REQUIRE(cache.get_hits() == 0);
+        CATCH_REQUIRE(cache.get_misses() == 0);
+        cache.clear();
+        CATCH_REQUIRE(cache.size() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_cache: LRU eviction")
+    {
+        edhttp::mime_type_cache cache(3);
+        std::string const a("<html>a"), b("<html>b"), c("<html>c"), d("<html>d");
+        cache.get_mime_type(as_span(a));
+        cache.get_mime_type(as_span(b));
+        cache.get_mime_type(as_span(c));
+        cache.get_mime_type(as_span(a));      // a becomes most recent
+        cache.get_mime_type(as_span(d));      // evicts b
+        CATCH_REQUIRE(cache.size() == 3);
+        cache.reset_statistics();
+        cache.get_mime_type(as_span(a));
+        cache.get_mime_type(as_span(c));
+        cache.get_mime_type(as_span(d));
+        CATCH_REQUIRE(cache.get_hits() == 3);
+        cache.get_mime_type(as_span(b));
+        CATCH_REQUIRE(cache.get_misses() == 1);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_cache: files")
+    {
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/mime-type-cache.test");
+        write_file(filename, g_png);
+
+        edhttp::mime_type_cache cache;
+        CATCH_REQUIRE(cache.get_file_mime_type(filename) == "image/png; charset=binary");
+        CATCH_REQUIRE(cache.get_file_mime_type(filename) == "image/png; charset=binary");
+        CATCH_REQUIRE(cache.get_hits() == 1);
+        CATCH_REQUIRE(cache.get_misses() == 1);
+
+        // a new modification time is a new entry
+        //
+        write_file(filename, "%PDF-1.4\n");
+        struct timespec const times[2] = { { 0, UTIME_NOW }, { 1000, 0 } };
+        CATCH_REQUIRE(utimensat(AT_FDCWD, filename.c_str(), times, 0) == 0);
+        CATCH_REQUIRE(cache.get_file_mime_type(filename) == "application/pdf; charset=binary");
+        CATCH_REQUIRE(cache.get_misses() == 2);
+        CATCH_REQUIRE(cache.size() == 2);
+
+        // both entries are for the same inode
+        //
+        CATCH_REQUIRE(cache.invalidate_file(filename) == 2);
+        CATCH_REQUIRE(cache.size() == 0);
+        CATCH_REQUIRE(cache.get_file_mime_type(filename) == "application/pdf; charset=binary");
+        CATCH_REQUIRE(cache.get_misses() == 3);
+
+        unlink(filename.c_str());
+        CATCH_REQUIRE(cache.invalidate_file(filename) == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_cache: max_bytes is part of the key")
+    {
+        // text followed by binary data is seen as text when only the
+        // text gets inspected
+        //
+        std::string data(1000, 'a');
+        data += '\n';
+        for(int i(0); i < 1000; ++i)
+        {
+            data += static_cast<char>(i * 37 % 256);
+        }
+
+        edhttp::mime_type_cache cache;
+        CATCH_REQUIRE(cache.get_mime_type(as_span(data), 1001).starts_with("text/plain"));
+        CATCH_REQUIRE_FALSE(cache.get_mime_type(as_span(data)).starts_with("text/plain"));
+        CATCH_REQUIRE(cache.get_misses() == 2);
+
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/mime-type-cache-max-bytes.test");
+        write_file(filename, data);
+        CATCH_REQUIRE(cache.get_file_mime_type(filename, 1001).starts_with("text/plain"));
+        CATCH_REQUIRE_FALSE(cache.get_file_mime_type(filename).starts_with("text/plain"));
+        CATCH_REQUIRE(cache.get_file_mime_type(filename, 1001).starts_with("text/plain"));
+        CATCH_REQUIRE(cache.get_misses() == 4);
+        CATCH_REQUIRE(cache.get_hits() == 1);
+        unlink(filename.c_str());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mime_type_cache: hash")
+    {
+        std::string data(1000, 'a');
+        std::uint64_t const h(edhttp::mime_type_cache::hash_prefix(as_span(data), 1));
+        CATCH_REQUIRE(h == edhttp::mime_type_cache::hash_prefix(as_span(data), 1));
+        CATCH_REQUIRE(h != edhttp::mime_type_cache::hash_prefix(as_span(data), 2));
+        for(std::size_t idx(0); idx < data.length(); idx += 37)
+        {
+            std::string modified(data);
+            modified[idx] = 'b';
+            CATCH_REQUIRE(h != edhttp::mime_type_cache::hash_prefix(as_span(modified), 1));
+        }
+        for(std::size_t length(0); length < 70; ++length)
+        {
+            CATCH_REQUIRE(edhttp::mime_type_cache::hash_prefix(std::span<char const>(data.data(), length), 1)
+                       != edhttp::mime_type_cache::hash_prefix(std::span<char const>(data.data(), length + 1), 1));
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+CATCH_TEST_CASE("mime_type_cache_errors", "[mime][cache][error]")
+{
+    CATCH_START_SECTION("mime_type_cache_errors: invalid parameters")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::mime_type_cache(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the maximum number of entries in a mime_type_cache must be at least 1."));
+
+        edhttp::mime_type_cache cache;
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  cache.get_file_mime_type("/this/file/does/not/exist")
+                , edhttp::mime_type_io_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: could not open \"/this/file/does/not/exist\" to determine its MIME type: No such file or directory."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+// vim: ts=4 sw=4 et
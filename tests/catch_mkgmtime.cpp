@@ -125,20 +125,35 @@ CATCH_TEST_CASE("mkgmtime", "[time]")
 }
 
 
-CATCH_TEST_CASE("mkgmtime_error", "[time][error]")
+CATCH_TEST_CASE("mkgmtime_large_years", "[time]")
 {
-    CATCH_START_SECTION("mkgmtime: year over 10,000 do not work")
+    CATCH_START_SECTION("mkgmtime: years over 10,000 work too")
     {
         time_t const t(1098547031761);
 
         struct tm tim;
         gmtime_r(&t, &tim);
 
-        // Note: at the moment, mkgmtime() is a C function
-        //
         time_t const back(mkgmtime(&tim));
 
-        CATCH_REQUIRE(back - 1);
+        CATCH_REQUIRE(back == t);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("mkgmtime: negative months and days are normalized")
+    {
+        struct tm tim = {};
+        tim.tm_year = 124;
+        tim.tm_mon = -3;    // October 2023
+        tim.tm_mday = 0;    // September 30, 2023
+        time_t const back(mkgmtime(&tim));
+
+        CATCH_REQUIRE(back == 1696032000);
+        CATCH_REQUIRE(tim.tm_year == 123);
+        CATCH_REQUIRE(tim.tm_mon == 8);
+        CATCH_REQUIRE(tim.tm_mday == 30);
+        CATCH_REQUIRE(tim.tm_wday == 6);
+        CATCH_REQUIRE(tim.tm_yday == 272);
     }
     CATCH_END_SECTION()
 }
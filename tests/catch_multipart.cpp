@@ -0,0 +1,432 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the multipart parser and builder.
+ *
+ * This file implements tests to verify that multipart bodies get parsed
+ * whatever the size of the buffers, and that the builder generates data
+ * that the parser reads back.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/multipart.h"
+#include    "edhttp/quoted_printable.h"
+
+
+// C++
+//
+#include    <random>
+
+
+
+namespace
+{
+
+
+
+struct part_t
+{
+    edhttp::multipart_header_map_t  f_headers = edhttp::multipart_header_map_t();
+    std::string                     f_body = std::string();
+    bool                            f_ended = false;
+};
+
+
+class test_parser
+    : public edhttp::multipart_parser
+{
+public:
+    test_parser(std::string_view boundary)
+        : multipart_parser(boundary)
+    {
+    }
+
+    std::vector<part_t>             f_parts = std::vector<part_t>();
+
+protected:
+    virtual void process_part_begin(edhttp::multipart_header_map_t const & headers) override
+    {
+        part_t p;
+        p.f_headers = headers;
+        f_parts.push_back(p);
+    }
+
+    virtual void process_part_data(std::string_view data) override
+    {
+        CATCH_REQUIRE_FALSE(data.empty());
+        CATCH_REQUIRE_FALSE(f_parts.back().f_ended);
+        f_parts.back().f_body += data;
+    }
+
+    virtual void process_part_end() override
+    {
+        f_parts.back().f_ended = true;
+    }
+};
+
+
+std::vector<part_t> parse(std::string_view boundary, std::string const & data, std::size_t chunk_size)
+{
+    test_parser parser(boundary);
+    for(std::size_t pos(0); pos < data.length(); pos += chunk_size)
+    {
+        parser.feed(std::span<char const>(data.data() + pos, std::min(chunk_size, data.length() - pos)));
+    }
+    parser.finish();
+    CATCH_REQUIRE(parser.is_done());
+    CATCH_REQUIRE(parser.get_part_count() == parser.f_parts.size());
+    return parser.f_parts;
+}
+
+
+std::string base64_decode(std::string const & encoded)
+{
+    std::string result;
+    std::uint32_t bits(0);
+    int count(0);
+    for(char const c : encoded)
+    {
+        char const * p(strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", c));
+        if(p == nullptr || c == '\0')
+        {
+            continue;
+        }
+        bits = (bits << 6) | static_cast<std::uint32_t>(p - "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+        count += 6;
+        if(count >= 8)
+        {
+            count -= 8;
+            result += static_cast<char>(bits >> count);
+        }
+    }
+    return result;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("multipart_parser", "[multipart]")
+{
+    CATCH_START_SECTION("multipart_parser: RFC 2046 example")
+    {
+        std::string const data(
+                "This is the preamble.  It is to be ignored, though it\r\n"
+                "is a handy place for composition agents to include an\r\n"
+                "explanatory note to non-MIME conformant readers.\r\n"
+                "\r\n"
+                "--simple boundary\r\n"
+                "\r\n"
+                "This is implicitly typed plain US-ASCII text.\r\n"
+                "It does NOT end with a linebreak.\r\n"
+                "--simple boundary\r\n"
+                "Content-type: text/plain; charset=us-ascii\r\n"
+                "\r\n"
+                "This is explicitly typed plain US-ASCII text.\r\n"
+                "It DOES end with a linebreak.\r\n"
+                "\r\n"
+                "--simple boundary--\r\n"
+                "\r\n"
+                "This is the epilogue.  It is also to be ignored.\r\n");
+
+        for(std::size_t chunk_size(1); chunk_size <= data.length(); ++chunk_size)
+        {
+            std::vector<part_t> const parts(parse("simple boundary", data, chunk_size));
+            CATCH_REQUIRE(parts.size() == 2);
+
+            CATCH_REQUIRE(parts[0].f_headers.empty());
+            CATCH_REQUIRE(parts[0].f_body ==
+                    "This is implicitly typed plain US-ASCII text.\r\n"
+                    "It does NOT end with a linebreak.");
+            CATCH_REQUIRE(parts[0].f_ended);
+
+            CATCH_REQUIRE(parts[1].f_headers.size() == 1);
+            CATCH_REQUIRE(parts[1].f_headers.at("content-type") == "text/plain; charset=us-ascii");
+            CATCH_REQUIRE(parts[1].f_body ==
+                    "This is explicitly typed plain US-ASCII text.\r\n"
+                    "It DOES end with a linebreak.\r\n");
+            CATCH_REQUIRE(parts[1].f_ended);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_parser: form data with near delimiters")
+    {
+        std::string const data(
+                "--AaB03x  \r\n"
+                "Content-Disposition: form-data;\r\n"
+                "\tname=\"files\"; filename=\"a.txt\"\r\n"
+                "Content-Type: text/plain\r\n"
+                "\r\n"
+                "\r\n--AaB03\r\n-AaB03x\r\n--AaB0\r\n\r\n"
+                "--AaB03x\r\n"
+                "X-Empty:\r\n"
+                "\r\n"
+                "\r\n--AaB03x--");
+
+        for(std::size_t chunk_size(1); chunk_size <= data.length(); ++chunk_size)
+        {
+            std::vector<part_t> const parts(parse("AaB03x", data, chunk_size));
+            CATCH_REQUIRE(parts.size() == 2);
+
+            CATCH_REQUIRE(parts[0].f_headers.at("content-disposition") == "form-data; name=\"files\"; filename=\"a.txt\"");
+            CATCH_REQUIRE(parts[0].f_headers.at("content-type") == "text/plain");
+            CATCH_REQUIRE(parts[0].f_body == "\r\n--AaB03\r\n-AaB03x\r\n--AaB0\r\n");
+
+            CATCH_REQUIRE(parts[1].f_headers.at("x-empty") == "");
+            CATCH_REQUIRE(parts[1].f_body.empty());
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_parser: get_parameter()")
+    {
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("multipart/form-data; boundary=AaB03x", "boundary") == "AaB03x");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("multipart/mixed; charset=utf-8; BOUNDARY = \"a \\\"b\\\" c\" ; x=y", "boundary") == "a \"b\" c");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("form-data; name=\"upload\"; filename=\"image.png\"", "filename") == "image.png");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("form-data; name=\"upload\"; filename=\"image.png\"", "name") == "upload");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("form-data; flag; name=x", "name") == "x");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("multipart/mixed", "boundary") == "");
+        CATCH_REQUIRE(edhttp::multipart_parser::get_parameter("multipart/mixed; name=boundary", "boundary") == "");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_parser: is_valid_boundary()")
+    {
+        CATCH_REQUIRE(edhttp::multipart_parser::is_valid_boundary("a"));
+        CATCH_REQUIRE(edhttp::multipart_parser::is_valid_boundary("simple boundary"));
+        CATCH_REQUIRE(edhttp::multipart_parser::is_valid_boundary("'()+_,-./:=?"));
+        CATCH_REQUIRE(edhttp::multipart_parser::is_valid_boundary(std::string(70, 'x')));
+        CATCH_REQUIRE_FALSE(edhttp::multipart_parser::is_valid_boundary(""));
+        CATCH_REQUIRE_FALSE(edhttp::multipart_parser::is_valid_boundary(std::string(71, 'x')));
+        CATCH_REQUIRE_FALSE(edhttp::multipart_parser::is_valid_boundary("space "));
+        CATCH_REQUIRE_FALSE(edhttp::multipart_parser::is_valid_boundary("a\r\nb"));
+        CATCH_REQUIRE_FALSE(edhttp::multipart_parser::is_valid_boundary("a;b"));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("multipart_builder", "[multipart]")
+{
+    CATCH_START_SECTION("multipart_builder: simple message")
+    {
+        edhttp::multipart_builder builder("XyZ");
+        CATCH_REQUIRE(builder.get_boundary() == "XyZ");
+        CATCH_REQUIRE(builder.get_content_type() == "multipart/mixed; boundary=\"XyZ\"");
+        CATCH_REQUIRE(builder.get_content_type("multipart/form-data") == "multipart/form-data; boundary=\"XyZ\"");
+
+        std::string out;
+        builder.begin_part({{"Content-Type", "text/plain"}}, edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE, out);
+        builder.write(std::string_view("Hello"), out);
+        builder.begin_part({}, edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE, out);
+        builder.write(std::string_view("caf\xC3\xA9 "), out);
+        builder.begin_part({}, edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_BASE64, out);
+        builder.write(std::string_view("ab"), out);
+        builder.write(std::string_view("cde"), out);
+        builder.finish(out);
+        builder.finish(out);
+
+        CATCH_REQUIRE(out ==
+                "--XyZ\r\n"
+                "Content-Type: text/plain\r\n"
+                "\r\n"
+                "Hello\r\n"
+                "--XyZ\r\n"
+                "Content-Transfer-Encoding: quoted-printable\r\n"
+                "\r\n"
+                "caf=C3=A9=20\r\n"
+                "--XyZ\r\n"
+                "Content-Transfer-Encoding: base64\r\n"
+                "\r\n"
+                "YWJjZGU=\r\n"
+                "--XyZ--\r\n");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_builder: random boundary")
+    {
+        edhttp::multipart_builder a;
+        edhttp::multipart_builder b;
+        CATCH_REQUIRE(edhttp::multipart_parser::is_valid_boundary(a.get_boundary()));
+        CATCH_REQUIRE(a.get_boundary() != b.get_boundary());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_builder: round trip")
+    {
+        std::mt19937 generator(5);
+        for(int count(0); count < 200; ++count)
+        {
+            std::vector<std::string> bodies;
+            std::vector<edhttp::multipart_builder::transfer_encoding_t> encodings;
+            std::size_t const part_count(generator() % 5);
+            edhttp::multipart_builder builder;
+            builder.set_quoted_printable_flags(edhttp::QUOTED_PRINTABLE_FLAG_BINARY);
+            std::string out;
+            for(std::size_t idx(0); idx < part_count; ++idx)
+            {
+                std::string body;
+                std::size_t const length(generator() % 500);
+                for(std::size_t j(0); j < length; ++j)
+                {
+                    body += static_cast<char>(generator());
+                }
+                bodies.push_back(body);
+                encodings.push_back(static_cast<edhttp::multipart_builder::transfer_encoding_t>(generator() % 3));
+
+                builder.begin_part(
+                          {{"Content-Disposition", "form-data; name=\"f" + std::to_string(idx) + "\""}}
+                        , encodings.back()
+                        , out);
+                std::size_t const chunk_size(generator() % 50 + 1);
+                for(std::size_t pos(0); pos < body.length(); pos += chunk_size)
+                {
+                    builder.write(std::span<char const>(body.data() + pos, std::min(chunk_size, body.length() - pos)), out);
+                }
+            }
+            builder.finish(out);
+
+            std::vector<part_t> const parts(parse(builder.get_boundary(), out, generator() % 100 + 1));
+            CATCH_REQUIRE(parts.size() == part_count);
+            for(std::size_t idx(0); idx < part_count; ++idx)
+            {
+                CATCH_REQUIRE(edhttp::multipart_parser::get_parameter(parts[idx].f_headers.at("content-disposition"), "name") == "f" + std::to_string(idx));
+                switch(encodings[idx])
+                {
+                case edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE:
+                    CATCH_REQUIRE(parts[idx].f_headers.count("content-transfer-encoding") == 0);
+                    CATCH_REQUIRE(parts[idx].f_body == bodies[idx]);
+                    break;
+
+                case edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_QUOTED_PRINTABLE:
+                    CATCH_REQUIRE(parts[idx].f_headers.at("content-transfer-encoding") == "quoted-printable");
+                    CATCH_REQUIRE(edhttp::quoted_printable_decode(parts[idx].f_body) == bodies[idx]);
+                    break;
+
+                case edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_BASE64:
+                    CATCH_REQUIRE(parts[idx].f_headers.at("content-transfer-encoding") == "base64");
+                    CATCH_REQUIRE(base64_decode(parts[idx].f_body) == bodies[idx]);
+                    for(std::size_t pos(0); pos < parts[idx].f_body.length(); pos += 78)
+                    {
+                        std::string::size_type const eol(parts[idx].f_body.find("\r\n", pos));
+                        CATCH_REQUIRE((eol == std::string::npos ? parts[idx].f_body.length() : eol) - pos <= 76);
+                    }
+                    break;
+
+                }
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("multipart_errors", "[multipart][error]")
+{
+    CATCH_START_SECTION("multipart_errors: invalid boundaries")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  test_parser("bad;boundary")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid multipart boundary \"bad;boundary\"."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::multipart_builder(std::string(71, 'x'))
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid multipart boundary \"" + std::string(71, 'x') + "\"."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_errors: invalid data")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--bx\r\n", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: unexpected character after a multipart boundary."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b\rx", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: a multipart boundary must be followed by CRLF."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b-x", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: a multipart close delimiter must end with \"--\"."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b\r\n no header\r\n", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: a multipart part cannot start with a header continuation."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b\r\nno colon\r\n", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid header \"no colon\" in a multipart part."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b\r\nX-Large: " + std::string(edhttp::multipart_parser::MAX_HEADER_SIZE, 'x') + "\r\n", 1000)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the headers of a multipart part are too large."));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  parse("b", "--b\r\n\r\ndata\r\n--b", 10)
+                , edhttp::multipart_error
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: multipart data ended before its closing delimiter."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("multipart_errors: builder misuse")
+    {
+        edhttp::multipart_builder builder;
+        std::string out;
+        CATCH_REQUIRE_THROWS_AS(builder.write(std::string_view("data"), out), edhttp::logic_error);
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  builder.begin_part({{"X-Bad", "a\r\nb"}}, edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE, out)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid multipart header \"X-Bad\"."));
+
+        builder.finish(out);
+        CATCH_REQUIRE_THROWS_AS(builder.begin_part({}, edhttp::multipart_builder::transfer_encoding_t::TRANSFER_ENCODING_NONE, out), edhttp::logic_error);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
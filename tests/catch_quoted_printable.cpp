@@ -0,0 +1,283 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the quoted-printable encoder and decoder.
+ *
+ * This file implements tests to verify that the quoted-printable codec
+ * generates the expected output and that the streaming classes give
+ * the same result whatever the size of the chunks.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/quoted_printable.h"
+
+
+// C++
+//
+#include    <random>
+
+
+
+namespace
+{
+
+
+
+std::string encode_in_chunks(std::string const & input, int flags, std::size_t chunk_size)
+{
+    std::string result;
+    edhttp::quoted_printable_encoder encoder(flags);
+    for(std::size_t pos(0); pos < input.length(); pos += chunk_size)
+    {
+        encoder.encode(std::span<char const>(input.data() + pos, std::min(chunk_size, input.length() - pos)), result);
+    }
+    encoder.finish(result);
+    return result;
+}
+
+
+std::string decode_in_chunks(std::string const & input, std::size_t chunk_size)
+{
+    std::string result;
+    edhttp::quoted_printable_decoder decoder;
+    for(std::size_t pos(0); pos < input.length(); pos += chunk_size)
+    {
+        decoder.decode(std::span<char const>(input.data() + pos, std::min(chunk_size, input.length() - pos)), result);
+    }
+    decoder.finish(result);
+    return result;
+}
+
+
+std::size_t longest_line(std::string const & encoded)
+{
+    std::size_t longest(0);
+    std::size_t start(0);
+    for(;;)
+    {
+        std::string::size_type const pos(encoded.find('\n', start));
+        std::size_t const end(pos == std::string::npos ? encoded.length() : pos);
+        std::size_t length(end - start);
+        if(length > 0 && encoded[end - 1] == '\r')
+        {
+            --length;
+        }
+        longest = std::max(longest, length);
+        if(pos == std::string::npos)
+        {
+            return longest;
+        }
+        start = pos + 1;
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("quoted_printable_encode", "[quoted_printable]")
+{
+    CATCH_START_SECTION("quoted_printable_encode: plain text")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("") == "");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("Hello World!") == "Hello World!");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a=b") == "a=3Db");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("caf\xC3\xA9") == "caf=C3=A9");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode(std::string("a\0b", 3)) == "a=00b");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_encode: new lines")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\nb\rc\r\nd") == "a\r\nb\r\nc\r\nd");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\r\nb", edhttp::QUOTED_PRINTABLE_FLAG_LFONLY) == "a\nb");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\r\nb", edhttp::QUOTED_PRINTABLE_FLAG_BINARY) == "a=0D=0Ab");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_encode: trailing spaces and tabs")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a b") == "a b");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a ") == "a=20");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\t") == "a=09");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a  \nb") == "a =20\r\nb");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a \xFF") == "a =FF");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a b", edhttp::QUOTED_PRINTABLE_FLAG_BINARY) == "a=20b");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_encode: EDBIC and lone periods")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a@b~", edhttp::QUOTED_PRINTABLE_FLAG_EDBIC) == "a=40b=7E");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\n.\nb", edhttp::QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD) == "a\r\n=2E\r\nb");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode(".", edhttp::QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD) == "=2E");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode(".a\na.\n..", edhttp::QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD) == ".a\r\na.\r\n..");
+        CATCH_REQUIRE(edhttp::quoted_printable_encode("a\n.\nb") == "a\r\n.\r\nb");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_encode: soft line breaks")
+    {
+        std::string const line(100, 'x');
+        std::string const encoded(edhttp::quoted_printable_encode(line));
+        CATCH_REQUIRE(encoded == std::string(75, 'x') + "=\r\n" + std::string(25, 'x'));
+
+        std::string const escaped(edhttp::quoted_printable_encode(std::string(74, 'x') + "=", edhttp::QUOTED_PRINTABLE_FLAG_LFONLY));
+        CATCH_REQUIRE(escaped == std::string(74, 'x') + "=\n=3D");
+
+        std::string const period(edhttp::quoted_printable_encode(std::string(75, 'x') + ".", edhttp::QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD));
+        CATCH_REQUIRE(period == std::string(75, 'x') + "=\r\n=2E");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("quoted_printable_decode", "[quoted_printable]")
+{
+    CATCH_START_SECTION("quoted_printable_decode: escape sequences")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("") == "");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("Hello World!") == "Hello World!");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=3Db") == "a=b");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("caf=c3=a9") == "caf\xC3\xA9");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=00b") == std::string("a\0b", 3));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_decode: soft line breaks")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("abc=\r\ndef") == "abcdef");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("abc=\ndef") == "abcdef");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("abc=\rdef") == "abcdef");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("abc\r\ndef") == "abc\r\ndef");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_decode: invalid sequences")
+    {
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=ZZb") == "a?Zb");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=4Zb") == "a?b");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=") == "a?");
+        CATCH_REQUIRE(edhttp::quoted_printable_decode("a=4") == "a?");
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("quoted_printable_streaming", "[quoted_printable]")
+{
+    CATCH_START_SECTION("quoted_printable_streaming: chunk boundaries do not matter")
+    {
+        char const alphabet[] = "abc .\t\r\n=\xC3\xA9~@\0";
+        std::mt19937 generator(1);
+        for(int count(0); count < 2000; ++count)
+        {
+            std::string input;
+            std::size_t const length(generator() % 300);
+            for(std::size_t idx(0); idx < length; ++idx)
+            {
+                input += alphabet[generator() % (sizeof(alphabet) - 1)];
+            }
+            int const flags(static_cast<int>(generator() % 16));
+
+            std::string const encoded(edhttp::quoted_printable_encode(input, flags));
+            CATCH_REQUIRE(longest_line(encoded) <= 76);
+
+            std::size_t const chunk_size(generator() % 20 + 1);
+            CATCH_REQUIRE(encode_in_chunks(input, flags, chunk_size) == encoded);
+            CATCH_REQUIRE(decode_in_chunks(encoded, chunk_size) == edhttp::quoted_printable_decode(encoded));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_streaming: binary round trip")
+    {
+        std::mt19937 generator(2);
+        for(int count(0); count < 500; ++count)
+        {
+            std::string input;
+            std::size_t const length(generator() % 1000);
+            for(std::size_t idx(0); idx < length; ++idx)
+            {
+                input += static_cast<char>(generator());
+            }
+            std::string const encoded(encode_in_chunks(input, edhttp::QUOTED_PRINTABLE_FLAG_BINARY, 37));
+            CATCH_REQUIRE(encoded.find_first_not_of("!\"#$%&'()*+,-./0123456789:;<>=?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\r\n") == std::string::npos);
+            CATCH_REQUIRE(decode_in_chunks(encoded, 13) == input);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_streaming: text round trip")
+    {
+        char const alphabet[] = "The quick brown fox\tjumps over the lazy dog=.\xC3\xA9";
+        std::mt19937 generator(3);
+        for(int count(0); count < 500; ++count)
+        {
+            std::string input;
+            std::size_t const length(generator() % 1000);
+            for(std::size_t idx(0); idx < length; ++idx)
+            {
+                input += alphabet[generator() % (sizeof(alphabet) - 1)];
+            }
+            std::string const encoded(encode_in_chunks(input, edhttp::QUOTED_PRINTABLE_FLAG_NO_LONE_PERIOD, 64));
+            CATCH_REQUIRE(longest_line(encoded) <= 76);
+            CATCH_REQUIRE(encoded.find(" \r\n") == std::string::npos);
+            CATCH_REQUIRE(encoded.find("\t\r\n") == std::string::npos);
+            CATCH_REQUIRE(decode_in_chunks(encoded, 1) == input);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("quoted_printable_streaming: reuse after finish()")
+    {
+        edhttp::quoted_printable_encoder encoder(edhttp::QUOTED_PRINTABLE_FLAG_LFONLY);
+        CATCH_REQUIRE(encoder.get_flags() == edhttp::QUOTED_PRINTABLE_FLAG_LFONLY);
+
+        std::string out;
+        encoder.encode(std::string_view("a \r"), out);
+        encoder.finish(out);
+        CATCH_REQUIRE(out == "a=20\n");
+
+        out.clear();
+        encoder.encode(std::string_view("\nb "), out);
+        encoder.finish(out);
+        CATCH_REQUIRE(out == "\nb=20");
+
+        edhttp::quoted_printable_decoder decoder;
+        out.clear();
+        decoder.decode(std::string_view("x=4"), out);
+        decoder.reset();
+        decoder.decode(std::string_view("1"), out);
+        decoder.finish(out);
+        CATCH_REQUIRE(out == "x1");
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
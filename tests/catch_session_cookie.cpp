@@ -0,0 +1,374 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the session_cookie codec.
+ *
+ * This file implements tests to verify that session cookies get signed,
+ * encrypted, verified and rejected as expected.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/session_cookie.h"
+
+
+// OpenSSL
+//
+#include    <openssl/evp.h>
+#include    <openssl/hmac.h>
+
+
+// C++
+//
+#include    <optional>
+
+
+
+namespace
+{
+
+
+
+std::string const g_secret1("0123456789abcdef0123456789abcdef");
+std::string const g_secret2("fedcba9876543210fedcba9876543210-second-key");
+time_t const g_now(1700000000);
+
+
+std::string tamper(std::string value, std::size_t pos)
+{
+    value[pos] = value[pos] == 'A' ? 'B' : 'A';
+    return value;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("session_cookie", "[cookie][session]")
+{
+    CATCH_START_SECTION("session_cookie: HMAC token format")
+    {
+        edhttp::session_cookie codec;
+        codec.add_key(7, g_secret1);
+        std::string const value(codec.encode("user=42", g_now));
+
+        // rebuild the token with the one-shot HMAC of OpenSSL
+        //
+        std::string token;
+        token += '\x01';
+        token += '\x07';
+        for(int shift(56); shift >= 0; shift -= 8)
+        {
+            token += static_cast<char>(static_cast<std::uint64_t>(g_now) >> shift);
+        }
+        token += "user=42";
+        unsigned char digest[32];
+        unsigned int size(0);
+        HMAC(EVP_sha256(), g_secret1.data(), static_cast<int>(g_secret1.length())
+                , reinterpret_cast<unsigned char const *>(token.data()), token.length()
+                , digest, &size);
+        CATCH_REQUIRE(size == 32);
+        token.append(reinterpret_cast<char const *>(digest), size);
+
+        unsigned char encoded[128];
+        int const length(EVP_EncodeBlock(encoded, reinterpret_cast<unsigned char const *>(token.data()), static_cast<int>(token.length())));
+        std::string expected(reinterpret_cast<char const *>(encoded), length);
+        while(!expected.empty() && expected.back() == '=')
+        {
+            expected.pop_back();
+        }
+        for(auto & c : expected)
+        {
+            if(c == '+')
+            {
+                c = '-';
+            }
+            else if(c == '/')
+            {
+                c = '_';
+            }
+        }
+        CATCH_REQUIRE(value == expected);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: round trip with both algorithms")
+    {
+        for(auto const algorithm : {
+                      edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256
+                    , edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM })
+        {
+            edhttp::session_cookie codec(algorithm);
+            CATCH_REQUIRE(codec.get_algorithm() == algorithm);
+            codec.add_key(1, g_secret1);
+
+            std::string binary;
+            for(int c(0); c < 256; ++c)
+            {
+                binary += static_cast<char>(c);
+            }
+            for(std::size_t length(0); length < 70; ++length)
+            {
+                std::string const payload(binary.substr(0, length));
+                std::string const value(codec.encode(payload, g_now));
+                CATCH_REQUIRE(value.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_") == std::string::npos);
+
+                std::string decoded("garbage");
+                CATCH_REQUIRE(codec.decode(value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+                CATCH_REQUIRE(decoded == payload);
+                CATCH_REQUIRE(codec.get_expire(value) == g_now + edhttp::session_cookie::DEFAULT_MAX_AGE);
+            }
+
+            // the encrypted payload is not visible
+            //
+            std::string const value(codec.encode("visible-secret", g_now));
+            std::string decoded;
+            CATCH_REQUIRE(codec.decode(value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+            if(algorithm == edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM)
+            {
+                CATCH_REQUIRE(value != codec.encode("visible-secret", g_now));
+            }
+            else
+            {
+                CATCH_REQUIRE(value == codec.encode("visible-secret", g_now));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: tampered cookies")
+    {
+        for(auto const algorithm : {
+                      edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256
+                    , edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM })
+        {
+            edhttp::session_cookie codec(algorithm);
+            codec.add_key(1, g_secret1);
+            std::string const value(codec.encode("user=42;admin=0", g_now));
+            std::string decoded;
+            for(std::size_t pos(3); pos < value.length() - 1; ++pos)
+            {
+                edhttp::session_cookie::status_t const status(codec.decode(tamper(value, pos), decoded, g_now));
+                CATCH_REQUIRE(status != edhttp::session_cookie::status_t::STATUS_VALID);
+                CATCH_REQUIRE(decoded.empty());
+            }
+
+            CATCH_REQUIRE(codec.decode("", decoded, g_now) == edhttp::session_cookie::status_t::STATUS_MALFORMED);
+            CATCH_REQUIRE(codec.decode("abc", decoded, g_now) == edhttp::session_cookie::status_t::STATUS_MALFORMED);
+            CATCH_REQUIRE(codec.decode(value + "=", decoded, g_now) == edhttp::session_cookie::status_t::STATUS_MALFORMED);
+            CATCH_REQUIRE(codec.decode(value.substr(0, value.length() - 8), decoded, g_now) != edhttp::session_cookie::status_t::STATUS_VALID);
+
+            // a token of the other algorithm is rejected
+            //
+            edhttp::session_cookie other(algorithm == edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256
+                                            ? edhttp::session_cookie::algorithm_t::ALGORITHM_AES_256_GCM
+                                            : edhttp::session_cookie::algorithm_t::ALGORITHM_HMAC_SHA256);
+            other.add_key(1, g_secret1);
+            CATCH_REQUIRE(codec.decode(other.encode("user=42;admin=0", g_now), decoded, g_now) == edhttp::session_cookie::status_t::STATUS_MALFORMED);
+
+            // same key id, different secret
+            //
+            edhttp::session_cookie forger(algorithm);
+            forger.add_key(1, g_secret2);
+            CATCH_REQUIRE(codec.decode(forger.encode("user=42;admin=1", g_now), decoded, g_now) == edhttp::session_cookie::status_t::STATUS_BAD_SIGNATURE);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: expiration")
+    {
+        edhttp::session_cookie codec;
+        codec.add_key(1, g_secret1);
+        codec.set_max_age(3600);
+        CATCH_REQUIRE(codec.get_max_age() == 3600);
+        codec.set_clock_skew(10);
+        CATCH_REQUIRE(codec.get_clock_skew() == 10);
+
+        std::string const value(codec.encode("x", g_now));
+        std::string decoded;
+        CATCH_REQUIRE(codec.decode(value, decoded, g_now + 3599) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(codec.decode(value, decoded, g_now + 3600) == edhttp::session_cookie::status_t::STATUS_EXPIRED);
+        CATCH_REQUIRE(decoded.empty());
+        CATCH_REQUIRE(codec.decode(value, decoded, g_now - 10) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(codec.decode(value, decoded, g_now - 11) == edhttp::session_cookie::status_t::STATUS_NOT_YET_VALID);
+        CATCH_REQUIRE(codec.get_expire(value) == g_now + 3600);
+        CATCH_REQUIRE(codec.get_expire("short") == -1);
+
+        edhttp::http_cookie cookie("session");
+        codec.set_cookie(cookie, "x");
+        CATCH_REQUIRE(cookie.get_secure());
+        CATCH_REQUIRE(cookie.get_http_only());
+        CATCH_REQUIRE(cookie.get_type() == edhttp::http_cookie::http_cookie_type_t::HTTP_COOKIE_TYPE_PERMANENT);
+        CATCH_REQUIRE(codec.decode(cookie.get_value(), decoded) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(decoded == "x");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: key rotation")
+    {
+        edhttp::session_cookie codec;
+        codec.add_key(1, g_secret1);
+        CATCH_REQUIRE(codec.get_current_key() == 1);
+        std::string const old_value(codec.encode("old", g_now));
+
+        codec.add_key(2, g_secret2);
+        CATCH_REQUIRE(codec.get_current_key() == 1);
+        codec.set_current_key(2);
+        CATCH_REQUIRE(codec.get_current_key() == 2);
+        std::string const new_value(codec.encode("new", g_now));
+
+        std::string decoded;
+        CATCH_REQUIRE(codec.decode(old_value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(decoded == "old");
+        CATCH_REQUIRE(codec.decode(new_value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(decoded == "new");
+
+        codec.remove_key(1);
+        CATCH_REQUIRE_FALSE(codec.has_key(1));
+        CATCH_REQUIRE(codec.has_key(2));
+        CATCH_REQUIRE(codec.decode(old_value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_UNKNOWN_KEY);
+        CATCH_REQUIRE(codec.decode(new_value, decoded, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: per connection cache")
+    {
+        edhttp::session_cookie codec;
+        codec.add_key(1, g_secret1);
+        codec.set_max_age(100);
+        std::string const value(codec.encode("user=42", g_now));
+
+        edhttp::session_cookie_cache cache;
+        CATCH_REQUIRE(cache.decode(codec, value, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+        CATCH_REQUIRE(cache.get_payload() == "user=42");
+        CATCH_REQUIRE(cache.get_misses() == 1);
+        for(int i(1); i < 100; ++i)
+        {
+            CATCH_REQUIRE(cache.decode(codec, value, g_now + i) == edhttp::session_cookie::status_t::STATUS_VALID);
+            CATCH_REQUIRE(cache.get_payload() == "user=42");
+        }
+        CATCH_REQUIRE(cache.get_hits() == 99);
+        CATCH_REQUIRE(cache.get_misses() == 1);
+
+        // expired
+        //
+        CATCH_REQUIRE(cache.decode(codec, value, g_now + 100) == edhttp::session_cookie::status_t::STATUS_EXPIRED);
+        CATCH_REQUIRE(cache.get_misses() == 2);
+
+        // a change of keys invalidates the cache
+        //
+        CATCH_REQUIRE(cache.decode(codec, value, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+        codec.add_key(2, g_secret2);
+        codec.set_current_key(2);
+        codec.remove_key(1);
+        CATCH_REQUIRE(cache.decode(codec, value, g_now) == edhttp::session_cookie::status_t::STATUS_UNKNOWN_KEY);
+        CATCH_REQUIRE(cache.get_payload().empty());
+
+        cache.clear();
+        CATCH_REQUIRE(cache.get_payload().empty());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("session_cookie: cache and codec swapped at the same address")
+    {
+        // the documented rotation creates a new codec; here it is built
+        // where the old one was to make sure the cache notices
+        //
+        std::optional<edhttp::session_cookie> codec;
+        codec.emplace();
+        codec->add_key(1, g_secret1);
+        std::string const value(codec->encode("user=42", g_now));
+
+        edhttp::session_cookie_cache cache;
+        CATCH_REQUIRE(cache.decode(*codec, value, g_now) == edhttp::session_cookie::status_t::STATUS_VALID);
+
+        edhttp::session_cookie const * old_codec(&*codec);
+        codec.reset();
+        codec.emplace();
+        codec->add_key(2, g_secret2);
+        CATCH_REQUIRE(&*codec == old_codec);
+
+        CATCH_REQUIRE(cache.decode(*codec, value, g_now) == edhttp::session_cookie::status_t::STATUS_UNKNOWN_KEY);
+        CATCH_REQUIRE(cache.get_payload().empty());
+        CATCH_REQUIRE(cache.get_hits() == 0);
+        CATCH_REQUIRE(cache.get_misses() == 2);
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+CATCH_TEST_CASE("session_cookie_errors", "[cookie][session][error]")
+{
+    CATCH_START_SECTION("session_cookie_errors: invalid setup")
+    {
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::session_cookie(static_cast<edhttp::session_cookie::algorithm_t>(3))
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: unknown session cookie algorithm."));
+
+        edhttp::session_cookie codec;
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.encode("x")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: a session cookie key must be added before encoding cookies."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.add_key(1, "too short")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: a session cookie secret must be at least 32 bytes."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.set_current_key(5)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: session cookie key 5 is not defined."));
+
+        codec.add_key(1, g_secret1);
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.remove_key(1)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the current session cookie key cannot be removed."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.set_max_age(0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the max-age of a session cookie must be positive."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  codec.set_clock_skew(-1)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: the clock skew of a session cookie cannot be negative."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,495 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the structured_field class.
+ *
+ * The corpus below is an offline copy of the cases found in the
+ * HTTP working group structured field tests
+ * (https://github.com/httpwg/structured-field-tests). Each case gives
+ * the raw field, its type, and either the canonical serialization or
+ * whether the parser must (or may) fail.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/structured_field.h"
+
+
+
+namespace
+{
+
+
+
+enum class expect_t
+{
+    EXPECT_PASS,
+    EXPECT_FAIL,
+    EXPECT_CAN_FAIL
+};
+
+
+struct corpus_t
+{
+    char const *                                f_name = nullptr;
+    char const *                                f_raw = nullptr;
+    edhttp::structured_field::field_type_t      f_type = edhttp::structured_field::field_type_t::FIELD_TYPE_ITEM;
+    char const *                                f_canonical = nullptr;     // nullptr when equal to f_raw
+    expect_t                                    f_expect = expect_t::EXPECT_PASS;
+};
+
+
+constexpr edhttp::structured_field::field_type_t const ITEM = edhttp::structured_field::field_type_t::FIELD_TYPE_ITEM;
+constexpr edhttp::structured_field::field_type_t const LIST = edhttp::structured_field::field_type_t::FIELD_TYPE_LIST;
+constexpr edhttp::structured_field::field_type_t const DICT = edhttp::structured_field::field_type_t::FIELD_TYPE_DICTIONARY;
+
+constexpr expect_t const PASS = expect_t::EXPECT_PASS;
+constexpr expect_t const FAIL = expect_t::EXPECT_FAIL;
+constexpr expect_t const CAN_FAIL = expect_t::EXPECT_CAN_FAIL;
+
+
+corpus_t const g_corpus[] =
+{
+    // binary.json
+    { "basic binary",                   ":aGVsbG8=:",               ITEM, nullptr, PASS },
+    { "empty binary",                   "::",                       ITEM, nullptr, PASS },
+    { "padding at beginning",           ":=aGVsbG8=:",              ITEM, nullptr, FAIL },
+    { "padding in middle",              ":a=GVsbG8=:",              ITEM, nullptr, FAIL },
+    { "bad padding",                    ":aGVsbG8:",                ITEM, ":aGVsbG8=:", CAN_FAIL },
+    { "bad padding dot",                ":aGVsbG8.:",               ITEM, nullptr, FAIL },
+    { "bad end delimiter",              ":aGVsbG8=",                ITEM, nullptr, FAIL },
+    { "extra whitespace",               ":aGVsb G8=:",              ITEM, nullptr, FAIL },
+    { "all whitespace",                 ":    :",                   ITEM, nullptr, FAIL },
+    { "extra chars",                    ":aGVsbG!8=:",              ITEM, nullptr, FAIL },
+    { "suffix chars",                   ":aGVsbG8=!:",              ITEM, nullptr, FAIL },
+    { "non-zero pad bits",              ":iZ==:",                   ITEM, ":iQ==:", CAN_FAIL },
+    { "non-ASCII binary",               ":/+Ah:",                   ITEM, nullptr, PASS },
+    { "base64url binary",               ":_-Ah:",                   ITEM, nullptr, FAIL },
+
+    // boolean.json
+    { "basic true boolean",             "?1",                       ITEM, nullptr, PASS },
+    { "basic false boolean",            "?0",                       ITEM, nullptr, PASS },
+    { "unknown boolean",                "?Q",                       ITEM, nullptr, FAIL },
+    { "whitespace boolean",             "? 1",                      ITEM, nullptr, FAIL },
+    { "negative zero boolean",          "?-0",                      ITEM, nullptr, FAIL },
+    { "T boolean",                      "?T",                       ITEM, nullptr, FAIL },
+    { "F boolean",                      "?F",                       ITEM, nullptr, FAIL },
+    { "t boolean",                      "?t",                       ITEM, nullptr, FAIL },
+    { "f boolean",                      "?f",                       ITEM, nullptr, FAIL },
+    { "spelled-out True boolean",       "?True",                    ITEM, nullptr, FAIL },
+    { "spelled-out False boolean",      "?False",                   ITEM, nullptr, FAIL },
+
+    // dictionary.json
+    { "basic dictionary",               "en=\"Applepie\", da=:w4ZibGV0w6ZydGUK:", DICT, nullptr, PASS },
+    { "empty dictionary",               "",                         DICT, nullptr, PASS },
+    { "single item dictionary",         "a=1",                      DICT, nullptr, PASS },
+    { "list item dictionary",           "a=(1 2)",                  DICT, nullptr, PASS },
+    { "single list item dictionary",    "a=(1)",                    DICT, nullptr, PASS },
+    { "empty list item dictionary",     "a=()",                     DICT, nullptr, PASS },
+    { "no whitespace dictionary",       "a=1,b=2",                  DICT, "a=1, b=2", PASS },
+    { "extra whitespace dictionary",    "a=1 ,  b=2",               DICT, "a=1, b=2", PASS },
+    { "tab separated dictionary",       "a=1\t,\tb=2",              DICT, "a=1, b=2", PASS },
+    { "leading whitespace dictionary",  "     a=1 ,  b=2",          DICT, "a=1, b=2", PASS },
+    { "whitespace before = dictionary", "a =1, b=2",                DICT, nullptr, FAIL },
+    { "whitespace after = dictionary",  "a=1, b= 2",                DICT, nullptr, FAIL },
+    { "two lines dictionary",           "a=1, b=2",                 DICT, nullptr, PASS },
+    { "missing value dictionary",       "a=1, b, c=3",              DICT, nullptr, PASS },
+    { "all missing value dictionary",   "a, b, c",                  DICT, nullptr, PASS },
+    { "start missing value dictionary", "a, b=2",                   DICT, nullptr, PASS },
+    { "end missing value dictionary",   "a=1, b",                   DICT, nullptr, PASS },
+    { "missing value with params dictionary", "a=1, b;foo=9, c=3",  DICT, nullptr, PASS },
+    { "explicit true value with params dictionary", "a=1, b=?1;foo=9, c=3", DICT, "a=1, b;foo=9, c=3", PASS },
+    { "trailing comma dictionary",      "a=1, b=2,",                DICT, nullptr, FAIL },
+    { "empty item dictionary",          "a=1,,b=2,",                DICT, nullptr, FAIL },
+    { "duplicate key dictionary",       "a=1,b=2,a=3",              DICT, "a=3, b=2", PASS },
+    { "numeric key dictionary",         "a=1,1b=2,a=1",             DICT, nullptr, FAIL },
+    { "uppercase key dictionary",       "a=1,B=2,a=1",              DICT, nullptr, FAIL },
+    { "bad key dictionary",             "a=1,b!=2,a=1",             DICT, nullptr, FAIL },
+
+    // examples.json
+    { "Foo-Example",                    "2; foourl=\"https://foo.example.com/\"", ITEM, "2;foourl=\"https://foo.example.com/\"", PASS },
+    { "Example-StrList",                "\"foo\", \"bar\", \"It was the best of times.\"", LIST, nullptr, PASS },
+    { "Example-Hdr (list on one line)", "foo, bar",                 LIST, nullptr, PASS },
+    { "Example-StrListList",            "(\"foo\" \"bar\"), (\"baz\"), (\"bat\" \"one\"), ()", LIST, nullptr, PASS },
+    { "Example-ListListParam",          "(\"foo\"; a=1;b=2);lvl=5, (\"bar\" \"baz\");lvl=1", LIST, "(\"foo\";a=1;b=2);lvl=5, (\"bar\" \"baz\");lvl=1", PASS },
+    { "Example-ParamList",              "abc;a=1;b=2; cde_456, (ghi;jk=4 l);q=\"9\";r=w", LIST, "abc;a=1;b=2;cde_456, (ghi;jk=4 l);q=\"9\";r=w", PASS },
+    { "Example-IntHeader",              "1; a; b=?0",               ITEM, "1;a;b=?0", PASS },
+    { "Example-DictHeader",             "en=\"Applepie\", da=:w4ZibGV0w6ZydGU=:", DICT, nullptr, PASS },
+    { "Example-DictHeader (boolean values)", "a=?0, b, c; foo=bar", DICT, "a=?0, b, c;foo=bar", PASS },
+    { "Example-DictListHeader",         "rating=1.5, feelings=(joy sadness)", DICT, nullptr, PASS },
+    { "Example-MixDict",                "a=(1 2), b=3, c=4;aa=bb, d=(5 6);valid", DICT, nullptr, PASS },
+    { "Example-Hdr (dictionary on one line)", "foo=1, bar=2",       DICT, nullptr, PASS },
+    { "Example-IntItemHeader",          "5",                        ITEM, nullptr, PASS },
+    { "Example-IntItemHeader (params)", "5; foo=bar",               ITEM, "5;foo=bar", PASS },
+    { "Example-IntegerHeader",          "42",                       ITEM, nullptr, PASS },
+    { "Example-FloatHeader",            "4.5",                      ITEM, nullptr, PASS },
+    { "Example-StringHeader",           "\"hello world\"",          ITEM, nullptr, PASS },
+    { "Example-BinaryHdr",              ":cHJldGVuZCB0aGlzIGlzIGJpbmFyeSBjb250ZW50Lg==:", ITEM, nullptr, PASS },
+    { "Example-BoolHdr",                "?1",                       ITEM, nullptr, PASS },
+
+    // item.json
+    { "empty item",                     "",                         ITEM, nullptr, FAIL },
+    { "leading space",                  " \t 1",                    ITEM, nullptr, FAIL },
+    { "trailing space",                 "1 \t ",                    ITEM, nullptr, FAIL },
+    { "leading and trailing space",     "  1  ",                    ITEM, "1", PASS },
+    { "leading and trailing whitespace", "     1  ",                ITEM, "1", PASS },
+
+    // list.json
+    { "basic list",                     "1, 42",                    LIST, nullptr, PASS },
+    { "empty list",                     "",                         LIST, nullptr, PASS },
+    { "leading SP list",                "  42, 43",                 LIST, "42, 43", PASS },
+    { "single item list",               "42",                       LIST, nullptr, PASS },
+    { "no whitespace list",             "1,42",                     LIST, "1, 42", PASS },
+    { "extra whitespace list",          "1 , 42",                   LIST, "1, 42", PASS },
+    { "tab separated list",             "1\t,\t42",                 LIST, "1, 42", PASS },
+    { "two line list",                  "1, 42",                    LIST, nullptr, PASS },
+    { "trailing comma list",            "1, 42,",                   LIST, nullptr, FAIL },
+    { "empty item list",                "1,,42",                    LIST, nullptr, FAIL },
+    { "empty item list (multiple field lines)", "1, , 42",          LIST, nullptr, FAIL },
+
+    // listlist.json
+    { "basic list of lists",            "(1 2), (42 43)",           LIST, nullptr, PASS },
+    { "single item list of lists",      "(42)",                     LIST, nullptr, PASS },
+    { "empty item list of lists",       "()",                       LIST, nullptr, PASS },
+    { "empty middle item list of lists", "(1),(),(42)",             LIST, "(1), (), (42)", PASS },
+    { "extra whitespace list of lists", "(  1  42  )",              LIST, "(1 42)", PASS },
+    { "wrong whitespace list of lists", "(1\t 42)",                 LIST, nullptr, FAIL },
+    { "no trailing parenthesis list of lists", "(1 42",             LIST, nullptr, FAIL },
+    { "no trailing parenthesis middle list of lists", "(1 2, (42 43)", LIST, nullptr, FAIL },
+    { "no spaces in inner-list",        "(abc\"def\"?0123*dXZ3*xyz)", LIST, nullptr, FAIL },
+    { "no closing parenthesis",         "(",                        LIST, nullptr, FAIL },
+
+    // number.json
+    { "basic integer",                  "42",                       ITEM, nullptr, PASS },
+    { "zero integer",                   "0",                        ITEM, nullptr, PASS },
+    { "negative zero",                  "-0",                       ITEM, "0", PASS },
+    { "double negative zero",           "--0",                      ITEM, nullptr, FAIL },
+    { "negative integer",               "-42",                      ITEM, nullptr, PASS },
+    { "leading 0 integer",              "042",                      ITEM, "42", PASS },
+    { "leading 0 negative integer",     "-042",                     ITEM, "-42", PASS },
+    { "leading 0 zero",                 "00",                       ITEM, "0", PASS },
+    { "comma",                          "2,3",                      ITEM, nullptr, FAIL },
+    { "negative non-DIGIT first character", "-a23",                 ITEM, nullptr, FAIL },
+    { "sign out of place",              "4-2",                      ITEM, nullptr, FAIL },
+    { "whitespace after sign",          "- 42",                     ITEM, nullptr, FAIL },
+    { "long integer",                   "123456789012345",          ITEM, nullptr, PASS },
+    { "long negative integer",          "-123456789012345",         ITEM, nullptr, PASS },
+    { "too long integer",               "1234567890123456",         ITEM, nullptr, FAIL },
+    { "negative too long integer",      "-1234567890123456",        ITEM, nullptr, FAIL },
+    { "simple decimal",                 "1.23",                     ITEM, nullptr, PASS },
+    { "negative decimal",               "-1.23",                    ITEM, nullptr, PASS },
+    { "decimal, whitespace after decimal", "1. 23",                 ITEM, nullptr, FAIL },
+    { "decimal, whitespace before decimal", "1 .23",                ITEM, nullptr, FAIL },
+    { "negative decimal, whitespace after sign", "- 1.23",          ITEM, nullptr, FAIL },
+    { "tricky precision decimal",       "123456789012.1",           ITEM, nullptr, PASS },
+    { "double decimal decimal",         "1.5.4",                    ITEM, nullptr, FAIL },
+    { "adjacent double decimal decimal", "1..4",                    ITEM, nullptr, FAIL },
+    { "decimal with three fractional digits", "1.123",              ITEM, nullptr, PASS },
+    { "negative decimal with three fractional digits", "-1.123",    ITEM, nullptr, PASS },
+    { "decimal with four fractional digits", "1.1234",              ITEM, nullptr, FAIL },
+    { "negative decimal with four fractional digits", "-1.1234",    ITEM, nullptr, FAIL },
+    { "decimal with thirteen integer digits", "1234567890123.0",    ITEM, nullptr, FAIL },
+    { "negative decimal with thirteen integer digits", "-1234567890123.0", ITEM, nullptr, FAIL },
+    { "decimal with trailing zeros",    "1.500",                    ITEM, "1.5", PASS },
+    { "decimal with no fractional digits", "1.",                    ITEM, nullptr, FAIL },
+    { "decimal with leading zero",      "0.5",                      ITEM, nullptr, PASS },
+    { "decimal zero",                   "0.0",                      ITEM, nullptr, PASS },
+    { "negative decimal zero",          "-0.0",                     ITEM, "0.0", PASS },
+
+    // param-dict.json
+    { "basic parameterised dict",       "abc=123;a=1;b=2, def=456, ghi=789;q=9;r=\"+w\"", DICT, nullptr, PASS },
+    { "single item parameterised dict", "a=b; q=1.0",               DICT, "a=b;q=1.0", PASS },
+    { "list item parameterised dictionary", "a=(1 2); q=1.0",       DICT, "a=(1 2);q=1.0", PASS },
+    { "missing parameter value parameterised dict", "a=3;c;d=5",    DICT, nullptr, PASS },
+    { "terminal missing parameter value parameterised dict", "a=3;c=5;d", DICT, nullptr, PASS },
+    { "no whitespace parameterised dict", "a=b;c=1,d=e;f=2",        DICT, "a=b;c=1, d=e;f=2", PASS },
+    { "whitespace before = parameterised dict", "a=b;q =0.5",       DICT, nullptr, FAIL },
+    { "whitespace after = parameterised dict", "a=b;q= 0.5",        DICT, nullptr, FAIL },
+    { "whitespace before ; parameterised dict", "a=b ;q=0.5",       DICT, nullptr, FAIL },
+    { "whitespace after ; parameterised dict", "a=b; q=0.5",        DICT, "a=b;q=0.5", PASS },
+    { "extra whitespace parameterised dict", "a=b;  c=1  ,  d=e; f=2; g=3", DICT, "a=b;c=1, d=e;f=2;g=3", PASS },
+    { "two lines parameterised list",   "a=b;c=1, d=e;f=2",         DICT, nullptr, PASS },
+    { "trailing comma parameterised list", "a=b; q=1.0,",           DICT, nullptr, FAIL },
+    { "empty item parameterised list",  "a=b; q=1.0,,c=d",          DICT, nullptr, FAIL },
+
+    // param-list.json
+    { "basic parameterised list",       "abc_123;a=1;b=2; cdef_456, ghi;q=9;r=\"+w\"", LIST, "abc_123;a=1;b=2;cdef_456, ghi;q=9;r=\"+w\"", PASS },
+    { "single item parameterised list", "text/html;q=1.0",          LIST, nullptr, PASS },
+    { "missing parameter value parameterised list", "text/html;a;q=1.0", LIST, nullptr, PASS },
+    { "missing terminal parameter value parameterised list", "text/html;q=1.0;a", LIST, nullptr, PASS },
+    { "no whitespace parameterised list", "text/html,text/plain;q=0.5", LIST, "text/html, text/plain;q=0.5", PASS },
+    { "whitespace before = parameterised list", "text/html, text/plain;q =0.5", LIST, nullptr, FAIL },
+    { "whitespace after = parameterised list", "text/html, text/plain;q= 0.5", LIST, nullptr, FAIL },
+    { "whitespace before ; parameterised list", "text/html, text/plain ;q=0.5", LIST, nullptr, FAIL },
+    { "whitespace after ; parameterised list", "text/html, text/plain; q=0.5", LIST, "text/html, text/plain;q=0.5", PASS },
+    { "extra whitespace parameterised list", "text/html  ,  text/plain;  q=0.5;  charset=utf-8", LIST, "text/html, text/plain;q=0.5;charset=utf-8", PASS },
+    { "trailing comma parameterised list", "text/html,text/plain;q=0.5,", LIST, nullptr, FAIL },
+    { "empty item parameterised list",  "text/html,,text/plain;q=0.5,", LIST, nullptr, FAIL },
+    { "duplicate parameter key",        "abc;a=1;b=2;a=3",          LIST, "abc;a=3;b=2", PASS },
+
+    // param-listlist.json
+    { "parameterised inner list",       "(abc_123);a=1;b=2, cdef_456", LIST, nullptr, PASS },
+    { "parameterised inner list item",  "(abc_123;a=1;b=2;cdef_456)", LIST, nullptr, PASS },
+    { "parameterised inner list with parameterised item", "(abc_123;a=1;b=2);cdef_456", LIST, nullptr, PASS },
+
+    // string.json
+    { "basic string",                   "\"foo bar\"",              ITEM, nullptr, PASS },
+    { "empty string",                   "\"\"",                     ITEM, nullptr, PASS },
+    { "long string",                    "\"foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo foo \"", ITEM, nullptr, PASS },
+    { "whitespace string",              "\"   \"",                  ITEM, nullptr, PASS },
+    { "non-ascii string",               "\"f\xC3\xBC\xC3\xBC\"",    ITEM, nullptr, FAIL },
+    { "tab in string",                  "\"\\t\"",                  ITEM, nullptr, FAIL },
+    { "newline in string",              "\" \n \"",                 ITEM, nullptr, FAIL },
+    { "single quoted string",           "'foo'",                    ITEM, nullptr, FAIL },
+    { "unbalanced string",              "\"foo",                    ITEM, nullptr, FAIL },
+    { "string quoting",                 "\"foo \\\"bar\\\" \\\\ baz\"", ITEM, nullptr, PASS },
+    { "bad string quoting",             "\"foo \\,\"",              ITEM, nullptr, FAIL },
+    { "ending string quote",            "\"foo \\\"",               ITEM, nullptr, FAIL },
+    { "abruptly ending string quote",   "\"foo \\",                 ITEM, nullptr, FAIL },
+
+    // token.json
+    { "basic token - item",             "a_b-c.d3:f%00/*",          ITEM, nullptr, PASS },
+    { "token with capitals - item",     "fooBar",                   ITEM, nullptr, PASS },
+    { "token starting with capitals - item", "FooBar",              ITEM, nullptr, PASS },
+    { "basic token - list",             "a_b-c3/*",                 LIST, nullptr, PASS },
+    { "token with capitals - list",     "fooBar",                   LIST, nullptr, PASS },
+    { "token starting with capitals - list", "FooBar",              LIST, nullptr, PASS },
+    { "token starting with asterisk",   "*foo",                     ITEM, nullptr, PASS },
+    { "token starting with digit",      "1foo",                     ITEM, nullptr, FAIL },
+    { "token starting with slash",      "/foo",                     ITEM, nullptr, FAIL },
+    { "token with separator",           "foo,bar",                  ITEM, nullptr, FAIL },
+
+    // key-generated.json (sample)
+    { "0x2a as a single-character dictionary key", "*=1",           DICT, nullptr, PASS },
+    { "0x41 as a single-character dictionary key", "A=1",           DICT, nullptr, FAIL },
+    { "0x5f in dictionary key",         "a_a=1",                    DICT, nullptr, PASS },
+    { "0x2e starting a dictionary key", ".a=1",                     DICT, nullptr, FAIL },
+    { "0x2a in parameterised list key", "foo; a*a=1",               LIST, "foo;a*a=1", PASS },
+    { "0x41 in parameterised list key", "foo; aAa=1",               LIST, nullptr, FAIL },
+};
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("structured_field_corpus", "[structured_field]")
+{
+    CATCH_START_SECTION("structured_field: official test suite corpus")
+    {
+        edhttp::structured_field field;
+        for(auto const & c : g_corpus)
+        {
+            CATCH_INFO(c.f_name);
+            bool const valid(field.parse(c.f_raw, c.f_type));
+            switch(c.f_expect)
+            {
+            case expect_t::EXPECT_PASS:
+                CATCH_REQUIRE(valid);
+                CATCH_REQUIRE(field.to_string() == (c.f_canonical == nullptr ? c.f_raw : c.f_canonical));
+                break;
+
+            case expect_t::EXPECT_FAIL:
+                CATCH_REQUIRE_FALSE(valid);
+                CATCH_REQUIRE(field.empty());
+                break;
+
+            case expect_t::EXPECT_CAN_FAIL:
+                if(valid)
+                {
+                    CATCH_REQUIRE(field.to_string() == (c.f_canonical == nullptr ? c.f_raw : c.f_canonical));
+                }
+                break;
+
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("structured_field: large-generated")
+    {
+        // large-generated.json: lists and dictionaries with 1024 members,
+        // parameters, and long keys; this also exercises the overflow of
+        // the inline arrays
+        //
+        std::string list;
+        std::string dictionary;
+        std::string params("foo");
+        for(int i(0); i < 1024; ++i)
+        {
+            if(i != 0)
+            {
+                list += ", ";
+                dictionary += ", ";
+            }
+            list += "a" + std::to_string(i);
+            dictionary += "a" + std::to_string(i) + "=1";
+            params += ";a" + std::to_string(i) + "=1";
+        }
+
+        edhttp::structured_field field(list, LIST);
+        CATCH_REQUIRE(field.size() == 1024);
+        CATCH_REQUIRE(field.to_string() == list);
+
+        CATCH_REQUIRE(field.parse(dictionary, DICT));
+        CATCH_REQUIRE(field.size() == 1024);
+        CATCH_REQUIRE(field.find_member("a1000") != nullptr);
+        CATCH_REQUIRE(field.to_string() == dictionary);
+
+        CATCH_REQUIRE(field.parse(params, ITEM));
+        CATCH_REQUIRE(field.get_member(0).f_param_count == 1024);
+        CATCH_REQUIRE(field.to_string() == params);
+
+        std::string const long_key(std::string(1000, 'a') + "=1");
+        CATCH_REQUIRE(field.parse(long_key, DICT));
+        CATCH_REQUIRE(field.to_string() == long_key);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("structured_field_access", "[structured_field]")
+{
+    CATCH_START_SECTION("structured_field: access members and parameters")
+    {
+        std::string const header("u=3, i, x=(\"a\\\\b\" :aGVsbG8=: 1.25);q, y=-7;ok=?0");
+        edhttp::structured_field field(header, DICT);
+        CATCH_REQUIRE(field.get_field_type() == DICT);
+        CATCH_REQUIRE(field.size() == 4);
+
+        edhttp::structured_field::item_t const * u(field.find_member("u"));
+        CATCH_REQUIRE(u != nullptr);
+        CATCH_REQUIRE(u->f_type == edhttp::structured_field::item_type_t::ITEM_TYPE_INTEGER);
+        CATCH_REQUIRE(u->f_integer == 3);
+
+        edhttp::structured_field::item_t const & i(field.get_member(1));
+        CATCH_REQUIRE(i.f_key == "i");
+        CATCH_REQUIRE(i.f_type == edhttp::structured_field::item_type_t::ITEM_TYPE_BOOLEAN);
+        CATCH_REQUIRE(i.get_boolean());
+
+        edhttp::structured_field::item_t const & x(field.get_member(2));
+        CATCH_REQUIRE(x.f_type == edhttp::structured_field::item_type_t::ITEM_TYPE_INNER_LIST);
+        CATCH_REQUIRE(x.f_integer == 3);
+        CATCH_REQUIRE(field.get_inner_item(x, 0).get_string() == "a\\b");
+        CATCH_REQUIRE(field.get_inner_item(x, 1).get_byte_sequence() == "hello");
+        CATCH_REQUIRE(field.get_inner_item(x, 2).get_decimal() == 1.25);
+        CATCH_REQUIRE(field.find_param(x, "q") != nullptr);
+        CATCH_REQUIRE(field.find_param(x, "z") == nullptr);
+
+        edhttp::structured_field::item_t const & y(field.get_member(3));
+        CATCH_REQUIRE(y.f_integer == -7);
+        CATCH_REQUIRE(field.get_param(y, 0).f_key == "ok");
+        CATCH_REQUIRE_FALSE(field.get_param(y, 0).get_boolean());
+
+        CATCH_REQUIRE(field.find_member("missing") == nullptr);
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  field.get_member(4)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: structured field member index out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  field.get_inner_item(x, 3)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: structured field inner list index out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  field.get_inner_item(y, 0)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: get_inner_item() called with an item which is not an inner list."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  field.get_param(y, 1)
+                , edhttp::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: structured field parameter index out of range."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("structured_field_serialize", "[structured_field]")
+{
+    CATCH_START_SECTION("structured_field: serialize bare items")
+    {
+        std::string out;
+        edhttp::structured_field::serialize_key(out, "cache-status");
+        out += '=';
+        edhttp::structured_field::serialize_integer(out, -42);
+        out += ';';
+        edhttp::structured_field::serialize_key(out, "q");
+        out += '=';
+        edhttp::structured_field::serialize_decimal(out, 0.5);
+        out += ' ';
+        edhttp::structured_field::serialize_decimal(out, 2.0);
+        out += ' ';
+        edhttp::structured_field::serialize_decimal(out, 1.0005);
+        out += ' ';
+        edhttp::structured_field::serialize_string(out, "say \"hi\" \\o/");
+        out += ' ';
+        edhttp::structured_field::serialize_token(out, "text/html");
+        out += ' ';
+        edhttp::structured_field::serialize_byte_sequence(out, "hello");
+        out += ' ';
+        edhttp::structured_field::serialize_boolean(out, false);
+        CATCH_REQUIRE(out == "cache-status=-42;q=0.5 2.0 1.0 \"say \\\"hi\\\" \\\\o/\" text/html :aGVsbG8=: ?0");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("structured_field: invalid values")
+    {
+        std::string out;
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::structured_field::serialize_integer(out, 1'000'000'000'000'000LL)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: structured field integer out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::structured_field::serialize_decimal(out, 1e12)
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: structured field decimal out of range."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::structured_field::serialize_string(out, "tab\t")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: structured field strings are limited to printable ASCII characters."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::structured_field::serialize_token(out, "1abc")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid structured field token."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::structured_field::serialize_key(out, "Key")
+                , edhttp::invalid_parameter
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: invalid structured field key."));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et
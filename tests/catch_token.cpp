@@ -0,0 +1,173 @@
+// Copyright (c) 2011-2024  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/edhttp
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+/** \file
+ * \brief Verify the token, field value, and path scanners.
+ *
+ * This file implements tests to verify that the scalar and vectorized
+ * character scanners return the same results.
+ */
+
+// self
+//
+#include    "catch_main.h"
+
+
+// edhttp
+//
+#include    "edhttp/exception.h"
+#include    "edhttp/token.h"
+
+
+
+namespace
+{
+
+
+
+std::string const g_token_chars(
+        "!#$%&'*+-.0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ^_`abcdefghijklmnopqrstuvwxyz|~");
+
+
+std::string const g_path_chars(
+        "!$%&'()*+,-./0123456789:;=@ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz~");
+
+
+bool is_token_char(int c)
+{
+    return g_token_chars.find(static_cast<char>(c)) != std::string::npos;
+}
+
+
+bool is_field_value_char(int c)
+{
+    return c == '\t' || (c >= ' ' && c != 0x7F);
+}
+
+
+bool is_path_char(int c)
+{
+    return g_path_chars.find(static_cast<char>(c)) != std::string::npos;
+}
+
+
+
+} // no name namespace
+
+
+
+CATCH_TEST_CASE("token", "[token]")
+{
+    CATCH_START_SECTION("token: is_token()")
+    {
+        CATCH_REQUIRE(edhttp::is_token("gzip"));
+        CATCH_REQUIRE(edhttp::is_token("Content-Type"));
+        CATCH_REQUIRE(edhttp::is_token(std::string("x-a$b")));
+        CATCH_REQUIRE_FALSE(edhttp::is_token("$name"));
+        CATCH_REQUIRE_FALSE(edhttp::is_token("Content Type"));
+        CATCH_REQUIRE_FALSE(edhttp::is_token("a:b"));
+        CATCH_REQUIRE_FALSE(edhttp::is_token("caf\xC3\xA9"));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  edhttp::is_token("")
+                , edhttp::invalid_token
+                , Catch::Matchers::ExceptionMessage(
+                          "edhttp_exception: an HTTP token cannot be empty."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("token: is_field_value() and is_path()")
+    {
+        CATCH_REQUIRE(edhttp::is_field_value(""));
+        CATCH_REQUIRE(edhttp::is_field_value("text/html; charset=utf-8"));
+        CATCH_REQUIRE(edhttp::is_field_value("caf\xC3\xA9\tau lait"));
+        CATCH_REQUIRE_FALSE(edhttp::is_field_value("bad\r\nX-Injected: yes"));
+        CATCH_REQUIRE_FALSE(edhttp::is_field_value(std::string_view("nul\0", 4)));
+        CATCH_REQUIRE_FALSE(edhttp::is_field_value("del\x7F"));
+
+        CATCH_REQUIRE(edhttp::is_path("/images/logo%20v2.png"));
+        CATCH_REQUIRE(edhttp::is_path("/a/b;c=d/e:f@g"));
+        CATCH_REQUIRE_FALSE(edhttp::is_path("/search?q=1"));
+        CATCH_REQUIRE_FALSE(edhttp::is_path("/a b"));
+        CATCH_REQUIRE_FALSE(edhttp::is_path("/page#top"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("token: every octet at every position of a long string")
+    {
+        std::string const valid_token(100, 'a');
+        std::string const valid_path(100, '/');
+        std::string const valid_value(100, ' ');
+        for(int c(0); c < 256; ++c)
+        {
+            for(std::size_t pos(0); pos < 70; pos += 7)
+            {
+                std::string token(valid_token);
+                token[pos] = static_cast<char>(c);
+                CATCH_REQUIRE(edhttp::scan_token(token) == (is_token_char(c) ? token.length() : pos));
+
+                std::string path(valid_path);
+                path[pos] = static_cast<char>(c);
+                CATCH_REQUIRE(edhttp::scan_path(path) == (is_path_char(c) ? path.length() : pos));
+
+                std::string value(valid_value);
+                value[pos] = static_cast<char>(c);
+                CATCH_REQUIRE(edhttp::scan_field_value(value) == (is_field_value_char(c) ? value.length() : pos));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("token: scalar and SIMD kernels agree")
+    {
+        edhttp::simd_level_t const detected(edhttp::get_simd_level());
+        for(int repeat(0); repeat < 1000; ++repeat)
+        {
+            std::string s(rand() % 200, '\0');
+            for(auto & c : s)
+            {
+                // mostly valid characters so we scan long runs
+                //
+                c = rand() % 50 == 0
+                        ? static_cast<char>(rand())
+                        : g_token_chars[rand() % g_token_chars.length()];
+            }
+
+            std::size_t results[3][3];
+            for(int level(0); level < 3; ++level)
+            {
+                edhttp::set_simd_level(static_cast<edhttp::simd_level_t>(level));
+                results[level][0] = edhttp::scan_token(s);
+                results[level][1] = edhttp::scan_field_value(s);
+                results[level][2] = edhttp::scan_path(s);
+            }
+            edhttp::set_simd_level(detected);
+
+            for(int idx(0); idx < 3; ++idx)
+            {
+                CATCH_REQUIRE(results[0][idx] == results[1][idx]);
+                CATCH_REQUIRE(results[0][idx] == results[2][idx]);
+            }
+        }
+        CATCH_REQUIRE(edhttp::get_simd_level() == detected);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// vim: ts=4 sw=4 et